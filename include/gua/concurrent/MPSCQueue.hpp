@@ -0,0 +1,112 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef GUA_MPSC_QUEUE_HPP
+#define GUA_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <utility>
+
+namespace gua
+{
+namespace concurrent
+{
+/**
+ * An unbounded, lock-free queue for many producers and a single consumer.
+ *
+ * push() may be called from any thread at any time, pop() only from one
+ * thread at a time. Neither of them ever blocks: a producer swaps itself in
+ * as the new head with a single atomic exchange and links its predecessor
+ * afterwards. If the consumer catches a producer between these two steps,
+ * pop() reports an empty queue and the element is delivered by the next call.
+ */
+template <typename T>
+class MPSCQueue
+{
+  public:
+    MPSCQueue() : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+
+    ~MPSCQueue()
+    {
+        T value;
+        while(pop(value))
+        {
+        }
+        delete tail_;
+    }
+
+    MPSCQueue(MPSCQueue const&) = delete;
+    MPSCQueue& operator=(MPSCQueue const&) = delete;
+
+    /**
+     * Appends a value to the queue.
+     */
+    void push(T value)
+    {
+        Node* node(new Node(std::move(value)));
+        Node* previous(head_.exchange(node, std::memory_order_acq_rel));
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * Removes the oldest value from the queue.
+     *
+     * \param value  Receives the removed value.
+     *
+     * \return       False, if there was no value to remove.
+     */
+    bool pop(T& value)
+    {
+        Node* next(tail_->next.load(std::memory_order_acquire));
+
+        if(!next)
+        {
+            return false;
+        }
+
+        value = std::move(next->value);
+        delete tail_;
+        tail_ = next;
+        return true;
+    }
+
+  private:
+    struct Node
+    {
+        Node() : value(), next(nullptr) {}
+        explicit Node(T&& v) : value(std::move(v)), next(nullptr) {}
+
+        T value;
+        std::atomic<Node*> next;
+    };
+
+    // most recently pushed node, written by the producers
+    std::atomic<Node*> head_;
+
+    // already consumed node preceding the oldest value, owned by the consumer
+    Node* tail_;
+};
+
+} // namespace concurrent
+} // namespace gua
+
+#endif // GUA_MPSC_QUEUE_HPP
@@ -0,0 +1,121 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef GUA_THREAD_POOL_HPP
+#define GUA_THREAD_POOL_HPP
+
+#include <gua/platform.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace gua
+{
+namespace concurrent
+{
+/**
+ * A fixed number of worker threads processing a FIFO queue of tasks.
+ *
+ * Besides submitting individual tasks, index ranges can be processed with
+ * parallel_for(). The calling thread takes part in the processing, so
+ * parallel_for() may safely be called from within a task.
+ */
+class GUA_DLL ThreadPool
+{
+  public:
+    /**
+     * Constructor.
+     *
+     * \param thread_count  Number of worker threads. If zero, one thread per
+     *                      hardware thread is created.
+     */
+    explicit ThreadPool(unsigned thread_count = 0);
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    /**
+     * Destructor. Waits until all queued tasks are finished.
+     */
+    ~ThreadPool();
+
+    /**
+     * Returns a pool shared by all of guacamole's subsystems.
+     */
+    static ThreadPool* instance();
+
+    /**
+     * Queues a task for execution on one of the worker threads.
+     *
+     * \param task  The task to be executed.
+     *
+     * \return      A future holding the task's result.
+     */
+    template <typename F>
+    std::future<typename std::result_of<F()>::type> submit(F&& task)
+    {
+        using result_type = typename std::result_of<F()>::type;
+
+        auto packaged(std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(task)));
+        auto result(packaged->get_future());
+
+        enqueue([packaged]() { (*packaged)(); });
+
+        return result;
+    }
+
+    /**
+     * Calls func(chunk_begin, chunk_end) for consecutive chunks of
+     * [begin, end) in parallel and returns when all chunks are processed.
+     *
+     * \param begin       First index.
+     * \param end         One past the last index.
+     * \param func        Called once per chunk.
+     * \param grain_size  Minimum number of indices per chunk.
+     */
+    void parallel_for(std::size_t begin, std::size_t end, std::function<void(std::size_t, std::size_t)> const& func, std::size_t grain_size = 1);
+
+    /**
+     * Returns the number of worker threads.
+     */
+    unsigned size() const { return unsigned(workers_.size()); }
+
+  private:
+    void enqueue(std::function<void()> const& task);
+    void work();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool shutdown_ = false;
+};
+
+} // namespace concurrent
+} // namespace gua
+
+#endif // GUA_THREAD_POOL_HPP
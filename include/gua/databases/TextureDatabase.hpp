@@ -28,8 +28,17 @@
 #include <gua/databases/Database.hpp>
 #include <gua/renderer/Texture.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <map>
 #include <mutex>
-#include <future>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
 #include <gua/virtual_texturing/VirtualTexture2D.hpp>
@@ -43,11 +52,37 @@ namespace gua
  * This Database stores texture data. It can be accessed via string
  * identifiers.
  *
+ * Image files are decoded by a fixed number of streaming threads. Until a
+ * texture has arrived, its name refers to "gua_default_texture". Pending
+ * requests are served by priority: the largest screen space size reported
+ * with request_visible() first, the priority passed to load() second.
+ *
  * \ingroup gua_databases
  */
 class GUA_DLL TextureDatabase : public Database<Texture>, public Singleton<TextureDatabase>
 {
   public:
+    /**
+     * Counters of the texture streaming threads.
+     */
+    struct StreamingStats
+    {
+        std::size_t requested = 0;
+        std::size_t loaded = 0;
+        std::size_t failed = 0;
+        std::size_t cancelled = 0;
+        std::size_t queued = 0;
+        std::size_t loading = 0;
+        std::size_t resident_bytes = 0;
+
+        // estimated sizes of the images being decoded
+        std::size_t reserved_bytes = 0;
+
+        // between the request and the arrival of a texture, in milliseconds
+        double average_latency = 0.0;
+        double max_latency = 0.0;
+    };
+
     /**
      * Loads a texture file to the database.
      *
@@ -58,6 +93,60 @@ class GUA_DLL TextureDatabase : public Database<Texture>, public Singleton<Textu
      */
     void load(std::string const& id);
 
+    /**
+     * Loads a texture file to the database.
+     *
+     * Image files are queued for the streaming threads. A request which is
+     * queued already gets the higher of both priorities.
+     *
+     * \param id        An absolute or relative path to the texture file.
+     * \param priority  Requests with a higher priority are loaded first.
+     */
+    void load(std::string const& id, float priority);
+
+    /**
+     * Reports the size of a queued texture on the screen, e.g. the fraction
+     * of the screen covered by an object using it. The largest size reported
+     * for a request determines its position in the queue.
+     *
+     * \return Whether the texture is still queued.
+     */
+    bool request_visible(std::string const& id, float screen_size);
+
+    /**
+     * Returns whether the texture was requested but has not arrived yet.
+     */
+    bool is_loading(std::string const& id) const;
+
+    /**
+     * Cancels the request for a texture which has not arrived yet and
+     * removes its placeholder.
+     *
+     * \return Whether the request was pending.
+     */
+    bool cancel(std::string const& id);
+
+    /**
+     * Removes a streamed texture and frees its share of the memory budget.
+     */
+    void unload(std::string const& id);
+
+    /**
+     * Sets the number of streaming threads. Takes effect if called before
+     * the first texture is requested.
+     */
+    void set_streaming_threads(unsigned count);
+
+    /**
+     * Streaming threads do not start decoding further images while the
+     * decoded images of all streamed textures take more than the given
+     * number of bytes. Streaming resumes once textures are unloaded or the
+     * budget is raised. Defaults to no limit.
+     */
+    void set_memory_budget(std::size_t bytes);
+
+    StreamingStats get_streaming_stats() const;
+
     int32_t get_global_texture_id_by_path(std::string const& tex_path) const;
 
     friend class Singleton<TextureDatabase>;
@@ -69,12 +158,62 @@ class GUA_DLL TextureDatabase : public Database<Texture>, public Singleton<Textu
   private:
     // this class is a Singleton --- private c'tor and d'tor
     TextureDatabase();
-    ~TextureDatabase() = default;
+    ~TextureDatabase();
+
+    struct Request
+    {
+        float screen_size = 0.f;
+        float priority = 0.f;
+        std::uint64_t sequence = 0;
+        std::chrono::steady_clock::time_point start;
+
+        // see estimate_image_2d_size()
+        bool estimated = false;
+        std::size_t estimated_bytes = 0;
+    };
+
+    // ordered by descending screen size and priority, then by request order
+    struct RequestOrder
+    {
+        bool operator()(Request const& a, Request const& b) const
+        {
+            if(a.screen_size != b.screen_size)
+            {
+                return a.screen_size > b.screen_size;
+            }
+            if(a.priority != b.priority)
+            {
+                return a.priority > b.priority;
+            }
+            return a.sequence < b.sequence;
+        }
+    };
 
-    std::vector<std::future<std::string>> textures_loading_;
-    std::mutex texture_request_mutex_;
+    void enqueue(std::string const& id, float priority);
+    void stream();
+
+    // whether the request may be decoded without exceeding the memory budget
+    bool fits_memory_budget(Request const& request) const;
+
+    mutable std::mutex texture_request_mutex_;
+    std::condition_variable texture_request_condition_;
     std::set<std::string> texture_loading_;
 
+    // queued requests and the names of the requests being decoded
+    std::map<Request, std::string, RequestOrder> texture_queue_;
+    std::unordered_map<std::string, Request> texture_requests_;
+    std::unordered_map<std::string, bool> textures_decoding_; // true if cancelled
+    std::unordered_map<std::string, std::size_t> texture_sizes_;
+    std::uint64_t next_request_ = 0;
+
+    std::vector<std::thread> streaming_threads_;
+    unsigned streaming_thread_count_ = std::max(1u, std::thread::hardware_concurrency() / 2);
+    std::size_t memory_budget_ = std::numeric_limits<std::size_t>::max();
+    bool shutdown_ = false;
+
+    StreamingStats stats_;
+    double total_latency_ = 0.0;
+
     std::unordered_map<std::string, uint32_t> texture_path_to_global_id_mapping_;
     uint32_t num_loaded_textured_ = 0;
 
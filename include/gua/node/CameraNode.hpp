@@ -150,7 +150,11 @@ class GUA_DLL CameraNode : public Node
 
     std::shared_ptr<PipelineDescription>& get_pipeline_description() { return pipeline_description_; }
 
-    void set_pipeline_description(std::shared_ptr<PipelineDescription> const& pipeline_description) { pipeline_description_ = pipeline_description; }
+    void set_pipeline_description(std::shared_ptr<PipelineDescription> const& pipeline_description)
+    {
+        pipeline_description_ = pipeline_description;
+        invalidate_snapshot();
+    }
 
     Frustum get_rendering_frustum(SceneGraph const& graph, CameraMode mode) const;
     Frustum get_culling_frustum(SceneGraph const& graph, CameraMode mode) const;
@@ -172,6 +176,9 @@ class GUA_DLL CameraNode : public Node
   private:
     static Frustum make_frustum(SceneGraph const& graph, math::mat4 const& camera_transform, CameraNode::Configuration const& config, CameraMode mode, bool use_alternative_culling_screen);
 
+    bool supports_flat_update() const override { return true; }
+    bool has_untracked_properties() const override { return true; }
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::GROUP; }
     std::shared_ptr<Node> copy() const override;
 
     /*virtual*/ void set_scenegraph(SceneGraph* scenegraph) override;
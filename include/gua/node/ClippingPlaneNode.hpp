@@ -90,6 +90,9 @@ class GUA_DLL ClippingPlaneNode : public Node
     friend class Node;
 
   private:
+    bool supports_flat_update() const override { return true; }
+    bool has_untracked_properties() const override { return true; }
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::GROUP; }
     std::shared_ptr<Node> copy() const override;
 
     /*virtual*/ void set_scenegraph(SceneGraph* scenegraph) override;
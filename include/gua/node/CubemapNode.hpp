@@ -25,7 +25,9 @@
 #include <gua/platform.hpp>
 #include <gua/node/SerializableNode.hpp>
 #include <gua/utils/configuration_macro.hpp>
+#include <gua/renderer/Frustum.hpp>
 
+#include <array>
 #include <string>
 #include <atomic>
 
@@ -153,6 +155,11 @@ class GUA_DLL CubemapNode : public SerializableNode
     std::vector<float> m_Weights;
     std::vector<float> m_DistortionWeights;
 
+    // frustums of the six faces, rebuilt when the clipping distances change
+    mutable std::array<Frustum, 6> m_FaceFrustums;
+    mutable float m_FaceFrustumsNear = -1.f;
+    mutable float m_FaceFrustumsFar = -1.f;
+
     void find_min_distance();
     math::vec3 calculate_direction_from_tex_coords(math::vec2ui const& tex_coords) const;
     math::vec3 project_back_to_world_coords(Distance_Info const& di) const;
@@ -160,6 +167,9 @@ class GUA_DLL CubemapNode : public SerializableNode
 
     void create_distortion_weights();
 
+    bool supports_flat_update() const override { return true; }
+    bool has_untracked_properties() const override { return true; }
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::GROUP; }
     std::shared_ptr<Node> copy() const override;
 };
 
@@ -72,7 +72,11 @@ class GUA_DLL GeometryNode : public SerializableNode
      * A value describing the shadow's quality.
      */
     ShadowMode get_shadow_mode() const { return shadow_mode_; }
-    void set_shadow_mode(ShadowMode v) { shadow_mode_ = v; }
+    void set_shadow_mode(ShadowMode v)
+    {
+        shadow_mode_ = v;
+        invalidate_snapshot();
+    }
 
     inline void update_cache() override { Node::update_cache(); }
 
@@ -91,6 +91,7 @@ class GUA_DLL LODNode : public TransformNode
     void accept(NodeVisitor& visitor) override;
 
   private:
+    bool has_untracked_properties() const override { return true; }
     std::shared_ptr<Node> copy() const;
 };
 
@@ -177,6 +177,9 @@ class GUA_DLL LightNode : public SerializableNode
     void update_bounding_box() const override;
 
   private:
+    bool supports_flat_update() const override { return true; }
+    bool has_untracked_properties() const override { return true; }
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::GROUP; }
     std::shared_ptr<Node> copy() const override;
 };
 
@@ -64,30 +64,66 @@ class GUA_DLL LineStripNode : public GeometryNode
     void set_material(std::shared_ptr<Material> const& material);
 
     inline bool get_render_to_gbuffer() const { return render_to_gbuffer_; }
-    inline void set_render_to_gbuffer(bool enable) { render_to_gbuffer_ = enable; }
+    inline void set_render_to_gbuffer(bool enable)
+    {
+        render_to_gbuffer_ = enable;
+        invalidate_snapshot();
+    }
 
     inline bool get_render_to_stencil_buffer() const { return render_to_stencil_buffer_; }
-    inline void set_render_to_stencil_buffer(bool enable) { render_to_stencil_buffer_ = enable; }
+    inline void set_render_to_stencil_buffer(bool enable)
+    {
+        render_to_stencil_buffer_ = enable;
+        invalidate_snapshot();
+    }
 
     inline bool get_render_volumetric() const { return render_volumetric_; }
-    inline void set_render_volumetric(bool enable) { render_volumetric_ = enable; }
+    inline void set_render_volumetric(bool enable)
+    {
+        render_volumetric_ = enable;
+        invalidate_snapshot();
+    }
 
     inline bool get_render_vertices_as_points() const { return render_vertices_as_points_; }
-    inline void set_render_vertices_as_points(bool enable) { render_vertices_as_points_ = enable; }
+    inline void set_render_vertices_as_points(bool enable)
+    {
+        render_vertices_as_points_ = enable;
+        invalidate_snapshot();
+    }
 
     inline float get_screen_space_point_size() const { return screen_space_point_size_; }
-    inline void set_screen_space_point_size(float point_size) { screen_space_point_size_ = /*std::max(1.0f, std::min(10.0f, */ point_size /*))*/; }
+    inline void set_screen_space_point_size(float point_size)
+    {
+        screen_space_point_size_ = /*std::max(1.0f, std::min(10.0f, */ point_size /*))*/;
+        invalidate_snapshot();
+    }
 
     inline float get_screen_space_line_width() const { return screen_space_line_width_; }
-    inline void set_screen_space_line_width(float line_width) { screen_space_line_width_ = std::max(1.0f, std::min(10.0f, line_width)); }
+    inline void set_screen_space_line_width(float line_width)
+    {
+        screen_space_line_width_ = std::max(1.0f, std::min(10.0f, line_width));
+        invalidate_snapshot();
+    }
 
     inline bool get_render_lines_as_strip() const { return render_lines_as_strip_; }
-    inline void set_render_lines_as_strip(bool render_lines_as_strip) { render_lines_as_strip_ = render_lines_as_strip; }
+    inline void set_render_lines_as_strip(bool render_lines_as_strip)
+    {
+        render_lines_as_strip_ = render_lines_as_strip;
+        invalidate_snapshot();
+    }
 
     inline bool get_was_created_empty() const { return was_created_empty_; }
-    inline void set_was_created_empty(bool was_created_empty) { was_created_empty_ = was_created_empty; }
-
-    void set_empty() { was_created_empty_ = true; }
+    inline void set_was_created_empty(bool was_created_empty)
+    {
+        was_created_empty_ = was_created_empty;
+        invalidate_snapshot();
+    }
+
+    void set_empty()
+    {
+        was_created_empty_ = true;
+        invalidate_snapshot();
+    }
 
     void compute_consistent_normals();
 
@@ -109,6 +145,16 @@ class GUA_DLL LineStripNode : public GeometryNode
     void compile_buffer_string(std::string& buffer_string);
     void uncompile_buffer_string(std::string const& buffer_string);
 
+    /**
+     * Compact updates for syncing the line strip, see LineStrip::write_sync()
+     * and LineStrip::read_sync(). Unlike compile_buffer_string(), only the
+     * vertices pushed and popped since the last update are written in delta
+     * mode and the caller provides the buffer.
+     */
+    std::size_t max_sync_size() const;
+    std::size_t write_sync(char* buffer, std::size_t capacity, bool delta = true, float precision = 0.0f);
+    bool read_sync(char const* buffer, std::size_t size);
+
     /**
      * Implements ray picking for a triangular mesh
      */
@@ -124,7 +170,11 @@ class GUA_DLL LineStripNode : public GeometryNode
     std::shared_ptr<LineStripResource> const& get_geometry() const;
 
     bool get_trigger_update() const { return trigger_update_; }
-    void set_trigger_update(bool trigger_update) { trigger_update_ = trigger_update; }
+    void set_trigger_update(bool trigger_update)
+    {
+        trigger_update_ = trigger_update;
+        invalidate_snapshot();
+    }
 
     /**
      * Accepts a visitor and calls concrete visit method.
@@ -138,6 +188,11 @@ class GUA_DLL LineStripNode : public GeometryNode
   protected:
     std::shared_ptr<Node> copy() const override;
 
+    bool supports_flat_update() const override { return true; }
+    void prepare_flat_update() override;
+
+    void update_geometry();
+
   private: // attributes e.g. special attributes for drawing
     std::shared_ptr<LineStripResource> geometry_;
     std::string geometry_description_;
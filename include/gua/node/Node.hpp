@@ -46,6 +46,8 @@ namespace gua
 class WindowBase;
 class NodeVisitor;
 class SceneGraph;
+class TransformHierarchy;
+class SceneBVH;
 class Serializer;
 class DotGenerator;
 struct SerializedScene;
@@ -105,7 +107,13 @@ class GUA_DLL Node
      *
      * \param name   The Node's new name.
      */
-    inline void set_name(std::string const& name) { name_ = name; }
+    inline void set_name(std::string const& name)
+    {
+        name_ = name;
+        invalidate_snapshot();
+        // paths resolved to this node are no longer valid
+        notify_structure_change();
+    }
 
     /**
      * Adds a child.
@@ -144,6 +152,7 @@ class GUA_DLL Node
         new_node->parent_ = this;
 
         set_dirty();
+        notify_structure_change();
 
         new_node->set_scenegraph(scenegraph_);
 
@@ -201,6 +210,17 @@ class GUA_DLL Node
 
     math::mat4 const& get_cached_world_transform() const;
 
+    /**
+     * Returns the Node's world transformation.
+     *
+     * Other than get_world_transform(), this reuses the transformation cached
+     * by the last SceneGraph::update_cache() unless the Node or one of its
+     * ancestors has been modified since.
+     *
+     * \return math::mat4  The Node's world transformation.
+     */
+    math::mat4 get_current_world_transform() const;
+
 	math::mat4 get_latest_cached_world_transform(const WindowBase* w) const;
 
   private:
@@ -426,7 +446,17 @@ class GUA_DLL Node
      */
     inline std::size_t const uuid() const { return uuid_; }
 
+    /**
+     * Returns a counter which is incremented whenever Nodes are added to or
+     * removed from any parent.
+     *
+     * \return std::size_t  The current structure version.
+     */
+    static std::size_t get_structure_version();
+
     friend class ::gua::SceneGraph;
+    friend class ::gua::TransformHierarchy;
+    friend class ::gua::SceneBVH;
     friend class ::gua::Serializer;
     friend class ::gua::DotGenerator;
     friend class ::gua::physics::CollisionShapeNodeVisitor;
@@ -448,6 +478,41 @@ class GUA_DLL Node
      */
     virtual std::shared_ptr<Node> deep_copy() const;
 
+    /**
+     * Creates a read-only copy of a Node with all its children which shares
+     * unchanged subtrees with the previously created snapshot.
+     *
+     * Only Nodes which have been modified since the last call (or whose
+     * descendants have been modified) are copied again. All other subtrees
+     * are reused. The returned Nodes must not be modified and are not
+     * attached to any SceneGraph.
+     *
+     * Shared Nodes are never re-attached. The parent of a Node in a snapshot
+     * is the copy of its parent which was made when the parent's own
+     * properties changed last; it is kept alive by all later copies. Hence
+     * it has the same properties as the parent in every snapshot containing
+     * the Node, only its children may belong to an older snapshot.
+     *
+     * \return node     A pointer to the snapshot of this Node.
+     */
+    std::shared_ptr<Node> snapshot() const;
+
+    /**
+     * Marks the Node as modified for the next snapshot().
+     *
+     * All setters of the Node classes call this. It has to be called after
+     * changing properties through references, e.g. tags or the uniforms of a
+     * material, if snapshots are used.
+     */
+    void invalidate_snapshot() const;
+
+    /**
+     * Whether the Node has properties which can be modified without notice,
+     * e.g. through a public configuration struct. Such Nodes are copied by
+     * every snapshot of their SceneGraph.
+     */
+    virtual bool has_untracked_properties() const { return false; }
+
     SceneGraph* get_scenegraph() const { return scenegraph_; }
 
   protected:
@@ -458,6 +523,59 @@ class GUA_DLL Node
      */
     inline bool is_root() const { return parent_ == nullptr; }
 
+    /**
+     * Returns whether the Node's world transformation and bounding box may be
+     * computed by a TransformHierarchy instead of update_cache(). Derived
+     * Nodes which override update_cache() or compute their transformation
+     * differently must return false, which is the default.
+     *
+     * \return bool     Whether flattened updates are supported.
+     */
+    virtual bool supports_flat_update() const { return false; }
+
+    /**
+     * Called by a TransformHierarchy on the application thread before the
+     * world transformation of a dirty Node is updated. Derived Nodes may
+     * resolve resources here which update_cache() would load otherwise.
+     */
+    virtual void prepare_flat_update() {}
+
+    /**
+     * Describes how a SceneBVH handles a Node when testing rays.
+     */
+    enum class RayTestMode
+    {
+        // the Node and its children are tested with ray_test_impl()
+        SUBTREE,
+        // the Node has no geometry of its own; if the mask rejects it, its
+        // children are skipped
+        GROUP,
+        // the Node's own geometry is tested with ray_test_geometry() if the
+        // mask accepts it; its children are tested in any case
+        GEOMETRY
+    };
+
+    /**
+     * Returns how a SceneBVH handles this Node. Derived Nodes which override
+     * ray_test_impl() have to return SUBTREE, which is the default.
+     *
+     * \return RayTestMode  The Node's ray test mode.
+     */
+    virtual RayTestMode get_ray_test_mode() const { return RayTestMode::SUBTREE; }
+
+    /**
+     * Intersects the Node's own geometry with a given Ray, regardless of its
+     * bounding box and children. Only called for Nodes of RayTestMode
+     * GEOMETRY.
+     *
+     * \param ray       The Ray used to check for intersections.
+     * \param options   int to configure the intersection process.
+     * \param hits      The set the resulting PickResults are added to.
+     */
+    virtual void ray_test_geometry(Ray const& ray, int options, std::set<PickResult>& hits) {}
+
+    static void notify_structure_change();
+
   private:
     /**
      * Sets the Node's parent.
@@ -485,9 +603,25 @@ class GUA_DLL Node
 
     virtual void set_scenegraph(SceneGraph* scenegraph);
 
+    /**
+     * Implements snapshot(). parent_anchor is the copy the snapshot's parent
+     * pointer refers to and parent_changed is set if it differs from the
+     * one of the previous snapshot.
+     */
+    virtual std::shared_ptr<Node> snapshot_subtree(Node* parent_anchor, bool parent_changed) const;
+
     mutable bool self_dirty_ = true;
     mutable bool child_dirty_ = true;
 
+    // set if this node or one of its descendants changed since snapshot()
+    mutable bool snapshot_dirty_ = true;
+    // set if the properties of this node changed since snapshot()
+    mutable bool snapshot_self_dirty_ = true;
+    mutable std::shared_ptr<Node> snapshot_;
+    // the copy which the children's snapshots point to; in copies, it keeps
+    // that copy alive
+    mutable std::shared_ptr<Node> snapshot_anchor_;
+
     // up (cached) annotations
     mutable math::BoundingBox<math::vec3> bounding_box_;
     bool draw_bounding_box_ = false;
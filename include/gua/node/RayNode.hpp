@@ -102,6 +102,8 @@ class GUA_DLL RayNode : public Node
     static const float END;
 
   private:
+    bool supports_flat_update() const override { return true; }
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::GROUP; }
     std::shared_ptr<Node> copy() const override;
 };
 
@@ -107,7 +107,12 @@ class GUA_DLL TexturedQuadNode : public SerializableNode
 
     void ray_test_impl(Ray const& ray, int options, Mask const& mask, std::set<PickResult>& hits) override;
 
+  protected:
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::GEOMETRY; }
+    void ray_test_geometry(Ray const& ray, int options, std::set<PickResult>& hits) override;
+
   private: // methods
+    bool has_untracked_properties() const override { return true; }
     std::shared_ptr<Node> copy() const override;
 };
 
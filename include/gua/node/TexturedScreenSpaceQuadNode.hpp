@@ -95,6 +95,7 @@ class GUA_DLL TexturedScreenSpaceQuadNode : public SerializableNode
     void update_cache() override;
 
   private: // methods
+    bool has_untracked_properties() const override { return true; }
     std::shared_ptr<Node> copy() const override;
 };
 
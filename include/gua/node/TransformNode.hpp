@@ -70,6 +70,8 @@ class GUA_DLL TransformNode : public Node
     void accept(NodeVisitor& visitor) override;
 
   private:
+    bool supports_flat_update() const override { return true; }
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::GROUP; }
     std::shared_ptr<Node> copy() const override;
 };
 
@@ -62,10 +62,18 @@ class GUA_DLL TriMeshNode : public GeometryNode
     void set_material(std::shared_ptr<Material> const& material);
 
     inline bool get_render_to_gbuffer() const { return render_to_gbuffer_; }
-    inline void set_render_to_gbuffer(bool enable) { render_to_gbuffer_ = enable; }
+    inline void set_render_to_gbuffer(bool enable)
+    {
+        render_to_gbuffer_ = enable;
+        invalidate_snapshot();
+    }
 
     inline bool get_render_to_stencil_buffer() const { return render_to_stencil_buffer_; }
-    inline void set_render_to_stencil_buffer(bool enable) { render_to_stencil_buffer_ = enable; }
+    inline void set_render_to_stencil_buffer(bool enable)
+    {
+        render_to_stencil_buffer_ = enable;
+        invalidate_snapshot();
+    }
 
     /**
      * Implements ray picking for a triangular mesh
@@ -93,6 +101,14 @@ class GUA_DLL TriMeshNode : public GeometryNode
   protected:
     std::shared_ptr<Node> copy() const override;
 
+    bool supports_flat_update() const override { return true; }
+    void prepare_flat_update() override;
+
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::GEOMETRY; }
+    void ray_test_geometry(Ray const& ray, int options, std::set<PickResult>& hits) override;
+
+    void update_geometry();
+
   private: // attributes e.g. special attributes for drawing
     std::shared_ptr<TriMeshRessource> geometry_;
     std::string geometry_description_;
@@ -64,6 +64,7 @@ class GUA_DLL CollisionShapeNode : public node::TransformNode
     /* virtual */ void accept(NodeVisitor&);
 
   private:
+    bool has_untracked_properties() const { return true; }
     std::shared_ptr<node::Node> copy() const;
 };
 
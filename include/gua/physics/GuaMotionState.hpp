@@ -24,7 +24,7 @@
 
 // external headers
 #include <LinearMath/btMotionState.h>
-#include <utility>
+#include <atomic>
 
 namespace gua
 {
@@ -36,6 +36,11 @@ class RigidBodyNode;
  * The GuaMotionState is an implementation of Bullet's btMotionState.
  *        This class is used internally in RigidBodyNode and Physics classes
  *        for synchronizing world transforms.
+ *
+ * Besides the transform Bullet works on, the motion state holds a lock-free
+ * triple buffer: the physics thread publishes into its back buffer, the
+ * application thread reads from its front buffer and both only ever exchange
+ * their buffer with the middle one. Neither side waits for the other.
  */
 class GuaMotionState : public btMotionState
 {
@@ -86,33 +91,41 @@ class GuaMotionState : public btMotionState
     virtual void latest_transform(btTransform& centerOfMassWorldTrans) const;
 
     /**
-     * Copies the transform from the writer's buffer to the intermediate
-     *        buffer. This method is used in Physics::simulate().
+     * Publishes the transform Bullet has written last. The writer's
+     *        buffer is exchanged with the intermediate buffer. This method is
+     *        used in Physics::simulate().
      */
     inline void flip_writer()
     {
-        *transforms_[1] = *transforms_[0];
-        dirty = true;
+        *transforms_[back_] = *transforms_[0];
+        back_ = middle_.exchange(back_ | UPDATED, std::memory_order_acq_rel) & INDEX;
     }
 
     /**
-     * Copies the transform from the intermediate buffer to the reader's
-     *        buffer. Physics::synchronize() calls this method for all
-     *        rigid bodies to retrieve the latest available transforms.
+     * Exchanges the reader's buffer with the intermediate buffer if a new
+     *        transform has been published since the last call.
+     *        Physics::synchronize() calls this method for all rigid bodies to
+     *        retrieve the latest available transforms.
      * \sa    latest_transform()
      */
     inline void flip_reader()
     {
-        if(dirty)
+        if(middle_.load(std::memory_order_relaxed) & UPDATED)
         {
-            std::swap(transforms_[1], transforms_[2]);
-            dirty = false;
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
         }
     }
 
   private:
-    btTransform* transforms_[3];
-    bool dirty;
+    // flag marking the intermediate buffer as not yet read
+    static const unsigned UPDATED = 4;
+    static const unsigned INDEX = 3;
+
+    // transforms_[0] belongs to Bullet, the others form the triple buffer
+    btTransform* transforms_[4];
+    unsigned back_;
+    std::atomic<unsigned> middle_;
+    unsigned front_;
 };
 
 } // namespace physics
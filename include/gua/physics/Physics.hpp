@@ -28,12 +28,12 @@
 #include <gua/physics/CollisionShapeNodeVisitor.hpp>
 #include <gua/physics/RigidBodyNode.hpp>
 #include <gua/utils/SpinLock.hpp>
+#include <gua/concurrent/MPSCQueue.hpp>
 
 #include <btBulletDynamicsCommon.h>
 
 // external headers
 #include <vector>
-#include <queue>
 #include <atomic>
 #include <thread>
 #include <mutex>
@@ -45,6 +45,7 @@ class btBroadphaseInterface;
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 class btSequentialImpulseConstraintSolver;
+class btConstraintSolverPoolMt;
 
 namespace gua
 {
@@ -79,8 +80,12 @@ class GUA_DLL Physics
      * \param gravity        Global gravity in m/s. Applies to Y axis only.
      * \param fixed_timestep Fixed internal timestep in seconds. See
      *                       set_fixed_timestep() description for more details.
+     * \param parallel_islands If true, disjoint simulation islands are solved
+     *                       in parallel on the thread pool. This requires
+     *                       Bullet 2.88 or newer built with BT_THREADSAFE;
+     *                       otherwise the world is stepped serially.
      */
-    Physics(float gravity, float fixed_timestep);
+    Physics(float gravity, float fixed_timestep, bool parallel_islands = false);
 
     /**
      * Destructor.
@@ -237,6 +242,7 @@ class GUA_DLL Physics
      * Invoke a given function just before the next simulation step.
      *
      * The function fun will be invoked once before the next simulation step.
+     * This method never blocks and may be called from any thread.
      *
      * \param fun Callback function.
      */
@@ -280,9 +286,6 @@ class GUA_DLL Physics
     // the simulation thread entry point.
     void simulate();
 
-    // pop front element from call-once queue
-    bool pop_call_once(std::function<void()>& value);
-
     // ensures exclusive access to the physics structures.
     mutable std::mutex simulation_mutex_;
 
@@ -290,9 +293,6 @@ class GUA_DLL Physics
     // the same time.
     mutable std::mutex start_stop_mutex_;
 
-    // ensures exclusive access to buffers in motion state updates.
-    mutable SpinLock motion_state_update_mutex_;
-
     SpinLock pause_mutex_;
 
     std::thread* thread_ = nullptr;
@@ -305,15 +305,15 @@ class GUA_DLL Physics
 
     CollisionShapeNodeVisitor shape_visitor_;
 
-    // queue for call-once functions
-    std::queue<std::function<void()>> call_once_queue_;
-    std::mutex call_once_queue_mutex_;
+    // queue for call-once functions, consumed by the simulation thread
+    concurrent::MPSCQueue<std::function<void()>> call_once_queue_;
 
     // Bullet's objects
     btBroadphaseInterface* broadphase_ = nullptr;
     btDefaultCollisionConfiguration* collision_configuration_ = nullptr;
     btCollisionDispatcher* dispatcher_ = nullptr;
     btSequentialImpulseConstraintSolver* solver_ = nullptr;
+    btConstraintSolverPoolMt* solver_pool_ = nullptr;
     btDynamicsWorld* dw_ = nullptr;
     std::vector<std::shared_ptr<RigidBodyNode>> rigid_bodies_;
     std::vector<Constraint*> constraints_;
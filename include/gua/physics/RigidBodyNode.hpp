@@ -355,6 +355,8 @@ class GUA_DLL RigidBodyNode : public node::TransformNode
     // collision shape.
     void sync_shapes(bool do_not_lock = false);
 
+    // get_transform() marks the node dirty, which is not thread-safe
+    bool supports_flat_update() const override { return false; }
     std::shared_ptr<node::Node> copy() const override;
 
     // Indicates if the body includes shapes that support static objects only.
@@ -55,7 +55,10 @@ class DepthCubeMap : public RenderTarget
 
     void remove_buffers(RenderContext const& ctx) override;
 
+    // starts an asynchronous download of the depth values
     void retrieve_data(RenderContext const& ctx, float near_clip, float far_clip);
+    // returns true, if a finished download has been converted to distances
+    bool fetch_data(RenderContext const& ctx);
 
     scm::gl::texture_2d_ptr const& get_depth_buffer() const override;
 
@@ -47,6 +47,7 @@ class DepthCubeMapRenderer
   private:
     void prepare_depth_cubemap(node::CubemapNode const& cube_map_node, Pipeline& pipe);
     void download_depth_cubemap(node::CubemapNode& cube_map_node, Pipeline const& pipe) const;
+    void fetch_depth_cubemap(node::CubemapNode& cube_map_node, Pipeline const& pipe) const;
 
     void generate_depth_cubemap_face(unsigned face, node::CubemapNode const& cube_map_node, Pipeline& pipe) const;
 
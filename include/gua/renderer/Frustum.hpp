@@ -27,6 +27,8 @@
 #include <gua/math/math.hpp>
 #include <gua/scenegraph/PickResult.hpp>
 
+#include <array>
+#include <cstdint>
 #include <set>
 
 namespace gua
@@ -64,6 +66,19 @@ class GUA_DLL Frustum
     inline math::mat4::value_type get_clip_far() const { return clip_far_; }
 
     bool intersects(math::BoundingBox<math::vec3> const& bbox, std::vector<math::vec4> const& global_planes = {}) const;
+
+    /**
+     * Tests several bounding boxes against the frustum and the given global
+     * planes at once. The boxes are processed in packs of four using AVX or
+     * SSE2 instructions, if available.
+     *
+     * \param boxes          Pointer to count bounding boxes.
+     * \param count          The number of bounding boxes.
+     * \param global_planes  Additional clipping planes.
+     * \param results        Receives 1 for each box which is (partially)
+     *                       inside, 0 otherwise. Has to hold count elements.
+     */
+    void intersects(math::BoundingBox<math::vec3> const* boxes, std::size_t count, std::vector<math::vec4> const& global_planes, std::uint8_t* results) const;
     bool contains(math::vec3 const& point) const;
 
     std::set<PickResult> const ray_test(node::RayNode const& ray, int options = PickResult::PICK_ALL);
@@ -80,7 +95,7 @@ class GUA_DLL Frustum
     math::mat4 screen_transform_;
     math::mat4 projection_;
     mutable math::mat4 view_;
-    std::vector<math::vec4> planes_;
+    std::array<math::vec4, 6> planes_;
     math::mat4::value_type clip_near_;
     math::mat4::value_type clip_far_;
 };
@@ -0,0 +1,146 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef GUA_LIGHT_CLUSTERER_HPP
+#define GUA_LIGHT_CLUSTERER_HPP
+
+// guacamole headers
+#include <gua/platform.hpp>
+#include <gua/math/math.hpp>
+#include <gua/renderer/LightTable.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace gua
+{
+/**
+ * Assigns point and spot lights to the tiles of the light table on the CPU.
+ *
+ * The view frustum is divided into the screen space tiles of the light table
+ * and into exponentially distributed depth slices. Each light is tested
+ * against the view space bounding boxes of the tile / slice cells (froxels)
+ * it may touch: point lights with a sphere test, spot lights additionally
+ * with a cone test. As the light table stores no depth, the bits of all
+ * slices of a tile are merged; the depth slices only make the result tighter
+ * than a test against the whole tile frustum.
+ *
+ * Slices are processed in parallel, tiles are tested four at a time with
+ * SSE2 where available.
+ */
+class GUA_DLL LightClusterer
+{
+  public:
+    /**
+     * Constructor.
+     *
+     * \param depth_slices  Number of depth slices between the near and far
+     *                      clipping plane.
+     */
+    explicit LightClusterer(unsigned depth_slices = 16);
+
+    void set_depth_slices(unsigned depth_slices);
+    unsigned get_depth_slices() const { return depth_slices_; }
+
+    /**
+     * Assigns the lights to the tiles of the given view.
+     *
+     * \param view            View matrix of the rendering frustum.
+     * \param projection      Projection matrix of the rendering frustum.
+     * \param resolution      Resolution of the rendered image in pixels.
+     * \param tile_power      Tiles are 2^tile_power pixels wide and high.
+     * \param lights          The lights as passed to LightTable::invalidate(),
+     *                        with the sun lights at the back.
+     * \param sun_lights_num  Number of sun lights. They light every tile and
+     *                        are not stored in the bitset.
+     *
+     * \return                The number of tiles in x and y direction.
+     */
+    math::vec2ui assign(math::mat4 const& view, math::mat4 const& projection, math::vec2ui const& resolution, int tile_power, LightTable::array_type const& lights, unsigned sun_lights_num);
+
+    /**
+     * Returns one bit per light and tile, in the layout of the light table's
+     * bitset: bit i % 32 of word (i / 32 * tiles.y + y) * tiles.x + x is set,
+     * if light i may illuminate tile (x, y). Row 0 is at the bottom.
+     */
+    std::vector<std::uint32_t> const& get_light_bitset() const { return light_bitset_; }
+
+    math::vec2ui const& get_tiles() const { return tiles_; }
+    unsigned get_words() const { return words_; }
+
+  private:
+    // a point or spot light in view space
+    struct Light
+    {
+        float center[3]; // bounding sphere
+        float radius;
+        float origin[3]; // spot lights only
+        float range;
+        float direction[3];
+        float cos_angle;
+        float sin_angle;
+        unsigned index;
+        bool spot;
+    };
+
+    // the tiles of one slice touched by the bounding sphere of a light
+    struct Rect
+    {
+        unsigned light;
+        unsigned min_x, max_x, min_y, max_y;
+        float radius2; // squared radius left after the depth distance
+    };
+
+    // the parts of the cone test shared by all froxels of a row
+    struct ConeRow
+    {
+        float extent2; // squared y and z half extents of the froxels
+        float length2; // squared y and z distance to the apex
+        float axial;   // y and z part of the distance along the axis
+    };
+
+    void compute_bounds(math::mat4 const& projection, math::vec2ui const& resolution, unsigned tile_size);
+    void transform_lights(math::mat4 const& view, LightTable::array_type const& lights, unsigned count);
+    void collect_rects(unsigned slice);
+    void fill_rows(unsigned begin, unsigned end);
+
+    ConeRow make_cone_row(Light const& light, unsigned slice, unsigned y) const;
+    static bool cone_intersects(Light const& light, ConeRow const& row, float center_x, float extent_x);
+
+    unsigned depth_slices_;
+    math::vec2ui tiles_;
+    unsigned words_ = 0;
+
+    std::vector<float> slice_depths_; // view space distances, depth_slices_ + 1
+    std::vector<float> column_min_;   // x bounds per slice and column
+    std::vector<float> column_max_;
+    std::vector<float> row_min_; // y bounds per slice and row
+    std::vector<float> row_max_;
+
+    std::vector<Light> lights_;
+    std::vector<std::vector<Rect>> rects_; // per slice
+    std::vector<std::uint32_t> light_bitset_;
+};
+
+} // namespace gua
+
+#endif // GUA_LIGHT_CLUSTERER_HPP
@@ -8,6 +8,9 @@
 
 #include <gua/renderer/Texture3D.hpp>
 
+#include <cstdint>
+#include <vector>
+
 namespace gua
 {
 class LightTable
@@ -52,6 +55,9 @@ class LightTable
 
     math::vec2ui invalidate(RenderContext const& ctx, math::vec2ui const& resolution, array_type const& lights, int tile_power, int sun_lights_num);
 
+    // uploads a bitset computed on the CPU, see LightClusterer
+    void upload_light_bitset(RenderContext const& ctx, math::vec2ui const& tiles, std::vector<std::uint32_t> const& bitset);
+
     std::shared_ptr<Texture3D> const& get_light_bitset() const { return light_bitset_; }
     int get_lights_num() const { return lights_num_; }
     int get_sun_lights_num() const { return sun_lights_num_; }
@@ -40,6 +40,23 @@ class GUA_DLL LightVisibilityPassDescription : public PipelinePassDescription
     }
     unsigned tile_power() const { return tile_power_; }
 
+    // assign lights to tiles on the CPU instead of rasterizing light proxies;
+    // the rasterization mode is ignored then
+    LightVisibilityPassDescription& cpu_clustering(bool enable)
+    {
+        cpu_clustering_ = enable;
+        return *this;
+    }
+    bool cpu_clustering() const { return cpu_clustering_; }
+
+    // number of depth slices used by the CPU clustering
+    LightVisibilityPassDescription& depth_slices(unsigned slices)
+    {
+        depth_slices_ = std::max(slices, 1u);
+        return *this;
+    }
+    unsigned depth_slices() const { return depth_slices_; }
+
     std::shared_ptr<PipelinePassDescription> make_copy() const override;
     friend class Pipeline;
 
@@ -47,6 +64,8 @@ class GUA_DLL LightVisibilityPassDescription : public PipelinePassDescription
     PipelinePass make_pass(RenderContext const&, SubstitutionMap&) override;
     RasterizationMode rasterization_mode_ = AUTO;
     int tile_power_ = 2;
+    bool cpu_clustering_ = false;
+    unsigned depth_slices_ = 16;
 };
 
 } // namespace gua
@@ -3,6 +3,7 @@
 
 #include <gua/renderer/PipelinePass.hpp>
 #include <gua/renderer/LightTable.hpp>
+#include <gua/renderer/LightClusterer.hpp>
 
 namespace gua
 {
@@ -15,6 +16,9 @@ class LightVisibilityRenderer
 
     void render(PipelinePass& pass, Pipeline& pipe, int tile_power, unsigned ms_sample_count, bool enable_conservative, bool enable_fullscreen_fallback);
 
+    // assigns the lights to the tiles on the CPU instead of drawing proxies
+    void render_clustered(Pipeline& pipe, int tile_power, unsigned depth_slices);
+
   private:
     void draw_lights(Pipeline& pipe, std::vector<math::mat4>& transforms, LightTable::array_type& lights) const;
 
@@ -28,6 +32,8 @@ class LightVisibilityRenderer
 
     scm::gl::frame_buffer_ptr empty_fbo_ = nullptr;
     scm::gl::texture_2d_ptr empty_fbo_color_attachment_ = nullptr;
+
+    LightClusterer clusterer_;
 };
 
 } // namespace gua
@@ -95,6 +95,10 @@ class LineStripResource : public GeometryResource
     void compile_buffer_string(std::string& buffer_string);
     void uncompile_buffer_string(std::string const& buffer_string);
 
+    std::size_t max_sync_size() const;
+    std::size_t write_sync(char* buffer, std::size_t capacity, bool delta = true, float precision = 0.0f);
+    bool read_sync(char const* buffer, std::size_t size);
+
     void push_vertex(LineStrip::Vertex const& in_vertex);
     void pop_front_vertex();
     void pop_back_vertex();
@@ -24,6 +24,7 @@
 
 #include <gua/renderer/ViewDependentUniform.hpp>
 
+#include <atomic>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -69,12 +70,14 @@ class GUA_DLL Material
             tmp.set(view_id, UniformValue(val));
             uniforms_[name] = tmp;
         }
+        ++version_;
         return *this;
     }
 
     Material& reset_uniform(std::string const& name, int view_id)
     {
         uniforms_[name].reset(view_id);
+        ++version_;
         return *this;
     }
 
@@ -108,6 +111,33 @@ class GUA_DLL Material
 
     void apply_uniforms(RenderContext const& ctx, ShaderProgram* shader, int view) const;
 
+    /**
+     * Binds a uniform buffer holding the uniforms for the given view, for
+     * shaders generated with MaterialShader::generate_substitution_map(true).
+     *
+     * The buffer is kept per context and is only updated if a uniform
+     * changed since it was bound last; texture handles are checked once
+     * per frame.
+     */
+    void bind_uniform_block(RenderContext const& ctx, int view) const;
+
+    /**
+     * Reports the screen space size of an object using this material for
+     * its textures which are still being streamed, see
+     * TextureDatabase::request_visible(). Only textures found while
+     * updating the uniform block of the given view are considered.
+     */
+    void request_textures(RenderContext const& ctx, int view, float screen_size) const;
+
+#ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
+    /**
+     * Returns the global texture id selecting the virtual texture of this
+     * material (gua_current_vt_idx), as found while updating the uniform
+     * block of the given view. The uniform block does not contain it.
+     */
+    int get_virtual_texture_index(RenderContext const& ctx, int view) const;
+#endif
+
     std::ostream& serialize_uniforms_to_stream(std::ostream& os) const;
     void set_uniforms_from_serialized_string(std::string const& value);
 
@@ -167,6 +197,7 @@ class GUA_DLL Material
     Material& set_uniform(std::string const& name, ViewDependentUniform const& value)
     {
         uniforms_[name] = value;
+        ++version_;
         return *this;
     }
 
@@ -183,6 +214,10 @@ class GUA_DLL Material
 #endif
 
     mutable std::mutex mutex_;
+
+    // identifies the material's uniform blocks, see bind_uniform_block()
+    std::size_t id_;
+    std::atomic<unsigned> version_;
 };
 
 template <>
@@ -30,6 +30,8 @@
 // external headers
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace Assimp
 {
@@ -51,6 +53,40 @@ class GeometryNode;
 class GUA_DLL MaterialLoader
 {
   public:
+    /**
+     * A material read from a file, which is created later on.
+     */
+    struct Description
+    {
+        // see PBSMaterialFactory::Capabilities
+        unsigned capabilities = 0;
+
+        // the shader is renamed to this name unless it is empty
+        std::string name;
+
+        std::vector<std::pair<std::string, UniformValue>> uniforms;
+
+        /**
+         * Returns the shader name and uniforms of the created material as
+         * stored by the TriMeshCache, without creating it.
+         *
+         * \return  False if the shader is renamed, since such materials
+         *          cannot be restored.
+         */
+        bool serialize(std::string& shader_name, std::string& serialized_uniforms) const;
+    };
+
+    /**
+     * Reads a material without accessing any database, hence it may be
+     * called on any thread.
+     */
+    Description describe_material(aiMaterial const* material, std::string const& assets_directory, bool optimize_material = true, bool nrp = false) const;
+
+    /**
+     * Creates a material read by describe_material().
+     */
+    std::shared_ptr<Material> create_material(Description const& description) const;
+
     std::shared_ptr<Material> load_material(aiMaterial const* material, std::string const& assets_directory, bool optimize_material = true, bool nrp = false) const;
 #ifdef GUACAMOLE_FBX
     std::shared_ptr<Material> load_material(FbxSurfaceMaterial const& material, std::string const& assets_directory, bool optimize_material = true, bool nrp = false) const;
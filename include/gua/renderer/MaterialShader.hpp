@@ -41,6 +41,17 @@ class ShaderProgram;
 class GUA_DLL MaterialShader
 {
   public:
+    // binding point of the uniform block holding the material's uniforms
+    static const unsigned UNIFORM_BLOCK_BINDING = 5;
+
+    // a uniform and its location in the std140 uniform block
+    struct UniformBlockMember
+    {
+        std::string name;
+        unsigned offset;
+        unsigned size;
+    };
+
     MaterialShader(std::string const& name, std::shared_ptr<MaterialShaderDescription> const& desc);
 
     std::shared_ptr<MaterialShaderDescription> const& get_description() const;
@@ -52,12 +63,31 @@ class GUA_DLL MaterialShader
     std::list<std::shared_ptr<MaterialShaderMethod>> const& get_vertex_methods() const;
     std::list<std::shared_ptr<MaterialShaderMethod>> const& get_fragment_methods() const;
 
-    SubstitutionMap generate_substitution_map() const;
+    /**
+     * If uniform_block is set, the material's uniforms are declared in a
+     * std140 uniform block at UNIFORM_BLOCK_BINDING, which has to be bound
+     * with Material::bind_uniform_block(). Otherwise they are plain uniforms
+     * which are set with Material::apply_uniforms().
+     */
+    SubstitutionMap generate_substitution_map(bool uniform_block = false) const;
+
+    std::vector<UniformBlockMember> const& get_uniform_block_members() const { return uniform_block_members_; }
+
+    // in bytes, zero if the material has no uniforms
+    unsigned get_uniform_block_size() const { return uniform_block_size_; }
+
+    // texture handles may change when textures are (re)loaded
+    bool get_uniform_block_has_textures() const { return uniform_block_has_textures_; }
 
   private:
     std::shared_ptr<MaterialShaderDescription> desc_;
 
     std::map<std::string, ViewDependentUniform> default_uniforms_;
+
+    std::vector<UniformBlockMember> uniform_block_members_;
+    unsigned uniform_block_size_ = 0;
+    bool uniform_block_has_textures_ = false;
+
     std::string name_;
 };
 
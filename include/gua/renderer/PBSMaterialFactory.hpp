@@ -52,6 +52,12 @@ class GUA_DLL PBSMaterialFactory
 
     static std::shared_ptr<Material> create_material(Capabilities const& capabilities);
     static std::string const material_name_from_capabilites(Capabilities const& capabilities);
+
+    /**
+     * Inverse of material_name_from_capabilites(). Unknown parts of the name
+     * are ignored.
+     */
+    static Capabilities capabilities_from_material_name(std::string const& material_name);
 };
 
 } // namespace gua
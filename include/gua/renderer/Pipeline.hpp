@@ -133,7 +133,10 @@ class GUA_DLL Pipeline
   private:
     void bind_camera_uniform_block(unsigned location) const;
 
-    void render_shadow_map(LightTable::LightBlock& light_block, Frustum const& frustum, unsigned cascade_id, unsigned viewport_size, bool redraw);
+    void serialize_views(CameraMode mode, node::SerializedCameraNode const& camera, std::vector<std::unique_ptr<const SceneGraph>> const& scene_graphs) const;
+    std::vector<std::shared_ptr<SerializedScene>> serialize_shadow_views(std::vector<Frustum> const& frustums, bool redraw) const;
+
+    void render_shadow_map(LightTable::LightBlock& light_block, Frustum const& frustum, std::shared_ptr<SerializedScene> const& scene, unsigned cascade_id, unsigned viewport_size, bool redraw);
 
     void generate_shadow_map_sunlight(
         std::shared_ptr<ShadowMap> const& shadowmap, node::LightNode& light, LightTable::LightBlock& light_block, unsigned viewport_size, bool redraw, math::mat4 const& original_screen_transform);
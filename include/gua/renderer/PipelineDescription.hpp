@@ -68,19 +68,35 @@ class GUA_DLL PipelineDescription
     std::shared_ptr<DebugViewPassDescription> const get_debug_view_pass() const;
     std::shared_ptr<SSAAPassDescription> const get_ssaa_pass() const;
 
-    void set_enable_abuffer(bool value) { enable_abuffer_ = value; }
+    void set_enable_abuffer(bool value)
+    {
+        enable_abuffer_ = value;
+        touch();
+    }
 
     bool get_enable_abuffer() const { return enable_abuffer_; }
 
-    void set_abuffer_size(size_t value) { abuffer_size_ = value; }
+    void set_abuffer_size(size_t value)
+    {
+        abuffer_size_ = value;
+        touch();
+    }
 
     size_t get_abuffer_size() const { return abuffer_size_; }
 
-    void set_blending_termination_threshold(float value) { blending_termination_threshold_ = std::max(std::min(value, 1.f), .5f); }
+    void set_blending_termination_threshold(float value)
+    {
+        blending_termination_threshold_ = std::max(std::min(value, 1.f), .5f);
+        touch();
+    }
 
     float get_blending_termination_threshold() const { return blending_termination_threshold_; }
 
-    void set_max_lights_count(int value) { max_lights_count_ = value; }
+    void set_max_lights_count(int value)
+    {
+        max_lights_count_ = value;
+        touch();
+    }
 
     int get_max_lights_count() const { return max_lights_count_; }
 
@@ -88,6 +104,18 @@ class GUA_DLL PipelineDescription
 
     void* get_user_data() const { return user_data_; }
 
+    /**
+     * Assigns a new version to the description. This is done by all setters
+     * and needs to be called only if the passes are modified directly.
+     */
+    void touch() { version_ = make_pipeline_description_version(); }
+
+    /**
+     * The version changes whenever the description itself is modified. Changes
+     * of its passes are tracked by the passes.
+     */
+    std::size_t get_version() const { return version_; }
+
     bool operator==(PipelineDescription const& other) const;
     bool operator!=(PipelineDescription const& other) const;
     PipelineDescription& operator=(PipelineDescription const& other);
@@ -106,7 +134,11 @@ class GUA_DLL PipelineDescription
         throw std::runtime_error("PipelinePassDescription::get_pass_by_type: No such pass in PipelineDescription");
     }
 
-    inline void clear() { passes_.clear(); }
+    inline void clear()
+    {
+        passes_.clear();
+        touch();
+    }
 
   private:
     std::vector<std::shared_ptr<PipelinePassDescription>> passes_;
@@ -115,6 +147,7 @@ class GUA_DLL PipelineDescription
     size_t abuffer_size_ = 800; // in MiB
     float blending_termination_threshold_ = 0.99f;
     int max_lights_count_ = 128;
+    std::size_t version_ = make_pipeline_description_version();
 };
 
 } // namespace gua
@@ -57,6 +57,61 @@ class GUA_DLL PipelinePassPrivate
     std::function<void(PipelinePass&, PipelinePassDescription const&, Pipeline&)> process_;
 };
 
+/**
+ * Returns a new, process-wide unique version number.
+ *
+ * PipelineDescriptions, their passes and the uniforms of the passes take a new
+ * one on every modification. As numbers are never handed out twice, equal
+ * versions imply that one object is an unmodified copy of the other.
+ */
+GUA_DLL std::size_t make_pipeline_description_version();
+
+/**
+ * The uniform values of a PipelinePassDescription.
+ *
+ * Behaves like a std::map, but every non-const access assigns a new version.
+ * Pipelines compare versions to update their copies only when needed.
+ */
+class GUA_DLL PipelinePassUniforms
+{
+  public:
+    typedef std::map<std::string, UniformValue> Map;
+    typedef Map::const_iterator const_iterator;
+
+    UniformValue& operator[](std::string const& name)
+    {
+        version_ = make_pipeline_description_version();
+        return values_[name];
+    }
+
+    std::size_t erase(std::string const& name)
+    {
+        version_ = make_pipeline_description_version();
+        return values_.erase(name);
+    }
+
+    void clear()
+    {
+        version_ = make_pipeline_description_version();
+        values_.clear();
+    }
+
+    const_iterator find(std::string const& name) const { return values_.find(name); }
+    std::size_t count(std::string const& name) const { return values_.count(name); }
+
+    const_iterator begin() const { return values_.begin(); }
+    const_iterator end() const { return values_.end(); }
+    std::size_t size() const { return values_.size(); }
+    bool empty() const { return values_.empty(); }
+
+    Map const& get() const { return values_; }
+    std::size_t version() const { return version_; }
+
+  private:
+    Map values_;
+    std::size_t version_ = make_pipeline_description_version();
+};
+
 class GUA_DLL PipelinePassDescription
 {
   public:
@@ -68,7 +123,7 @@ class GUA_DLL PipelinePassDescription
 
     void touch();
     std::string const& name() const;
-    unsigned mod_count() const;
+    std::size_t mod_count() const;
 
   protected:
     virtual PipelinePass make_pass(RenderContext const& ctx, SubstitutionMap& substitution_map) = 0;
@@ -83,14 +138,15 @@ class GUA_DLL PipelinePassDescription
     bool fragment_shader_is_file_name_ = true;
     bool geometry_shader_is_file_name_ = true;
 
-    unsigned mod_count_ = 0;
+    // changed by touch(), unique among all passes which are not copies
+    std::size_t mod_count_ = make_pipeline_description_version();
     mutable bool recompile_shaders_ = true;
 
     PipelinePassPrivate private_;
     std::vector<std::shared_ptr<PipelineResponsibilityDescription>> pipeline_responsibilities_;
 
   public:
-    std::map<std::string, UniformValue> uniforms;
+    PipelinePassUniforms uniforms;
 
     void set_user_data(void* data) { user_data_ = data; }
     void* get_user_data() const { return user_data_; }
@@ -39,6 +39,7 @@
 #include <scm/gl_core/window_management/display.h>
 #include <scm/gl_core/window_management/surface.h>
 #include <atomic>
+#include <list>
 
 namespace gua
 {
@@ -169,6 +170,63 @@ struct GUA_DLL RenderContext
     mutable std::unordered_map<std::size_t, std::vector<scm::gl::texture_2d_ptr>> texture_2d_arrays;
     mutable std::unordered_map<std::size_t, std::vector<scm::gl::texture_3d_ptr>> texture_3d_arrays;
 
+    class MaterialUniformBlock
+    {
+      public:
+        scm::gl::buffer_ptr buffer;
+        std::vector<char> data;
+        unsigned version = 0;
+        unsigned framecount = 0;
+
+        // framecount of the last bind, see evict_material_uniform_blocks()
+        unsigned last_used = 0;
+
+        // textures referenced by the block which have not arrived yet
+        std::vector<std::string> loading_textures;
+
+#ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
+        // global id of the last texture in the block, see
+        // Material::get_virtual_texture_index()
+        int virtual_texture_index = 0;
+#endif
+    };
+
+    /**
+     * Uniform blocks of materials, see Material::bind_uniform_block()
+     */
+    mutable std::unordered_map<std::size_t, MaterialUniformBlock> material_uniform_blocks;
+
+    /**
+     * Number of frames after which uniform blocks which have not been bound
+     * are released, e.g. since their Material has been destroyed.
+     */
+    static const unsigned MATERIAL_UNIFORM_BLOCK_LIFETIME = 600;
+
+    /**
+     * Releases the uniform blocks which have not been bound during the last
+     * MATERIAL_UNIFORM_BLOCK_LIFETIME frames. Called once per frame, sweeps
+     * the blocks only every MATERIAL_UNIFORM_BLOCK_LIFETIME frames.
+     */
+    void evict_material_uniform_blocks() const;
+
+    class CachedShaderProgram
+    {
+      public:
+        scm::gl::program_ptr program;
+
+        // compared on lookup, since programs are only keyed by a hash
+        std::vector<std::pair<scm::gl::shader_stage, std::string>> sources;
+        std::list<std::string> interleaved_stream_capture;
+        bool in_rasterization_discard = false;
+    };
+
+    /**
+     * Linked programs by hash of their expanded sources, see
+     * ShaderProgram::upload_to(). They outlive the ShaderPrograms which
+     * are recreated whenever a Pipeline changes.
+     */
+    mutable std::unordered_map<std::size_t, CachedShaderProgram> shader_programs;
+
     /**
      * Resources associated with this context
      */
@@ -84,7 +84,23 @@ class GUA_DLL Renderer
 
     inline float get_application_fps() { return application_fps_.fps; }
 
+    /**
+     * Enables structural sharing of the SceneGraph copies passed to the
+     * rendering threads.
+     *
+     * If enabled, only the paths to modified Nodes are copied each frame
+     * instead of the entire graph (see SceneGraph::snapshot()). Properties
+     * which are not tracked automatically have to be announced with
+     * Node::invalidate_snapshot(). Disabled by default.
+     *
+     * \param enable           Whether snapshots should be shared.
+     */
+    void set_enable_snapshot_sharing(bool enable);
+    bool get_enable_snapshot_sharing() const;
+
   private:
+    std::shared_ptr<const SceneGraphs> make_snapshot(std::vector<SceneGraph const*> const& scene_graphs);
+
     void send_renderclient(std::string const& window, std::shared_ptr<const Renderer::SceneGraphs> sgs, node::CameraNode* cam, bool alternate_frame_rendering);
 
     struct Item
@@ -108,6 +124,8 @@ class GUA_DLL Renderer
     std::map<std::string, Renderclient> render_clients_;
 
     FpsCounter application_fps_;
+
+    bool enable_snapshot_sharing_ = false;
 };
 
 } // namespace gua
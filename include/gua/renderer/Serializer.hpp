@@ -22,7 +22,9 @@
 #ifndef GUA_SERIALIZER_HPP
 #define GUA_SERIALIZER_HPP
 
+#include <cstdint>
 #include <stack>
+#include <vector>
 
 // guacamole headers
 #include <gua/renderer/SerializedScene.hpp>
@@ -43,11 +45,33 @@ class SerializableNode;
 /**
  * This class is used to convert the scengraph to a (opimized) sequence.
  *
- * It serializes the scene graph.
+ * It serializes the scene graph. Several views may be serialized at once: each
+ * Node is then tested against all views which can see its parent, so the
+ * graph is traversed only once. The children of a Node are culled together,
+ * using Frustum's batched intersection test. Subtrees are distributed to the
+ * ThreadPool.
  */
 class Serializer : public NodeVisitor
 {
   public:
+    /**
+     * The maximum number of views which are culled in a single traversal.
+     * Additional views are processed in further traversals.
+     */
+    static const unsigned MAX_VIEWS = 64;
+
+    /**
+     * A view for which the scene graph is serialized. Frustums and reference
+     * camera position have to be set on the output beforehand.
+     */
+    struct View
+    {
+        SerializedScene* output;
+        Mask mask;
+        bool enable_frustum_culling;
+        int view_id;
+    };
+
     /**
      * Constructor.
      *
@@ -65,6 +89,15 @@ class Serializer : public NodeVisitor
      */
     void check(SerializedScene& output, SceneGraph const& scene_graph, Mask const& mask, bool enable_frustum_culling, int view_id);
 
+    /**
+     * Takes the Scenegraph and processes geometry, light and camera lists for
+     * several views in a single traversal.
+     *
+     * \param views                The views to be processed.
+     * \param scene_graph          The SceneGraph to be processed.
+     */
+    void check(std::vector<View> const& views, SceneGraph const& scene_graph);
+
     /**
      * Visits a TransformNode
      *
@@ -93,19 +126,47 @@ class Serializer : public NodeVisitor
     void visit(node::SerializableNode* geometry) override;
 
   private:
-    bool is_visible(node::Node* node) const;
-    bool check_clipping_planes(node::Node* node) const;
-
-    void visit_children(node::Node* node);
-
-    Frustum culling_frustum_;
-    Frustum rendering_frustum_;
-    Mask render_mask_;
-
-    SerializedScene* data_;
-
-    bool enable_frustum_culling_;
-    bool enable_alternative_frustum_culling_;
+    struct ViewState
+    {
+        // receives the serialized nodes and bounding boxes
+        SerializedScene* output;
+        // provides frustums, clipping planes and camera position
+        SerializedScene const* scene;
+        Mask const* mask;
+        bool enable_frustum_culling;
+        bool enable_alternative_frustum_culling;
+    };
+
+    struct Subtree
+    {
+        node::Node* node;
+        std::uint64_t views;
+    };
+
+    void check_batch(std::vector<View>::const_iterator begin, std::vector<View>::const_iterator end, SceneGraph const& scene_graph);
+    unsigned get_split_depth(node::Node* root) const;
+
+    void cull(std::shared_ptr<node::Node> const* nodes, std::size_t count, std::uint64_t views, std::uint64_t* visible_views);
+    std::uint64_t get_visible_views(node::Node* node) const;
+
+    void traverse(node::Node* node, std::uint64_t views);
+    void visit_children(node::Node* node, std::uint64_t views);
+
+    std::vector<ViewState> views_;
+    std::uint64_t active_views_;
+
+    // scratch buffers of cull()
+    std::vector<math::BoundingBox<math::vec3>> boxes_;
+    std::vector<std::uint8_t> has_boxes_;
+    std::vector<std::uint8_t> rendering_results_;
+    std::vector<std::uint8_t> culling_results_;
+
+    // visible views of the children of the node being visited, per depth
+    std::vector<std::vector<std::uint64_t>> child_views_;
+
+    unsigned depth_;
+    unsigned split_depth_;
+    std::vector<Subtree>* deferred_subtrees_;
 };
 
 } // namespace gua
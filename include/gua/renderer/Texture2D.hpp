@@ -114,5 +114,9 @@ class GUA_DLL Texture2D : public Texture
 };
 
 scm::gl::texture_image_data_ptr load_image_2d(std::string const& file, bool create_mips);
+
+// upper bound of the size of the image load_image_2d() returns, read from the
+// file header; zero if unknown
+std::size_t estimate_image_2d_size(std::string const& file, bool create_mips);
 } // namespace gua
 #endif // GUA_TEXTURE2D_HPP
@@ -0,0 +1,111 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef GUA_TEXTURE_CACHE_HPP
+#define GUA_TEXTURE_CACHE_HPP
+
+// guacamole headers
+#include <gua/platform.hpp>
+
+// external headers
+#include <scm/gl_util/data/imaging/texture_image_data.h>
+
+#include <string>
+
+namespace gua
+{
+/**
+ * Stores images loaded by load_image_2d() in a GPU-ready format.
+ *
+ * A cache file holds the complete mip chain of an image. Images with 8 bit
+ * channels are block-compressed (BC1, BC3, BC4 or BC5, depending on their
+ * channels), all others are stored as they are. Cache files are memory
+ * mapped when read and uploaded directly from the mapping, so neither the
+ * image decoder nor the mip map generation has to run. Images are expected
+ * to have their origin in the lower left corner, as load_image_2d() creates
+ * them.
+ *
+ * A cache file is ignored if it was written by a different version of this
+ * class, or if the size or modification time of its source file changed.
+ */
+class GUA_DLL TextureCache
+{
+  public:
+    /**
+     * Enables or disables the cache for all subsequently loaded images.
+     * Disabled by default.
+     */
+    static void set_enabled(bool enabled);
+    static bool get_enabled();
+
+    /**
+     * Sets the directory for cache files. If it is empty (the default), cache
+     * files are stored next to their source files.
+     *
+     * \param directory  An existing, writable directory.
+     */
+    static void set_directory(std::string const& directory);
+
+    /**
+     * Returns the directory for cache files.
+     */
+    static std::string const& get_directory();
+
+    /**
+     * Returns the path of the cache file for the given source file.
+     *
+     * \param file_name    The source file.
+     * \param create_mips  Whether a full mip chain is requested.
+     */
+    static std::string get_cache_file(std::string const& file_name, bool create_mips);
+
+    /**
+     * Restores an image from its cache file.
+     *
+     * \return  The memory mapped image, or nullptr if there is no valid
+     *          cache file.
+     */
+    static scm::gl::texture_image_data_ptr read(std::string const& file_name, bool create_mips);
+
+    /**
+     * Writes the cache file for an image which was returned by compress().
+     *
+     * \return  False if the file could not be written.
+     */
+    static bool write(std::string const& file_name, bool create_mips, scm::gl::texture_image_data_ptr const& image);
+
+    /**
+     * Block-compresses all mip levels of an image on the shared ThreadPool.
+     *
+     * \return  The compressed image, or the given image if its format cannot
+     *          be compressed.
+     */
+    static scm::gl::texture_image_data_ptr compress(scm::gl::texture_image_data_ptr const& image);
+
+  private:
+    static bool enabled_;
+    static std::string directory_;
+};
+
+} // namespace gua
+
+#endif // GUA_TEXTURE_CACHE_HPP
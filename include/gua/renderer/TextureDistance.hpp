@@ -36,6 +36,9 @@
 #include <mutex>
 #include <thread>
 
+// same declaration as in the OpenGL headers
+typedef struct __GLsync* GLsync;
+
 namespace gua
 {
 /**
@@ -57,21 +60,59 @@ class GUA_DLL TextureDistance : public Texture2D
      * \param color_format     The color format of the resulting
      *                         texture.
      * \param state_descripton The sampler state for the loaded texture.
+     * \param readback_buffers Number of downloads which may be in flight.
      */
     TextureDistance(unsigned width,
                     unsigned height,
                     scm::gl::data_format color_format,
                     unsigned mipmap_layers = 1,
-                    scm::gl::sampler_state_desc const& state_descripton = scm::gl::sampler_state_desc(scm::gl::FILTER_MIN_MAG_MIP_LINEAR, scm::gl::WRAP_CLAMP_TO_EDGE, scm::gl::WRAP_CLAMP_TO_EDGE));
+                    scm::gl::sampler_state_desc const& state_descripton = scm::gl::sampler_state_desc(scm::gl::FILTER_MIN_MAG_MIP_LINEAR, scm::gl::WRAP_CLAMP_TO_EDGE, scm::gl::WRAP_CLAMP_TO_EDGE),
+                    unsigned readback_buffers = 3);
 
     virtual ~TextureDistance() {}
 
+    /**
+     * Starts downloading the depth values into the next buffer of a ring of
+     * readback buffers, without waiting for the GPU. Only if all buffers are
+     * still in flight, the oldest download is waited for.
+     */
     void download_data(RenderContext const& ctx, float near_clip, float far_clip);
+
+    /**
+     * Converts the most recent finished download to distances.
+     *
+     * \return  True, if get_data() returns new distances.
+     */
+    bool fetch_data(RenderContext const& ctx);
+
+    /**
+     * Drops all downloads in flight and frees the readback buffers.
+     */
+    void remove_readback_buffers(RenderContext const& ctx);
+
     std::vector<float> const& get_data();
 
   protected:
   private:
-    uint32_t* texture_data_;
+    struct Readback
+    {
+        scm::gl::buffer_ptr buffer = nullptr;
+        GLsync fence = nullptr;
+        float near_clip = 0.f;
+        float far_clip = 0.f;
+    };
+
+    void convert(RenderContext const& ctx, Readback& readback);
+
+    std::vector<Readback> readbacks_;
+    unsigned next_readback_ = 0;
+    bool waited_for_readback_ = false;
+
+    // length of the ray through each texel of a face, in units of depth
+    std::vector<float> ray_lengths_;
+
+    // swapped with world_depth_data_ once a conversion is complete
+    std::vector<float> converted_data_;
     std::vector<float> world_depth_data_;
 };
 
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef GUA_TRI_MESH_CACHE_HPP
+#define GUA_TRI_MESH_CACHE_HPP
+
+// guacamole headers
+#include <gua/platform.hpp>
+#include <gua/renderer/TriMeshLoader.hpp>
+
+// external headers
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gua
+{
+namespace node
+{
+class Node;
+}
+
+/**
+ * Stores files loaded by the TriMeshLoader in a binary format.
+ *
+ * A cache file holds the interleaved vertices, indices, bounding boxes and
+ * kd-trees of all meshes of a file, together with their materials and the
+ * node hierarchy the TriMeshLoader created. Cache files are memory mapped when
+ * read and vertex data is uploaded directly from the mapping, so neither
+ * Assimp nor any post-processing has to run.
+ *
+ * A cache file is ignored if it was written by a different version of this
+ * class, or if the size or modification time of its source file changed.
+ */
+class GUA_DLL TriMeshCache
+{
+  public:
+    /**
+     * Sets the directory for cache files. If it is empty (the default), cache
+     * files are stored next to their source files.
+     *
+     * \param directory  An existing, writable directory.
+     */
+    static void set_directory(std::string const& directory);
+
+    /**
+     * Returns the directory for cache files.
+     */
+    static std::string const& get_directory();
+
+    /**
+     * Returns the path of the cache file for the given source file.
+     *
+     * \param file_name  The source file.
+     * \param flags      The TriMeshLoader::Flags it is loaded with.
+     */
+    static std::string get_cache_file(std::string const& file_name, unsigned flags);
+
+    /**
+     * Restores a file from its cache file and adds its meshes to the
+     * GeometryDatabase.
+     *
+     * \param file_name  The source file.
+     * \param flags      The TriMeshLoader::Flags it is loaded with.
+     * \param materials  If not null, the materials are not created but
+     *                   appended to this list.
+     *
+     * \return           The restored node hierarchy, or nullptr if there is
+     *                   no valid cache file.
+     */
+    static std::shared_ptr<node::Node> read(std::string const& file_name, unsigned flags, std::vector<TriMeshLoader::DeferredMaterial>* materials = nullptr);
+
+    /**
+     * Writes the cache file for a loaded file. As the materials are stored
+     * as they will be created, this may be called on any thread.
+     *
+     * \param file_name  The source file.
+     * \param flags      The TriMeshLoader::Flags it was loaded with.
+     * \param root       The node hierarchy created by the TriMeshLoader.
+     * \param materials  The materials of the hierarchy, which have not been
+     *                   created yet.
+     *
+     * \return           False if the hierarchy cannot be cached or the file
+     *                   could not be written.
+     */
+    static bool write(std::string const& file_name, unsigned flags, std::shared_ptr<node::Node> const& root, std::vector<TriMeshLoader::DeferredMaterial> const& materials);
+
+  private:
+    static std::string directory_;
+};
+
+} // namespace gua
+
+#endif // GUA_TRI_MESH_CACHE_HPP
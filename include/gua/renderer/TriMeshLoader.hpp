@@ -30,7 +30,11 @@
 // external headers
 #include <string>
 #include <list>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Assimp
 {
@@ -46,6 +50,7 @@ namespace node
 class Node;
 class InnerNode;
 class GeometryNode;
+class TriMeshNode;
 } // namespace node
 
 /**
@@ -67,9 +72,35 @@ class GUA_DLL TriMeshLoader
         NORMALIZE_SCALE = 1 << 4,
         NO_SHARED_MATERIALS = 1 << 5,
         OPTIMIZE_MATERIALS = 1 << 6,
-        PARSE_HIERARCHY = 1 << 7
+        PARSE_HIERARCHY = 1 << 7,
+        CACHE_GEOMETRY = 1 << 8, // see TriMeshCache
+        NO_BITANGENTS = 1 << 9,  // reconstructed in the vertex shader
+        NO_TANGENTS = 1 << 10    // implies NO_BITANGENTS
     };
 
+    /**
+     * A material of loaded geometry which has not been created yet.
+     *
+     * Creating materials accesses the MaterialShaderDatabase, hence it is
+     * postponed to the application thread when files are loaded on other
+     * threads.
+     */
+    struct DeferredMaterial
+    {
+        std::function<std::shared_ptr<Material>()> create;
+        std::vector<std::shared_ptr<node::TriMeshNode>> nodes;
+
+        // the material as stored by the TriMeshCache, the shader name is
+        // empty if it cannot be cached
+        std::string shader_name;
+        std::string uniforms;
+    };
+
+    /**
+     * Creates the given materials and assigns them to their nodes.
+     */
+    static void create_materials(std::vector<DeferredMaterial> const& materials);
+
   public:
     /**
      * Default constructor.
@@ -90,6 +121,39 @@ class GUA_DLL TriMeshLoader
 
     std::shared_ptr<node::Node> create_geometry_from_file(std::string const& node_name, std::string const& file_name, unsigned flags = DEFAULTS);
 
+    /**
+     * Like create_geometry_from_file(), but returns immediately.
+     *
+     * The file is imported on the worker threads of the shared ThreadPool,
+     * each of its meshes in a separate task. Until then, the returned
+     * TransformNode has no children; the loaded geometry is attached to it by
+     * apply_async_loads(), which also creates its materials.
+     *
+     * \param node_name          The name of the returned node.
+     * \param file_name          The file to load the meshes from.
+     * \param fallback_material  Used for meshes without a material.
+     * \param flags              A combination of TriMeshLoader::Flags.
+     *
+     * \return                   An empty placeholder node.
+     */
+    std::shared_ptr<node::Node> create_geometry_from_file_async(std::string const& node_name, std::string const& file_name, std::shared_ptr<Material> const& fallback_material, unsigned flags = DEFAULTS);
+
+    std::shared_ptr<node::Node> create_geometry_from_file_async(std::string const& node_name, std::string const& file_name, unsigned flags = DEFAULTS);
+
+    /**
+     * Creates the materials of all finished asynchronous loads and attaches
+     * their geometry to the placeholder nodes.
+     *
+     * This modifies the SceneGraph and thus has to be called on the thread
+     * which owns it. The Renderer does so before each frame.
+     */
+    static void apply_async_loads();
+
+    /**
+     * Returns the number of asynchronous loads which have not been applied yet.
+     */
+    static std::size_t pending_async_loads();
+
     /**
      * Constructor from a file.
      *
@@ -115,19 +179,64 @@ class GUA_DLL TriMeshLoader
     bool is_supported(std::string const& file_name) const;
 
   private: // methods
-    static std::shared_ptr<node::Node>
-    get_tree(std::shared_ptr<Assimp::Importer> const& importer, aiScene const* ai_scene, aiNode* ai_root, std::string const& file_name, unsigned flags, unsigned& mesh_count, bool enforce_hierarchy);
+    // a file imported by import_file() which is completed by finish_file()
+    struct ImportedFile
+    {
+        std::string key;
+        unsigned flags = DEFAULTS;
+        std::shared_ptr<node::Node> root;
+        std::vector<DeferredMaterial> materials;
+        bool from_loaded_files = false;
+    };
+
+    // may be called on any thread, creates no materials but writes the cache
+    // file of geometry loaded with CACHE_GEOMETRY
+    ImportedFile import_file(std::string const& file_name, unsigned flags);
+
+    // creates the materials and adds the file to loaded_files_
+    static std::shared_ptr<node::Node> finish_file(ImportedFile& file);
+
+    // copies a loaded file, a fallback_material of nullptr selects the default material
+    static std::shared_ptr<node::Node> instantiate(std::shared_ptr<node::Node> const& cached_node, std::string const& node_name, std::shared_ptr<Material> const& fallback_material, unsigned flags);
+
+    std::shared_ptr<node::Node> load(std::string const& file_name, unsigned flags, std::vector<DeferredMaterial>& materials);
+
+    static std::shared_ptr<node::Node> get_tree(std::shared_ptr<Assimp::Importer> const& importer,
+                                                aiScene const* ai_scene,
+                                                std::vector<std::shared_ptr<TriMeshRessource>> const& meshes,
+                                                aiNode* ai_root,
+                                                std::string const& file_name,
+                                                unsigned flags,
+                                                unsigned& mesh_count,
+                                                bool enforce_hierarchy,
+                                                std::vector<DeferredMaterial>& materials);
+
+    static std::shared_ptr<node::Node> create_async(std::string const& node_name, std::string const& file_name, std::shared_ptr<Material> const& fallback_material, unsigned flags);
 
     static void apply_fallback_material(std::shared_ptr<node::Node> const& root, std::shared_ptr<Material> const& fallback_material, bool no_shared_materials);
 
 #ifdef GUACAMOLE_FBX
-    static std::shared_ptr<node::Node> get_tree(FbxNode& node, std::string const& file_name, unsigned flags, unsigned& mesh_count);
+    static std::shared_ptr<node::Node>
+    get_tree(FbxNode& node, std::shared_ptr<FbxManager> const& manager, std::string const& file_name, unsigned flags, unsigned& mesh_count, std::vector<DeferredMaterial>& materials);
 
     static FbxScene* load_fbx_file(FbxManager* manager, std::string const& file_path);
 #endif
 
   private: // attributes
+    struct AsyncLoad
+    {
+        std::weak_ptr<node::Node> placeholder;
+        std::shared_ptr<Material> fallback_material;
+        unsigned flags;
+        std::future<ImportedFile> result;
+    };
+
     static std::unordered_map<std::string, std::shared_ptr<::gua::node::Node>> loaded_files_;
+    static std::mutex loaded_files_mutex_;
+
+    static std::list<AsyncLoad> async_loads_;
+    static std::mutex async_loads_mutex_;
+
     static gua::math::mat4 convert_transformation(aiMatrix4x4t<float> const& transform_mat);
     static void apply_transformation(std::shared_ptr<node::Node> node, aiMatrix4x4t<float> const& transform_mat);
 };
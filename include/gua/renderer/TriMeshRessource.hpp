@@ -26,11 +26,13 @@
 #include <gua/platform.hpp>
 #include <gua/renderer/GeometryResource.hpp>
 #include <gua/utils/Mesh.hpp>
+#include <gua/utils/InterleavedMesh.hpp>
 #include <gua/utils/KDTree.hpp>
 
 // external headers
 #include <scm/gl_core.h>
 
+#include <memory>
 #include <mutex>
 #include <thread>
 
@@ -61,12 +63,36 @@ class GUA_DLL TriMeshRessource : public GeometryResource
     /**
      * Constructor from an Assimp mesh.
      *
-     * Initializes the mesh from a given Assimp mesh.
+     * Initializes the mesh from a given Assimp mesh. The kd-tree used for
+     * picking is built on the first call to ray_test().
      *
      * \param mesh             The Assimp mesh to load the data from.
+     * \param build_kd_tree    Whether the mesh can be picked.
      */
     TriMeshRessource(Mesh const& mesh, bool build_kd_tree);
 
+    /**
+     * Constructor from interleaved vertex data.
+     *
+     * The vertex data is uploaded to each context as it is, so the mesh
+     * should be created on a loading thread.
+     *
+     * \param mesh             The interleaved mesh.
+     * \param build_kd_tree    Whether the mesh can be picked.
+     */
+    TriMeshRessource(InterleavedMesh const& mesh, bool build_kd_tree);
+
+    /**
+     * Constructor from cached data.
+     *
+     * \param mesh             The interleaved mesh. Its data is kept alive as
+     *                         long as this resource.
+     * \param kd_tree          A kd-tree for picking. If it is empty, the mesh
+     *                         cannot be picked.
+     * \param bounding_box     The bounding box of the mesh.
+     */
+    TriMeshRessource(InterleavedMesh const& mesh, KDTree const& kd_tree, math::BoundingBox<math::vec3> const& bounding_box);
+
     /**
      * Draws the Mesh.
      *
@@ -78,17 +104,23 @@ class GUA_DLL TriMeshRessource : public GeometryResource
 
     void ray_test(Ray const& ray, int options, node::Node* owner, std::set<PickResult>& hits) override;
 
-    inline unsigned int num_vertices() const { return mesh_.num_vertices; }
-    inline unsigned int num_faces() const { return mesh_.num_triangles; }
+    inline unsigned int num_vertices() const { return mesh_.get_num_vertices(); }
+    inline unsigned int num_faces() const { return mesh_.get_num_triangles(); }
 
     math::vec3 get_vertex(unsigned int i) const;
     std::vector<unsigned int> get_face(unsigned int i) const;
 
   private:
+    friend class TriMeshCache;
+
     void upload_to(RenderContext& context) const;
+    void generate_kd_tree();
 
     KDTree kd_tree_;
-    Mesh mesh_;
+    bool build_kd_tree_ = false;
+    std::once_flag kd_tree_flag_;
+
+    InterleavedMesh mesh_;
 };
 
 } // namespace gua
@@ -114,6 +114,13 @@ class GUA_DLL UniformValue
 
     void write_bytes(RenderContext const& ctx, char* target) const { write_bytes_impl_(this, ctx, target); }
 
+    // size and base alignment of the value in a std140 uniform block
+    unsigned get_std140_size() const;
+    unsigned get_std140_alignment() const;
+
+    // writes the value in std140 layout, e.g. matrix columns are padded
+    void write_std140(RenderContext const& ctx, char* target) const;
+
     void operator=(UniformValue const& to_copy)
     {
         write_bytes_impl_ = to_copy.write_bytes_impl_;
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef GUA_SCENE_BVH_HPP
+#define GUA_SCENE_BVH_HPP
+
+#include <gua/platform.hpp>
+#include <gua/math/BoundingBox.hpp>
+#include <gua/scenegraph/PickResult.hpp>
+#include <gua/utils/Mask.hpp>
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace gua
+{
+struct Ray;
+
+namespace node
+{
+class Node;
+}
+
+/**
+ * A bounding volume hierarchy over the pickable Nodes of a SceneGraph.
+ *
+ * Instead of recursing through the whole Node hierarchy, rays are tested
+ * against a binary tree of bounding boxes whose leaves refer to the Nodes
+ * with geometry (see Node::get_ray_test_mode()). Their geometry is then tested
+ * by the Nodes themselves, e.g. using the KDTree of their resources. Nodes
+ * which implement ray tests differently are tested together with their
+ * children, as if ray_test_impl() was called on them.
+ *
+ * Several rays may be tested in a single traversal of the tree.
+ *
+ * The tree is rebuilt whenever Nodes are added or removed. Otherwise, its
+ * bounding boxes are refitted to the Nodes' current bounding boxes after
+ * invalidate() has been called.
+ *
+ * \ingroup gua_scenegraph
+ */
+class GUA_DLL SceneBVH
+{
+  public:
+    /**
+     * Marks the bounding boxes of the tree as outdated, e.g. after the
+     * SceneGraph's cache has been updated.
+     */
+    void invalidate() { refit_required_ = true; }
+
+    /**
+     * Rebuilds or refits the tree if necessary.
+     *
+     * \param root  The root Node of the SceneGraph.
+     */
+    void update(node::Node* root);
+
+    /**
+     * Intersects several rays with the Nodes of the tree in a single
+     * traversal. update() has to be called before.
+     *
+     * \param rays      The Rays to be tested.
+     * \param options   int to configure the intersection process.
+     * \param mask      A mask to restrict the intersection to certain Nodes.
+     * \param hits      Receives the hits of all rays, ordered by ray and
+     *                  distance.
+     * \param offsets   Receives rays.size() + 1 offsets into hits. The hits
+     *                  of ray i are hits[offsets[i], offsets[i + 1]).
+     */
+    void ray_test(std::vector<Ray> const& rays, int options, Mask const& mask, std::vector<PickResult>& hits, std::vector<std::size_t>& offsets) const;
+
+    /**
+     * Returns the number of Nodes referenced by the leaves of the tree.
+     */
+    std::size_t size() const { return primitives_.size(); }
+
+  private:
+    struct TreeNode
+    {
+        math::BoundingBox<math::vec3> bounds;
+        // leaves: first primitive; inner nodes: index of the second child,
+        // the first child directly follows its parent
+        std::uint32_t offset;
+        // number of primitives, zero for inner nodes
+        std::uint32_t count;
+    };
+
+    // a Node referenced by the leaves of the tree
+    struct Primitive
+    {
+        node::Node* node;
+        // index of the closest ancestor whose mask may exclude it, or -1
+        int group;
+        bool test_subtree;
+    };
+
+    // a Node of RayTestMode GROUP which may exclude its descendants
+    struct Group
+    {
+        node::Node* node;
+        int parent;
+    };
+
+    void rebuild(node::Node* root);
+    void refit();
+
+    std::uint32_t build(std::vector<math::vec3> const& centers, std::vector<std::uint32_t>& indices, std::uint32_t begin, std::uint32_t end);
+
+    bool is_rejected(Primitive const& primitive, Mask const& mask, std::vector<std::int8_t>& group_results) const;
+
+    node::Node* root_ = nullptr;
+    std::size_t structure_version_ = 0;
+    bool refit_required_ = true;
+
+    std::vector<TreeNode> tree_;
+    std::vector<Primitive> primitives_;
+    std::vector<Group> groups_;
+};
+
+} // namespace gua
+
+#endif // GUA_SCENE_BVH_HPP
@@ -28,10 +28,16 @@
 #include <gua/utils/Logger.hpp>
 #include <gua/renderer/SerializedScene.hpp>
 #include <gua/renderer/enums.hpp>
+#include <gua/scenegraph/TransformHierarchy.hpp>
+#include <gua/scenegraph/SceneBVH.hpp>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 namespace gua
 {
@@ -44,6 +50,7 @@ class Node;
 class CameraNode;
 class ClippingPlaneNode;
 class RayNode;
+class ScreenNode;
 struct SerializedCameraNode;
 } // namespace node
 
@@ -77,6 +84,17 @@ class GUA_DLL SceneGraph
      */
     SceneGraph(SceneGraph const& graph);
 
+    /**
+     * Creates a read-only copy of the SceneGraph.
+     *
+     * In contrast to the copy constructor, subtrees which did not change since
+     * the last call are shared with the previously created snapshot. See
+     * Node::snapshot() for details.
+     *
+     * \return std::unique_ptr<SceneGraph> The new snapshot.
+     */
+    std::unique_ptr<SceneGraph> snapshot() const;
+
     /**
      * Adds a new Node.
      *
@@ -235,6 +253,20 @@ class GUA_DLL SceneGraph
      */
     std::shared_ptr<node::Node> operator[](std::string const& path_to_node) const;
 
+    /**
+     * Returns the ScreenNode at a given path.
+     *
+     * Other than operator[], resolved paths are cached until Nodes are added,
+     * removed or renamed. Snapshots take over the screens resolved in their
+     * original graph.
+     *
+     * \param path_to_screen              The path to the wanted ScreenNode.
+     *
+     * \return std::shared_ptr<ScreenNode> The wanted ScreenNode or nullptr if
+     *                                     there is none at the given path.
+     */
+    std::shared_ptr<node::ScreenNode> get_screen_node(std::string const& path_to_screen) const;
+
     /**
      * Assignment operator.
      *
@@ -260,10 +292,21 @@ class GUA_DLL SceneGraph
     /**
      * Updates the cache of all SceneGraph Nodes.
      *
-     * Calls Node::update_cache() on the root Node.
+     * Calls Node::update_cache() on the root Node or, if enabled, updates
+     * the SceneGraph's TransformHierarchy.
      */
     void update_cache() const;
 
+    /**
+     * Enables updating world transformations and bounding boxes with a
+     * flattened TransformHierarchy instead of recursing through all Nodes.
+     * This pays off for large scenes. Disabled by default.
+     *
+     * \param enable   Whether a TransformHierarchy should be used.
+     */
+    void set_enable_transform_hierarchy(bool enable);
+    bool get_enable_transform_hierarchy() const;
+
     /**
      * Accepts a NodeVisitor to process all SceneGraph Nodes.
      *
@@ -278,6 +321,41 @@ class GUA_DLL SceneGraph
 
     std::shared_ptr<SerializedScene> serialize(node::SerializedCameraNode const& camera, CameraMode mode) const;
 
+    /**
+     * Serializes the SceneGraph for several camera views in a single
+     * traversal.
+     *
+     * If the serialization cache is enabled, views which have been serialized
+     * before are not culled again.
+     *
+     * \param views     Pairs of camera and camera mode.
+     *
+     * \return          One SerializedScene per view.
+     */
+    std::vector<std::shared_ptr<SerializedScene>> serialize(std::vector<std::pair<node::SerializedCameraNode const*, CameraMode>> const& views) const;
+
+    /**
+     * Serializes the SceneGraph for several frustums, e.g. shadow map
+     * cascades, in a single traversal.
+     *
+     * \return          One SerializedScene per frustum.
+     */
+    std::vector<std::shared_ptr<SerializedScene>>
+    serialize(std::vector<Frustum> const& frustums, math::vec3 const& reference_camera_position, bool enable_frustum_culling, Mask const& mask, int view_id) const;
+
+    /**
+     * Enables caching of serialized camera views, keyed by camera, camera
+     * mode, mask, view id, frusta and the visible clipping planes. The cache
+     * is not invalidated
+     * when Nodes are modified, hence it should be enabled only for SceneGraph
+     * copies which do not change anymore, e.g. the ones passed to the
+     * rendering threads. Disabled by default.
+     *
+     * \param enable    Whether serialized views should be cached.
+     */
+    void set_enable_serialization_cache(bool enable);
+    bool get_enable_serialization_cache() const;
+
     /**
      * Intersects a SceneGraph with a given RayNode.
      *
@@ -292,7 +370,8 @@ class GUA_DLL SceneGraph
     /**
      * Intersects a SceneGraph with a given Ray.
      *
-     * Calls Node::ray_test() on the root Node.
+     * Calls Node::ray_test() on the root Node or, if enabled, uses the
+     * SceneGraph's SceneBVH.
      *
      * \param ray       The Ray used to check for intersections.
      * \param options   int to configure the intersection process.
@@ -300,6 +379,32 @@ class GUA_DLL SceneGraph
      */
     std::set<PickResult> const ray_test(Ray const& ray, int options = PickResult::PICK_ALL, Mask const& mask = Mask());
 
+    /**
+     * Intersects a SceneGraph with several Rays.
+     *
+     * If enabled, all Rays are tested in a single traversal of the
+     * SceneGraph's SceneBVH.
+     *
+     * \param rays      The Rays used to check for intersections.
+     * \param hits      Receives the hits of all rays, ordered by ray and
+     *                  distance.
+     * \param offsets   Receives rays.size() + 1 offsets into hits. The hits
+     *                  of ray i are hits[offsets[i], offsets[i + 1]).
+     * \param options   int to configure the intersection process.
+     * \param mask      A mask to restrict the intersection to certain Nodes.
+     */
+    void ray_test(std::vector<Ray> const& rays, std::vector<PickResult>& hits, std::vector<std::size_t>& offsets, int options = PickResult::PICK_ALL, Mask const& mask = Mask());
+
+    /**
+     * Enables testing rays against a bounding volume hierarchy of the
+     * SceneGraph's geometry instead of recursing through all Nodes. This pays
+     * off for large scenes and many rays. Disabled by default.
+     *
+     * \param enable   Whether a SceneBVH should be used.
+     */
+    void set_enable_bvh_ray_test(bool enable);
+    bool get_enable_bvh_ray_test() const;
+
     std::vector<node::CameraNode*> const& get_camera_nodes() const { return camera_nodes_; }
 
     std::vector<node::ClippingPlaneNode*> const& get_clipping_plane_nodes() const { return clipping_plane_nodes_; }
@@ -309,8 +414,28 @@ class GUA_DLL SceneGraph
     friend class ::gua::node::ClippingPlaneNode;
 
   private:
+    // everything a serialized scene depends on, besides the nodes
+    struct SerializationCacheEntry
+    {
+        std::size_t camera_uuid;
+        CameraMode mode;
+        Mask mask;
+        int view_id;
+        bool enable_frustum_culling;
+        math::mat4 camera_transform;
+        Frustum rendering_frustum;
+        Frustum culling_frustum;
+        std::vector<math::vec4> clipping_planes;
+        std::shared_ptr<SerializedScene> scene;
+    };
+
+    SerializationCacheEntry make_serialization_cache_key(node::SerializedCameraNode const& camera, CameraMode mode) const;
+
     std::shared_ptr<node::Node> find_node(std::string const& path_to_node, std::string const& path_to_start = "/") const;
 
+    // takes over the screens resolved in graph, of which this is a deep copy
+    void copy_resolved_screens(SceneGraph const& graph);
+
     bool has_child(std::shared_ptr<node::Node> const& parent, std::string const& child_name) const;
 
     void add_camera_node(node::CameraNode* camera);
@@ -324,6 +449,22 @@ class GUA_DLL SceneGraph
 
     std::vector<node::CameraNode*> camera_nodes_;
     std::vector<node::ClippingPlaneNode*> clipping_plane_nodes_;
+
+    // nodes which are copied by every snapshot(), see Node::has_untracked_properties()
+    std::unordered_set<node::Node*> untracked_nodes_;
+
+    std::unique_ptr<TransformHierarchy> transform_hierarchy_;
+    std::unique_ptr<SceneBVH> bvh_;
+
+    bool enable_serialization_cache_ = false;
+    mutable std::mutex serialization_cache_mutex_;
+    mutable std::vector<SerializationCacheEntry> serialization_cache_;
+
+    // screens looked up by get_screen_node(), valid as long as the node
+    // structure version equals resolved_screens_version_
+    mutable std::mutex resolved_screens_mutex_;
+    mutable std::unordered_map<std::string, std::shared_ptr<node::ScreenNode>> resolved_screens_;
+    mutable std::size_t resolved_screens_version_ = 0;
 };
 
 } // namespace gua
@@ -0,0 +1,99 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef GUA_TRANSFORM_HIERARCHY_HPP
+#define GUA_TRANSFORM_HIERARCHY_HPP
+
+#include <gua/platform.hpp>
+#include <gua/math/math.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace gua
+{
+namespace node
+{
+class Node;
+}
+
+/**
+ * A flattened, depth-ordered copy of a SceneGraph's transformation hierarchy.
+ *
+ * The Nodes are stored level by level (breadth first) in a structure of
+ * arrays holding parent indices, local and world transformations and dirty
+ * flags. World transformations are computed in linear sweeps over these
+ * arrays, each level in parallel. Bounding boxes are updated bottom-up in the
+ * same manner. Results are written back to the Nodes, so their interface does
+ * not change.
+ *
+ * Nodes which do not support flattened updates (see
+ * Node::supports_flat_update()) are updated with Node::update_cache() once
+ * their parent's transformation is known; their children are not part of the
+ * hierarchy.
+ *
+ * The hierarchy is rebuilt automatically whenever Nodes are added or removed.
+ *
+ * \ingroup gua_scenegraph
+ */
+class GUA_DLL TransformHierarchy
+{
+  public:
+    /**
+     * Updates world transformations and bounding boxes of all dirty Nodes
+     * below root, rebuilding the hierarchy first if necessary.
+     *
+     * \param root  The root Node of the SceneGraph.
+     */
+    void update(node::Node* root);
+
+    /**
+     * Returns the number of Nodes in the hierarchy.
+     */
+    std::size_t size() const { return nodes_.size(); }
+
+  private:
+    enum Flags : std::uint8_t
+    {
+        SELF_DIRTY = 1 << 0,
+        CHILD_DIRTY = 1 << 1,
+        CHANGED = 1 << 2,
+        RECURSIVE = 1 << 3
+    };
+
+    void rebuild(node::Node* root);
+
+    node::Node* root_ = nullptr;
+    std::size_t structure_version_ = 0;
+
+    std::vector<node::Node*> nodes_;
+    std::vector<int> parents_;
+    std::vector<math::mat4> local_transforms_;
+    std::vector<math::mat4> world_transforms_;
+    std::vector<std::uint8_t> flags_;
+
+    // nodes_[level_offsets_[l], level_offsets_[l + 1]) are on level l
+    std::vector<std::size_t> level_offsets_;
+};
+
+} // namespace gua
+
+#endif // GUA_TRANSFORM_HIERARCHY_HPP
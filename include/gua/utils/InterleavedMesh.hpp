@@ -0,0 +1,167 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef GUA_INTERLEAVED_MESH_HPP
+#define GUA_INTERLEAVED_MESH_HPP
+
+// guacamole headers
+#include <gua/platform.hpp>
+#include <gua/utils/Mesh.hpp>
+
+// external headers
+#include <scm/gl_core.h>
+#include <memory>
+
+namespace gua
+{
+/**
+ * @brief holds the vertices of a triangle mesh interleaved, as they are uploaded to the GPU
+ * @details positions are always stored, other attributes may be stripped. The
+ * vertex and index data may be shared, e.g. with a memory mapped file.
+ */
+class GUA_DLL InterleavedMesh
+{
+  public:
+    /**
+     * @brief optional vertex attributes
+     */
+    enum Attributes
+    {
+        TEXCOORDS = 1 << 0,
+        NORMALS = 1 << 1,
+        TANGENTS = 1 << 2,
+        BITANGENTS = 1 << 3, // reconstructed from normals and tangents if missing
+        ALL_ATTRIBUTES = TEXCOORDS | NORMALS | TANGENTS | BITANGENTS
+    };
+
+    InterleavedMesh();
+
+    /**
+     * @brief interleaves the given mesh
+     * @details attributes which are zero for all vertices are stripped as well
+     *
+     * @param mesh mesh to convert
+     * @param attributes attributes to keep
+     * @param optimize_indices whether to reorder triangles and vertices for the vertex cache
+     */
+    InterleavedMesh(Mesh const& mesh, unsigned attributes = ALL_ATTRIBUTES, bool optimize_indices = false);
+
+    /**
+     * @brief uses existing interleaved data
+     *
+     * @param attributes attributes contained in the vertex data
+     * @param num_vertices number of vertices
+     * @param vertices vertex data
+     * @param num_triangles number of triangles
+     * @param indices index data
+     */
+    InterleavedMesh(unsigned attributes, unsigned num_vertices, std::shared_ptr<float const> const& vertices, unsigned num_triangles, std::shared_ptr<unsigned const> const& indices);
+
+    /**
+     * @brief reorders triangles for the post-transform vertex cache and vertices by first use
+     * @details uses Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+     *
+     * @param num_vertices number of vertices
+     * @param vertex_size number of floats per vertex
+     * @param vertices interleaved vertex data, reordered in place
+     * @param indices index data, reordered in place
+     */
+    static void optimize_indices(unsigned num_vertices, unsigned vertex_size, float* vertices, std::vector<unsigned>& indices);
+
+    /**
+     * @brief returns the average number of vertex shader invocations per triangle
+     * @details for a FIFO cache with the given size; 0.5 is optimal, 3 is worst
+     */
+    static float average_cache_miss_ratio(std::vector<unsigned> const& indices, unsigned cache_size = 32);
+
+    /**
+     * @brief returns the vertex layout of the stored attributes
+     * @details attribute locations match those of Mesh::get_vertex_format()
+     */
+    scm::gl::vertex_format get_vertex_format() const;
+
+    unsigned get_attributes() const { return attributes_; }
+    unsigned get_num_vertices() const { return num_vertices_; }
+    unsigned get_num_triangles() const { return num_triangles_; }
+
+    /**
+     * @brief returns the size of one vertex in bytes
+     */
+    std::size_t get_vertex_size() const { return vertex_size_ * sizeof(float); }
+
+    float const* get_vertices() const { return vertices_.get(); }
+    unsigned const* get_indices() const { return indices_.get(); }
+
+    scm::math::vec3f const& get_position(unsigned vertex) const { return *reinterpret_cast<scm::math::vec3f const*>(vertices_.get() + vertex * vertex_size_); }
+
+    /**
+     * @brief returns zero if the attribute was stripped
+     */
+    scm::math::vec3f get_normal(unsigned vertex) const { return get_vec3(normal_offset_, vertex); }
+
+    /**
+     * @brief returns zero if the attribute was stripped
+     */
+    scm::math::vec3f get_tangent(unsigned vertex) const { return get_vec3(tangent_offset_, vertex); }
+
+    /**
+     * @brief reconstructs stripped bitangents like tri_mesh_shader.vert does
+     */
+    scm::math::vec3f get_bitangent(unsigned vertex) const
+    {
+        return bitangent_offset_ ? get_vec3(bitangent_offset_, vertex) : scm::math::cross(get_normal(vertex), get_tangent(vertex));
+    }
+
+    /**
+     * @brief returns zero if the attribute was stripped
+     */
+    scm::math::vec2f get_texcoords(unsigned vertex) const
+    {
+        return texcoords_offset_ ? *reinterpret_cast<scm::math::vec2f const*>(vertices_.get() + vertex * vertex_size_ + texcoords_offset_) : scm::math::vec2f(0.f, 0.f);
+    }
+
+  private:
+    void compute_layout();
+
+    scm::math::vec3f get_vec3(unsigned offset, unsigned vertex) const
+    {
+        return offset ? *reinterpret_cast<scm::math::vec3f const*>(vertices_.get() + vertex * vertex_size_ + offset) : scm::math::vec3f(0.f, 0.f, 0.f);
+    }
+
+    unsigned attributes_ = 0;
+    unsigned num_vertices_ = 0;
+    unsigned num_triangles_ = 0;
+
+    // in floats, zero for stripped attributes
+    unsigned vertex_size_ = 3;
+    unsigned texcoords_offset_ = 0;
+    unsigned normal_offset_ = 0;
+    unsigned tangent_offset_ = 0;
+    unsigned bitangent_offset_ = 0;
+
+    std::shared_ptr<float const> vertices_;
+    std::shared_ptr<unsigned const> indices_;
+};
+
+} // namespace gua
+
+#endif // GUA_INTERLEAVED_MESH_HPP
@@ -28,7 +28,9 @@
 #include <gua/utils/KDTreeUtils.hpp>
 #include <gua/scenegraph/PickResult.hpp>
 #include <gua/utils/Mesh.hpp>
+#include <gua/utils/InterleavedMesh.hpp>
 
+#include <cstdint>
 #include <set>
 #include <vector>
 #include <iosfwd>
@@ -37,7 +39,16 @@
 namespace gua
 {
 /**
- * This class contains a simple KDTree implementation.
+ * This class contains a kd-tree over the triangles of a Mesh.
+ *
+ * Splitting planes are chosen with the surface area heuristic (SAH), large
+ * subtrees are built in parallel. The tree is stored in one array in
+ * depth-first order: the first child of an inner node directly follows its
+ * parent. Leaves reference a contiguous range of triangle indices.
+ *
+ * Rays are traversed without a stack by restarting at the root for each
+ * visited leaf; the triangles of a leaf are intersected four at a time.
+ * ray_test() does not modify the tree and may be called concurrently.
  */
 class KDTree
 {
@@ -45,16 +56,24 @@ class KDTree
     KDTree();
 
     /**
-     * Initializes the KDTree with the given triangles.
+     * Initializes the KDTree with the triangles of the given Mesh.
      *
-     * \param triangles A vector of Triangle.
+     * \param mesh The Mesh.
      */
     void generate(Mesh const& mesh);
 
+    /**
+     * Initializes the KDTree with the triangles of the given InterleavedMesh.
+     *
+     * \param mesh The InterleavedMesh.
+     */
+    void generate(InterleavedMesh const& mesh);
+
     /**
      * Checks for intersections with the KDTree.
      *
      * \param ray     The Ray which shall be tested against the tree.
+     * \param mesh    The Mesh the tree was generated for.
      * \param options A bitwise combined set of options.
      * \param owner   The Node which will be written in the generated PickResults.
      * \param hits    A reference to the resulting set. Any contained data will be
@@ -62,60 +81,103 @@ class KDTree
      */
     void ray_test(Ray const& ray, Mesh const& mesh, int options, node::Node* owner, std::set<PickResult>& hits) const;
 
-  private:
-    // a private struct used for triangle data storage in the leaves of the tree
-    struct LeafData
-    {
-        struct Comparator
-        {
-            Comparator(unsigned dim);
+    /**
+     * Checks for intersections with the KDTree.
+     *
+     * \param ray     The Ray which shall be tested against the tree.
+     * \param mesh    The InterleavedMesh the tree was generated for.
+     * \param options A bitwise combined set of options.
+     * \param owner   The Node which will be written in the generated PickResults.
+     * \param hits    A reference to the resulting set. Any contained data will be
+     *                deleted depending on the supplied options.
+     */
+    void ray_test(Ray const& ray, InterleavedMesh const& mesh, int options, node::Node* owner, std::set<PickResult>& hits) const;
 
-            bool operator()(LeafData const& lhs, LeafData const& rhs) const;
-            unsigned dim_;
-        };
+    /**
+     * Returns the number of bytes used by the nodes and triangle indices.
+     */
+    std::size_t get_memory_usage() const;
 
-        LeafData();
-        LeafData(Mesh const& mesh, Triangle const& triangle, unsigned id);
-        LeafData(math::BoundingBox<math::vec3> const& bbox, unsigned id);
+    /**
+     * Returns true if the tree contains no triangles.
+     */
+    bool is_empty() const { return nodes_.empty(); }
 
-        unsigned id_;
-        math::BoundingBox<math::vec3> bbox_;
+    /**
+     * Writes the tree in a binary format, e.g. to cache it on disk.
+     *
+     * \param os The stream to write to.
+     */
+    void write(std::ostream& os) const;
 
-        bool operator<(LeafData);
+    /**
+     * Restores a tree which was written with write().
+     *
+     * \param data Start of the serialized tree.
+     * \param end  End of the readable memory.
+     *
+     * \return     A pointer behind the serialized tree, or nullptr if the data
+     *             is truncated.
+     */
+    char const* read(char const* data, char const* end);
+
+  private:
+    // a private struct used for triangle data storage during construction.
+    // Vertices and splitting positions are single precision, so are the
+    // (clipped) bounds of the triangles
+    struct LeafData
+    {
+        unsigned id_;
+        float min_[3];
+        float max_[3];
     };
 
-    // a private struct which may be used for leaves and internal nodes
+    // a node of the linearized tree. The lowest two bits of flags_ contain the
+    // splitting dimension of inner nodes or 3 for leaves. The remaining bits
+    // contain the index of the second child of inner nodes or the number of
+    // triangles of leaves.
     struct KDNode
     {
-        KDNode(std::vector<LeafData> const& data = std::vector<LeafData>());
+        KDNode() : first_triangle_(0), flags_(0) {}
 
-        KDNode(KDNode* left_child, KDNode* right_child, unsigned splitting_dimension, float splitting_position, math::BoundingBox<math::vec3> const& bounds);
+        bool is_leaf() const { return (flags_ & 3) == 3; }
+        unsigned splitting_dimension() const { return flags_ & 3; }
+        std::uint32_t second_child() const { return flags_ >> 2; }
+        std::uint32_t triangle_count() const { return flags_ >> 2; }
 
-        void print(unsigned depth) const;
+        union
+        {
+            float splitting_position_;
+            std::uint32_t first_triangle_;
+        };
 
-        std::vector<LeafData> data_;
-        KDNode *left_child_, *right_child_;
-        bool is_leaf_;
-        unsigned splitting_dimension_;
-        float splitting_position_;
-        math::BoundingBox<math::vec3> bounds_;
+        std::uint32_t flags_;
     };
 
-    // constructs the tree
-    KDNode* build(std::vector<std::vector<LeafData>> const& sorted_triangles, math::BoundingBox<math::vec3> const& bounds);
+    // distance along the ray and triangle id
+    using Hit = std::pair<float, unsigned>;
+
+    // constructs the subtree for the given triangles and appends it to nodes
+    static void build(std::vector<LeafData>& data, math::BoundingBox<math::vec3> const& bounds, unsigned depth, unsigned bad_refines, std::vector<KDNode>& nodes, std::vector<unsigned>& indices);
+
+    // appends a subtree which was constructed separately
+    static void append(std::vector<KDNode> const& subtree_nodes, std::vector<unsigned> const& subtree_indices, std::vector<KDNode>& nodes, std::vector<unsigned>& indices);
 
-    // ray test against the tree, returns upon the first intersection
-    bool intersect_one(KDNode* node, Ray const& ray, Mesh const& mesh, int options, std::vector<Triangle> const& triangles, std::set<PickResult>& hits) const;
+    // implementations of the public methods for all mesh types
+    template <typename MeshType>
+    void generate_impl(MeshType const& mesh);
 
-    // ray test against the tree, searches for all intersections
-    void intersect_all(KDNode* node, Ray const& ray, Mesh const& mesh, int options, std::vector<Triangle> const& triangles, std::set<PickResult>& hits) const;
+    template <typename MeshType>
+    void ray_test_impl(Ray const& ray, MeshType const& mesh, int options, node::Node* owner, std::set<PickResult>& hits) const;
 
-    KDNode* root_;
-    std::vector<Triangle> triangles_;
+    // ray test against the tree. Returns the closest intersection if only_first
+    // is set, all intersections otherwise
+    template <typename MeshType>
+    void intersect(Ray const& ray, MeshType const& mesh, bool only_first, std::vector<Hit>& hits) const;
 
-    mutable node::Node* current_owner_;
-    mutable int current_options_;
-    mutable unsigned current_visit_flag_;
+    std::vector<KDNode> nodes_;
+    std::vector<unsigned> triangle_indices_;
+    math::BoundingBox<math::vec3> bounds_;
 };
 
 } // namespace gua
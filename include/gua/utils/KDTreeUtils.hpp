@@ -27,6 +27,7 @@
 
 #include <scm/gl_core/primitives/box.h>
 #include <gua/utils/Mesh.hpp>
+#include <gua/utils/InterleavedMesh.hpp>
 
 #include <vector>
 
@@ -72,6 +73,13 @@ struct GUA_DLL Triangle
     math::vec3 get_normal_interpolated(Mesh const& mesh, math::vec3 const& position) const;
     math::vec2 get_texture_coords_interpolated(Mesh const& mesh, math::vec3 const& position) const;
 
+    float intersect(InterleavedMesh const& mesh, Ray const& ray) const;
+
+    math::vec3 get_vertex(InterleavedMesh const& mesh, unsigned vertex_id) const;
+    math::vec3 get_normal(InterleavedMesh const& mesh) const;
+    math::vec3 get_normal_interpolated(InterleavedMesh const& mesh, math::vec3 const& position) const;
+    math::vec2 get_texture_coords_interpolated(InterleavedMesh const& mesh, math::vec3 const& position) const;
+
     unsigned face_id_;
     mutable unsigned visit_flag_;
 };
@@ -32,6 +32,7 @@
 #include <scm/gl_core.h>
 #include <scm/core/math/quat.h>
 
+#include <cstdint>
 #include <mutex>
 #include <vector>
 
@@ -93,6 +94,51 @@ struct GUA_DLL LineStrip
     void compile_buffer_string(std::string& buffer_string);
     void uncompile_buffer_string(std::string const& buffer_string);
 
+    /**
+     * @brief returns the number of bytes write_sync() needs at most for the
+     *        current strip
+     */
+    std::size_t max_sync_size() const;
+
+    /**
+     * @brief writes a compact update of the strip to the given buffer
+     *
+     * Positions are quantized to a grid and stored as differences between
+     * consecutive vertices, colors are quantized to 8 bits per channel and
+     * runs of equal colors and thicknesses are stored once. Normals are not
+     * written, they are recomputed by compute_consistent_normals().
+     *
+     * In delta mode only the vertices pushed since the last update are
+     * written, together with the number of vertices popped from both ends.
+     * The first update and all other modifications (forwarding queued
+     * vertices, uncompiling or reading an update) result in a complete update.
+     *
+     * @param buffer    buffer to write to
+     * @param capacity  size of the buffer, max_sync_size() always suffices
+     * @param delta     whether an update relative to the last one may be written
+     * @param precision quantization step for positions, 0 uses 1/65535 of the
+     *                  extent of the written vertices
+     *
+     * @return number of bytes written, 0 if the buffer is too small
+     */
+    std::size_t write_sync(char* buffer, std::size_t capacity, bool delta = true, float precision = 0.0f);
+
+    /**
+     * @brief applies an update written by write_sync()
+     *
+     * @param buffer buffer to read from
+     * @param size   number of bytes in the buffer
+     *
+     * Every update carries the sequence number of its write, a delta update
+     * is only applied directly after the update it was written against. The
+     * strip is left untouched if the update is rejected.
+     *
+     * @return false if the buffer is malformed or a delta update does not
+     *         match the current state, the sender should then be asked for
+     *         a complete update
+     */
+    bool read_sync(char const* buffer, std::size_t size);
+
     bool push_vertex(Vertex const& v_to_push);
     bool pop_back_vertex();
     bool pop_front_vertex();
@@ -128,6 +174,20 @@ struct GUA_DLL LineStrip
 
   protected:
     void enlarge_reservoirs();
+    void reserve_vertex_slots(int num_vertices);
+    void restart_sync();
+
+    // sender side state of write_sync()
+    uint64_t sync_generation_ = 1;
+    uint64_t sync_sequence_ = 0;
+    bool sync_written_ = false;
+    uint64_t synced_vertices_ = 0;
+    uint64_t unchanged_vertices_ = 0;
+    uint64_t popped_front_vertices_ = 0;
+
+    // receiver side state of read_sync()
+    uint64_t received_generation_ = 0;
+    uint64_t received_sequence_ = 0;
 };
 
 } // namespace gua
@@ -85,6 +85,7 @@ void MLodNode::set_geometry_description(std::string const& v)
 {
     geometry_description_ = v;
     geometry_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -95,6 +96,7 @@ void MLodNode::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
     material_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -102,6 +104,7 @@ void MLodNode::set_error_threshold(float const threshold)
 {
     error_threshold_ = threshold;
     self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -254,6 +257,7 @@ int MLodNode::get_min_lod_depth()
 void MLodNode::set_min_lod_depth(int min_lod_depth)
 {
     min_lod_depth_ = min_lod_depth;
+    invalidate_snapshot();
 }
 } // namespace node
 } // namespace gua
@@ -87,6 +87,7 @@ void PLodNode::set_geometry_description(std::string const& v)
 {
     geometry_description_ = v;
     geometry_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -97,6 +98,7 @@ void PLodNode::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
     material_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -107,6 +109,7 @@ void PLodNode::set_radius_scale(float scale)
 {
     radius_scale_ = scale;
     self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -117,6 +120,7 @@ void PLodNode::set_max_surfel_radius(float threshold)
 {
     max_surfel_size_ = threshold;
     self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -127,6 +131,7 @@ void PLodNode::set_error_threshold(float threshold)
 {
     error_threshold_ = threshold;
     self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -134,6 +139,7 @@ void PLodNode::set_enable_backface_culling_by_normal(bool const enable_backface_
 {
     enable_backface_culling_by_normal_ = enable_backface_culling;
     self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -17,6 +17,7 @@ class GUA_NRP_DLL NRPCameraNode : public gua::node::CameraNode
 
     std::shared_ptr<node::Node> deep_copy() const override;
     void update_cache() override;
+    bool supports_flat_update() const override { return false; }
     void set_transform(math::mat4 const &transform) override;
     void scale(math::float_t x, math::float_t y, math::float_t z) override;
     void scale(math::vec3 const &s) override;
@@ -16,6 +16,7 @@ class GUA_NRP_DLL NRPNode : public gua::node::TransformNode
 
     std::shared_ptr<node::Node> deep_copy() const override;
     void update_cache() override;
+    bool supports_flat_update() const override { return false; }
     void set_transform(math::mat4 const &transform) override;
     void scale(math::float_t x, math::float_t y, math::float_t z) override;
     void scale(math::vec3 const &s) override;
@@ -27,6 +28,7 @@ class GUA_NRP_DLL NRPNode : public gua::node::TransformNode
 
     void accept(NodeVisitor &visitor) override;
     void ray_test_impl(Ray const &ray, int options, Mask const &mask, std::set<PickResult> &hits) override;
+    RayTestMode get_ray_test_mode() const override { return RayTestMode::SUBTREE; }
 
     void callback_pre_pass();
     void callback_post_pass();
@@ -36,6 +38,9 @@ class GUA_NRP_DLL NRPNode : public gua::node::TransformNode
     void set_should_update_avango(bool should_update_avango);
     bool get_should_update_avango();
 
+  protected:
+    std::shared_ptr<node::Node> snapshot_subtree(node::Node *parent_anchor, bool parent_changed) const override;
+
   private:
     std::shared_ptr<node::Node> copy() const override;
 
@@ -26,6 +26,12 @@ std::shared_ptr<node::Node> NRPNode::deep_copy() const
     auto copied_node = node::TransformNode::deep_copy();
     return copied_node;
 }
+std::shared_ptr<node::Node> NRPNode::snapshot_subtree(node::Node *parent_anchor, bool parent_changed) const
+{
+    std::unique_lock<std::mutex> lock(NRPBinder::get_instance().get_scene_mutex());
+    auto copied_node = node::TransformNode::snapshot_subtree(parent_anchor, parent_changed);
+    return copied_node;
+}
 void NRPNode::accept(NodeVisitor &visitor)
 {
     std::unique_lock<std::mutex> lock(NRPBinder::get_instance().get_scene_mutex());
@@ -88,9 +94,21 @@ void NRPNode::ray_test_impl(Ray const &ray, int options, Mask const &mask, std::
 }
 void NRPNode::callback_pre_pass() { _pre_pass(); }
 void NRPNode::callback_post_pass() { _post_pass(); }
-void NRPNode::set_pre_pass(const std::function<void()> pre_pass) { this->_pre_pass = std::move(pre_pass); }
-void NRPNode::set_post_pass(const std::function<void()> post_pass) { this->_post_pass = std::move(post_pass); }
+void NRPNode::set_pre_pass(const std::function<void()> pre_pass)
+{
+    this->_pre_pass = std::move(pre_pass);
+    invalidate_snapshot();
+}
+void NRPNode::set_post_pass(const std::function<void()> post_pass)
+{
+    this->_post_pass = std::move(post_pass);
+    invalidate_snapshot();
+}
 bool NRPNode::get_should_update_avango() { return _should_update_avango; }
-void NRPNode::set_should_update_avango(bool should_update_avango) { this->_should_update_avango = should_update_avango; }
+void NRPNode::set_should_update_avango(bool should_update_avango)
+{
+    this->_should_update_avango = should_update_avango;
+    invalidate_snapshot();
+}
 } // namespace nrp
 } // namespace gua
\ No newline at end of file
@@ -54,6 +54,7 @@ void NURBSNode::set_geometry_description(std::string const& v)
 {
     geometry_description_ = v;
     geometry_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -64,6 +65,7 @@ void NURBSNode::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
     material_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -86,6 +86,7 @@ void PLODNode::set_geometry_description(std::string const& v)
 {
     geometry_description_ = v;
     geometry_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -96,6 +97,7 @@ void PLODNode::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
     material_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -103,6 +105,7 @@ void PLODNode::set_radius_scale(float const scale)
 {
     radius_scale_ = scale;
     self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -113,6 +116,7 @@ void PLODNode::set_error_threshold(float const threshold)
 {
     error_threshold_ = threshold;
     self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -123,6 +127,7 @@ void PLODNode::set_enable_backface_culling_by_normal(bool const enable_backface_
 {
     enable_backface_culling_by_normal_ = enable_backface_culling;
     self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -26,11 +26,16 @@
 #include <gua/node/GeometryNode.hpp>
 #include <gua/skelanim/utils/SkeletalAnimation.hpp>
 #include <gua/skelanim/utils/Skeleton.hpp>
+#include <gua/skelanim/utils/SkeletalPose.hpp>
 #include <gua/platform.hpp>
 
 namespace gua
 {
 class SkinnedMeshResource;
+namespace concurrent
+{
+class ThreadPool;
+}
 class SkeletalAnimation;
 struct Bone;
 
@@ -116,6 +121,7 @@ class GUA_SKELANIM_DLL SkeletalAnimationNode : public GeometryNode
 
     // animation related methods
     void add_animations(std::string const& file_name, std::string const& animation_name);
+    void add_animation(SkeletalAnimation const& animation);
 
     std::string const& get_animation_1() const;
     void set_animation_1(std::string const&);
@@ -147,6 +153,16 @@ class GUA_SKELANIM_DLL SkeletalAnimationNode : public GeometryNode
      */
     void update_bone_transforms();
 
+    /**
+     * @brief recalculates the bone transformations of many nodes at once
+     * @details the nodes are distributed over the threads of the given pool.
+     * Each node must be contained only once.
+     *
+     * @param nodes nodes to update
+     * @param pool pool to use, updates serially if nullptr
+     */
+    static void update_bone_transforms(std::vector<SkeletalAnimationNode*> const& nodes, concurrent::ThreadPool* pool);
+
     /**
      * Accepts a visitor and calls concrete visit method.
      *
@@ -159,6 +175,10 @@ class GUA_SKELANIM_DLL SkeletalAnimationNode : public GeometryNode
   protected:
     std::shared_ptr<Node> copy() const override;
 
+  private:
+    // maps the bones of all animations to the current skeleton
+    void bind_animations();
+
   private: // attributes e.g. special attributes for drawing
     std::vector<std::shared_ptr<SkinnedMeshResource>> geometries_;
     std::vector<std::string> geometry_descriptions_;
@@ -184,6 +204,10 @@ class GUA_SKELANIM_DLL SkeletalAnimationNode : public GeometryNode
     float anim_time_2_;
 
     std::vector<scm::math::mat4f> bone_transforms_;
+
+    // scratch poses, reused by every update
+    SkeletalPose pose_1_;
+    SkeletalPose pose_2_;
 };
 
 } // namespace node
@@ -38,8 +38,22 @@ class GUA_SKELANIM_DLL SkeletalAnimationPassDescription : public PipelinePassDes
     std::shared_ptr<PipelinePassDescription> make_copy() const override;
     friend class Pipeline;
 
+    /**
+     * @brief distance beyond which bones are updated less often
+     * @details a node at distance d is updated every ceil(d / value)
+     * frames, at most every max_update_interval() frames. 0 disables this.
+     */
+    SkeletalAnimationPassDescription& update_lod_distance(float value);
+    float update_lod_distance() const;
+
+    SkeletalAnimationPassDescription& max_update_interval(unsigned value);
+    unsigned max_update_interval() const;
+
   protected:
     PipelinePass make_pass(RenderContext const&, SubstitutionMap&) override;
+
+    float update_lod_distance_ = 0.f;
+    unsigned max_update_interval_ = 4;
 };
 
 } // namespace gua
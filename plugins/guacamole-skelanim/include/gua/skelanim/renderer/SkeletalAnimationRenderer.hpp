@@ -36,6 +36,10 @@ namespace gua
 class MaterialShader;
 class Pipeline;
 class PipelinePassDescription;
+namespace node
+{
+class SkeletalAnimationNode;
+}
 
 /**
  * @brief holds bone mapping offsets
@@ -60,6 +64,10 @@ class GUA_SKELANIM_DLL SkeletalAnimationRenderer
     void create_state_objects(RenderContext const& ctx);
 
   private:
+    void update_bone_transforms(Pipeline& pipe, PipelinePassDescription const& desc);
+
+    std::vector<scm::math::mat4f> const& get_bone_transforms(node::SkeletalAnimationNode const& node) const;
+
     scm::gl::rasterizer_state_ptr rs_cull_back_;
     scm::gl::rasterizer_state_ptr rs_cull_none_;
 
@@ -72,6 +80,24 @@ class GUA_SKELANIM_DLL SkeletalAnimationRenderer
     SharedSkinningResource skinning_resource_;
 
     unsigned last_frame_;
+
+    // nodes whose bones are updated this frame
+    std::vector<node::SkeletalAnimationNode*> update_nodes_;
+
+    /**
+     * The bones of a node as of its last update and the frame offset at which
+     * it is updated. The serialized nodes are fresh copies each frame, so both
+     * are kept here by the uuid of the node.
+     */
+    struct CachedBones
+    {
+        std::vector<scm::math::mat4f> transforms;
+        unsigned phase = 0;
+        unsigned last_frame = 0;
+    };
+
+    std::unordered_map<std::size_t, CachedBones> cached_bones_;
+    unsigned next_phase_;
 };
 
 } // namespace gua
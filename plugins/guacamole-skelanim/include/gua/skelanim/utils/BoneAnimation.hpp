@@ -35,6 +35,7 @@ struct aiNodeAnim;
 namespace gua
 {
 struct BonePose;
+class SkeletalPose;
 
 /**
  * @brief holds transformation at one point in time
@@ -74,6 +75,15 @@ class BoneAnimation
      */
     BonePose calculate_pose(float time) const;
 
+    /**
+     * @brief writes pose at given time into skeletal pose
+     *
+     * @param time normalized time
+     * @param bone index of the animated bone in the pose
+     * @param pose pose to write to
+     */
+    void calculate_pose(float time, unsigned bone, SkeletalPose& pose) const;
+
     std::string const& get_name() const;
 
   private:
@@ -83,13 +93,14 @@ class BoneAnimation
     /**
      * @brief finds keyframe closest to given time
      * @details finds last keyframe before given time
+     * with a binary search
      *
      * @param animationTime normalized time
      * @param keys vector of keyframes to search in
-     * @return index of keyframe
+     * @return index of keyframe, -1 if time is before first key
      */
     template <class T>
-    int find_key(float animationTime, std::vector<Keyframe<T>> keys) const;
+    int find_key(float animationTime, std::vector<Keyframe<T>> const& keys) const;
 
     /**
      * @brief returns transformation at given time
@@ -102,7 +113,7 @@ class BoneAnimation
      * @return interpolated transformation
      */
     template <class T>
-    T calculate_value(float time, std::vector<Keyframe<T>> keys) const;
+    T calculate_value(float time, std::vector<Keyframe<T>> const& keys) const;
 
     std::string name;
     std::vector<Keyframe<scm::math::vec3f>> scalingKeys;
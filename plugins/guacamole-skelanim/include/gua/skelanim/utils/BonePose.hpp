@@ -45,6 +45,10 @@ struct GUA_SKELANIM_DLL BonePose
 
     scm::math::mat4f to_matrix() const;
 
+    scm::math::vec3f const& get_scaling() const { return scaling; }
+    scm::math::quatf const& get_rotation() const { return rotation; }
+    scm::math::vec3f const& get_translation() const { return translation; }
+
     BonePose blend(BonePose const& t, float const factor) const;
 
     BonePose operator+(BonePose const& t) const;
@@ -37,6 +37,7 @@ struct aiAnimation;
 namespace gua
 {
 class SkeletalPose;
+class Skeleton;
 
 /**
  * @brief holds bone animations for one animation
@@ -52,14 +53,35 @@ class GUA_SKELANIM_DLL SkeletalAnimation
 #endif
     ~SkeletalAnimation();
 
+    /**
+     * @brief maps bone animations to bones
+     * @details resolves the bone names of the animated bones once,
+     * so that poses can be calculated without looking them up
+     *
+     * @param skeleton skeleton the anim is applied to
+     */
+    void bind(Skeleton const& skeleton);
+
     /**
      * @brief calculates skelpose from this anim
-     * @details calculates the pose at the given time
+     * @details calculates the pose at the given time, indexed
+     * by the bones of the given skeleton
      *
      * @param time time for which to calculate pose
+     * @param skeleton skeleton the anim is applied to
      * @return SkeletalPose at given time
      */
-    SkeletalPose calculate_pose(float time) const;
+    SkeletalPose calculate_pose(float time, Skeleton const& skeleton) const;
+
+    /**
+     * @brief calculates skelpose from this anim
+     * @details like above, but reuses the memory of the given pose
+     *
+     * @param time time for which to calculate pose
+     * @param skeleton skeleton the anim is applied to
+     * @param pose pose to write to
+     */
+    void calculate_pose(float time, Skeleton const& skeleton, SkeletalPose& pose) const;
 
     /**
      * @brief returns anim duration
@@ -77,6 +99,10 @@ class GUA_SKELANIM_DLL SkeletalAnimation
     unsigned numBoneAnims;
 
     std::vector<BoneAnimation> boneAnims;
+
+    // skeleton bone per bone animation, -1 if the bone does not exist
+    Skeleton const* boundSkeleton;
+    std::vector<int> boneIndices;
 };
 
 } // namespace gua
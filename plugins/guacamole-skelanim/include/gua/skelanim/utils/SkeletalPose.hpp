@@ -25,8 +25,11 @@
 #include <gua/skelanim/platform.hpp>
 
 // external headers
-#include <map>
-#include <memory>
+#include <scm/gl_core.h>
+#include <scm/core/math/quat.h>
+
+#include <cstdint>
+#include <vector>
 
 namespace gua
 {
@@ -35,31 +38,64 @@ struct BonePose;
 
 /**
  * @brief holds transformations for bones at one point in an anim
- * @details used to accumulate and blend boneposes
+ * @details used to accumulate and blend boneposes. Bones are
+ * addressed by their index in the Skeleton; scalings, rotations
+ * and translations are stored in separate arrays, so that poses of
+ * whole skeletons are blended in tight loops
  */
 class GUA_SKELANIM_DLL SkeletalPose
 {
   public:
     SkeletalPose();
 
+    /**
+     * @brief creates pose without any transformations
+     *
+     * @param num_bones number of bones in the skeleton
+     */
+    explicit SkeletalPose(std::size_t num_bones);
+
+    /**
+     * @brief returns number of bones the pose has room for
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief removes all transformations
+     * @details keeps the allocated memory, so that
+     * the pose can be reused every frame
+     *
+     * @param num_bones number of bones in the skeleton
+     */
+    void reset(std::size_t num_bones);
+
     /**
      * @brief returns if pose contains bonepose
      * @details checks if the pose
      * contains transform for given bone
      *
-     * @param name name of bone
+     * @param bone index of bone
      * @return whether pose exists
      */
-    bool contains(std::string const& name) const;
+    bool contains(unsigned bone) const;
 
     /**
      * @brief returns tranform for given bone
-     * @details returns
+     * @details returns the identity
+     * if the bone is not contained
      *
-     * @param name name of bone
+     * @param bone index of bone
      * @return pose of the bone
      */
-    BonePose const& get_transform(std::string const& name) const;
+    BonePose get_transform(unsigned bone) const;
+
+    /**
+     * @brief returns tranform matrix for given bone
+     *
+     * @param bone index of bone
+     * @return matrix of the bone's pose
+     */
+    scm::math::mat4f get_matrix(unsigned bone) const;
 
     /**
      * @brief sets pose for bone
@@ -68,10 +104,11 @@ class GUA_SKELANIM_DLL SkeletalPose
      * adds this bone to the skepose if
      * it wasnt included before
      *
-     * @param name name of bone
+     * @param bone index of bone
      * @param value pose to set
      */
-    void set_transform(std::string const& name, BonePose const& value);
+    void set_transform(unsigned bone, BonePose const& value);
+    void set_transform(unsigned bone, scm::math::vec3f const& scaling, scm::math::quatf const& rotation, scm::math::vec3f const& translation);
 
     /**
      * @brief blends with another pose
@@ -102,9 +139,12 @@ class GUA_SKELANIM_DLL SkeletalPose
     void partial_replace(SkeletalPose const& pose2, Skeleton const& skeleton, unsigned bone);
 
   private:
-    std::map<std::string, BonePose> transforms;
+    void grow(std::size_t num_bones);
 
-    const static BonePose blank_pose;
+    std::vector<std::uint8_t> contained_;
+    std::vector<scm::math::vec3f> scalings_;
+    std::vector<scm::math::quatf> rotations_;
+    std::vector<scm::math::vec3f> translations_;
 };
 
 } // namespace gua
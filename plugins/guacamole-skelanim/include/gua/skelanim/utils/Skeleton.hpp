@@ -72,6 +72,17 @@ class GUA_SKELANIM_DLL Skeleton
      */
     std::vector<scm::math::mat4f> accumulate_matrices(unsigned index_bone, SkeletalPose const& pose) const;
 
+    /**
+     * @brief calculates tranform matrices from skeletalpose
+     * @details writes transform matrices for all bones of skeleton
+     * to the given vector, which is only reallocated if its size
+     * does not match the number of bones
+     *
+     * @param pose pose from which transformation is calculated
+     * @param matrices vector to write to
+     */
+    void accumulate_matrices(unsigned index_bone, SkeletalPose const& pose, std::vector<scm::math::mat4f>& matrices) const;
+
     /**
      * @brief finds bone in hierarchy
      * @details
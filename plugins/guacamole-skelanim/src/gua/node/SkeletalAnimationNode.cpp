@@ -32,6 +32,7 @@
 // #include <gua/node/RayNode.hpp>
 #include <gua/math/BoundingBoxAlgo.hpp>
 #include <gua/databases/GeometryDatabase.hpp>
+#include <gua/concurrent/ThreadPool.hpp>
 
 namespace gua
 {
@@ -62,6 +63,7 @@ void SkeletalAnimationNode::set_geometry_descriptions(std::vector<std::string> c
 {
     geometry_descriptions_ = v;
     geometry_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -70,6 +72,8 @@ void SkeletalAnimationNode::set_skeleton_description(std::string const& descript
     gua::SkeletalAnimationLoader loader;
     skeleton_ = loader.load_skeleton(description);
     new_bones_ = true;
+    bind_animations();
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -81,6 +85,7 @@ void SkeletalAnimationNode::add_material(std::shared_ptr<Material> const& materi
     //   Logger::LOG_WARNING << "Cant have more materials than geometries"
     //                     << std::endl;
     // }
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -111,6 +116,7 @@ void SkeletalAnimationNode::set_material(std::shared_ptr<Material> material, uns
     {
         Logger::LOG_ERROR << "Cant set material of invalid index!" << std::endl;
     }
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -124,6 +130,26 @@ void SkeletalAnimationNode::add_animations(std::string const& file_name, std::st
     }
 
     has_anims_ = animations_.size() > 0;
+    bind_animations();
+    invalidate_snapshot();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SkeletalAnimationNode::add_animation(SkeletalAnimation const& animation)
+{
+    auto result(animations_.insert(std::make_pair(animation.get_name(), animation)));
+    result.first->second.bind(skeleton_);
+    has_anims_ = true;
+    invalidate_snapshot();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SkeletalAnimationNode::bind_animations()
+{
+    for(auto& animation : animations_)
+    {
+        animation.second.bind(skeleton_);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -135,18 +161,18 @@ void SkeletalAnimationNode::update_bone_transforms()
     if(!has_anims_)
     {
         new_bones_ = false;
-        bone_transforms_ = SkeletalTransformation::from_hierarchy(skeleton_, 0);
+        pose_1_.reset(0);
     }
     // use first anim
     else if(blend_factor_ <= 0.0)
     {
         if(anim_1_ != SkeletalAnimationNode::none_loaded)
         {
-            bone_transforms_ = SkeletalTransformation::from_anim(skeleton_, 0, anim_time_1_, animations_.at(anim_1_));
+            animations_.at(anim_1_).calculate_pose(anim_time_1_, skeleton_, pose_1_);
         }
         else
         {
-            bone_transforms_ = SkeletalTransformation::from_hierarchy(skeleton_, 0);
+            pose_1_.reset(0);
         }
     }
     // use second anim
@@ -154,36 +180,72 @@ void SkeletalAnimationNode::update_bone_transforms()
     {
         if(anim_2_ != SkeletalAnimationNode::none_loaded)
         {
-            SkeletalTransformation::from_anim(skeleton_, 0, anim_time_2_, animations_.at(anim_2_));
+            animations_.at(anim_2_).calculate_pose(anim_time_2_, skeleton_, pose_1_);
         }
         else
         {
-            bone_transforms_ = SkeletalTransformation::from_hierarchy(skeleton_, 0);
+            pose_1_.reset(0);
         }
     }
     // use both anims
     else
     {
-        bone_transforms_ = SkeletalTransformation::blend_anims(skeleton_, 0, blend_factor_, anim_time_1_, anim_time_2_, animations_.at(anim_1_), animations_.at(anim_2_));
+        animations_.at(anim_1_).calculate_pose(anim_time_1_, skeleton_, pose_1_);
+        animations_.at(anim_2_).calculate_pose(anim_time_2_, skeleton_, pose_2_);
+        pose_1_.blend(pose_2_, blend_factor_);
     }
+
+    // poses and matrices keep their memory between updates
+    skeleton_.accumulate_matrices(0, pose_1_, bone_transforms_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void SkeletalAnimationNode::update_bone_transforms(std::vector<SkeletalAnimationNode*> const& nodes, concurrent::ThreadPool* pool)
+{
+    if(!pool)
+    {
+        for(auto node : nodes)
+        {
+            node->update_bone_transforms();
+        }
+        return;
+    }
+
+    // nodes only write to their own poses and matrices
+    pool->parallel_for(0, nodes.size(), [&nodes](std::size_t begin, std::size_t end) {
+        for(std::size_t i(begin); i < end; ++i)
+        {
+            nodes[i]->update_bone_transforms();
+        }
+    });
 }
 ////////////////////////////////////////////////////////////////////////////////
 bool SkeletalAnimationNode::get_render_to_gbuffer() const { return render_to_gbuffer_; }
 
 ////////////////////////////////////////////////////////////////////////////////
-void SkeletalAnimationNode::set_render_to_gbuffer(bool enable) { render_to_gbuffer_ = enable; }
+void SkeletalAnimationNode::set_render_to_gbuffer(bool enable)
+{
+    render_to_gbuffer_ = enable;
+    invalidate_snapshot();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 bool SkeletalAnimationNode::get_render_to_stencil_buffer() const { return render_to_stencil_buffer_; }
 
 ////////////////////////////////////////////////////////////////////////////////
-void SkeletalAnimationNode::set_render_to_stencil_buffer(bool enable) { render_to_stencil_buffer_ = enable; }
+void SkeletalAnimationNode::set_render_to_stencil_buffer(bool enable)
+{
+    render_to_stencil_buffer_ = enable;
+    invalidate_snapshot();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 void SkeletalAnimationNode::set_bones(std::vector<Bone> const& bones)
 {
     skeleton_.set_bones(bones);
     new_bones_ = true;
+    bind_animations();
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -460,6 +522,7 @@ std::shared_ptr<Node> SkeletalAnimationNode::copy() const
     result->geometry_changed_ = geometry_changed_;
     result->skeleton_ = skeleton_;
     result->animations_ = animations_;
+    result->bind_animations();
     result->new_bones_ = new_bones_;
     result->has_anims_ = has_anims_;
     result->anim_1_ = anim_1_;
@@ -494,6 +557,7 @@ void SkeletalAnimationNode::set_animation_1(std::string const& animation_name)
     //   gua::Logger::LOG_ERROR << "No matching animation with name: '"
     //                            << animation_name << "' found!" << std::endl;
     // }
+    invalidate_snapshot();
 }
 std::string const& SkeletalAnimationNode::get_animation_2() const
 {
@@ -516,6 +580,7 @@ void SkeletalAnimationNode::set_animation_2(std::string const& animation_name)
     //   gua::Logger::LOG_ERROR << "No matching animation with name: '"
     //                            << animation_name << "' found!" << std::endl;
     // }
+    invalidate_snapshot();
 }
 
 float SkeletalAnimationNode::get_duration(std::string const& animation_name) const
@@ -533,13 +598,25 @@ float SkeletalAnimationNode::get_duration(std::string const& animation_name) con
 
 float SkeletalAnimationNode::get_blend_factor() const { return blend_factor_; }
 
-void SkeletalAnimationNode::set_blend_factor(float f) { blend_factor_ = f; }
+void SkeletalAnimationNode::set_blend_factor(float f)
+{
+    blend_factor_ = f;
+    invalidate_snapshot();
+}
 
-void SkeletalAnimationNode::set_time_1(float time) { anim_time_1_ = time; }
+void SkeletalAnimationNode::set_time_1(float time)
+{
+    anim_time_1_ = time;
+    invalidate_snapshot();
+}
 
 float SkeletalAnimationNode::get_time_1() const { return anim_time_1_; }
 
-void SkeletalAnimationNode::set_time_2(float time) { anim_time_2_ = time; }
+void SkeletalAnimationNode::set_time_2(float time)
+{
+    anim_time_2_ = time;
+    invalidate_snapshot();
+}
 
 float SkeletalAnimationNode::get_time_2() const { return anim_time_2_; }
 
@@ -50,6 +50,30 @@ std::shared_ptr<PipelinePassDescription> SkeletalAnimationPassDescription::make_
 
 ////////////////////////////////////////////////////////////////////////////////
 
+SkeletalAnimationPassDescription& SkeletalAnimationPassDescription::update_lod_distance(float value)
+{
+    update_lod_distance_ = value;
+    return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+float SkeletalAnimationPassDescription::update_lod_distance() const { return update_lod_distance_; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkeletalAnimationPassDescription& SkeletalAnimationPassDescription::max_update_interval(unsigned value)
+{
+    max_update_interval_ = value;
+    return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned SkeletalAnimationPassDescription::max_update_interval() const { return max_update_interval_; }
+
+////////////////////////////////////////////////////////////////////////////////
+
 PipelinePass SkeletalAnimationPassDescription::make_pass(RenderContext const& ctx, SubstitutionMap& substitution_map)
 {
     auto renderer = std::make_shared<SkeletalAnimationRenderer>(ctx);
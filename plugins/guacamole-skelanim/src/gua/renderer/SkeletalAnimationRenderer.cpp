@@ -25,10 +25,16 @@
 // guacamole headers
 #include <gua/skelanim/node/SkeletalAnimationNode.hpp>
 #include <gua/skelanim/renderer/SkinnedMeshResource.hpp>
+#include <gua/skelanim/renderer/SkeletalAnimationPass.hpp>
+#include <gua/concurrent/ThreadPool.hpp>
 #include <gua/renderer/Pipeline.hpp>
 #include <gua/renderer/MaterialShader.hpp>
 #include <gua/databases/Resources.hpp>
 
+// external headers
+#include <algorithm>
+#include <cmath>
+
 namespace
 {
 gua::math::vec2ui get_handle(scm::gl::texture_image_ptr const& tex)
@@ -43,7 +49,7 @@ namespace gua
 {
 ////////////////////////////////////////////////////////////////////////////////
 
-SkeletalAnimationRenderer::SkeletalAnimationRenderer(RenderContext const& ctx) : bones_block_(ctx.render_device), last_frame_(0)
+SkeletalAnimationRenderer::SkeletalAnimationRenderer(RenderContext const& ctx) : bones_block_(ctx.render_device), last_frame_(0), next_phase_(0)
 {
 #ifdef GUACAMOLE_RUNTIME_PROGRAM_COMPILATION
     ResourceFactory factory;
@@ -68,6 +74,96 @@ void SkeletalAnimationRenderer::create_state_objects(RenderContext const& ctx)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void SkeletalAnimationRenderer::update_bone_transforms(Pipeline& pipe, PipelinePassDescription const& desc)
+{
+    auto const& skel_desc(static_cast<SkeletalAnimationPassDescription const&>(desc));
+    auto const& scene(*pipe.current_viewstate().scene);
+    auto const& nodes(scene.nodes.find(std::type_index(typeid(node::SkeletalAnimationNode)))->second);
+
+    float lod_distance(skel_desc.update_lod_distance());
+    unsigned max_interval(std::max(1u, skel_desc.max_update_interval()));
+    auto camera_position(scene.rendering_frustum.get_camera_position());
+    unsigned frame(pipe.get_context().framecount);
+
+    // the serialized nodes have already passed frustum culling
+    update_nodes_.clear();
+
+    if(lod_distance <= 0.f)
+    {
+        cached_bones_.clear();
+
+        for(auto const& object : nodes)
+        {
+            update_nodes_.push_back(reinterpret_cast<node::SkeletalAnimationNode*>(object));
+        }
+
+        node::SkeletalAnimationNode::update_bone_transforms(update_nodes_, concurrent::ThreadPool::instance());
+        return;
+    }
+
+    for(auto const& object : nodes)
+    {
+        auto skel_anim_node(reinterpret_cast<node::SkeletalAnimationNode*>(object));
+        auto& cached(cached_bones_[skel_anim_node->uuid()]);
+        cached.last_frame = frame;
+
+        // nodes without previous bones are updated right away
+        if(cached.transforms.empty())
+        {
+            cached.phase = next_phase_++;
+        }
+        else
+        {
+            auto distance(scm::math::length(math::get_translation(skel_anim_node->get_cached_world_transform()) - camera_position));
+            unsigned interval(std::min(max_interval, unsigned(std::ceil(distance / lod_distance))));
+
+            // spread the updates of distant nodes over the frames
+            if(interval > 1 && (frame + cached.phase) % interval != 0)
+            {
+                continue;
+            }
+        }
+
+        update_nodes_.push_back(skel_anim_node);
+    }
+
+    node::SkeletalAnimationNode::update_bone_transforms(update_nodes_, concurrent::ThreadPool::instance());
+
+    for(auto skel_anim_node : update_nodes_)
+    {
+        cached_bones_[skel_anim_node->uuid()].transforms = skel_anim_node->get_bone_transforms();
+    }
+
+    // forget nodes which left the view; they are updated once they return
+    for(auto cached(cached_bones_.begin()); cached != cached_bones_.end();)
+    {
+        if(cached->second.last_frame != frame)
+        {
+            cached = cached_bones_.erase(cached);
+        }
+        else
+        {
+            ++cached;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<scm::math::mat4f> const& SkeletalAnimationRenderer::get_bone_transforms(node::SkeletalAnimationNode const& node) const
+{
+    auto cached(cached_bones_.find(node.uuid()));
+
+    if(cached != cached_bones_.end() && !cached->second.transforms.empty())
+    {
+        return cached->second.transforms;
+    }
+
+    return node.get_bone_transforms();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void SkeletalAnimationRenderer::render(Pipeline& pipe, PipelinePassDescription const& desc)
 {
     auto& scene = *pipe.current_viewstate().scene;
@@ -108,6 +204,11 @@ void SkeletalAnimationRenderer::render(Pipeline& pipe, PipelinePassDescription c
         auto current_rasterizer_state = rs_cull_back_;
         ctx.render_context->apply();
 
+        if(ctx.framecount > last_frame_)
+        {
+            update_bone_transforms(pipe, desc);
+        }
+
         ctx.render_context->bind_uniform_buffer(bones_block_.block().block_buffer(), 2);
         // loop through all objects, sorted by material ----------------------------
         for(auto const& object : sorted_objects->second)
@@ -195,12 +296,8 @@ void SkeletalAnimationRenderer::render(Pipeline& pipe, PipelinePassDescription c
                     }
 
                     ctx.render_context->apply_program();
-                    if(ctx.framecount > last_frame_)
-                    {
-                        skel_anim_node->update_bone_transforms();
-                    }
 
-                    bones_block_.update(ctx.render_context, skel_anim_node->get_bone_transforms());
+                    bones_block_.update(ctx.render_context, get_bone_transforms(*skel_anim_node));
                     // upload data if necessary
                     auto iter = ctx.meshes.find(geometries[i]->uuid());
                     if(iter == ctx.meshes.end())
@@ -4,6 +4,7 @@
 // guacamole headers
 #include <gua/utils/Logger.hpp>
 #include <gua/skelanim/utils/BonePose.hpp>
+#include <gua/skelanim/utils/SkeletalPose.hpp>
 #include <gua/utils/ToGua.hpp>
 
 // external headers
@@ -12,6 +13,8 @@
 #endif
 #include <assimp/scene.h> // for ainodeanim
 
+#include <algorithm>
+
 namespace gua
 {
 BoneAnimation::BoneAnimation() : name("default"), scalingKeys(), rotationKeys(), translationKeys() {}
@@ -61,6 +64,11 @@ BoneAnimation::BoneAnimation(aiNodeAnim* anim) : name(anim->mNodeName.C_Str()),
 
 BonePose BoneAnimation::calculate_pose(float time) const { return BonePose{calculate_value(time, scalingKeys), calculate_value(time, rotationKeys), calculate_value(time, translationKeys)}; }
 
+void BoneAnimation::calculate_pose(float time, unsigned bone, SkeletalPose& pose) const
+{
+    pose.set_transform(bone, calculate_value(time, scalingKeys), calculate_value(time, rotationKeys), calculate_value(time, translationKeys));
+}
+
 std::string const& BoneAnimation::get_name() const { return name; }
 
 scm::math::vec3f BoneAnimation::interpolate(scm::math::vec3f val1, scm::math::vec3f val2, float factor) const { return val1 * (1 - factor) + val2 * factor; }
@@ -68,7 +76,7 @@ scm::math::vec3f BoneAnimation::interpolate(scm::math::vec3f val1, scm::math::ve
 scm::math::quatf BoneAnimation::interpolate(scm::math::quatf val1, scm::math::quatf val2, float factor) const { return normalize(slerp(val1, val2, factor)); }
 
 template <class T>
-int BoneAnimation::find_key(float animationTime, std::vector<Keyframe<T>> keys) const
+int BoneAnimation::find_key(float animationTime, std::vector<Keyframe<T>> const& keys) const
 {
     if(keys.size() < 1)
     {
@@ -76,19 +84,14 @@ int BoneAnimation::find_key(float animationTime, std::vector<Keyframe<T>> keys)
         assert(false);
     }
 
-    for(int i = -1; i < int(keys.size() - 1); ++i)
-    {
-        if(animationTime < (float)keys[i + 1].time)
-        {
-            return i;
-        }
-    }
+    // first key after the given time
+    auto next = std::upper_bound(keys.begin(), keys.end(), animationTime, [](float time, Keyframe<T> const& key) { return time < (float)key.time; });
 
-    return keys.size() - 1;
+    return int(next - keys.begin()) - 1;
 }
 
 template <class T>
-T BoneAnimation::calculate_value(float time, std::vector<Keyframe<T>> keys) const
+T BoneAnimation::calculate_value(float time, std::vector<Keyframe<T>> const& keys) const
 {
     if(keys.size() == 1)
     {
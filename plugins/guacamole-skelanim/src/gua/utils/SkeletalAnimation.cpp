@@ -5,6 +5,7 @@
 #include <gua/skelanim/utils/SkeletalPose.hpp>
 #include <gua/skelanim/utils/BonePose.hpp>
 #include <gua/skelanim/utils/BoneAnimation.hpp>
+#include <gua/skelanim/utils/Skeleton.hpp>
 
 // external headers
 #ifdef GUACAMOLE_FBX
@@ -14,11 +15,11 @@
 
 namespace gua
 {
-SkeletalAnimation::SkeletalAnimation() : name("default"), numFrames(0), numFPS(0), duration(0), numBoneAnims(0), boneAnims() {}
+SkeletalAnimation::SkeletalAnimation() : name("default"), numFrames(0), numFPS(0), duration(0), numBoneAnims(0), boneAnims(), boundSkeleton(nullptr), boneIndices() {}
 
 SkeletalAnimation::SkeletalAnimation(aiAnimation const& anim, std::string const& nm)
     : name(nm == "" ? anim.mName.C_Str() : nm), numFrames(unsigned(anim.mDuration)), numFPS(anim.mTicksPerSecond > 0 ? anim.mTicksPerSecond : 25), duration(double(numFrames) / numFPS),
-      numBoneAnims(anim.mNumChannels), boneAnims()
+      numBoneAnims(anim.mNumChannels), boneAnims(), boundSkeleton(nullptr), boneIndices()
 {
     for(unsigned i = 0; i < numBoneAnims; ++i)
     {
@@ -28,7 +29,7 @@ SkeletalAnimation::SkeletalAnimation(aiAnimation const& anim, std::string const&
 
 #ifdef GUACAMOLE_FBX
 SkeletalAnimation::SkeletalAnimation(FbxAnimStack* anim, std::vector<FbxNode*> const& bones, std::string const& nm)
-    : name(nm == "" ? anim->GetName() : nm), numFrames(0), numFPS(0), duration(0), numBoneAnims(0), boneAnims()
+    : name(nm == "" ? anim->GetName() : nm), numFrames(0), numFPS(0), duration(0), numBoneAnims(0), boneAnims(), boundSkeleton(nullptr), boneIndices()
 {
     // set animation for which the bones will be evaluated
     FbxScene* scene = anim->GetScene();
@@ -47,21 +48,43 @@ SkeletalAnimation::SkeletalAnimation(FbxAnimStack* anim, std::vector<FbxNode*> c
 
 SkeletalAnimation::~SkeletalAnimation() {}
 
-SkeletalPose SkeletalAnimation::calculate_pose(float time) const
+void SkeletalAnimation::bind(Skeleton const& skeleton)
 {
-    SkeletalPose pose{};
+    boundSkeleton = &skeleton;
+    boneIndices.clear();
 
-    float currFrame = time * numFrames;
     for(BoneAnimation const& boneAnim : boneAnims)
     {
-        BonePose boneTransform = boneAnim.calculate_pose(currFrame);
-
-        pose.set_transform(boneAnim.get_name(), boneTransform);
+        boneIndices.push_back(skeleton.find(boneAnim.get_name()));
     }
+}
 
+SkeletalPose SkeletalAnimation::calculate_pose(float time, Skeleton const& skeleton) const
+{
+    SkeletalPose pose{};
+    calculate_pose(time, skeleton, pose);
     return pose;
 }
 
+void SkeletalAnimation::calculate_pose(float time, Skeleton const& skeleton, SkeletalPose& pose) const
+{
+    pose.reset(skeleton.num_bones());
+
+    // bones are looked up by name if the anim is not bound to this skeleton
+    bool bound = boundSkeleton == &skeleton && boneIndices.size() == boneAnims.size();
+
+    float currFrame = time * numFrames;
+    for(std::size_t i = 0; i < boneAnims.size(); ++i)
+    {
+        int bone = bound ? boneIndices[i] : skeleton.find(boneAnims[i].get_name());
+
+        if(bone >= 0 && std::size_t(bone) < pose.size())
+        {
+            boneAnims[i].calculate_pose(currFrame, unsigned(bone), pose);
+        }
+    }
+}
+
 double SkeletalAnimation::get_duration() const { return duration; }
 
 std::string const& SkeletalAnimation::get_name() const { return name; }
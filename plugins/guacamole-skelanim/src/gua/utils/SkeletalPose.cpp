@@ -8,54 +8,140 @@
 
 namespace gua
 {
-const BonePose SkeletalPose::blank_pose = BonePose{};
+namespace
+{
+// per bone linear interpolation, written as a flat loop the compiler can
+// vectorize
+void lerp(scm::math::vec3f* values, scm::math::vec3f const* others, float const* factors, std::size_t count)
+{
+    float* a(&values[0][0]);
+    float const* b(&others[0][0]);
+
+    for(std::size_t i(0); i < count; ++i)
+    {
+        for(std::size_t c(0); c < 3; ++c)
+        {
+            a[3 * i + c] += (b[3 * i + c] - a[3 * i + c]) * factors[i];
+        }
+    }
+}
+} // namespace
+
+SkeletalPose::SkeletalPose() : contained_{}, scalings_{}, rotations_{}, translations_{} {}
+
+SkeletalPose::SkeletalPose(std::size_t num_bones)
+    : contained_(num_bones, 0), scalings_(num_bones, scm::math::vec3f{1.0f}), rotations_(num_bones, scm::math::quatf::identity()), translations_(num_bones, scm::math::vec3f{0.0f})
+{
+}
 
-SkeletalPose::SkeletalPose() : transforms{} {}
+std::size_t SkeletalPose::size() const { return contained_.size(); }
 
-bool SkeletalPose::contains(std::string const& name) const { return transforms.find(name) != transforms.end(); }
+void SkeletalPose::reset(std::size_t num_bones)
+{
+    contained_.assign(num_bones, 0);
+    scalings_.resize(num_bones);
+    rotations_.resize(num_bones);
+    translations_.resize(num_bones);
+}
+
+bool SkeletalPose::contains(unsigned bone) const { return bone < contained_.size() && contained_[bone]; }
 
-BonePose const& SkeletalPose::get_transform(std::string const& name) const
+BonePose SkeletalPose::get_transform(unsigned bone) const
 {
-    if(contains(name))
+    if(contains(bone))
     {
-        return transforms.at(name);
+        return BonePose{scalings_[bone], rotations_[bone], translations_[bone]};
     }
     else
     {
-        Logger::LOG_ERROR << "bone '" << name << "' not contained in pose" << std::endl;
-        return blank_pose;
+        Logger::LOG_ERROR << "bone " << bone << " not contained in pose" << std::endl;
+        return BonePose{};
     }
 }
 
-void SkeletalPose::set_transform(std::string const& name, BonePose const& value) { transforms[name] = value; }
+scm::math::mat4f SkeletalPose::get_matrix(unsigned bone) const
+{
+    return scm::math::make_translation(translations_[bone]) * rotations_[bone].to_matrix() * scm::math::make_scale(scalings_[bone]);
+}
+
+void SkeletalPose::set_transform(unsigned bone, BonePose const& value) { set_transform(bone, value.get_scaling(), value.get_rotation(), value.get_translation()); }
+
+void SkeletalPose::set_transform(unsigned bone, scm::math::vec3f const& scaling, scm::math::quatf const& rotation, scm::math::vec3f const& translation)
+{
+    grow(bone + 1);
+
+    contained_[bone] = 1;
+    scalings_[bone] = scaling;
+    rotations_[bone] = rotation;
+    translations_[bone] = translation;
+}
 
 void SkeletalPose::blend(SkeletalPose const& pose2, float blendFactor)
 {
-    for_each(pose2.transforms.cbegin(), pose2.transforms.cend(), [this, &blendFactor](std::pair<std::string, BonePose> const& p) {
-        if(contains(p.first))
+    grow(pose2.size());
+
+    // bones missing in this pose are copied, bones missing in the other
+    // pose are kept
+    std::vector<float> factors(pose2.size(), 0.0f);
+    for(std::size_t i = 0; i < pose2.size(); ++i)
+    {
+        if(pose2.contained_[i])
         {
-            set_transform(p.first, get_transform(p.first).blend(p.second, blendFactor));
+            factors[i] = blendFactor;
+
+            if(!contained_[i])
+            {
+                contained_[i] = 1;
+                scalings_[i] = pose2.scalings_[i];
+                rotations_[i] = pose2.rotations_[i];
+                translations_[i] = pose2.translations_[i];
+            }
         }
-        else
+    }
+
+    if(pose2.size() == 0)
+    {
+        return;
+    }
+
+    lerp(scalings_.data(), pose2.scalings_.data(), factors.data(), pose2.size());
+    lerp(translations_.data(), pose2.translations_.data(), factors.data(), pose2.size());
+
+    for(std::size_t i = 0; i < pose2.size(); ++i)
+    {
+        if(pose2.contained_[i])
         {
-            set_transform(p.first, p.second);
+            rotations_[i] = slerp(rotations_[i], pose2.rotations_[i], blendFactor);
         }
-    });
-    // *this = *this * (1 - blendFactor) + pose2 * blendFactor;
+    }
 }
 
 SkeletalPose& SkeletalPose::operator+=(SkeletalPose const& pose2)
 {
-    for_each(pose2.transforms.cbegin(), pose2.transforms.cend(), [this](std::pair<std::string, BonePose> const& p) {
-        if(contains(p.first))
+    grow(pose2.size());
+
+    for(std::size_t i = 0; i < pose2.size(); ++i)
+    {
+        if(!pose2.contained_[i])
         {
-            set_transform(p.first, get_transform(p.first) + p.second);
+            continue;
+        }
+
+        if(contained_[i])
+        {
+            scalings_[i] = scalings_[i] + pose2.scalings_[i];
+            rotations_[i] = scm::math::normalize(pose2.rotations_[i] * rotations_[i]);
+            translations_[i] = translations_[i] + pose2.translations_[i];
         }
         else
         {
-            set_transform(p.first, p.second);
+            contained_[i] = 1;
+            scalings_[i] = pose2.scalings_[i];
+            rotations_[i] = pose2.rotations_[i];
+            translations_[i] = pose2.translations_[i];
         }
-    });
+    }
+
     return *this;
 }
 SkeletalPose SkeletalPose::operator+(SkeletalPose const& p2) const
@@ -67,9 +153,14 @@ SkeletalPose SkeletalPose::operator+(SkeletalPose const& p2) const
 
 SkeletalPose& SkeletalPose::operator*=(float const factor)
 {
-    for(auto& p : transforms)
+    for(std::size_t i = 0; i < size(); ++i)
     {
-        p.second *= factor;
+        if(contained_[i])
+        {
+            scalings_[i] = scalings_[i] * factor;
+            rotations_[i] = slerp(scm::math::quatf::identity(), rotations_[i], factor);
+            translations_[i] = translations_[i] * factor;
+        }
     }
     return *this;
 }
@@ -82,9 +173,9 @@ SkeletalPose SkeletalPose::operator*(float const factor) const
 
 void SkeletalPose::partial_replace(SkeletalPose const& pose2, Skeleton const& skeleton, unsigned bone)
 {
-    if(pose2.contains(skeleton.get(bone).name))
+    if(pose2.contains(bone))
     {
-        set_transform(skeleton.get(bone).name, pose2.get_transform(skeleton.get(bone).name));
+        set_transform(bone, pose2.scalings_[bone], pose2.rotations_[bone], pose2.translations_[bone]);
     }
 
     for(auto const& child : skeleton.get(bone).children)
@@ -93,4 +184,15 @@ void SkeletalPose::partial_replace(SkeletalPose const& pose2, Skeleton const& sk
     }
 }
 
-} // namespace gua
\ No newline at end of file
+void SkeletalPose::grow(std::size_t num_bones)
+{
+    if(num_bones > size())
+    {
+        contained_.resize(num_bones, 0);
+        scalings_.resize(num_bones, scm::math::vec3f{1.0f});
+        rotations_.resize(num_bones, scm::math::quatf::identity());
+        translations_.resize(num_bones, scm::math::vec3f{0.0f});
+    }
+}
+
+} // namespace gua
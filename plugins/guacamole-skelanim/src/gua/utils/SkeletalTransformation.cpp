@@ -15,8 +15,8 @@ namespace SkeletalTransformation
 std::vector<scm::math::mat4f>
 blend_anims(Skeleton const& skeleton, unsigned start_node, float blend_factor, float time_normalized1, float time_normalized2, SkeletalAnimation const& anim_1, SkeletalAnimation const& anim_2)
 {
-    SkeletalPose pose1{anim_1.calculate_pose(time_normalized1)};
-    SkeletalPose pose2{anim_2.calculate_pose(time_normalized2)};
+    SkeletalPose pose1{anim_1.calculate_pose(time_normalized1, skeleton)};
+    SkeletalPose pose2{anim_2.calculate_pose(time_normalized2, skeleton)};
 
     pose1.blend(pose2, blend_factor);
 
@@ -26,8 +26,8 @@ blend_anims(Skeleton const& skeleton, unsigned start_node, float blend_factor, f
 std::vector<scm::math::mat4f> partial_blend(
     Skeleton const& skeleton, unsigned start_node, float time_normalized1, float time_normalized2, SkeletalAnimation const& anim_1, SkeletalAnimation const& anim_2, std::string const& split_node_name)
 {
-    SkeletalPose full_body{anim_1.calculate_pose(time_normalized1)};
-    SkeletalPose upper_body{anim_2.calculate_pose(time_normalized2)};
+    SkeletalPose full_body{anim_1.calculate_pose(time_normalized1, skeleton)};
+    SkeletalPose upper_body{anim_2.calculate_pose(time_normalized2, skeleton)};
 
     int split_index = skeleton.find(split_node_name);
     if(split_index >= 0)
@@ -44,7 +44,7 @@ std::vector<scm::math::mat4f> partial_blend(
 
 std::vector<scm::math::mat4f> from_anim(Skeleton const& skeleton, unsigned start_node, float time_normalized, SkeletalAnimation const& anim)
 {
-    return skeleton.accumulate_matrices(start_node, anim.calculate_pose(time_normalized));
+    return skeleton.accumulate_matrices(start_node, anim.calculate_pose(time_normalized, skeleton));
 }
 
 std::vector<scm::math::mat4f> from_hierarchy(Skeleton const& skeleton, unsigned start_node) { return skeleton.accumulate_matrices(start_node, SkeletalPose{}); }
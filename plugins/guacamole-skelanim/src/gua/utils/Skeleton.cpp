@@ -14,6 +14,8 @@
 #endif
 #include <assimp/scene.h>
 
+#include <algorithm>
+
 namespace gua
 {
 unsigned Skeleton::addBone(aiNode const& node)
@@ -158,7 +160,12 @@ Skeleton::Skeleton(FbxScene& scene)
 
 std::vector<Bone> const& Skeleton::get_bones() const { return m_bones; }
 
-void Skeleton::set_bones(std::vector<Bone> const& bones) { m_bones = bones; }
+void Skeleton::set_bones(std::vector<Bone> const& bones)
+{
+    m_bones = bones;
+    m_mapping.clear();
+    store_mapping();
+}
 
 int Skeleton::find(std::string const& name) const
 {
@@ -207,14 +214,21 @@ std::vector<scm::math::mat4f> Skeleton::accumulate_matrices(unsigned index_bone,
     return matrices;
 }
 
+void Skeleton::accumulate_matrices(unsigned index_bone, SkeletalPose const& pose, std::vector<scm::math::mat4f>& matrices) const
+{
+    matrices.resize(num_bones());
+    std::fill(matrices.begin(), matrices.end(), scm::math::mat4f::identity());
+    accumulate_matrices(index_bone, matrices, pose, scm::math::mat4f::identity());
+}
+
 void Skeleton::accumulate_matrices(unsigned index_bone, std::vector<scm::math::mat4f>& transformMat4s, SkeletalPose const& pose, scm::math::mat4f const& parentTransform) const
 {
     auto const& bone = m_bones[index_bone];
     // initialize with idle transform
     scm::math::mat4f nodeTransformation{bone.idle_matrix};
-    if(pose.contains(bone.name))
+    if(pose.contains(index_bone))
     {
-        nodeTransformation = pose.get_transform(bone.name).to_matrix();
+        nodeTransformation = pose.get_matrix(index_bone);
     }
 
     scm::math::mat4f finalTransformation = parentTransform * nodeTransformation;
@@ -57,7 +57,11 @@ class GUA_SPOINTS_DLL SPointsNode : public GeometryNode
     void update_cache() override;
 
     inline float get_screen_space_point_size() const { return screen_space_point_size_; }
-    inline void set_screen_space_point_size(float point_size) { screen_space_point_size_ = point_size; }
+    inline void set_screen_space_point_size(float point_size)
+    {
+        screen_space_point_size_ = point_size;
+        invalidate_snapshot();
+    }
 
 
     inline spoints::SPointsStats get_latest_spoints_stats() const
@@ -72,6 +76,18 @@ class GUA_SPOINTS_DLL SPointsNode : public GeometryNode
         }
     };
 
+    inline spoints::SPointsDecodeStats get_latest_decode_stats() const
+    {
+        if(nullptr != spoints_)
+        {
+            return spoints_->get_latest_decode_stats();
+        }
+        else
+        {
+            return spoints::SPointsDecodeStats();
+        }
+    };
+
     /**
      * Accepts a visitor and calls concrete visit method.
      *
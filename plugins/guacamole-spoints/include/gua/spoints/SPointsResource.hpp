@@ -103,6 +103,21 @@ class GUA_SPOINTS_DLL SPointsResource : public GeometryResource
         return spoints::SPointsStats();
     }
 
+    spoints::SPointsDecodeStats get_latest_decode_stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_push_matrix_package_mutex_);
+
+        if(spointsdata_)
+        {
+            if(spointsdata_->nka_)
+            {
+                return spointsdata_->nka_->get_latest_decode_stats();
+            }
+        }
+
+        return spoints::SPointsDecodeStats();
+    }
+
     void push_matrix_package(spoints::camera_matrix_package const& cam_mat_package);
 
     void update_buffers(RenderContext const& ctx, Pipeline& pipe);
@@ -7,7 +7,11 @@
 #include <gua/math/BoundingBox.hpp>
 #include <gua/math/math.hpp>
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
@@ -18,6 +22,11 @@
 #include <turbojpeg.h>
 #endif //GUACAMOLE_ENABLE_TURBOJPEG
 
+namespace zmq
+{
+class message_t;
+}
+
 namespace spoints
 {
 struct key_package
@@ -107,6 +116,17 @@ struct SPointsStats
     uint32_t m_total_message_payload_in_byte = 0;
 };
 
+// time a frame spent in each stage of the decode pipeline
+struct SPointsDecodeStats
+{
+    float m_queue_wait_ms = 0.0f;       // received -> unpacking started
+    float m_unpack_ms = 0.0f;           // header parsing and uncompressed copies
+    float m_geometry_decode_ms = 0.0f;  // LZ4, overlaps with image decoding
+    float m_image_decode_ms = 0.0f;     // all JPEG layers, decoded in parallel
+    float m_total_ms = 0.0f;            // received -> ready for the cpu swap
+    uint32_t m_dropped_messages = 0;    // total replaced by newer ones before unpacking
+};
+
 struct SPointsCalibrationDescriptor {
     uint32_t num_sensors = 0;
     std::array<uint32_t, 3> inv_xyz_calibration_res;
@@ -128,6 +148,8 @@ struct SPointsModelDescriptor {
     uint32_t total_message_payload_in_byte = 0;
 
     bool is_fully_encoded_vertex_data = false;
+
+    SPointsDecodeStats decode_stats;
 };
 
 class NetKinectArray
@@ -174,16 +196,28 @@ class NetKinectArray
                             m_model_descriptor_.total_message_payload_in_byte};
     }
 
+    SPointsDecodeStats get_latest_decode_stats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex_);
+
+        return m_model_descriptor_.decode_stats;
+    }
+
     // void push_matrix_package(bool is_camera, std::size_t view_uuid, bool is_stereo_mode, matrix_package mp);
     void push_matrix_package(spoints::camera_matrix_package const& cam_mat_package);
 
     bool has_calibration(gua::RenderContext const& ctx) { return m_received_calibration_[ctx.id].load(); }
 
+    // makes the latest decoded frame current without uploading it, e.g. to
+    // replay recorded messages without a render context
+    bool swap_decoded_frame() { return _try_swap_model_data_cpu(); }
+
   // helper functions
   private:
 #ifdef GUACAMOLE_ENABLE_TURBOJPEG
-    void _decompress_geometry_buffer();
-    void _decompress_images();
+    // both return the elapsed time in milliseconds
+    float _decompress_geometry_buffer(uint8_t const* compressed_geometry, std::size_t compressed_byte_size);
+    float _decompress_images(uint8_t const* compressed_images);
 #endif //GUACAMOLE_ENABLE_TURBOJPEG
     void _unpack_back_message();
     void _readloop();
@@ -192,7 +226,7 @@ class NetKinectArray
 
     bool _try_swap_calibration_data_gpu(gua::RenderContext const& ctx);
 
-    void _try_swap_model_data_cpu();
+    bool _try_swap_model_data_cpu();
 
     // receiving geometry
 
@@ -206,27 +240,21 @@ class NetKinectArray
     std::mutex m_mutex_;
 
     std::mutex m_unpack_mutex_;
+    std::condition_variable m_unpack_condition_;
 
-    bool m_has_new_message_to_unpack = false;
-    std::vector<uint8_t> m_back_zmq_unpack_buffer_ = std::vector<uint8_t>(MAX_ZMQ_MESSAGE_SIZE);
-    std::vector<uint8_t> m_front_zmq_unpack_buffer_ = std::vector<uint8_t>(MAX_ZMQ_MESSAGE_SIZE);
-
-    std::size_t m_back_unpack_zmq_message_size_ = 0;
-    std::size_t m_front_unpack_zmq_message_size_ = 0;
+    // latest received message, owned by the unpack thread once taken
+    std::unique_ptr<zmq::message_t> m_pending_message_;
+    std::chrono::system_clock::time_point m_pending_message_timestamp_;
+    uint32_t m_num_dropped_messages_ = 0;
 
     std::atomic<bool> m_running_;
     std::string const m_server_endpoint_;
     std::string const m_feedback_endpoint_;
     std::vector<uint8_t> m_buffer_ = std::vector<uint8_t>(INITIAL_VBO_SIZE);
     std::vector<uint8_t> m_buffer_back_ = std::vector<uint8_t>(INITIAL_VBO_SIZE);
-    std::vector<uint8_t> m_buffer_back_compressed_ = std::vector<uint8_t>(INITIAL_VBO_SIZE);
 
     std::vector<uint8_t> m_texture_buffer_ = std::vector<uint8_t>(11059200, 0);
     std::vector<uint8_t> m_texture_buffer_back_ = std::vector<uint8_t>(11059200, 0);
-    std::vector<uint8_t> m_texture_buffer_back_compressed_ = std::vector<uint8_t>(11059200, 0);
-
-    std::vector<uint8_t*> m_tj_compressed_image_buffer_per_layer_ =  std::vector<uint8_t*>(MAX_LAYER_IDX, nullptr);
-    std::array<uint8_t, 1024 * 1024 * 100> m_decompressed_image_buffer_;
 
     std::vector<uint8_t> m_calibration_;
     std::vector<uint8_t> m_calibration_back_;
@@ -279,15 +307,8 @@ class NetKinectArray
     std::atomic<bool> m_need_model_cpu_swap_{false};
     mutable std::unordered_map<std::size_t, std::atomic<bool>> m_need_model_gpu_swap_;
     std::thread m_recv_thread_;
-    std::thread m_decompress_geometry_thread_;
-    std::thread m_decompress_images_thread_;
     std::thread m_unpack_thread_;
 
-    volatile std::atomic<bool> m_submitted_compressed_geometry_buffer_{false};
-    volatile std::atomic<bool> m_geometry_decompressor_finished_{false};
-
-    volatile std::atomic<bool> m_submitted_compressed_images_{false};
-    volatile std::atomic<bool> m_image_decompressor_finished_{false};
     volatile std::atomic<bool> m_image_decompression_without_errors_{true};
     // sending matrices
     std::mutex m_feedback_mutex_;
@@ -83,6 +83,7 @@ void SPointsNode::set_spoints_description(std::string const& v)
 {
     spoints_description_ = v;
     spoints_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -96,6 +97,7 @@ void SPointsNode::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
     spoints_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -141,7 +143,11 @@ std::shared_ptr<Node> SPointsNode::copy() const { return std::make_shared<SPoint
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void SPointsNode::set_is_server_resource(bool is_server_resource) { is_server_resource_ = is_server_resource; }
+void SPointsNode::set_is_server_resource(bool is_server_resource)
+{
+    is_server_resource_ = is_server_resource;
+    invalidate_snapshot();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
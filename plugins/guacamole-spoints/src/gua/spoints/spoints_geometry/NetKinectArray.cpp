@@ -1,4 +1,5 @@
 #include <gua/utils/Logger.hpp>
+#include <gua/concurrent/ThreadPool.hpp>
 
 #include <gua/spoints/SPointsFeedbackCollector.hpp>
 #include <gua/spoints/spoints_geometry/NetKinectArray.hpp>
@@ -22,6 +23,14 @@ gua::math::vec2ui get_handle(scm::gl::texture_image_ptr const& tex)
     return gua::math::vec2ui(handle & 0x00000000ffffffff, handle & 0xffffffff00000000);
 }
 
+// number of jpeg compressed sensor layers per message
+uint32_t const NUM_JPEG_LAYERS = 4;
+
+float elapsed_ms(std::chrono::system_clock::time_point const& start, std::chrono::system_clock::time_point const& end)
+{
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
 } // namespace
 
 namespace spoints
@@ -38,27 +47,28 @@ NetKinectArray::NetKinectArray(const std::string& server_endpoint, const std::st
     m_recv_thread_ = std::thread([this]() { _readloop(); });
 
     m_unpack_thread_ = std::thread([this]() { _unpack_back_message(); });
-
-#ifdef GUACAMOLE_ENABLE_TURBOJPEG
-    //m_decompress_geometry_thread_ = std::thread([this]() { _decompress_geometry_buffer(); });
-    //m_decompress_images_thread_ = std::thread([this]() { _decompress_images(); });
-#endif
 }
 
 NetKinectArray::~NetKinectArray()
 {
-#ifdef GUACAMOLE_ENABLE_TURBOJPEG
+    {
+        std::lock_guard<std::mutex> unpack_lock(m_unpack_mutex_);
+        m_running_ = false;
+    }
+    m_unpack_condition_.notify_all();
 
-    for(uint32_t layer_idx = 0; layer_idx < MAX_LAYER_IDX; ++layer_idx) {
+    m_recv_thread_.join();
+    m_unpack_thread_.join();
 
-        if(nullptr != m_tj_compressed_image_buffer_per_layer_[layer_idx]) 
+#ifdef GUACAMOLE_ENABLE_TURBOJPEG
+    for(auto& decompressor : m_jpeg_decompressor_per_layer)
+    {
+        if(0 != decompressor)
         {
-            tjFree(m_tj_compressed_image_buffer_per_layer_[layer_idx]);
+            tjDestroy(decompressor);
         }
     }
 #endif //GUACAMOLE_ENABLE_TURBOJPEG
-    m_running_ = false;
-    m_recv_thread_.join();
 }
 
 void NetKinectArray::draw_textured_triangle_soup(gua::RenderContext const& ctx, std::shared_ptr<gua::ShaderProgram>& shader_program)
@@ -342,7 +352,7 @@ bool NetKinectArray::_try_swap_calibration_data_gpu(gua::RenderContext const& ct
         return true;
 }
 
-void NetKinectArray::_try_swap_model_data_cpu() {
+bool NetKinectArray::_try_swap_model_data_cpu() {
 
         std::lock_guard<std::mutex> lock(m_mutex_);
     if(m_need_model_cpu_swap_.load())
@@ -350,7 +360,7 @@ void NetKinectArray::_try_swap_model_data_cpu() {
 
 
         if(num_clients_gpu_swapping_.load()) {
-            return;
+            return false;
         }
 
         ++num_clients_cpu_swapping_;
@@ -378,7 +388,10 @@ void NetKinectArray::_try_swap_model_data_cpu() {
         // end of synchro point
         --num_clients_cpu_swapping_;
         m_need_model_cpu_swap_.store(false);
+        return true;
     }
+
+    return false;
 }
 
 bool NetKinectArray::update(gua::RenderContext const& ctx, gua::math::BoundingBox<gua::math::vec3>& in_out_bb, scm::math::vec3ui const& inv_xyz_vol_res, scm::math::vec3ui const& uv_vol_res)
@@ -696,36 +709,47 @@ bool NetKinectArray::update(gua::RenderContext const& ctx, gua::math::BoundingBo
 
 
 void NetKinectArray::_unpack_back_message() {
-        while(true) {
+        while(m_running_) {
 
-            {
-                std::lock_guard<std::mutex> unpack_lock(m_unpack_mutex_);
+            // take ownership of the latest message, no copy involved
+            std::unique_ptr<zmq::message_t> message;
+            std::chrono::system_clock::time_point receive_timestamp;
+            uint32_t num_dropped_messages = 0;
 
+            {
+                std::unique_lock<std::mutex> unpack_lock(m_unpack_mutex_);
+                m_unpack_condition_.wait(unpack_lock, [this]() { return m_pending_message_ || !m_running_; });
 
-                if(m_has_new_message_to_unpack) {
-                    m_front_unpack_zmq_message_size_ = m_back_unpack_zmq_message_size_;
-                    memcpy( (char*) m_front_zmq_unpack_buffer_.data(), m_back_zmq_unpack_buffer_.data(), m_front_unpack_zmq_message_size_);
-                    m_has_new_message_to_unpack = false;
-                } else {
-                    continue;
+                if(!m_running_) {
+                    return;
                 }
+
+                message = std::move(m_pending_message_);
+                receive_timestamp = m_pending_message_timestamp_;
+                num_dropped_messages = m_num_dropped_messages_;
             }
 
 
-            while(m_need_model_cpu_swap_ || num_clients_gpu_swapping_.load() || num_clients_cpu_swapping_.load())
+            // newer messages replace the pending one meanwhile
+            while(m_running_ && (m_need_model_cpu_swap_ || num_clients_gpu_swapping_.load() || num_clients_cpu_swapping_.load()))
             {
-               ;
+               std::this_thread::yield();
             }
 
+            auto const unpack_start = std::chrono::system_clock::now();
 
-
-            //continue;
+            uint8_t const* message_data = static_cast<uint8_t const*>(message->data());
+            std::size_t const message_size = message->size();
 
             SGTP::header_data_t message_header;
 
             std::size_t const HEADER_SIZE = SGTP::HEADER_BYTE_SIZE;
 
-            memcpy((char*)&message_header, (unsigned char*)m_front_zmq_unpack_buffer_.data(), SGTP::HEADER_BYTE_SIZE);
+            if(message_size < HEADER_SIZE) {
+                continue;
+            }
+
+            memcpy((char*)&message_header, message_data, SGTP::HEADER_BYTE_SIZE);
 
             if(message_header.is_calibration_data)
             {
@@ -739,7 +763,7 @@ void NetKinectArray::_unpack_back_message() {
 
                 m_calibration_back_.resize(message_header.total_payload);
 
-                memcpy((char*)&m_calibration_back_[0], ((char*)m_front_zmq_unpack_buffer_.data()) + HEADER_SIZE, message_header.total_payload);
+                memcpy((char*)&m_calibration_back_[0], message_data + HEADER_SIZE, message_header.total_payload);
 
                 // memcpy inv_model_to_world_mat
 
@@ -774,7 +798,7 @@ void NetKinectArray::_unpack_back_message() {
                 m_model_descriptor_back_.received_kinect_timestamp = message_header.timestamp;
                 m_model_descriptor_back_.received_reconstruction_time = message_header.geometry_creation_time_in_ms;
 
-                m_model_descriptor_back_.total_message_payload_in_byte = m_front_unpack_zmq_message_size_;
+                m_model_descriptor_back_.total_message_payload_in_byte = message_size;
 
                 auto passed_microseconds_to_request = message_header.passed_microseconds_since_request;
 
@@ -825,7 +849,7 @@ void NetKinectArray::_unpack_back_message() {
 
                 if(total_num_received_primitives > 50000000)
                 {
-                    return;
+                    continue;
                 }
 
                 std::size_t size_of_vertex = 0;
@@ -847,56 +871,61 @@ void NetKinectArray::_unpack_back_message() {
                     m_buffer_back_.resize(total_uncompressed_geometry_payload_byte_size*4);
                 }
 
-                size_t const total_encoded_geometry_byte_size = m_front_unpack_zmq_message_size_ - (m_model_descriptor_back_.texture_payload_size_in_byte + HEADER_SIZE);
-
-                if(message_header.is_data_compressed)
+                if(message_size < m_model_descriptor_back_.texture_payload_size_in_byte + HEADER_SIZE)
                 {
-                    if(m_buffer_back_compressed_.size() < total_encoded_geometry_byte_size) {
-                        m_buffer_back_compressed_.resize(total_encoded_geometry_byte_size);
-                    }
-                    memcpy((unsigned char*)&m_buffer_back_compressed_[0], ((unsigned char*)m_front_zmq_unpack_buffer_.data()) + HEADER_SIZE, total_encoded_geometry_byte_size);
-                }
-                else
-                {
-                    memcpy((unsigned char*)&m_buffer_back_[0], ((unsigned char*)m_front_zmq_unpack_buffer_.data()) + HEADER_SIZE, total_encoded_geometry_byte_size);
+                    continue;
                 }
 
-    #ifdef GUACAMOLE_ENABLE_TURBOJPEG
-                if(message_header.is_data_compressed)
-                {
-                    memcpy((unsigned char*)&m_texture_buffer_back_compressed_[0], ((unsigned char*)m_front_zmq_unpack_buffer_.data()) + HEADER_SIZE + total_encoded_geometry_byte_size, m_model_descriptor_back_.texture_payload_size_in_byte);
-                } else 
-    #endif
+                size_t const total_encoded_geometry_byte_size = message_size - (m_model_descriptor_back_.texture_payload_size_in_byte + HEADER_SIZE);
+
+                // compressed payloads are decoded straight from the message
+                uint8_t const* encoded_geometry = message_data + HEADER_SIZE;
+                uint8_t const* encoded_images = encoded_geometry + total_encoded_geometry_byte_size;
+
+                if(!message_header.is_data_compressed)
                 {
-                    memcpy((unsigned char*)&m_texture_buffer_back_[0], ((unsigned char*)m_front_zmq_unpack_buffer_.data()) + HEADER_SIZE + total_encoded_geometry_byte_size, m_model_descriptor_back_.texture_payload_size_in_byte);
+                    if(m_buffer_back_.size() < total_encoded_geometry_byte_size) {
+                        m_buffer_back_.resize(total_encoded_geometry_byte_size);
+                    }
+                    memcpy((unsigned char*)&m_buffer_back_[0], encoded_geometry, total_encoded_geometry_byte_size);
+
+                    if(m_texture_buffer_back_.size() < m_model_descriptor_back_.texture_payload_size_in_byte) {
+                        m_texture_buffer_back_.resize(m_model_descriptor_back_.texture_payload_size_in_byte);
+                    }
+                    memcpy((unsigned char*)&m_texture_buffer_back_[0], encoded_images, m_model_descriptor_back_.texture_payload_size_in_byte);
                 }
 
-                for(uint32_t sensor_layer_idx = 0; sensor_layer_idx < 4; ++sensor_layer_idx)
+                for(uint32_t sensor_layer_idx = 0; sensor_layer_idx < NUM_JPEG_LAYERS; ++sensor_layer_idx)
                 {
                     m_byte_offset_to_jpeg_windows_[sensor_layer_idx] = message_header.jpeg_bytes_per_sensor[sensor_layer_idx];
                 }
 
+                SPointsDecodeStats& decode_stats = m_model_descriptor_back_.decode_stats;
+                decode_stats = SPointsDecodeStats{};
+                decode_stats.m_queue_wait_ms = elapsed_ms(receive_timestamp, unpack_start);
+                decode_stats.m_dropped_messages = num_dropped_messages;
+
                 if(message_header.is_data_compressed)
                 {
     #ifdef GUACAMOLE_ENABLE_TURBOJPEG
+                    decode_stats.m_unpack_ms = elapsed_ms(unpack_start, std::chrono::system_clock::now());
 
-                auto start_decompression = std::chrono::system_clock::now();
-                    //m_submitted_compressed_geometry_buffer_.store(true);
-
-                    //m_submitted_compressed_images_.store(true);
-
-                    _decompress_geometry_buffer();
+                    // lz4 runs on a worker while the jpeg layers are decoded
+                    auto geometry_decoded = gua::concurrent::ThreadPool::instance()->submit(
+                        [this, encoded_geometry, total_encoded_geometry_byte_size]() { return _decompress_geometry_buffer(encoded_geometry, total_encoded_geometry_byte_size); });
 
-                    _decompress_images();
-
-                auto end_decompression = std::chrono::system_clock::now();
-
-                std::chrono::duration<double> elapsed_seconds = end_decompression-start_decompression;
-        
+                    decode_stats.m_image_decode_ms = _decompress_images(encoded_images);
+                    decode_stats.m_geometry_decode_ms = geometry_decoded.get();
     #else
                     gua::Logger::LOG_WARNING << "TurboJPEG not available. Compile with option ENABLE_TURBOJPEG" << std::endl;
     #endif // GUACAMOLE_ENABLE_TURBOJPEG
                 }
+                else
+                {
+                    decode_stats.m_unpack_ms = elapsed_ms(unpack_start, std::chrono::system_clock::now());
+                }
+
+                decode_stats.m_total_ms = elapsed_ms(receive_timestamp, std::chrono::system_clock::now());
 
                 { // swap
                     //std::lock_guard<std::mutex> lock(m_mutex_);
@@ -917,114 +946,100 @@ void NetKinectArray::_unpack_back_message() {
 
 #ifdef GUACAMOLE_ENABLE_TURBOJPEG
 
-void NetKinectArray::_decompress_geometry_buffer() {
+float NetKinectArray::_decompress_geometry_buffer(uint8_t const* compressed_geometry, std::size_t compressed_byte_size) {
+    auto const start_decompression = std::chrono::system_clock::now();
 
-    //while(true) {
-        //while(!m_submitted_compressed_geometry_buffer_.load()) {
-        //    ;
-        //}
-        //m_submitted_compressed_geometry_buffer_.store(false);
+    int num_decompressed_bytes = LZ4_decompress_safe((const char*)compressed_geometry, (char*)&m_buffer_back_[0], compressed_byte_size, m_buffer_back_.size());
 
-        int num_decompressed_bytes = LZ4_decompress_safe((const char*)&m_buffer_back_compressed_[0], (char*)&m_buffer_back_[0], m_buffer_back_compressed_.size(), m_buffer_back_.size());
+    if(num_decompressed_bytes < 0)
+    {
+        gua::Logger::LOG_WARNING << "Failed to decompress geometry of " << compressed_byte_size << " bytes" << std::endl;
+    }
 
-     //   m_geometry_decompressor_finished_.store(true);
-    //}
+    return elapsed_ms(start_decompression, std::chrono::system_clock::now());
 }
 
-void NetKinectArray::_decompress_images()
+float NetKinectArray::_decompress_images(uint8_t const* compressed_images)
 {
+    auto const start_decompression = std::chrono::system_clock::now();
 
-    //while(true) {
-    //    while(!m_submitted_compressed_images_.load()) {
-    //        ;
-    //    }
-        m_submitted_compressed_images_.store(false);
-        
-
-
-            for(uint32_t sensor_layer_idx = 0; sensor_layer_idx < 4; ++sensor_layer_idx) {
-                if(nullptr == m_tj_compressed_image_buffer_per_layer_[sensor_layer_idx])
-                {
-                    m_tj_compressed_image_buffer_per_layer_[sensor_layer_idx] = tjAlloc(1024 * 1024 * 50);
-                }
-            }
-
-
-            std::size_t byte_offset_to_current_image = 0;
-
-            std::size_t total_image_byte_size = 0;
-
-            std::size_t decompressed_image_offset = 0;
-
-            for(uint32_t sensor_layer_idx = 0; sensor_layer_idx < 4; ++sensor_layer_idx)
+    for(uint32_t sensor_layer_idx = 0; sensor_layer_idx < NUM_JPEG_LAYERS; ++sensor_layer_idx)
+    {
+        if(0 == m_jpeg_decompressor_per_layer[sensor_layer_idx])
+        {
+            m_jpeg_decompressor_per_layer[sensor_layer_idx] = tjInitDecompress();
+            if(m_jpeg_decompressor_per_layer[sensor_layer_idx] == NULL)
             {
-                total_image_byte_size += m_byte_offset_to_jpeg_windows_[sensor_layer_idx];// byte_offset_to_jpeg_windows[sensor_layer_idx];
+                std::cout << "ERROR INITIALIZING DECOMPRESSOR\n";
             }
+        }
+    }
 
-            for(uint32_t sensor_layer_idx = 0; sensor_layer_idx < 4; ++sensor_layer_idx)
-            {
-                //if(m_jpeg_decompressor_per_layer.end() == m_jpeg_decompressor_per_layer.find(sensor_layer_idx))
-                if(0 == m_jpeg_decompressor_per_layer[sensor_layer_idx])
-                {
-                    m_jpeg_decompressor_per_layer[sensor_layer_idx] = tjInitDecompress();
-                    if(m_jpeg_decompressor_per_layer[sensor_layer_idx] == NULL)
-                    {
-                        std::cout << "ERROR INITIALIZING DECOMPRESSOR\n";
-                    }
-                }
-            }
+    // the headers determine where each layer is decoded to
+    std::array<std::size_t, NUM_JPEG_LAYERS> jpeg_offsets;
+    std::array<std::size_t, NUM_JPEG_LAYERS> image_offsets;
+    std::array<int, NUM_JPEG_LAYERS> widths;
+    std::array<int, NUM_JPEG_LAYERS> heights;
 
-            bool skip_decompression = false;
-            for(uint32_t sensor_layer_idx = 0; sensor_layer_idx < 4; ++sensor_layer_idx) 
-            {
-                long unsigned int jpeg_size = m_byte_offset_to_jpeg_windows_[sensor_layer_idx];
+    std::size_t byte_offset_to_current_image = 0;
+    std::size_t decompressed_image_offset = 0;
 
-                //memcpy((char*)&m_tj_compressed_image_buffer_per_layer_[sensor_layer_idx][0], (char*)&m_texture_buffer_back_compressed_[byte_offset_to_current_image], jpeg_size);
+    for(uint32_t sensor_layer_idx = 0; sensor_layer_idx < NUM_JPEG_LAYERS; ++sensor_layer_idx)
+    {
+        long unsigned int jpeg_size = m_byte_offset_to_jpeg_windows_[sensor_layer_idx];
 
-                int header_width, header_height, header_subsamp;
+        int header_subsamp;
 
-                auto& current_decompressor_handle = m_jpeg_decompressor_per_layer[sensor_layer_idx];
+        int error_handle = tjDecompressHeader2(m_jpeg_decompressor_per_layer[sensor_layer_idx],
+                                               const_cast<unsigned char*>(compressed_images + byte_offset_to_current_image),
+                                               jpeg_size,
+                                               &widths[sensor_layer_idx],
+                                               &heights[sensor_layer_idx],
+                                               &header_subsamp);
 
-                int error_handle = tjDecompressHeader2(current_decompressor_handle, (unsigned char*)&m_texture_buffer_back_compressed_[byte_offset_to_current_image], jpeg_size, &header_width, &header_height, &header_subsamp);
+        if(-1 == error_handle)
+        {
+            std::cout << "ERROR DECOMPRESSING JPEG\n";
+            std::cout << "Error was: " << tjGetErrorStr() << "\n";
 
-                if(-1 == error_handle)
-                {
-                    std::cout << "ERROR DECOMPRESSING JPEG\n";
-                    std::cout << "Error was: " << tjGetErrorStr() << "\n";
+            std::cout << "JPEG SIZE IN BYTE:" << jpeg_size << "\n";
+            std::cout << "Skipping frame again 6.\n";
+            m_image_decompression_without_errors_.store(false);
 
-                    std::cout << "JPEG SIZE IN BYTE:" << jpeg_size << "\n";
-                    std::cout << "Skipping frame again 6.\n";
-                    m_image_decompression_without_errors_.store(false);
+            return elapsed_ms(start_decompression, std::chrono::system_clock::now());
+        }
 
-                    skip_decompression = true;
-                }
+        jpeg_offsets[sensor_layer_idx] = byte_offset_to_current_image;
+        image_offsets[sensor_layer_idx] = decompressed_image_offset;
 
-                if(!skip_decompression) {
-                    tjDecompress2(current_decompressor_handle,
-                                  (unsigned char*)&m_texture_buffer_back_compressed_[byte_offset_to_current_image],
-                                  jpeg_size,
-                                  &m_texture_buffer_back_[decompressed_image_offset],
-                                  header_width,
-                                  0,
-                                  header_height,
-                                  TJPF_BGR,
-                                  TJFLAG_FASTDCT);
-
-                    uint32_t copied_image_byte = header_height * header_width * 3;
-
-                    byte_offset_to_current_image += jpeg_size;
-                    decompressed_image_offset += copied_image_byte;
-                }
-            }
+        byte_offset_to_current_image += jpeg_size;
+        decompressed_image_offset += heights[sensor_layer_idx] * widths[sensor_layer_idx] * 3;
+    }
 
-            if(!skip_decompression) {
-                m_image_decompression_without_errors_.store(true);
-            }
+    if(m_texture_buffer_back_.size() < decompressed_image_offset)
+    {
+        m_texture_buffer_back_.resize(decompressed_image_offset);
+    }
+
+    // every layer has its own decompressor and output window
+    gua::concurrent::ThreadPool::instance()->parallel_for(0, NUM_JPEG_LAYERS, [&](std::size_t begin, std::size_t end) {
+        for(std::size_t sensor_layer_idx = begin; sensor_layer_idx < end; ++sensor_layer_idx)
+        {
+            tjDecompress2(m_jpeg_decompressor_per_layer[sensor_layer_idx],
+                          const_cast<unsigned char*>(compressed_images + jpeg_offsets[sensor_layer_idx]),
+                          m_byte_offset_to_jpeg_windows_[sensor_layer_idx],
+                          &m_texture_buffer_back_[image_offsets[sensor_layer_idx]],
+                          widths[sensor_layer_idx],
+                          0,
+                          heights[sensor_layer_idx],
+                          TJPF_BGR,
+                          TJFLAG_FASTDCT);
+        }
+    });
 
-            //memcpy((char*)m_texture_buffer_back_.data(), (char*)m_decompressed_image_buffer_.data(), decompressed_image_offset);
-        m_image_decompressor_finished_.store(true);
-    //}
+    m_image_decompression_without_errors_.store(true);
 
+    return elapsed_ms(start_decompression, std::chrono::system_clock::now());
 }
 #endif //GUACAMOLE_ENABLE_TURBOJPEG
 
@@ -1039,38 +1054,36 @@ void NetKinectArray::_readloop()
     int conflate_messages = 1;
     socket.setsockopt(ZMQ_CONFLATE, &conflate_messages, sizeof(conflate_messages));
 
+    // wake up regularly to notice shutdown
+    int receive_timeout_ms = 100;
+    socket.setsockopt(ZMQ_RCVTIMEO, &receive_timeout_ms, sizeof(receive_timeout_ms));
+
     std::string endpoint("tcp://" + m_server_endpoint_);
     socket.connect(endpoint.c_str());
 
-    const unsigned message_size = sizeof(size_t); //(m_colorsize_byte + m_depthsize_byte) * m_calib_files.size();
-
-    // size_t header_byte_size = 100;
-    // std::vector<uint8_t> header_data(header_byte_size, 0);
-
-
-    zmq::message_t zmqm;
-
-    auto pre_loop_time_stamp = std::chrono::system_clock::now();
-    auto current_timestamp = std::chrono::system_clock::now();
     while(m_running_)
     {
+        std::unique_ptr<zmq::message_t> message(new zmq::message_t());
 
-        socket.recv(&zmqm); // blocking
+        if(!socket.recv(message.get())) // blocking until timeout
         {
-            std::lock_guard<std::mutex> unpack_lock(m_unpack_mutex_);
-
-            m_has_new_message_to_unpack = true;
-            memcpy( (char*) m_back_zmq_unpack_buffer_.data(), zmqm.data(), zmqm.size());
-            m_back_unpack_zmq_message_size_ = zmqm.size();
+            continue;
         }
 
-        pre_loop_time_stamp = current_timestamp;
-        current_timestamp = std::chrono::system_clock::now();
+        {
+            std::lock_guard<std::mutex> unpack_lock(m_unpack_mutex_);
 
-        std::chrono::duration<double> elapsed_receive_seconds = current_timestamp-pre_loop_time_stamp;
+            // the unpack thread is still busy, only the latest message is kept
+            if(m_pending_message_)
+            {
+                ++m_num_dropped_messages_;
+            }
 
-        //std::cout << "elapsed milliseconds since last receive: " << elapsed_receive_seconds.count() * 1000.0f << "ms" << std::endl;
+            m_pending_message_ = std::move(message);
+            m_pending_message_timestamp_ = std::chrono::system_clock::now();
+        }
 
+        m_unpack_condition_.notify_one();
     }
 }
 
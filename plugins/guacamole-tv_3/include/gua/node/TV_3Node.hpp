@@ -132,10 +132,18 @@ class GUA_TV_3_DLL TV_3Node : public GeometryNode
     float get_time_cursor_pos() const { return geometry_->get_time_cursor_pos(); }
 
     RenderMode get_render_mode() const { return render_mode_; }
-    void set_render_mode(RenderMode const render_mode) { render_mode_ = render_mode; }
+    void set_render_mode(RenderMode const render_mode)
+    {
+        render_mode_ = render_mode;
+        invalidate_snapshot();
+    }
 
     float get_iso_value() const { return iso_value_; }
-    void set_iso_value(float iso_value) { iso_value_ = iso_value; }
+    void set_iso_value(float iso_value)
+    {
+        iso_value_ = iso_value;
+        invalidate_snapshot();
+    }
 
     TV_3Resource::CompressionMode get_compression_mode() const { return geometry_->get_compression_mode(); }
 
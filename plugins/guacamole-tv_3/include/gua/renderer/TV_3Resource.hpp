@@ -45,6 +45,12 @@
 #include <scm/core/utilities/platform_warning_disable.h>
 
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 //#include <pbr/types.h>
 //#include <pbr/ren/model_database.h>
 //#include <pbr/ren/cut_database.h>
@@ -97,7 +103,16 @@ class TV_3Resource : public GeometryResource
   public: // c'tor /d'tor
     static void tokenize_volume_name(std::string const& string_to_split, std::map<std::string, uint64_t>& tokens);
 
-    TV_3Resource(std::string const& resource_file_string, bool is_pickable, CompressionMode compression_mode = CompressionMode::UNCOMPRESSED);
+    /**
+     * Time steps are streamed from disk on a worker thread. At most
+     * cpu_budget_in_mb of them are kept in main memory and at most
+     * gpu_budget_in_mb of them in 3D textures per context.
+     */
+    TV_3Resource(std::string const& resource_file_string,
+                 bool is_pickable,
+                 CompressionMode compression_mode = CompressionMode::UNCOMPRESSED,
+                 int const cpu_budget_in_mb = 1024,
+                 int const gpu_budget_in_mb = 1024);
 
     ~TV_3Resource();
 
@@ -139,6 +154,20 @@ class TV_3Resource : public GeometryResource
     void ray_test(Ray const& ray, int options, node::Node* owner, std::set<PickResult>& hits);
 
   protected:
+    // a token of the volume name, or 0 if the name does not contain it
+    uint64_t volume_token(std::string const& token) const;
+
+    void volume_texture_format(scm::math::vec3ui& dims, scm::gl::data_format& format) const;
+
+    // returns the index of the context's 3D texture holding time_step, or the
+    // most recently used one while time_step is still being loaded
+    std::size_t resident_texture(RenderContext const& ctx, int32_t time_step) const;
+
+    // time_step and its successors in playback direction are prefetched
+    void request_time_steps(int32_t time_step) const;
+    void stream_time_steps() const;
+    void read_time_step(int32_t time_step, std::vector<uint8_t>& buffer) const;
+
     // std::shared_ptr<*/scm::gl::box_volume_geometry> volume_proxy_;
     bool is_pickable_;
     math::mat4 local_transform_;
@@ -157,8 +186,45 @@ class TV_3Resource : public GeometryResource
     static std::mutex cpu_volume_loading_mutex_;
     static std::map<std::size_t, bool> are_cpu_time_steps_loaded_;
     static std::map<std::size_t, std::map<std::string, uint64_t>> volume_descriptor_tokens_;
-    static std::map<std::size_t, std::vector<std::ifstream>> per_resource_file_streams_;
-    static std::map<std::size_t, std::vector<std::vector<uint8_t>>> per_resource_cpu_cache_;
+
+    // filled while loading, the compressed resource adds its codebook tokens;
+    // read by the render and streaming threads without locking
+    std::map<std::string, uint64_t> volume_tokens_;
+
+  private:
+    struct TimeStepBuffer
+    {
+        int32_t time_step = -1;
+        bool is_ready = false;
+        unsigned num_uploads = 0;
+        std::vector<uint8_t> data;
+    };
+
+    struct ResidentTextures
+    {
+        std::vector<int32_t> time_steps;
+        std::vector<uint64_t> last_used;
+        uint64_t use_counter = 0;
+    };
+
+    std::vector<std::string> time_step_files_;
+    int const cpu_budget_in_mb_;
+    int const gpu_budget_in_mb_;
+    mutable std::size_t num_resident_textures_ = 0;
+
+    mutable std::mutex streaming_mutex_;
+    mutable std::condition_variable streaming_condition_;
+    mutable std::thread streaming_thread_;
+    mutable bool streaming_shutdown_ = false;
+
+    // bounded ring of time steps in main memory
+    mutable std::vector<TimeStepBuffer> time_step_buffers_;
+    mutable int32_t requested_time_step_ = -1;
+    mutable std::vector<int32_t> prefetch_window_;
+    mutable std::deque<int32_t> prefetch_queue_;
+
+    // per context id
+    mutable std::unordered_map<std::size_t, ResidentTextures> resident_textures_;
 };
 
 } // namespace gua
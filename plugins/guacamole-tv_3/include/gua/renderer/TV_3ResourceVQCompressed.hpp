@@ -63,7 +63,7 @@ class TV_3Node;
 class TV_3ResourceVQCompressed : public TV_3Resource
 {
   public: // c'tor /d'tor
-    TV_3ResourceVQCompressed(std::string const& resource_file_string, bool is_pickable);
+    TV_3ResourceVQCompressed(std::string const& resource_file_string, bool is_pickable, int const cpu_budget_in_mb = 1024, int const gpu_budget_in_mb = 1024);
 
     ~TV_3ResourceVQCompressed();
 
@@ -98,6 +98,7 @@ class TV_3ResourceVQCompressed : public TV_3Resource
 
   protected:
     mutable int32_t num_codebooks_ = 0;
+    mutable int64_t num_codewords_per_row_ = 0;
     static std::mutex cpu_codebook_loading_mutex_;
     static std::map<std::size_t, bool> are_cpu_codebooks_loaded_;
     static std::map<std::size_t, std::vector<std::ifstream>> per_resource_codebook_file_streams_;
@@ -56,6 +56,7 @@ void TV_3Node::set_geometry_description(std::string const& v)
 {
     geometry_description_ = v;
     geometry_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -66,6 +67,7 @@ void TV_3Node::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
     // material_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -124,11 +124,11 @@ std::shared_ptr<node::Node> TV_3Loader::load_geometry(std::string const& file_na
             std::shared_ptr<TV_3Resource> resource = nullptr;
             if(file_name.find("SW_VQ") != std::string::npos)
             {
-                resource = std::make_shared<TV_3ResourceVQCompressed>(file_name, flags & TV_3Loader::MAKE_PICKABLE);
+                resource = std::make_shared<TV_3ResourceVQCompressed>(file_name, flags & TV_3Loader::MAKE_PICKABLE, cpu_budget, gpu_budget);
             }
             else
             {
-                resource = std::make_shared<TV_3Resource>(file_name, flags & TV_3Loader::MAKE_PICKABLE);
+                resource = std::make_shared<TV_3Resource>(file_name, flags & TV_3Loader::MAKE_PICKABLE, TV_3Resource::CompressionMode::UNCOMPRESSED, cpu_budget, gpu_budget);
             }
 
             GeometryDatabase::instance()->add(desc.unique_key(), resource);
@@ -183,7 +183,7 @@ std::shared_ptr<node::Node> TV_3Loader::load_geometry(std::string const& file_na
 std::shared_ptr<node::Node> TV_3Loader::create_geometry_from_file(
     std::string const& node_name, std::string const& file_name, std::shared_ptr<Material> const& fallback_material, unsigned flags, int const cpu_budget, int const gpu_budget)
 {
-    auto cached_node(load_geometry(file_name, flags));
+    auto cached_node(load_geometry(file_name, flags, cpu_budget, gpu_budget));
 
     if(cached_node)
     {
@@ -202,7 +202,7 @@ std::shared_ptr<node::Node> TV_3Loader::create_geometry_from_file(
 
 std::shared_ptr<node::Node> TV_3Loader::create_geometry_from_file(std::string const& node_name, std::string const& file_name, unsigned flags, int const cpu_budget, int const gpu_budget)
 {
-    auto cached_node(load_geometry(file_name, flags));
+    auto cached_node(load_geometry(file_name, flags, cpu_budget, gpu_budget));
 
     if(cached_node)
     {
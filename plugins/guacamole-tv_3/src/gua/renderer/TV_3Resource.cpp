@@ -58,8 +58,6 @@ namespace gua
 std::mutex TV_3Resource::cpu_volume_loading_mutex_;
 std::map<std::size_t, bool> TV_3Resource::are_cpu_time_steps_loaded_;
 std::map<std::size_t, std::map<std::string, uint64_t>> TV_3Resource::volume_descriptor_tokens_;
-std::map<std::size_t, std::vector<std::ifstream>> TV_3Resource::per_resource_file_streams_;
-std::map<std::size_t, std::vector<std::vector<uint8_t>>> TV_3Resource::per_resource_cpu_cache_;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -124,9 +122,9 @@ void TV_3Resource::tokenize_volume_name(std::string const& string_to_split, std:
 
 ////////////////////////////////////////////////////////////////////////////////
 
-TV_3Resource::TV_3Resource(std::string const& resource_file_string, bool is_pickable, CompressionMode compression_mode)
+TV_3Resource::TV_3Resource(std::string const& resource_file_string, bool is_pickable, CompressionMode compression_mode, int const cpu_budget_in_mb, int const gpu_budget_in_mb)
     : resource_file_name_(resource_file_string), is_pickable_(is_pickable), compression_mode_(compression_mode),
-      local_transform_(gua::math::mat4(1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0))
+      local_transform_(gua::math::mat4(1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0)), cpu_budget_in_mb_(cpu_budget_in_mb), gpu_budget_in_mb_(gpu_budget_in_mb)
 {
     std::cout << "Created Uncompressed Volume Resource\n";
     std::cout << "Loading once\n";
@@ -163,16 +161,32 @@ TV_3Resource::TV_3Resource(std::string const& resource_file_string, bool is_pick
                 tokenize_volume_name(vol_path, volume_descriptor_tokens_[uuid_]);
             }
 
-            per_resource_file_streams_[uuid_].push_back(std::ifstream(vol_path.c_str(), std::ios::in | std::ios::binary));
+            // time steps are read on demand
+            time_step_files_.push_back(vol_path);
         }
+        num_time_steps_ = std::max<int32_t>(1, time_step_files_.size());
         are_cpu_time_steps_loaded_[uuid_] = true;
     }
+    volume_tokens_ = volume_descriptor_tokens_[uuid_];
     cpu_volume_loading_mutex_.unlock();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-TV_3Resource::~TV_3Resource() {}
+TV_3Resource::~TV_3Resource()
+{
+    {
+        std::lock_guard<std::mutex> lock(streaming_mutex_);
+        streaming_shutdown_ = true;
+    }
+
+    streaming_condition_.notify_all();
+
+    if(streaming_thread_.joinable())
+    {
+        streaming_thread_.join();
+    }
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -185,90 +199,292 @@ void TV_3Resource::apply_resource_dependent_uniforms(RenderContext const& ctx, s
 
 };
 
+uint64_t TV_3Resource::volume_token(std::string const& token) const
+{
+    auto value(volume_tokens_.find(token));
+    return value != volume_tokens_.end() ? value->second : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TV_3Resource::volume_texture_format(scm::math::vec3ui& vol_dims, scm::gl::data_format& read_format) const
+{
+    vol_dims = scm::math::vec3ui(volume_token("w"), volume_token("h"), volume_token("d"));
+    read_format = scm::gl::data_format::FORMAT_NULL;
+
+    int64_t num_bytes_per_voxel = volume_token("num_bytes_per_voxel");
+
+    if(CompressionMode::UNCOMPRESSED != compression_mode_)
+    {
+        int64_t const num_index_bytes = volume_token("i") / 8;
+        int64_t const block_size = volume_token("bs");
+        for(int dim_idx = 0; dim_idx < 3; ++dim_idx)
+        {
+            vol_dims[dim_idx] /= block_size;
+        }
+
+        if(1 == num_index_bytes)
+        {
+            read_format = scm::gl::data_format::FORMAT_R_8UI;
+        }
+        else if(2 == num_index_bytes)
+        {
+            read_format = scm::gl::data_format::FORMAT_R_16UI;
+        }
+        else if(3 == num_index_bytes)
+        {
+            read_format = scm::gl::data_format::FORMAT_RGB_8UI;
+        }
+        else if(4 == num_index_bytes)
+        {
+            read_format = scm::gl::data_format::FORMAT_R_32UI;
+        }
+    }
+    else
+    {
+        if(1 == num_bytes_per_voxel)
+        {
+            read_format = scm::gl::data_format::FORMAT_R_8;
+        }
+        else if(2 == num_bytes_per_voxel)
+        {
+            read_format = scm::gl::data_format::FORMAT_R_16;
+        }
+        else if(4 == num_bytes_per_voxel)
+        {
+            read_format = scm::gl::data_format::FORMAT_R_32F;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void TV_3Resource::upload_to(RenderContext const& ctx) const
 {
     if(are_cpu_time_steps_loaded_[uuid_])
     {
-        int32_t loaded_volumes_count = 0;
+        std::size_t const bytes_per_mb = 1024 * 1024;
+        std::size_t const num_bytes_per_time_step = std::max<std::size_t>(1, volume_token("total_num_bytes"));
 
-        auto& current_tokens = volume_descriptor_tokens_[uuid_];
+        std::lock_guard<std::mutex> lock(streaming_mutex_);
 
-        for(auto& vol_path : per_resource_file_streams_[uuid_])
+        // the budgets determine how many time steps are resident at once
+        if(time_step_buffers_.empty())
         {
-            scm::math::vec3ui vol_dims = scm::math::vec3ui(current_tokens["w"], current_tokens["h"], current_tokens["d"]);
+            std::size_t num_buffers = std::max<std::size_t>(2, std::max(0, cpu_budget_in_mb_) * bytes_per_mb / num_bytes_per_time_step);
+            time_step_buffers_.resize(std::min<std::size_t>(num_buffers, num_time_steps_));
 
-            int64_t num_bytes_per_voxel = current_tokens["num_bytes_per_voxel"];
+            std::size_t num_textures = std::max<std::size_t>(1, std::max(0, gpu_budget_in_mb_) * bytes_per_mb / num_bytes_per_time_step);
+            num_resident_textures_ = std::min<std::size_t>(num_textures, num_time_steps_);
+        }
 
-            int64_t num_voxels = current_tokens["total_num_bytes"];
+        scm::math::vec3ui vol_dims;
+        scm::gl::data_format read_format;
+        volume_texture_format(vol_dims, read_format);
 
-            // std::vector<unsigned char> read_buffer(num_voxels);
+        auto& textures = ctx.texture_3d_arrays[uuid()];
+        for(std::size_t i = 0; i < num_resident_textures_; ++i)
+        {
+            textures.push_back(ctx.render_device->create_texture_3d(scm::gl::texture_3d_desc(vol_dims, read_format)));
+        }
 
-            per_resource_cpu_cache_[uuid_].push_back(std::vector<uint8_t>(num_voxels, 0));
-            vol_path.read((char*)&per_resource_cpu_cache_[uuid_][loaded_volumes_count][0], num_voxels);
+        auto& resident = resident_textures_[ctx.id];
+        resident.time_steps.assign(num_resident_textures_, -1);
+        resident.last_used.assign(num_resident_textures_, 0);
+    }
+}
 
-            scm::gl::data_format read_format = scm::gl::data_format::FORMAT_NULL;
+////////////////////////////////////////////////////////////////////////////////
 
-            if(CompressionMode::UNCOMPRESSED != compression_mode_)
-            {
-                int64_t const num_index_bytes = current_tokens["i"] / 8;
-                int64_t const block_size = current_tokens["bs"];
-                for(int dim_idx = 0; dim_idx < 3; ++dim_idx)
-                {
-                    vol_dims[dim_idx] /= block_size;
-                }
+std::size_t TV_3Resource::resident_texture(RenderContext const& ctx, int32_t time_step) const
+{
+    ResidentTextures* resident = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(streaming_mutex_);
+        resident = &resident_textures_[ctx.id];
+    }
 
-                if(1 == num_index_bytes)
-                {
-                    read_format = scm::gl::data_format::FORMAT_R_8UI;
-                }
-                else if(2 == num_index_bytes)
-                {
-                    read_format = scm::gl::data_format::FORMAT_R_16UI;
-                }
-                else if(3 == num_index_bytes)
-                {
-                    read_format = scm::gl::data_format::FORMAT_RGB_8UI;
-                }
-                else if(4 == num_index_bytes)
-                {
-                    read_format = scm::gl::data_format::FORMAT_R_32UI;
-                }
-            }
-            else
-            {
-                if(1 == num_bytes_per_voxel)
-                {
-                    read_format = scm::gl::data_format::FORMAT_R_8;
-                }
-                else if(2 == num_bytes_per_voxel)
-                {
-                    read_format = scm::gl::data_format::FORMAT_R_16;
-                }
-                else if(4 == num_bytes_per_voxel)
-                {
-                    read_format = scm::gl::data_format::FORMAT_R_32F;
-                }
-            }
+    if(resident->time_steps.empty())
+    {
+        return 0;
+    }
+
+    auto const use = ++resident->use_counter;
+
+    auto texture = std::find(resident->time_steps.begin(), resident->time_steps.end(), time_step);
+    if(texture != resident->time_steps.end())
+    {
+        std::size_t texture_idx = texture - resident->time_steps.begin();
+        resident->last_used[texture_idx] = use;
+        return texture_idx;
+    }
 
-            /*volume_textures_.push_back(ctx.render_device->create_texture_3d(scm::gl::texture_3d_desc(vol_dims, read_format), read_format,
-                                                                            {(void*) &per_resource_cpu_cache_[uuid_][loaded_volumes_count][0]} ) );
-            */
-            ctx.texture_3d_arrays[uuid()].push_back(
-                ctx.render_device->create_texture_3d(scm::gl::texture_3d_desc(vol_dims, read_format), read_format, {(void*)&per_resource_cpu_cache_[uuid_][loaded_volumes_count][0]}));
-            ++loaded_volumes_count;
+    std::unique_lock<std::mutex> lock(streaming_mutex_);
+
+    auto is_loaded = [time_step](TimeStepBuffer const& candidate) { return candidate.time_step == time_step && candidate.is_ready; };
+    auto buffer = std::find_if(time_step_buffers_.begin(), time_step_buffers_.end(), is_loaded);
+
+    if(buffer == time_step_buffers_.end())
+    {
+        // keep showing the last time step until the requested one is loaded
+        std::size_t latest_idx = std::max_element(resident->last_used.begin(), resident->last_used.end()) - resident->last_used.begin();
+        if(resident->time_steps[latest_idx] >= 0)
+        {
+            resident->last_used[latest_idx] = use;
+            return latest_idx;
+        }
+
+        // nothing to show yet
+        streaming_condition_.wait(lock, [&]() {
+            buffer = std::find_if(time_step_buffers_.begin(), time_step_buffers_.end(), is_loaded);
+            return buffer != time_step_buffers_.end() || streaming_shutdown_;
+        });
+
+        if(buffer == time_step_buffers_.end())
+        {
+            return 0;
+        }
+    }
+
+    // protect the buffer from being reused while it is uploaded
+    ++buffer->num_uploads;
+    lock.unlock();
+
+    // replace the least recently used texture
+    std::size_t texture_idx = std::min_element(resident->last_used.begin(), resident->last_used.end()) - resident->last_used.begin();
+
+    scm::math::vec3ui vol_dims;
+    scm::gl::data_format read_format;
+    volume_texture_format(vol_dims, read_format);
+
+    ctx.render_context->update_sub_texture(
+        ctx.texture_3d_arrays[uuid()][texture_idx], scm::gl::texture_region(scm::math::vec3ui(0, 0, 0), vol_dims), 0, read_format, (void*)buffer->data.data());
+
+    resident->time_steps[texture_idx] = time_step;
+    resident->last_used[texture_idx] = use;
+
+    lock.lock();
+    --buffer->num_uploads;
+    lock.unlock();
+
+    streaming_condition_.notify_all();
+
+    return texture_idx;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TV_3Resource::request_time_steps(int32_t time_step) const
+{
+    std::lock_guard<std::mutex> lock(streaming_mutex_);
+
+    if(time_step == requested_time_step_ || time_step_buffers_.empty())
+    {
+        return;
+    }
+
+    requested_time_step_ = time_step;
+
+    int32_t const direction = PlaybackMode::BACKWARD == playback_mode_ ? -1 : 1;
+
+    prefetch_window_.clear();
+    prefetch_queue_.clear();
+
+    for(std::size_t i = 0; i < time_step_buffers_.size(); ++i)
+    {
+        int32_t const upcoming_time_step = ((time_step + direction * int32_t(i)) % num_time_steps_ + num_time_steps_) % num_time_steps_;
+        prefetch_window_.push_back(upcoming_time_step);
+
+        bool is_buffered = std::any_of(
+            time_step_buffers_.begin(), time_step_buffers_.end(), [upcoming_time_step](TimeStepBuffer const& buffer) { return buffer.time_step == upcoming_time_step; });
+
+        if(!is_buffered)
+        {
+            prefetch_queue_.push_back(upcoming_time_step);
+        }
+    }
+
+    if(!streaming_thread_.joinable())
+    {
+        streaming_thread_ = std::thread(&TV_3Resource::stream_time_steps, this);
+    }
+
+    streaming_condition_.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TV_3Resource::stream_time_steps() const
+{
+    std::unique_lock<std::mutex> lock(streaming_mutex_);
+
+    while(true)
+    {
+        streaming_condition_.wait(lock, [this]() { return streaming_shutdown_ || !prefetch_queue_.empty(); });
+
+        if(streaming_shutdown_)
+        {
+            return;
+        }
+
+        int32_t const time_step = prefetch_queue_.front();
+        prefetch_queue_.pop_front();
+
+        bool is_buffered =
+            std::any_of(time_step_buffers_.begin(), time_step_buffers_.end(), [time_step](TimeStepBuffer const& buffer) { return buffer.time_step == time_step; });
+
+        if(is_buffered)
+        {
+            continue;
+        }
+
+        // reuse an empty buffer or one which has left the prefetch window
+        auto buffer = std::find_if(time_step_buffers_.begin(), time_step_buffers_.end(), [this](TimeStepBuffer const& candidate) {
+            return candidate.time_step < 0 ||
+                   (candidate.is_ready && 0 == candidate.num_uploads && std::find(prefetch_window_.begin(), prefetch_window_.end(), candidate.time_step) == prefetch_window_.end());
+        });
+
+        if(buffer == time_step_buffers_.end())
+        {
+            // retry once an upload or load has finished
+            prefetch_queue_.push_front(time_step);
+            streaming_condition_.wait(lock);
+            continue;
         }
 
-        num_time_steps_ = loaded_volumes_count;
-        /*
+        buffer->time_step = time_step;
+        buffer->is_ready = false;
+
+        lock.unlock();
+        read_time_step(time_step, buffer->data);
+        lock.lock();
 
-        std::make_shared<scm::gl::texture_3d>(
-                                                                new scm::gl::texture_3d(*ctx.render_device,
-                                                                    scm::gl::texture_3d_desc(scm::math::vec3ui(256,256,225),
-                                                                                        scm::gl::data_format::FORMAT_R_8)  );
-      */
+        buffer->is_ready = true;
+        streaming_condition_.notify_all();
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+void TV_3Resource::read_time_step(int32_t time_step, std::vector<uint8_t>& buffer) const
+{
+    buffer.resize(volume_token("total_num_bytes"), 0);
+
+    if(std::size_t(time_step) >= time_step_files_.size())
+    {
+        return;
+    }
+
+    std::ifstream volume_file(time_step_files_[time_step].c_str(), std::ios::in | std::ios::binary);
+
+    if(!volume_file.read((char*)buffer.data(), buffer.size()))
+    {
+        Logger::LOG_WARNING << "TV_3Resource: Unable to read time step from " << time_step_files_[time_step] << std::endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void TV_3Resource::bind_volume_texture(RenderContext const& ctx, scm::gl::sampler_state_ptr const& sampler_state) const
 {
     auto iter = ctx.texture_3d_arrays.find(uuid());
@@ -304,8 +520,10 @@ void TV_3Resource::bind_volume_texture(RenderContext const& ctx, scm::gl::sample
 
     int32_t volume_id = int32_t(time_cursor_pos_) % num_time_steps_;
 
+    request_time_steps(volume_id);
+
     // ctx.render_context->bind_texture(volume_textures_[ ((frame_counter_++) / 10) % volume_textures_.size()], sampler_state, 0);
-    ctx.render_context->bind_texture((iter->second)[volume_id], sampler_state, 0);
+    ctx.render_context->bind_texture((iter->second)[resident_texture(ctx, volume_id)], sampler_state, 0);
 
     /*
       std::cout << "In drawing branch\n";
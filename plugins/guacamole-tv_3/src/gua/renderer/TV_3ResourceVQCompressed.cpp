@@ -63,7 +63,8 @@ std::map<std::size_t, std::vector<std::vector<uint8_t>>> TV_3ResourceVQCompresse
 
 ////////////////////////////////////////////////////////////////////////////////
 
-TV_3ResourceVQCompressed::TV_3ResourceVQCompressed(std::string const& resource_file_string, bool is_pickable) : TV_3Resource(resource_file_string, is_pickable, CompressionMode::SW_VQ)
+TV_3ResourceVQCompressed::TV_3ResourceVQCompressed(std::string const& resource_file_string, bool is_pickable, int const cpu_budget_in_mb, int const gpu_budget_in_mb)
+    : TV_3Resource(resource_file_string, is_pickable, CompressionMode::SW_VQ, cpu_budget_in_mb, gpu_budget_in_mb)
 {
     std::cout << "Created Compressed Volume Resource\n";
 
@@ -107,7 +108,7 @@ TV_3ResourceVQCompressed::TV_3ResourceVQCompressed(std::string const& resource_f
         {
             if(0 == num_parsed_volumes++)
             {
-                tokenize_volume_name(vol_path, volume_descriptor_tokens_[uuid_]);
+                tokenize_volume_name(vol_path, volume_tokens_);
             }
 
             per_resource_codebook_file_streams_[uuid_].push_back(std::ifstream(vol_path.c_str(), std::ios::in | std::ios::binary | std::ios::ate));
@@ -131,24 +132,23 @@ void TV_3ResourceVQCompressed::upload_to(RenderContext const& ctx) const
     {
         int64_t loaded_volumes_count = 0;
 
-        auto& current_tokens = volume_descriptor_tokens_[uuid_];
-        int64_t num_bytes_per_voxel = current_tokens["num_bytes_per_voxel"];
+        int64_t num_bytes_per_voxel = volume_token("num_bytes_per_voxel");
 
-        int64_t total_block_size = std::pow(current_tokens["bs"], 3);
+        int64_t total_block_size = std::pow(volume_token("bs"), 3);
         int64_t size_per_codeword = (num_bytes_per_voxel)*total_block_size;
 
         int64_t const MAX_CODEBOOK_WIDTH = 16384;
 
-        current_tokens["num_codewords_per_row"] = std::floor(MAX_CODEBOOK_WIDTH / total_block_size);
-        int64_t codebook_width = current_tokens["num_codewords_per_row"] * total_block_size;
+        num_codewords_per_row_ = std::floor(MAX_CODEBOOK_WIDTH / total_block_size);
+        int64_t codebook_width = num_codewords_per_row_ * total_block_size;
 
-        size_t size_of_data_type = current_tokens["b"];
+        size_t size_of_data_type = volume_token("b");
 
         for(auto& codebook_stream : per_resource_codebook_file_streams_[uuid_])
         {
-            int64_t actual_num_index_bit_power = current_tokens["a"];
+            int64_t actual_num_index_bit_power = volume_token("a");
             int64_t num_codewords = std::pow(2, actual_num_index_bit_power);
-            int64_t codebook_height = int64_t(std::ceil(num_codewords / (float)current_tokens["num_codewords_per_row"]));
+            int64_t codebook_height = int64_t(std::ceil(num_codewords / (float)num_codewords_per_row_));
 
             int64_t codebook_texture_num_bytes = codebook_height * codebook_width * num_bytes_per_voxel;
             int64_t num_bytes_in_codebook_file = codebook_stream.tellg();
@@ -158,10 +158,7 @@ void TV_3ResourceVQCompressed::upload_to(RenderContext const& ctx) const
             per_resource_codebook_cpu_cache_[uuid_].push_back(std::vector<uint8_t>(codebook_texture_num_bytes, 0));
             codebook_stream.read((char*)&(per_resource_codebook_cpu_cache_[uuid_][loaded_volumes_count][0]), num_bytes_in_codebook_file);
 
-            current_tokens["codebook_width"] = codebook_width;
-            current_tokens["codebook_height"] = codebook_height;
-
-            scm::math::vec2ui codebook_dims = scm::math::vec2ui(current_tokens["codebook_width"], current_tokens["codebook_height"]);
+            scm::math::vec2ui codebook_dims = scm::math::vec2ui(codebook_width, codebook_height);
 
             scm::gl::data_format read_format = scm::gl::data_format::FORMAT_NULL;
 
@@ -199,11 +196,11 @@ void TV_3ResourceVQCompressed::apply_resource_dependent_uniforms(RenderContext c
 {
     TV_3Resource::apply_resource_dependent_uniforms(ctx, current_program);
 
-    auto& current_tokens = volume_descriptor_tokens_[uuid_];
-    current_program->apply_uniform(ctx, "num_codewords_per_row", int32_t(current_tokens["num_codewords_per_row"]));
-    current_program->apply_uniform(ctx, "block_offset_vector", math::vec3i(1, current_tokens["bs"], current_tokens["bs"] * current_tokens["bs"]));
-    current_program->apply_uniform(ctx, "total_block_size", int32_t(current_tokens["bs"] * current_tokens["bs"] * current_tokens["bs"]));
-    current_program->apply_uniform(ctx, "volume_dimensions", math::vec3i(current_tokens["w"], current_tokens["h"], current_tokens["d"]));
+    int32_t const block_size = volume_token("bs");
+    current_program->apply_uniform(ctx, "num_codewords_per_row", int32_t(num_codewords_per_row_));
+    current_program->apply_uniform(ctx, "block_offset_vector", math::vec3i(1, block_size, block_size * block_size));
+    current_program->apply_uniform(ctx, "total_block_size", int32_t(block_size * block_size * block_size));
+    current_program->apply_uniform(ctx, "volume_dimensions", math::vec3i(volume_token("w"), volume_token("h"), volume_token("d")));
     // current_program->apply_uniform(ctx, "total_block_size", )
     /*
       uniform ivec3 block_offset_vector = ivec3(0, 0, 0);
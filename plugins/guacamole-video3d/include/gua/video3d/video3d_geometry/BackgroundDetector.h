@@ -121,6 +121,10 @@ struct pixel_f{
 	
 };
 
+// Classifies the pixels of rgb frames as background or foreground by their
+// CIELab distance to a background model. Frames are processed row-parallel
+// on the gua::concurrent::ThreadPool, four pixels at a time where SSE2 is
+// available.
 class BackgroundDetector{
 	
 public:
@@ -139,23 +143,23 @@ public:
 	bool detectBackground(unsigned index, unsigned char r, unsigned char g, unsigned char b);
 
 
+	// same as detect, but blends background pixels into the background model
 	void detectBackground(unsigned char* frame, float thresh = 0.64);
 
 
 private:
 	
-	void RGB_to_CIELab();
-	void CIELab_to_RGB();
+	void classify(const unsigned char* frame, float thresh, bool blend_background);
+	void classifyRows(const unsigned char* frame, float thresh, bool blend_background, unsigned first_row, unsigned last_row);
+	void resetRows(const unsigned char* frame, unsigned first_row, unsigned last_row);
 	
 	pixel_f RGB_to_CIELab(unsigned char r, unsigned char g, unsigned char b);
 
 	unsigned m_w;
 	unsigned m_h;
 	
-	pixel_f*   m_bg_f;
-	
-	pixel_f*   m_lab;
-	pixel_s*   m_image;
+	// background model, one plane per L*, a* and b*
+	float*   m_bg_lab[3];
 	
 	pixel* m_bg;
 	pixel* m_fg;
@@ -3,14 +3,10 @@
 
 
 #include <ctime>
+#include <cstddef>
 #include <gua/video3d/video3d_geometry/fastdxt/libdxt.h>
 
 
-
-//#ifndef DXTCOMPRESSOR_NUMTHREADS
-//#define DXTCOMPRESSOR_NUMTHREADS 2
-//#endif
-
 class BackgroundDetector;
 
 namespace mvt{
@@ -21,29 +17,26 @@ namespace mvt{
     DXTCompressor();
     ~DXTCompressor();
 
+    // width and height have to be multiples of 4
     unsigned init(unsigned width, unsigned height, unsigned type = FORMAT_DXT1);
     unsigned getStorageSize();
+    // compresses an rgb image, rows of blocks are distributed over the gua::concurrent::ThreadPool
     unsigned char* compress(unsigned char* buff, bool resetbg = false);
     unsigned getType();
   private:
 
-    void docompress(unsigned tid, unsigned char* buff, bool resetbg = false);
+    void compressBlockRows(unsigned char const* buff, std::size_t begin, std::size_t end);
 
 
     unsigned _fc;
     //sensor::Timer _timer;
     unsigned _width;
     unsigned _height;
-    unsigned _height_sub;
     unsigned _type;
     unsigned _storage;
-    unsigned _compressed_buff_sub_size;
+    unsigned _block_row_size;
     byte* _rgba_buff;
-//    byte* _rgba_buff_sub[DXTCOMPRESSOR_NUMTHREADS];
     byte* _compressed_buff;
-//    byte* _compressed_buff_sub[DXTCOMPRESSOR_NUMTHREADS];
-
-//    BackgroundDetector* _bgd[DXTCOMPRESSOR_NUMTHREADS];
 
   };
 
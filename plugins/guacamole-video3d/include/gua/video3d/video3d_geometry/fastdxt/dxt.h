@@ -55,6 +55,20 @@ typedef unsigned int dword;
 #endif
 
 
+// Instruction sets of the block encoders
+#define DXT_ISA_SCALAR 0
+#define DXT_ISA_SSE41  1
+#define DXT_ISA_AVX2   2
+
+// Best instruction set supported by this cpu
+int GetSupportedDXTInstructionSet();
+
+// Selects the block encoders used by all following compressions, defaults to
+// the best supported ones; returns the instruction set actually selected
+int SetDXTInstructionSet(int isa);
+
+int GetDXTInstructionSet();
+
 // Compress to DXT1 format
 void CompressImageDXT1( const byte *inBuf, byte *outBuf, int width, int height, int &outputBytes );
 
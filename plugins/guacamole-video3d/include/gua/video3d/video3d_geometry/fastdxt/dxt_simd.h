@@ -0,0 +1,115 @@
+// SIMD versions of the block encoders in dxt.cpp, based on:
+//    Real-Time DXT Compression
+//    May 20th 2006 J.M.P. van Waveren
+//    (c) 2006, Id Software, Inc.
+//
+// Each encoder compresses numBlocks horizontally adjacent 4x4 blocks of an
+// RGBA image, starting at inPtr. width is the row length of the image in
+// pixels. outData receives 8 (DXT1) or 16 (DXT5) bytes per block. The output
+// is bit-identical to the scalar encoders.
+//
+// The SSE4.1 and AVX2 encoders live in translation units of their own which
+// are compiled for the respective instruction set; CompressImageDXT1() and
+// friends pick one at runtime, see SetDXTInstructionSet(). The helpers below
+// are static so that no copy compiled for AVX2 can be shared with code which
+// runs on older cpus.
+
+#ifndef DXT_SIMD_H
+#define DXT_SIMD_H
+
+#include <gua/video3d/video3d_geometry/fastdxt/dxt.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DXT_HAVE_X86_SIMD 1
+#endif
+
+typedef void (*DXTBlockRowEncoder)(const byte* inPtr, int width, int numBlocks, byte* outData);
+
+#if defined(DXT_HAVE_X86_SIMD)
+void CompressBlockRowDXT1_SSE41(const byte* inPtr, int width, int numBlocks, byte* outData);
+void CompressBlockRowDXT5_SSE41(const byte* inPtr, int width, int numBlocks, byte* outData);
+void CompressBlockRowDXT5YCoCg_SSE41(const byte* inPtr, int width, int numBlocks, byte* outData);
+
+void CompressBlockRowDXT1_AVX2(const byte* inPtr, int width, int numBlocks, byte* outData);
+void CompressBlockRowDXT5_AVX2(const byte* inPtr, int width, int numBlocks, byte* outData);
+void CompressBlockRowDXT5YCoCg_AVX2(const byte* inPtr, int width, int numBlocks, byte* outData);
+#endif
+
+// Insets the range of one channel, as done by GetMinMaxColorsByBBox
+static inline void InsetChannel(byte& minValue, byte& maxValue)
+{
+    byte inset = (maxValue - minValue) >> INSET_SHIFT;
+    minValue = (minValue + inset <= 255) ? minValue + inset : 255;
+    maxValue = (maxValue >= inset) ? maxValue - inset : 0;
+}
+
+// The four colors of the palette used by EmitColorIndicesFast
+static inline void ComputeColorPalette(const byte* minColor, const byte* maxColor, word colors[4][3])
+{
+    colors[0][0] = (maxColor[0] & C565_5_MASK) | (maxColor[0] >> 5);
+    colors[0][1] = (maxColor[1] & C565_6_MASK) | (maxColor[1] >> 6);
+    colors[0][2] = (maxColor[2] & C565_5_MASK) | (maxColor[2] >> 5);
+    colors[1][0] = (minColor[0] & C565_5_MASK) | (minColor[0] >> 5);
+    colors[1][1] = (minColor[1] & C565_6_MASK) | (minColor[1] >> 6);
+    colors[1][2] = (minColor[2] & C565_5_MASK) | (minColor[2] >> 5);
+
+    for(int c = 0; c < 3; c++)
+    {
+        colors[2][c] = (2 * colors[0][c] + 1 * colors[1][c]) / 3;
+        colors[3][c] = (1 * colors[0][c] + 2 * colors[1][c]) / 3;
+    }
+}
+
+// The seven thresholds used by EmitAlphaIndicesFast, including its byte overflow
+static inline void ComputeAlphaThresholds(const byte minAlpha, const byte maxAlpha, byte thresholds[7])
+{
+    byte mid = (maxAlpha - minAlpha) / (2 * 7);
+    thresholds[0] = minAlpha + mid;
+
+    for(int k = 1; k < 7; k++)
+    {
+        thresholds[k] = ((7 - k) * maxAlpha + k * minAlpha) / 7 + mid;
+    }
+}
+
+// Spreads the 16 bits of mask to the even bits of the result
+static inline dword SpreadBits(dword mask)
+{
+    mask = (mask | (mask << 8)) & 0x00FF00FF;
+    mask = (mask | (mask << 4)) & 0x0F0F0F0F;
+    mask = (mask | (mask << 2)) & 0x33333333;
+    mask = (mask | (mask << 1)) & 0x55555555;
+    return mask;
+}
+
+static inline word PackColor565(const byte* color) { return ((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3); }
+
+// Writes the little endian 8 byte DXT1 color block
+static inline void StoreColorBlock(const byte* minColor, const byte* maxColor, dword indices, byte* outData)
+{
+    word maxPacked = PackColor565(maxColor);
+    word minPacked = PackColor565(minColor);
+
+    outData[0] = maxPacked & 255;
+    outData[1] = maxPacked >> 8;
+    outData[2] = minPacked & 255;
+    outData[3] = minPacked >> 8;
+    outData[4] = (indices >> 0) & 255;
+    outData[5] = (indices >> 8) & 255;
+    outData[6] = (indices >> 16) & 255;
+    outData[7] = (indices >> 24) & 255;
+}
+
+// Writes the 8 byte DXT5 alpha block, indices holds 16 three bit indices
+static inline void StoreAlphaBlock(const byte minAlpha, const byte maxAlpha, unsigned long long indices, byte* outData)
+{
+    outData[0] = maxAlpha;
+    outData[1] = minAlpha;
+
+    for(int i = 0; i < 6; i++)
+    {
+        outData[2 + i] = (indices >> (8 * i)) & 255;
+    }
+}
+
+#endif // DXT_SIMD_H
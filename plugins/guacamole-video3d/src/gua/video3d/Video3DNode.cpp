@@ -82,6 +82,7 @@ void Video3DNode::set_video_description(std::string const& v)
 {
     video_description_ = v;
     video_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -95,6 +96,7 @@ void Video3DNode::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
     video_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1,127 +1,152 @@
 #include <gua/video3d/video3d_geometry/BackgroundDetector.h>
 
+#include <gua/concurrent/ThreadPool.hpp>
+
 #include <iostream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BACKGROUNDDETECTOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
 namespace
 {
-#define FORC(cnt) for(c = 0; c < cnt; c++)
-#define FORC3 FORC(3)
+// To the extent possible under law, Manuel Llorens <manuelllorens@gmail.com>
+// has waived all copyright and related or neighboring rights to this work.
+// This code is licensed under CC0 v1.0, see license information at
+// http://creativecommons.org/publicdomain/zero/1.0/
 
-#define MIN(a, b) ((a) < (b) ? (a) : (b))
-#define MAX(a, b) ((a) > (b) ? (a) : (b))
-#define LIM(x, min, max) MAX(min, MIN(x, max))
-#define CLIP(x) LIM(x, 0, 65535)
+const float EPSILON = 216.0f / 24389.0f;
+const float KAPPA = 24389.0f / 27.0f;
+const float d50_white[3] = {0.964220f, 1.0f, 0.825211f};
+const double rgb_xyz[3][3] = {{0.7976748465, 0.1351917082, 0.0313534088}, {0.2880402025, 0.7118741325, 0.0000856651}, {0.0000000000, 0.0000000000, 0.8252114389}}; // From Jacques Desmis
 
-void pseudoinverse(const double (*in)[3], double (*out)[3], int size)
-{
-    double work[3][6], num;
-    int i, j, k;
+// weight of the current frame when blending background pixels into the model
+const float BLEND_ALPHA = 0.125f;
 
-    for(i = 0; i < 3; i++)
-    {
-        for(j = 0; j < 6; j++)
-            work[i][j] = j == i + 3;
-        for(j = 0; j < 3; j++)
-            for(k = 0; k < size; k++)
-                work[i][j] += in[k][i] * in[k][j];
-    }
-    for(i = 0; i < 3; i++)
+// minimum number of rows processed by one task of the thread pool
+const std::size_t ROWS_PER_TASK = 8;
+
+// Maps a value of one color channel to its contribution to X/Xw, Y/Yw and
+// Z/Zw. This folds the linearization of the channel, the rgb to xyz matrix
+// and the white point into three lookups per pixel. The channel values are
+// taken as linear on the 16 bit scale the conversion was written for.
+struct LabTable
+{
+    LabTable()
     {
-        num = work[i][i];
-        for(j = 0; j < 6; j++)
-            work[i][j] /= num;
-        for(k = 0; k < 3; k++)
+        for(unsigned channel = 0; channel < 3; ++channel)
         {
-            if(k == i)
-                continue;
-            num = work[k][i];
-            for(j = 0; j < 6; j++)
-                work[k][j] -= work[i][j] * num;
+            for(unsigned value = 0; value < 256; ++value)
+            {
+                for(unsigned c = 0; c < 3; ++c)
+                {
+                    xyz[channel][value][c] = float(rgb_xyz[c][channel] * value / d50_white[c] / 65535.0);
+                }
+                xyz[channel][value][3] = 0.0f;
+            }
         }
     }
-    for(i = 0; i < size; i++)
-        for(j = 0; j < 3; j++)
-            for(out[i][j] = k = 0; k < 3; k++)
-                out[i][j] += work[j][k + 3] * in[i][k];
+
+    alignas(16) float xyz[3][256][4];
+};
+
+LabTable const& lab_table()
+{
+    static LabTable table;
+    return table;
 }
 
-// To the extent possible under law, Manuel Llorens <manuelllorens@gmail.com>
-// has waived all copyright and related or neighboring rights to this work.
-// This code is licensed under CC0 v1.0, see license information at
-// http://creativecommons.org/publicdomain/zero/1.0/
+float lab_f(float t) { return t > EPSILON ? std::cbrt(t) : (KAPPA * t + 16.0f) / 116.0f; }
 
-#if 0	
-	float (*lab)[3];
-	unsigned short (*image)[3];
-#endif
-double ep, ka;
-double xyz_rgb_2[3][3];
-float d50_white[3] = {0.964220, 1, 0.825211};
-static const double rgb_xyz[3][3] = {{0.7976748465, 0.1351917082, 0.0313534088}, {0.2880402025, 0.7118741325, 0.0000856651}, {0.0000000000, 0.0000000000, 0.8252114389}}; // From Jacques Desmis
+void rgb_to_lab(LabTable const& table, unsigned char r, unsigned char g, unsigned char b, float lab[3])
+{
+    float f[3];
+    for(unsigned c = 0; c < 3; ++c)
+    {
+        f[c] = lab_f(table.xyz[0][r][c] + table.xyz[1][g][c] + table.xyz[2][b][c]);
+    }
+
+    lab[0] = 116.0f * f[1] - 16.0f;
+    lab[1] = 500.0f * (f[0] - f[1]);
+    lab[2] = 200.0f * (f[1] - f[2]);
+}
 
-double f_cbrt(double r)
+float squared_dist(const float a[3], const float b[3]) { return (a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]); }
+
+#if defined(BACKGROUNDDETECTOR_SSE2)
+// cube root of positive values: an exponent division by three as initial
+// guess, refined by two iterations of Halley's method
+__m128 cbrt_ps(__m128 x)
 {
-    r /= 65535.0;
-    return r > ep ? pow(r, 1 / 3.0) : (ka * r + 16) / 116.0;
+    __m128i bits = _mm_castps_si128(x);
+    bits = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / 3.0f))), _mm_set1_epi32(709921077));
+    __m128 y = _mm_castsi128_ps(bits);
+
+    const __m128 two = _mm_set1_ps(2.0f);
+    for(int i = 0; i < 2; ++i)
+    {
+        __m128 y3 = _mm_mul_ps(_mm_mul_ps(y, y), y);
+        y = _mm_mul_ps(y, _mm_div_ps(_mm_add_ps(y3, _mm_mul_ps(two, x)), _mm_add_ps(_mm_mul_ps(two, y3), x)));
+    }
+
+    return y;
 }
 
-#if 0	
-	void CIELab_Init(){
-		int i;
-		
-		ep=216.0/24389.0;
-		ka=24389.0/27.0;
-		pseudoinverse(rgb_xyz,xyz_rgb_2,3);
-		
-		lab=(float (*)[3])calloc(width*height,sizeof *lab);  
-		merror(lab,"CIELab_Init()");		
-	}
-	
-	void CIELab_End(){
-		if(lab) free(lab);
-	}
-#endif
+__m128 lab_f_ps(__m128 t)
+{
+    __m128 linear = _mm_div_ps(_mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(KAPPA)), _mm_set1_ps(16.0f)), _mm_set1_ps(116.0f));
+    __m128 cube = _mm_cmpgt_ps(t, _mm_set1_ps(EPSILON));
+
+    // dark pixels only need the linear segment
+    if(!_mm_movemask_ps(cube))
+    {
+        return linear;
+    }
 
-float dist(const pixel_f& a, const pixel_f& b) { return std::sqrt((a.r - b.r) * (a.r - b.r) + (a.g - b.g) * (a.g - b.g) + (a.b - b.b) * (a.b - b.b)); }
+    return _mm_or_ps(_mm_and_ps(cube, cbrt_ps(t)), _mm_andnot_ps(cube, linear));
+}
 
-pixel_f blend(const pixel_f& curr, const pixel_f& old)
+// converts four rgb pixels to one register per L*, a* and b*
+void rgb_to_lab_ps(LabTable const& table, const unsigned char* rgb, __m128 lab[3])
 {
-    pixel_f res;
-    const float alpha = 0.125f;
-    res.r = alpha * curr.r + (1.0f - alpha) * old.r;
-    res.g = alpha * curr.g + (1.0f - alpha) * old.g;
-    res.b = alpha * curr.b + (1.0f - alpha) * old.b;
-    return res;
+    __m128 p0 = _mm_add_ps(_mm_add_ps(_mm_load_ps(table.xyz[0][rgb[0]]), _mm_load_ps(table.xyz[1][rgb[1]])), _mm_load_ps(table.xyz[2][rgb[2]]));
+    __m128 p1 = _mm_add_ps(_mm_add_ps(_mm_load_ps(table.xyz[0][rgb[3]]), _mm_load_ps(table.xyz[1][rgb[4]])), _mm_load_ps(table.xyz[2][rgb[5]]));
+    __m128 p2 = _mm_add_ps(_mm_add_ps(_mm_load_ps(table.xyz[0][rgb[6]]), _mm_load_ps(table.xyz[1][rgb[7]])), _mm_load_ps(table.xyz[2][rgb[8]]));
+    __m128 p3 = _mm_add_ps(_mm_add_ps(_mm_load_ps(table.xyz[0][rgb[9]]), _mm_load_ps(table.xyz[1][rgb[10]])), _mm_load_ps(table.xyz[2][rgb[11]]));
+
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+    __m128 fx = lab_f_ps(p0);
+    __m128 fy = lab_f_ps(p1);
+    __m128 fz = lab_f_ps(p2);
+
+    lab[0] = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(116.0f), fy), _mm_set1_ps(16.0f));
+    lab[1] = _mm_mul_ps(_mm_set1_ps(500.0f), _mm_sub_ps(fx, fy));
+    lab[2] = _mm_mul_ps(_mm_set1_ps(200.0f), _mm_sub_ps(fy, fz));
 }
+#endif
 
 } // namespace
-/*
- unsigned m_w;
- unsigned m_h;
-
- pixel_f*   m_bg_f;
- pixel* m_bg;
- pixel* m_fg;
 
- */
-BackgroundDetector::BackgroundDetector(unsigned w, unsigned h) : m_w(w), m_h(h), m_bg_f(0), m_lab(0), m_image(0), m_bg(0), m_fg(0), m_reset(false)
+BackgroundDetector::BackgroundDetector(unsigned w, unsigned h) : m_w(w), m_h(h), m_bg_lab(), m_bg(0), m_fg(0), m_reset(false)
 {
-    m_bg_f = new pixel_f[m_w * m_h];
-    m_lab = new pixel_f[m_w * m_h];
-    m_image = new pixel_s[m_w * m_h];
+    for(unsigned c = 0; c < 3; ++c)
+    {
+        m_bg_lab[c] = new float[m_w * m_h]();
+    }
     m_bg = new pixel[m_w * m_h];
     m_fg = new pixel[m_w * m_h];
 
-    ep = 216.0 / 24389.0;
-    ka = 24389.0 / 27.0;
-    pseudoinverse(rgb_xyz, xyz_rgb_2, 3);
+    lab_table();
 }
 
 BackgroundDetector::~BackgroundDetector()
 {
-    delete[] m_bg_f;
-    delete[] m_lab;
-    delete[] m_image;
+    for(unsigned c = 0; c < 3; ++c)
+    {
+        delete[] m_bg_lab[c];
+    }
     delete[] m_bg;
     delete[] m_fg;
 }
@@ -131,315 +156,162 @@ void BackgroundDetector::reset() { m_reset = true; }
 void BackgroundDetector::detect(unsigned char* frame, float thresh)
 {
     std::cerr << "detect: " << thresh << std::endl;
+    classify(frame, thresh, false);
+}
 
-#if 0	
-	for( unsigned y = 0; y < m_h; ++y){
-		for(unsigned x = 0; x < m_w; ++x){
-			const unsigned i = 3 * m_w * y + 3 * x;
-			const unsigned j =     m_w * y + x;
-			unsigned char r = frame[i + 0];
-			unsigned char g = frame[i + 1];
-			unsigned char b = frame[i + 2];
-			
-			pixel_f pf(r,g,b);
-			pixel_f pf_yuv = pf.to_yuv();
-			if(pf_yuv.r < 0.1){
-				m_fg[j] = pixel(0,255,0);//p.to_char();
-				m_bg[j] = pixel(0,0,0);
-			}
-			else{
-				m_bg[j] = pixel(255,0,0);//p.to_char();
-				m_fg[j] = pixel(0,0,0);				
-			}
-		}
-	}
-#endif
-    // 1. convert frame to 16 bit image
-    for(unsigned y = 0; y < m_h; ++y)
+unsigned char* BackgroundDetector::getBackground() { return (unsigned char*)m_bg; }
+
+unsigned char* BackgroundDetector::getForeground() { return (unsigned char*)m_fg; }
+
+void BackgroundDetector::setBackground(unsigned index, unsigned char r, unsigned char g, unsigned char b)
+{
+    pixel_f lab(RGB_to_CIELab(r, g, b));
+    m_bg_lab[0][index] = lab.r;
+    m_bg_lab[1][index] = lab.g;
+    m_bg_lab[2][index] = lab.b;
+}
+
+bool BackgroundDetector::detectBackground(unsigned index, unsigned char r, unsigned char g, unsigned char b)
+{
+    float lab[3];
+    rgb_to_lab(lab_table(), r, g, b, lab);
+
+    const float bg[3] = {m_bg_lab[0][index], m_bg_lab[1][index], m_bg_lab[2][index]};
+
+    if(squared_dist(lab, bg) < 0.64f * 0.64f)
     {
-        for(unsigned x = 0; x < m_w; ++x)
+        for(unsigned c = 0; c < 3; ++c)
         {
-            const unsigned i = 3 * m_w * y + 3 * x;
-            const unsigned j = m_w * y + x;
-            unsigned char r = frame[i + 0];
-            unsigned char g = frame[i + 1];
-            unsigned char b = frame[i + 2];
-
-            m_image[j] = pixel_s(r, g, b);
+            m_bg_lab[c][index] = BLEND_ALPHA * lab[c] + (1.0f - BLEND_ALPHA) * bg[c];
         }
+        return true;
     }
+    return false;
+}
+
+void BackgroundDetector::detectBackground(unsigned char* frame, float thresh) { classify(frame, thresh, true); }
 
-    // 2. convert image to lab
-    RGB_to_CIELab();
+void BackgroundDetector::classify(const unsigned char* frame, float thresh, bool blend_background)
+{
+    auto pool(gua::concurrent::ThreadPool::instance());
 
     if(m_reset)
     {
         m_reset = false;
         std::cerr << "resetting" << std::endl;
-        for(unsigned y = 0; y < m_h; ++y)
-        {
-            for(unsigned x = 0; x < m_w; ++x)
-            {
-                const unsigned j = m_w * y + x;
-                m_bg_f[j] = m_lab[j];
-                m_bg[j] = pixel(255, 0, 0); // m_image[j].to_char();
-                m_fg[j] = pixel(0, 0, 0);
-            }
-        }
+        pool->parallel_for(0, m_h, [this, frame](std::size_t begin, std::size_t end) { resetRows(frame, begin, end); }, ROWS_PER_TASK);
     }
-    else
+    else if(m_h > 2)
     {
-        for(unsigned y = 1; y < m_h - 1; ++y)
-        {
-            for(unsigned x = 1; x < m_w - 1; ++x)
-            {
-                const unsigned j = m_w * y + x;
-
-                const unsigned nw = m_w * y + x;
-                const unsigned nn = m_w * y + x;
-                const unsigned ne = m_w * y + x;
-                const unsigned ee = m_w * y + x;
-                const unsigned se = m_w * y + x;
-                const unsigned ss = m_w * y + x;
-                const unsigned sw = m_w * y + x;
-                const unsigned ww = m_w * y + x;
-
-                const float w = 1.5f;
-
-                const float d = dist(m_lab[j], m_bg_f[j]) + w * dist(m_lab[nw], m_bg_f[nw]) + w * dist(m_lab[nn], m_bg_f[nn]) + w * dist(m_lab[ne], m_bg_f[ne]) + w * dist(m_lab[ee], m_bg_f[ee]) +
-                                w * dist(m_lab[se], m_bg_f[se]) + w * dist(m_lab[ss], m_bg_f[ss]) + w * dist(m_lab[sw], m_bg_f[sw]) + w * dist(m_lab[ww], m_bg_f[ww]);
-                if(d < (thresh + 8 * w * thresh))
-                {
-                    m_bg[j] = pixel(255, 0, 0);
-                    m_fg[j] = pixel(0, 0, 0);
-                    // blend new bg into old bg
-                    // m_bg_f[j] = blend(m_lab[j],m_bg_f[j]);
-                }
-                else
-                {
-                    m_bg[j] = pixel(0, 0, 0);
-                    // m_fg[j] = pixel(0,255,0);
-                    const unsigned i = 3 * m_w * y + 3 * x;
-                    unsigned char r = frame[i + 0];
-                    unsigned char g = frame[i + 1];
-                    unsigned char b = frame[i + 2];
-                    m_fg[j] = pixel(r, g, b);
-                }
-            }
-        }
-        for(unsigned y = 1; y < m_h - 1; ++y)
-        {
-            for(unsigned x = 1; x < m_w - 1; ++x)
-            {
-                const unsigned j = m_w * y + x;
-                if(m_bg[j].r == 255)
-                {
-                    // blend new bg into old bg
-                    // m_bg_f[j] = blend(m_lab[j],m_bg_f[j]);
-                }
-            }
-        }
+        // the one pixel wide border is left untouched
+        pool->parallel_for(1,
+                           m_h - 1,
+                           [this, frame, thresh, blend_background](std::size_t begin, std::size_t end) { classifyRows(frame, thresh, blend_background, begin, end); },
+                           ROWS_PER_TASK);
     }
-
-#if 0	
-	// 3. convert image back to rgb
-	CIELab_to_RGB();
-	
-	// 4. apply image to unsigned char image
-	for( unsigned y = 0; y < m_h; ++y){
-		for(unsigned x = 0; x < m_w; ++x){
-			const unsigned j =     m_w * y + x;
-			m_fg[j] = m_image[j].to_char();
-			m_bg[j] = m_fg[j];
-		}
-	}
-#endif
 }
 
-unsigned char* BackgroundDetector::getBackground() { return (unsigned char*)m_bg; }
-
-unsigned char* BackgroundDetector::getForeground() { return (unsigned char*)m_fg; }
-
-void BackgroundDetector::RGB_to_CIELab()
+void BackgroundDetector::resetRows(const unsigned char* frame, unsigned first_row, unsigned last_row)
 {
-    int c;
-    double xyz[3];
+    LabTable const& table(lab_table());
 
-#pragma omp parallel for private(offset, xyz, c) shared(lab)
-    for(unsigned offset = 0; offset < m_w * m_h; offset++)
+    for(unsigned j = first_row * m_w; j < last_row * m_w; ++j)
     {
-        // Convert RGB to XYZ
-        xyz[0] = xyz[1] = xyz[2] = 0;
-        FORC3
+        float lab[3];
+        rgb_to_lab(table, frame[3 * j + 0], frame[3 * j + 1], frame[3 * j + 2], lab);
+
+        for(unsigned c = 0; c < 3; ++c)
         {
-#if 0
-			xyz[c]+=rgb_xyz[c][0]*(double)image[offset][0];
-			xyz[c]+=rgb_xyz[c][1]*(double)image[offset][1];
-			xyz[c]+=rgb_xyz[c][2]*(double)image[offset][2];
-#endif
-            xyz[c] += rgb_xyz[c][0] * (double)m_image[offset].r;
-            xyz[c] += rgb_xyz[c][1] * (double)m_image[offset].g;
-            xyz[c] += rgb_xyz[c][2] * (double)m_image[offset].b;
+            m_bg_lab[c][j] = lab[c];
         }
-
-        // Convert XYZ to L*a*b*
-        FORC3 xyz[c] = f_cbrt(xyz[c] / d50_white[c]);
-#if 0		
-		lab[offset][0]=116.0*xyz[1]-16.0;		
-		lab[offset][1]=500.0*(xyz[0]-xyz[1]);;
-		lab[offset][2]=200.0*(xyz[1]-xyz[2]);
-#endif
-        m_lab[offset].r = 116.0 * xyz[1] - 16.0;
-        m_lab[offset].g = 500.0 * (xyz[0] - xyz[1]);
-        ;
-        m_lab[offset].b = 200.0 * (xyz[1] - xyz[2]);
+        m_bg[j] = pixel(255, 0, 0);
+        m_fg[j] = pixel(0, 0, 0);
     }
 }
 
-void BackgroundDetector::CIELab_to_RGB()
+void BackgroundDetector::classifyRows(const unsigned char* frame, float thresh, bool blend_background, unsigned first_row, unsigned last_row)
 {
-    int c;
-    double L;
-    double xyz[3], rgb[3], f[3];
-
-#pragma omp parallel for private(offset, xyz, c, f, L, rgb) shared(image)
-    for(unsigned offset = 0; offset < m_w * m_h; offset++)
-    {
-        // Convert L*a*b* to XYZ
+    LabTable const& table(lab_table());
 
-#if 0		
-		L=(double)lab[offset][0];
-		f[1]=(L+16.0)/116.0;	// fy
-		f[0]=f[1]+(double)lab[offset][1]/500.0;	// fx
-		f[2]=f[1]-(double)lab[offset][2]/200.0;	// fz
-#endif
-
-        L = (double)m_lab[offset].r;
-        f[1] = (L + 16.0) / 116.0;                     // fy
-        f[0] = f[1] + (double)m_lab[offset].g / 500.0; // fx
-        f[2] = f[1] - (double)m_lab[offset].b / 200.0; // fz
-
-        xyz[0] = 65535.0 * d50_white[0] * (f[0] * f[0] * f[0] > ep ? f[0] * f[0] * f[0] : (116.0 * f[0] - 16.0) / ka);
-        xyz[1] = 65535.0 * d50_white[1] * (L > ka * ep ? pow(f[1], 3.0) : L / ka);
-        xyz[2] = 65535.0 * d50_white[2] * (f[2] * f[2] * f[2] > ep ? f[2] * f[2] * f[2] : (116.0 * f[2] - 16.0) / ka);
+    // The weighted sum of the distances of a pixel and its eight neighbours
+    // used to be compared to (1 + 8 * 1.5) * thresh, but all neighbour indices
+    // referred to the pixel itself. Hence this is the pixel's own distance
+    // compared to thresh, which is done on squared distances.
+    const float thresh2 = thresh * thresh;
 
-        // Convert XYZ to RGB
-        rgb[0] = rgb[1] = rgb[2] = 0;
-        FORC3
+    auto classify_pixel = [&](unsigned j, bool background) {
+        if(background)
         {
-            rgb[0] += xyz[c] * xyz_rgb_2[c][0];
-            rgb[1] += xyz[c] * xyz_rgb_2[c][1];
-            rgb[2] += xyz[c] * xyz_rgb_2[c][2];
+            m_bg[j] = pixel(255, 0, 0);
+            m_fg[j] = pixel(0, 0, 0);
         }
-#if 0
-		FORC3 image[offset][c]=(unsigned short)CLIP(rgb[c]);
-#endif
-
-        m_image[offset].r = (unsigned short)CLIP(rgb[0]);
-        m_image[offset].g = (unsigned short)CLIP(rgb[1]);
-        m_image[offset].b = (unsigned short)CLIP(rgb[2]);
-    }
-}
-
-void BackgroundDetector::setBackground(unsigned index, unsigned char r, unsigned char g, unsigned char b) { m_bg_f[index] = RGB_to_CIELab(r, g, b); }
-
-bool BackgroundDetector::detectBackground(unsigned index, unsigned char r, unsigned char g, unsigned char b)
-{
-    pixel_f lab(RGB_to_CIELab(r, g, b));
-    const float d = dist(lab, m_bg_f[index]);
+        else
+        {
+            m_bg[j] = pixel(0, 0, 0);
+            m_fg[j] = pixel(frame[3 * j + 0], frame[3 * j + 1], frame[3 * j + 2]);
+        }
+    };
 
-    if(d < 0.64)
+    for(unsigned y = first_row; y < last_row; ++y)
     {
-        m_bg_f[index] = blend(lab, m_bg_f[index]);
-        return true;
-    }
-    return false;
-}
+        unsigned x = 1;
 
-void BackgroundDetector::detectBackground(unsigned char* frame, float thresh)
-{
-    // 1. convert frame to 16 bit image
-    for(unsigned y = 0; y < m_h; ++y)
-    {
-        for(unsigned x = 0; x < m_w; ++x)
+#if defined(BACKGROUNDDETECTOR_SSE2)
+        const __m128 threshold(_mm_set1_ps(thresh2));
+        const __m128 alpha(_mm_set1_ps(BLEND_ALPHA));
+        const __m128 one_minus_alpha(_mm_set1_ps(1.0f - BLEND_ALPHA));
+
+        for(; x + 4 <= m_w - 1; x += 4)
         {
-            const unsigned i = 3 * m_w * y + 3 * x;
             const unsigned j = m_w * y + x;
-            unsigned char r = frame[i + 0];
-            unsigned char g = frame[i + 1];
-            unsigned char b = frame[i + 2];
 
-            m_image[j] = pixel_s(r, g, b);
-        }
-    }
+            __m128 lab[3], bg[3];
+            rgb_to_lab_ps(table, frame + 3 * j, lab);
 
-    // 2. convert image to lab
-    RGB_to_CIELab();
+            __m128 d2(_mm_setzero_ps());
+            for(unsigned c = 0; c < 3; ++c)
+            {
+                bg[c] = _mm_loadu_ps(m_bg_lab[c] + j);
+                __m128 diff(_mm_sub_ps(lab[c], bg[c]));
+                d2 = _mm_add_ps(d2, _mm_mul_ps(diff, diff));
+            }
 
-    if(m_reset)
-    {
-        m_reset = false;
-        std::cerr << "resetting" << std::endl;
-        for(unsigned y = 0; y < m_h; ++y)
-        {
-            for(unsigned x = 0; x < m_w; ++x)
+            __m128 background(_mm_cmplt_ps(d2, threshold));
+            int mask(_mm_movemask_ps(background));
+
+            for(unsigned k = 0; k < 4; ++k)
             {
-                const unsigned j = m_w * y + x;
-                m_bg_f[j] = m_lab[j];
-                m_bg[j] = pixel(255, 0, 0); // m_image[j].to_char();
-                m_fg[j] = pixel(0, 0, 0);
+                classify_pixel(j + k, (mask >> k) & 1);
             }
-        }
-    }
-    else
-    {
-        for(unsigned y = 1; y < m_h - 1; ++y)
-        {
-            for(unsigned x = 1; x < m_w - 1; ++x)
+
+            if(blend_background && mask)
             {
-                const unsigned j = m_w * y + x;
-
-                const unsigned nw = m_w * y + x;
-                const unsigned nn = m_w * y + x;
-                const unsigned ne = m_w * y + x;
-                const unsigned ee = m_w * y + x;
-                const unsigned se = m_w * y + x;
-                const unsigned ss = m_w * y + x;
-                const unsigned sw = m_w * y + x;
-                const unsigned ww = m_w * y + x;
-
-                const float w = 1.5f;
-
-                const float d = dist(m_lab[j], m_bg_f[j]) + w * dist(m_lab[nw], m_bg_f[nw]) + w * dist(m_lab[nn], m_bg_f[nn]) + w * dist(m_lab[ne], m_bg_f[ne]) + w * dist(m_lab[ee], m_bg_f[ee]) +
-                                w * dist(m_lab[se], m_bg_f[se]) + w * dist(m_lab[ss], m_bg_f[ss]) + w * dist(m_lab[sw], m_bg_f[sw]) + w * dist(m_lab[ww], m_bg_f[ww]);
-                if(d < (thresh + 8 * w * thresh))
-                {
-                    m_bg[j] = pixel(255, 0, 0);
-                    m_fg[j] = pixel(0, 0, 0);
-                    // blend new bg into old bg
-                    // m_bg_f[j] = blend(m_lab[j],m_bg_f[j]);
-                }
-                else
+                for(unsigned c = 0; c < 3; ++c)
                 {
-                    m_bg[j] = pixel(0, 0, 0);
-                    // m_fg[j] = pixel(0,255,0);
-                    const unsigned i = 3 * m_w * y + 3 * x;
-                    unsigned char r = frame[i + 0];
-                    unsigned char g = frame[i + 1];
-                    unsigned char b = frame[i + 2];
-                    m_fg[j] = pixel(r, g, b);
+                    __m128 blended(_mm_add_ps(_mm_mul_ps(alpha, lab[c]), _mm_mul_ps(one_minus_alpha, bg[c])));
+                    _mm_storeu_ps(m_bg_lab[c] + j, _mm_or_ps(_mm_and_ps(background, blended), _mm_andnot_ps(background, bg[c])));
                 }
             }
         }
-        for(unsigned y = 1; y < m_h - 1; ++y)
+#endif
+
+        for(; x < m_w - 1; ++x)
         {
-            for(unsigned x = 1; x < m_w - 1; ++x)
+            const unsigned j = m_w * y + x;
+
+            float lab[3];
+            rgb_to_lab(table, frame[3 * j + 0], frame[3 * j + 1], frame[3 * j + 2], lab);
+
+            const float bg[3] = {m_bg_lab[0][j], m_bg_lab[1][j], m_bg_lab[2][j]};
+            const bool background(squared_dist(lab, bg) < thresh2);
+
+            classify_pixel(j, background);
+
+            if(blend_background && background)
             {
-                const unsigned j = m_w * y + x;
-                if(m_bg[j].r == 255)
+                for(unsigned c = 0; c < 3; ++c)
                 {
-                    // blend new bg into old bg
-                    m_bg_f[j] = blend(m_lab[j], m_bg_f[j]);
+                    m_bg_lab[c][j] = BLEND_ALPHA * lab[c] + (1.0f - BLEND_ALPHA) * bg[c];
                 }
             }
         }
@@ -448,26 +320,7 @@ void BackgroundDetector::detectBackground(unsigned char* frame, float thresh)
 
 pixel_f BackgroundDetector::RGB_to_CIELab(unsigned char r, unsigned char g, unsigned char b)
 {
-    int c;
-    double xyz[3];
-
-    pixel_f lab;
-
-    xyz[0] = xyz[1] = xyz[2] = 0;
-    FORC3
-    {
-        xyz[c] += rgb_xyz[c][0] * (double)r;
-        xyz[c] += rgb_xyz[c][1] * (double)g;
-        xyz[c] += rgb_xyz[c][2] * (double)b;
-    }
-
-    // Convert XYZ to L*a*b*
-    FORC3 xyz[c] = f_cbrt(xyz[c] / d50_white[c]);
-
-    lab.r = 116.0 * xyz[1] - 16.0;
-    lab.g = 500.0 * (xyz[0] - xyz[1]);
-    ;
-    lab.b = 200.0 * (xyz[1] - xyz[2]);
-
-    return lab;
+    float lab[3];
+    rgb_to_lab(lab_table(), r, g, b, lab);
+    return pixel_f(lab[0], lab[1], lab[2]);
 }
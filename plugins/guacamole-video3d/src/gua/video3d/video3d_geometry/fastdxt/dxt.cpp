@@ -6,17 +6,20 @@
 #include <gua/video3d/video3d_geometry/fastdxt/dxt.h>
 #include <gua/video3d/video3d_geometry/fastdxt/util.h>
 
-#include <iostream>
+#include <gua/video3d/video3d_geometry/fastdxt/dxt_simd.h>
 
-//#define DXT_INTR 1
+#include <atomic>
+
+#if defined(DXT_HAVE_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
 
 void ExtractBlock(const byte* inPtr, int width, byte* colorBlock);
-void ExtractBlock_Intrinsics(const byte* inPtr, int width, byte* colorBlock);
 
 void GetMinMaxColors(const byte* colorBlock, byte* minColor, byte* maxColor);
 void GetMinMaxColorsByLuminance(const byte* colorBlock, byte* minColor, byte* maxColor);
 void GetMinMaxColorsByBBox(const byte* colorBlock, byte* minColor, byte* maxColor);
-void GetMinMaxColors_Intrinsics(const byte* colorBlock, byte* minColor, byte* maxColor);
 
 // for DXT5
 void GetMinMaxColorsAlpha(byte* colorBlock, byte* minColor, byte* maxColor);
@@ -29,52 +32,146 @@ void EmitDoubleWord(dword i, byte*&);
 
 void EmitColorIndices(const byte* colorBlock, const byte* minColor, const byte* maxColor, byte*& outData);
 void EmitColorIndicesFast(const byte* colorBlock, const byte* minColor, const byte* maxColor, byte*& outData);
-void EmitColorIndices_Intrinsics(const byte* colorBlock, const byte* minColor, const byte* maxColor, byte*& outData);
 
 // Emit indices for DXT5
 void EmitAlphaIndices(const byte* colorBlock, const byte minAlpha, const byte maxAlpha, byte*& outData);
 void EmitAlphaIndicesFast(const byte* colorBlock, const byte minAlpha, const byte maxAlpha, byte*& outData);
-void EmitAlphaIndices_Intrinsics(const byte* colorBlock, const byte minAlpha, const byte maxAlpha, byte*& outData);
 
-void CompressImageDXT1(const byte* inBuf, byte* outBuf, int width, int height, int& outputBytes)
+void RGBAtoYCoCg(const byte* inBuf, byte* outBuf, int width, int height);
+
+static void CompressBlockRowDXT1(const byte* inPtr, int width, int numBlocks, byte* outData)
 {
-    ALIGN16(byte * outData);
     ALIGN16(byte block[64]);
     ALIGN16(byte minColor[4]);
     ALIGN16(byte maxColor[4]);
 
-    outData = outBuf;
+    for(int i = 0; i < numBlocks; i++, inPtr += 4 * 4)
+    {
+        ExtractBlock(inPtr, width, block);
+        GetMinMaxColorsByBBox(block, minColor, maxColor);
+
+        EmitWord(ColorTo565(maxColor), outData);
+        EmitWord(ColorTo565(minColor), outData);
+
+        EmitColorIndicesFast(block, minColor, maxColor, outData);
+    }
+}
+
+static void EncodeBlockDXT5(byte* block, byte*& outData)
+{
+    ALIGN16(byte minColor[4]);
+    ALIGN16(byte maxColor[4]);
+
+    GetMinMaxColorsAlpha(block, minColor, maxColor);
+
+    EmitByte(maxColor[3], outData);
+    EmitByte(minColor[3], outData);
+
+    EmitAlphaIndicesFast(block, minColor[3], maxColor[3], outData);
+
+    EmitWord(ColorTo565(maxColor), outData);
+    EmitWord(ColorTo565(minColor), outData);
+
+    EmitColorIndicesFast(block, minColor, maxColor, outData);
+}
+
+static void CompressBlockRowDXT5(const byte* inPtr, int width, int numBlocks, byte* outData)
+{
+    ALIGN16(byte block[64]);
+
+    for(int i = 0; i < numBlocks; i++, inPtr += 4 * 4)
+    {
+        ExtractBlock(inPtr, width, block);
+        EncodeBlockDXT5(block, outData);
+    }
+}
+
+static void CompressBlockRowDXT5YCoCg(const byte* inPtr, int width, int numBlocks, byte* outData)
+{
+    ALIGN16(byte block[64]);
 
-    for(int j = 0; j < height; j += 4, inBuf += width * 4 * 4)
+    for(int i = 0; i < numBlocks; i++, inPtr += 4 * 4)
     {
-        for(int i = 0; i < width; i += 4)
-        {
-            // std::cerr << "i " << i << " j " << j << std::endl;
-#if defined(DXT_INTR)
-            ExtractBlock_Intrinsics(inBuf + i * 4, width, block);
-#else
-            ExtractBlock(inBuf + i * 4, width, block);
+        ExtractBlock(inPtr, width, block);
+        // the conversion is done per pixel, so it may be applied per block
+        RGBAtoYCoCg(block, block, 4, 4);
+        EncodeBlockDXT5(block, outData);
+    }
+}
+
+struct BlockRowEncoders
+{
+    DXTBlockRowEncoder dxt1;
+    DXTBlockRowEncoder dxt5;
+    DXTBlockRowEncoder dxt5ycocg;
+};
+
+static const BlockRowEncoders blockRowEncoders[] = {
+    {CompressBlockRowDXT1, CompressBlockRowDXT5, CompressBlockRowDXT5YCoCg},
+#if defined(DXT_HAVE_X86_SIMD)
+    {CompressBlockRowDXT1_SSE41, CompressBlockRowDXT5_SSE41, CompressBlockRowDXT5YCoCg_SSE41},
+    {CompressBlockRowDXT1_AVX2, CompressBlockRowDXT5_AVX2, CompressBlockRowDXT5YCoCg_AVX2},
 #endif
+};
 
-#if defined(DXT_INTR)
-            GetMinMaxColors_Intrinsics(block, minColor, maxColor);
+int GetSupportedDXTInstructionSet()
+{
+#if defined(DXT_HAVE_X86_SIMD)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+    __cpuidex(info, 7, 0);
+    bool avx2 = avx && (info[1] & (1 << 5));
 #else
-            GetMinMaxColorsByBBox(block, minColor, maxColor);
+    __builtin_cpu_init();
+    bool sse41 = __builtin_cpu_supports("sse4.1");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if(avx2)
+    {
+        return DXT_ISA_AVX2;
+    }
+    if(sse41)
+    {
+        return DXT_ISA_SSE41;
+    }
 #endif
+    return DXT_ISA_SCALAR;
+}
 
-            EmitWord(ColorTo565(maxColor), outData);
-            EmitWord(ColorTo565(minColor), outData);
+static std::atomic<int>& ActiveInstructionSet()
+{
+    static std::atomic<int> isa(GetSupportedDXTInstructionSet());
+    return isa;
+}
 
-#if defined(DXT_INTR)
-            EmitColorIndices_Intrinsics(block, minColor, maxColor, outData);
-#else
-            EmitColorIndicesFast(block, minColor, maxColor, outData);
-#endif
-        }
+int SetDXTInstructionSet(int isa)
+{
+    int supported = GetSupportedDXTInstructionSet();
+    ActiveInstructionSet() = isa < supported ? (isa < DXT_ISA_SCALAR ? DXT_ISA_SCALAR : isa) : supported;
+    return ActiveInstructionSet();
+}
+
+int GetDXTInstructionSet() { return ActiveInstructionSet(); }
+
+static const BlockRowEncoders& ActiveEncoders() { return blockRowEncoders[ActiveInstructionSet()]; }
+
+static void CompressBlockRows(DXTBlockRowEncoder encode, int blockSize, const byte* inBuf, byte* outBuf, int width, int height, int& outputBytes)
+{
+    const int numBlocks = (width + 3) / 4;
+    byte* outData = outBuf;
+
+    for(int j = 0; j < height; j += 4, inBuf += width * 4 * 4, outData += numBlocks * blockSize)
+    {
+        encode(inBuf, width, numBlocks, outData);
     }
     outputBytes = (int)(outData - outBuf);
 }
 
+void CompressImageDXT1(const byte* inBuf, byte* outBuf, int width, int height, int& outputBytes) { CompressBlockRows(ActiveEncoders().dxt1, 8, inBuf, outBuf, width, height, outputBytes); }
+
 void RGBAtoYCoCg(const byte* inBuf, byte* outBuf, int width, int height)
 {
     for(int j = 0; j < width * height; j++)
@@ -116,63 +213,10 @@ void RGBAtoYCoCg(const byte* inBuf, byte* outBuf, int width, int height)
 
 void CompressImageDXT5YCoCg(const byte* inBuf, byte* outBuf, int width, int height, int& outputBytes)
 {
-    byte* tmpBuf;
-    tmpBuf = (byte*)memalign(16, width * height * 4);
-    memset(tmpBuf, 0, width * height * 4);
-    RGBAtoYCoCg(inBuf, tmpBuf, width, height);
-    CompressImageDXT5(tmpBuf, outBuf, width, height, outputBytes);
-    memfree(tmpBuf);
+    CompressBlockRows(ActiveEncoders().dxt5ycocg, 16, inBuf, outBuf, width, height, outputBytes);
 }
 
-void CompressImageDXT5(const byte* inBuf, byte* outBuf, int width, int height, int& outputBytes)
-{
-    ALIGN16(byte * outData);
-
-    ALIGN16(byte block[64]);
-    ALIGN16(byte minColor[4]);
-    ALIGN16(byte maxColor[4]);
-
-    outData = outBuf;
-    for(int j = 0; j < height; j += 4, inBuf += width * 4 * 4)
-    {
-        for(int i = 0; i < width; i += 4)
-        {
-#if defined(DXT_INTR)
-            ExtractBlock_Intrinsics(inBuf + i * 4, width, block);
-#else
-            ExtractBlock(inBuf + i * 4, width, block);
-#endif
-
-#if defined(DXT_INTR)
-            GetMinMaxColors_Intrinsics(block, minColor, maxColor);
-#else
-            GetMinMaxColorsAlpha(block, minColor, maxColor);
-#endif
-
-            EmitByte(maxColor[3], outData);
-            EmitByte(minColor[3], outData);
-
-#if defined(DXT_INTR)
-            // Not Yet Implemented
-            // EmitAlphaIndices_Intrinsics( block, minColor[3], maxColor[3], outData );
-
-            EmitAlphaIndicesFast(block, minColor[3], maxColor[3], outData);
-#else
-            EmitAlphaIndicesFast(block, minColor[3], maxColor[3], outData);
-#endif
-
-            EmitWord(ColorTo565(maxColor), outData);
-            EmitWord(ColorTo565(minColor), outData);
-
-#if defined(DXT_INTR)
-            EmitColorIndices_Intrinsics(block, minColor, maxColor, outData);
-#else
-            EmitColorIndicesFast(block, minColor, maxColor, outData);
-#endif
-        }
-    }
-    outputBytes = int(outData - outBuf);
-}
+void CompressImageDXT5(const byte* inBuf, byte* outBuf, int width, int height, int& outputBytes) { CompressBlockRows(ActiveEncoders().dxt5, 16, inBuf, outBuf, width, height, outputBytes); }
 
 void ExtractBlock(const byte* inPtr, int width, byte* colorBlock)
 {
@@ -0,0 +1,308 @@
+// AVX2 block encoders, based on:
+//    Real-Time DXT Compression
+//    May 20th 2006 J.M.P. van Waveren
+//    (c) 2006, Id Software, Inc.
+//
+// Works like the SSE4.1 encoders, but on two horizontally adjacent blocks at
+// once: the lower 128 bit lane of each register holds the first block, the
+// upper lane the second one. An odd last block of a row is passed on to the
+// SSE4.1 encoder.
+
+#include <gua/video3d/video3d_geometry/fastdxt/dxt_simd.h>
+
+#if defined(DXT_HAVE_X86_SIMD)
+
+#include <immintrin.h>
+
+namespace
+{
+// Gathers the pixels of two 4x4 blocks into one register per channel
+inline void LoadBlocks(const byte* inPtr, int width, __m256i& r, __m256i& g, __m256i& b)
+{
+    const __m256i planar = _mm256_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15, 0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+    __m256i row0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(inPtr + 0 * width * 4)), planar);
+    __m256i row1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(inPtr + 1 * width * 4)), planar);
+    __m256i row2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(inPtr + 2 * width * 4)), planar);
+    __m256i row3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(inPtr + 3 * width * 4)), planar);
+
+    __m256i rg01 = _mm256_unpacklo_epi32(row0, row1);
+    __m256i ba01 = _mm256_unpackhi_epi32(row0, row1);
+    __m256i rg23 = _mm256_unpacklo_epi32(row2, row3);
+    __m256i ba23 = _mm256_unpackhi_epi32(row2, row3);
+
+    r = _mm256_unpacklo_epi64(rg01, rg23);
+    g = _mm256_unpackhi_epi64(rg01, rg23);
+    b = _mm256_unpacklo_epi64(ba01, ba23);
+}
+
+// Broadcasts first to the lower and second to the upper lane
+inline __m256i SetLanes(__m128i first, __m128i second) { return _mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1); }
+
+// Minimum of each lane, in byte 0 and 16
+inline void HorizontalMin(__m256i v, byte& first, byte& second)
+{
+    v = _mm256_min_epu8(v, _mm256_srli_si256(v, 8));
+    v = _mm256_min_epu8(v, _mm256_srli_si256(v, 4));
+    v = _mm256_min_epu8(v, _mm256_srli_si256(v, 2));
+    v = _mm256_min_epu8(v, _mm256_srli_si256(v, 1));
+    first = byte(_mm_cvtsi128_si32(_mm256_castsi256_si128(v)));
+    second = byte(_mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1)));
+}
+
+inline void HorizontalMax(__m256i v, byte& first, byte& second)
+{
+    v = _mm256_max_epu8(v, _mm256_srli_si256(v, 8));
+    v = _mm256_max_epu8(v, _mm256_srli_si256(v, 4));
+    v = _mm256_max_epu8(v, _mm256_srli_si256(v, 2));
+    v = _mm256_max_epu8(v, _mm256_srli_si256(v, 1));
+    first = byte(_mm_cvtsi128_si32(_mm256_castsi256_si128(v)));
+    second = byte(_mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1)));
+}
+
+inline void ColorDistance(__m256i const channels[3][2], const word* first, const word* second, __m256i& lo, __m256i& hi)
+{
+    lo = _mm256_setzero_si256();
+    hi = _mm256_setzero_si256();
+
+    for(int c = 0; c < 3; c++)
+    {
+        __m256i value = SetLanes(_mm_set1_epi16(short(first[c])), _mm_set1_epi16(short(second[c])));
+        lo = _mm256_add_epi16(lo, _mm256_abs_epi16(_mm256_sub_epi16(channels[c][0], value)));
+        hi = _mm256_add_epi16(hi, _mm256_abs_epi16(_mm256_sub_epi16(channels[c][1], value)));
+    }
+}
+
+// Same as EmitColorIndicesFast, for both blocks
+inline void ColorIndices(__m256i r, __m256i g, __m256i b, const byte minColor[2][4], const byte maxColor[2][4], dword indices[2])
+{
+    word colors[2][4][3];
+    ComputeColorPalette(minColor[0], maxColor[0], colors[0]);
+    ComputeColorPalette(minColor[1], maxColor[1], colors[1]);
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i channels[3][2] = {{_mm256_unpacklo_epi8(r, zero), _mm256_unpackhi_epi8(r, zero)},
+                                    {_mm256_unpacklo_epi8(g, zero), _mm256_unpackhi_epi8(g, zero)},
+                                    {_mm256_unpacklo_epi8(b, zero), _mm256_unpackhi_epi8(b, zero)}};
+
+    __m256i d[4][2];
+    for(int j = 0; j < 4; j++)
+    {
+        ColorDistance(channels, colors[0][j], colors[1][j], d[j][0], d[j][1]);
+    }
+
+    __m256i bit0[2], bit1[2];
+    for(int h = 0; h < 2; h++)
+    {
+        __m256i b0 = _mm256_cmpgt_epi16(d[0][h], d[3][h]);
+        __m256i b1 = _mm256_cmpgt_epi16(d[1][h], d[2][h]);
+        __m256i b2 = _mm256_cmpgt_epi16(d[0][h], d[2][h]);
+        __m256i b3 = _mm256_cmpgt_epi16(d[1][h], d[3][h]);
+        __m256i b4 = _mm256_cmpgt_epi16(d[2][h], d[3][h]);
+
+        bit0[h] = _mm256_and_si256(b0, b4);
+        bit1[h] = _mm256_or_si256(_mm256_and_si256(b1, b2), _mm256_and_si256(b0, b3));
+    }
+
+    // the lanes are packed separately, so each holds the 16 masks of its block
+    dword mask0 = dword(_mm256_movemask_epi8(_mm256_packs_epi16(bit0[0], bit0[1])));
+    dword mask1 = dword(_mm256_movemask_epi8(_mm256_packs_epi16(bit1[0], bit1[1])));
+
+    indices[0] = SpreadBits(mask0 & 0xFFFF) | (SpreadBits(mask1 & 0xFFFF) << 1);
+    indices[1] = SpreadBits(mask0 >> 16) | (SpreadBits(mask1 >> 16) << 1);
+}
+
+// Same as EmitAlphaIndicesFast, for both blocks
+inline void AlphaIndices(__m256i a, const byte minAlpha[2], const byte maxAlpha[2], unsigned long long indices[2])
+{
+    byte thresholds[2][7];
+    ComputeAlphaThresholds(minAlpha[0], maxAlpha[0], thresholds[0]);
+    ComputeAlphaThresholds(minAlpha[1], maxAlpha[1], thresholds[1]);
+
+    __m256i count = _mm256_setzero_si256();
+    for(int k = 0; k < 7; k++)
+    {
+        __m256i threshold = SetLanes(_mm_set1_epi8(char(thresholds[0][k])), _mm_set1_epi8(char(thresholds[1][k])));
+        count = _mm256_sub_epi8(count, _mm256_cmpeq_epi8(_mm256_min_epu8(a, threshold), a));
+    }
+
+    const __m256i one = _mm256_set1_epi8(1);
+    __m256i index = _mm256_and_si256(_mm256_add_epi8(count, one), _mm256_set1_epi8(7));
+    __m256i less_than_two = _mm256_cmpeq_epi8(_mm256_min_epu8(index, one), index);
+    index = _mm256_xor_si256(index, _mm256_and_si256(less_than_two, one));
+
+    __m256i pairs = _mm256_maddubs_epi16(index, _mm256_set1_epi16(1 | (8 << 8)));
+    __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(1 | (64 << 16)));
+
+    ALIGN16(dword packed[8]);
+    _mm256_storeu_si256((__m256i*)packed, quads);
+
+    for(int block = 0; block < 2; block++)
+    {
+        const dword* q = packed + 4 * block;
+        indices[block] = (unsigned long long)(q[0]) | ((unsigned long long)(q[1]) << 12) | ((unsigned long long)(q[2]) << 24) | ((unsigned long long)(q[3]) << 36);
+    }
+}
+
+inline void ConvertToYCoCg(__m256i& r, __m256i& g, __m256i& b)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i co[2], cg[2];
+
+    for(int h = 0; h < 2; h++)
+    {
+        __m256i r16 = h == 0 ? _mm256_unpacklo_epi8(r, zero) : _mm256_unpackhi_epi8(r, zero);
+        __m256i g16 = h == 0 ? _mm256_unpacklo_epi8(g, zero) : _mm256_unpackhi_epi8(g, zero);
+        __m256i b16 = h == 0 ? _mm256_unpacklo_epi8(b, zero) : _mm256_unpackhi_epi8(b, zero);
+
+        __m256i co16 = _mm256_sub_epi16(r16, b16);
+        __m256i t = _mm256_add_epi16(b16, _mm256_srai_epi16(_mm256_sub_epi16(co16, _mm256_srai_epi16(co16, 15)), 1));
+
+        co[h] = _mm256_add_epi16(co16, _mm256_set1_epi16(128));
+        cg[h] = _mm256_add_epi16(_mm256_sub_epi16(g16, t), _mm256_set1_epi16(96));
+    }
+
+    r = _mm256_packus_epi16(co[0], co[1]);
+    g = _mm256_packus_epi16(cg[0], cg[1]);
+    b = zero;
+}
+
+inline __m256i ConvertToCoCgY(__m256i& r, __m256i& g, __m256i& b)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i low_byte = _mm256_set1_epi16(255);
+    __m256i co[2], cg[2], y[2];
+
+    for(int h = 0; h < 2; h++)
+    {
+        __m256i r16 = h == 0 ? _mm256_unpacklo_epi8(r, zero) : _mm256_unpackhi_epi8(r, zero);
+        __m256i g16 = h == 0 ? _mm256_unpacklo_epi8(g, zero) : _mm256_unpackhi_epi8(g, zero);
+        __m256i b16 = h == 0 ? _mm256_unpacklo_epi8(b, zero) : _mm256_unpackhi_epi8(b, zero);
+        __m256i sum = _mm256_add_epi16(r16, b16);
+
+        y[h] = _mm256_add_epi16(_mm256_srli_epi16(g16, 1), _mm256_srli_epi16(sum, 2));
+        cg[h] = _mm256_and_si256(_mm256_sub_epi16(g16, _mm256_srli_epi16(sum, 1)), low_byte);
+        co[h] = _mm256_and_si256(_mm256_sub_epi16(r16, b16), low_byte);
+    }
+
+    r = _mm256_packus_epi16(co[0], co[1]);
+    g = _mm256_packus_epi16(cg[0], cg[1]);
+    b = zero;
+    return _mm256_packus_epi16(y[0], y[1]);
+}
+
+inline void EncodeBlocksDXT1(__m256i r, __m256i g, __m256i b, byte* outData)
+{
+    byte minColor[2][4], maxColor[2][4];
+    HorizontalMin(r, minColor[0][0], minColor[1][0]);
+    HorizontalMin(g, minColor[0][1], minColor[1][1]);
+    HorizontalMin(b, minColor[0][2], minColor[1][2]);
+    HorizontalMax(r, maxColor[0][0], maxColor[1][0]);
+    HorizontalMax(g, maxColor[0][1], maxColor[1][1]);
+    HorizontalMax(b, maxColor[0][2], maxColor[1][2]);
+
+    for(int block = 0; block < 2; block++)
+    {
+        for(int c = 0; c < 3; c++)
+        {
+            InsetChannel(minColor[block][c], maxColor[block][c]);
+        }
+    }
+
+    dword indices[2];
+    ColorIndices(r, g, b, minColor, maxColor, indices);
+
+    StoreColorBlock(minColor[0], maxColor[0], indices[0], outData);
+    StoreColorBlock(minColor[1], maxColor[1], indices[1], outData + 8);
+}
+
+inline void EncodeBlocksDXT5(__m256i r, __m256i g, __m256i b, byte* outData)
+{
+    __m256i y = ConvertToCoCgY(r, g, b);
+
+    byte minColor[2][4] = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+    byte maxColor[2][4] = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+    HorizontalMin(r, minColor[0][0], minColor[1][0]);
+    HorizontalMin(g, minColor[0][1], minColor[1][1]);
+    HorizontalMin(y, minColor[0][3], minColor[1][3]);
+    HorizontalMax(r, maxColor[0][0], maxColor[1][0]);
+    HorizontalMax(g, maxColor[0][1], maxColor[1][1]);
+    HorizontalMax(y, maxColor[0][3], maxColor[1][3]);
+
+    byte minAlpha[2], maxAlpha[2];
+    for(int block = 0; block < 2; block++)
+    {
+        for(int c = 0; c < 4; c++)
+        {
+            InsetChannel(minColor[block][c], maxColor[block][c]);
+        }
+
+        minAlpha[block] = minColor[block][3];
+        maxAlpha[block] = maxColor[block][3];
+    }
+
+    unsigned long long alphaIndices[2];
+    AlphaIndices(y, minAlpha, maxAlpha, alphaIndices);
+
+    dword colorIndices[2];
+    ColorIndices(r, g, b, minColor, maxColor, colorIndices);
+
+    for(int block = 0; block < 2; block++)
+    {
+        StoreAlphaBlock(minAlpha[block], maxAlpha[block], alphaIndices[block], outData + 16 * block);
+        StoreColorBlock(minColor[block], maxColor[block], colorIndices[block], outData + 16 * block + 8);
+    }
+}
+
+} // namespace
+
+void CompressBlockRowDXT1_AVX2(const byte* inPtr, int width, int numBlocks, byte* outData)
+{
+    int i = 0;
+    for(; i + 1 < numBlocks; i += 2, inPtr += 2 * 4 * 4, outData += 2 * 8)
+    {
+        __m256i r, g, b;
+        LoadBlocks(inPtr, width, r, g, b);
+        EncodeBlocksDXT1(r, g, b, outData);
+    }
+
+    if(i < numBlocks)
+    {
+        CompressBlockRowDXT1_SSE41(inPtr, width, 1, outData);
+    }
+}
+
+void CompressBlockRowDXT5_AVX2(const byte* inPtr, int width, int numBlocks, byte* outData)
+{
+    int i = 0;
+    for(; i + 1 < numBlocks; i += 2, inPtr += 2 * 4 * 4, outData += 2 * 16)
+    {
+        __m256i r, g, b;
+        LoadBlocks(inPtr, width, r, g, b);
+        EncodeBlocksDXT5(r, g, b, outData);
+    }
+
+    if(i < numBlocks)
+    {
+        CompressBlockRowDXT5_SSE41(inPtr, width, 1, outData);
+    }
+}
+
+void CompressBlockRowDXT5YCoCg_AVX2(const byte* inPtr, int width, int numBlocks, byte* outData)
+{
+    int i = 0;
+    for(; i + 1 < numBlocks; i += 2, inPtr += 2 * 4 * 4, outData += 2 * 16)
+    {
+        __m256i r, g, b;
+        LoadBlocks(inPtr, width, r, g, b);
+        ConvertToYCoCg(r, g, b);
+        EncodeBlocksDXT5(r, g, b, outData);
+    }
+
+    if(i < numBlocks)
+    {
+        CompressBlockRowDXT5YCoCg_SSE41(inPtr, width, 1, outData);
+    }
+}
+
+#endif // DXT_HAVE_X86_SIMD
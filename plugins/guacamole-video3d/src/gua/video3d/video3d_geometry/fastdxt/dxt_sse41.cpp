@@ -0,0 +1,247 @@
+// SSE4.1 block encoders, based on:
+//    Real-Time DXT Compression
+//    May 20th 2006 J.M.P. van Waveren
+//    (c) 2006, Id Software, Inc.
+//
+// The 16 pixels of a block are transposed to one register per channel. All
+// pixels are processed at once, only the per block end points are computed
+// on scalars.
+
+#include <gua/video3d/video3d_geometry/fastdxt/dxt_simd.h>
+
+#if defined(DXT_HAVE_X86_SIMD)
+
+#include <smmintrin.h>
+
+namespace
+{
+// Gathers the pixels of a 4x4 block into one register per channel
+inline void LoadBlock(const byte* inPtr, int width, __m128i& r, __m128i& g, __m128i& b)
+{
+    const __m128i planar = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+    __m128i row0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(inPtr + 0 * width * 4)), planar);
+    __m128i row1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(inPtr + 1 * width * 4)), planar);
+    __m128i row2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(inPtr + 2 * width * 4)), planar);
+    __m128i row3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(inPtr + 3 * width * 4)), planar);
+
+    __m128i rg01 = _mm_unpacklo_epi32(row0, row1);
+    __m128i ba01 = _mm_unpackhi_epi32(row0, row1);
+    __m128i rg23 = _mm_unpacklo_epi32(row2, row3);
+    __m128i ba23 = _mm_unpackhi_epi32(row2, row3);
+
+    r = _mm_unpacklo_epi64(rg01, rg23);
+    g = _mm_unpackhi_epi64(rg01, rg23);
+    b = _mm_unpacklo_epi64(ba01, ba23);
+}
+
+inline byte HorizontalMin(__m128i v)
+{
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 1));
+    return byte(_mm_cvtsi128_si32(v));
+}
+
+inline byte HorizontalMax(__m128i v)
+{
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+    return byte(_mm_cvtsi128_si32(v));
+}
+
+// Sum of absolute differences of the first and second half of the pixels to
+// one palette color
+inline void ColorDistance(__m128i const channels[3][2], const word* color, __m128i& lo, __m128i& hi)
+{
+    lo = _mm_setzero_si128();
+    hi = _mm_setzero_si128();
+
+    for(int c = 0; c < 3; c++)
+    {
+        __m128i value = _mm_set1_epi16(short(color[c]));
+        lo = _mm_add_epi16(lo, _mm_abs_epi16(_mm_sub_epi16(channels[c][0], value)));
+        hi = _mm_add_epi16(hi, _mm_abs_epi16(_mm_sub_epi16(channels[c][1], value)));
+    }
+}
+
+// Same as EmitColorIndicesFast
+inline dword ColorIndices(__m128i r, __m128i g, __m128i b, const byte* minColor, const byte* maxColor)
+{
+    word colors[4][3];
+    ComputeColorPalette(minColor, maxColor, colors);
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i channels[3][2] = {{_mm_unpacklo_epi8(r, zero), _mm_unpackhi_epi8(r, zero)},
+                                    {_mm_unpacklo_epi8(g, zero), _mm_unpackhi_epi8(g, zero)},
+                                    {_mm_unpacklo_epi8(b, zero), _mm_unpackhi_epi8(b, zero)}};
+
+    __m128i d[4][2];
+    for(int j = 0; j < 4; j++)
+    {
+        ColorDistance(channels, colors[j], d[j][0], d[j][1]);
+    }
+
+    __m128i bit0[2], bit1[2];
+    for(int h = 0; h < 2; h++)
+    {
+        __m128i b0 = _mm_cmpgt_epi16(d[0][h], d[3][h]);
+        __m128i b1 = _mm_cmpgt_epi16(d[1][h], d[2][h]);
+        __m128i b2 = _mm_cmpgt_epi16(d[0][h], d[2][h]);
+        __m128i b3 = _mm_cmpgt_epi16(d[1][h], d[3][h]);
+        __m128i b4 = _mm_cmpgt_epi16(d[2][h], d[3][h]);
+
+        bit0[h] = _mm_and_si128(b0, b4);
+        bit1[h] = _mm_or_si128(_mm_and_si128(b1, b2), _mm_and_si128(b0, b3));
+    }
+
+    dword mask0 = dword(_mm_movemask_epi8(_mm_packs_epi16(bit0[0], bit0[1])));
+    dword mask1 = dword(_mm_movemask_epi8(_mm_packs_epi16(bit1[0], bit1[1])));
+
+    return SpreadBits(mask0) | (SpreadBits(mask1) << 1);
+}
+
+// Same as EmitAlphaIndicesFast
+inline unsigned long long AlphaIndices(__m128i a, const byte minAlpha, const byte maxAlpha)
+{
+    byte thresholds[7];
+    ComputeAlphaThresholds(minAlpha, maxAlpha, thresholds);
+
+    // counts the thresholds a is less or equal to
+    __m128i count = _mm_setzero_si128();
+    for(int k = 0; k < 7; k++)
+    {
+        __m128i le = _mm_cmpeq_epi8(_mm_min_epu8(a, _mm_set1_epi8(char(thresholds[k]))), a);
+        count = _mm_sub_epi8(count, le);
+    }
+
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i index = _mm_and_si128(_mm_add_epi8(count, one), _mm_set1_epi8(7));
+    __m128i less_than_two = _mm_cmpeq_epi8(_mm_min_epu8(index, one), index);
+    index = _mm_xor_si128(index, _mm_and_si128(less_than_two, one));
+
+    // 3 bits per index: pairs to 6 bits, quadruples to 12 bits
+    __m128i pairs = _mm_maddubs_epi16(index, _mm_set1_epi16(1 | (8 << 8)));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(1 | (64 << 16)));
+
+    return (unsigned long long)(dword(_mm_extract_epi32(quads, 0))) | ((unsigned long long)(dword(_mm_extract_epi32(quads, 1))) << 12) |
+           ((unsigned long long)(dword(_mm_extract_epi32(quads, 2))) << 24) | ((unsigned long long)(dword(_mm_extract_epi32(quads, 3))) << 36);
+}
+
+// Same as the conversion in RGBAtoYCoCg: r becomes Co, g becomes Cg, b zero
+inline void ConvertToYCoCg(__m128i& r, __m128i& g, __m128i& b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i co[2], cg[2];
+
+    for(int h = 0; h < 2; h++)
+    {
+        __m128i r16 = h == 0 ? _mm_unpacklo_epi8(r, zero) : _mm_unpackhi_epi8(r, zero);
+        __m128i g16 = h == 0 ? _mm_unpacklo_epi8(g, zero) : _mm_unpackhi_epi8(g, zero);
+        __m128i b16 = h == 0 ? _mm_unpacklo_epi8(b, zero) : _mm_unpackhi_epi8(b, zero);
+
+        __m128i co16 = _mm_sub_epi16(r16, b16);
+        // division by two rounding towards zero
+        __m128i t = _mm_add_epi16(b16, _mm_srai_epi16(_mm_sub_epi16(co16, _mm_srai_epi16(co16, 15)), 1));
+
+        co[h] = _mm_add_epi16(co16, _mm_set1_epi16(128));
+        cg[h] = _mm_add_epi16(_mm_sub_epi16(g16, t), _mm_set1_epi16(96));
+    }
+
+    r = _mm_packus_epi16(co[0], co[1]);
+    g = _mm_packus_epi16(cg[0], cg[1]);
+    b = zero;
+}
+
+// Same as the conversion in GetMinMaxColorsAlpha: r becomes co, g cg, b zero
+// and the returned alpha y
+inline __m128i ConvertToCoCgY(__m128i& r, __m128i& g, __m128i& b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low_byte = _mm_set1_epi16(255);
+    __m128i co[2], cg[2], y[2];
+
+    for(int h = 0; h < 2; h++)
+    {
+        __m128i r16 = h == 0 ? _mm_unpacklo_epi8(r, zero) : _mm_unpackhi_epi8(r, zero);
+        __m128i g16 = h == 0 ? _mm_unpacklo_epi8(g, zero) : _mm_unpackhi_epi8(g, zero);
+        __m128i b16 = h == 0 ? _mm_unpacklo_epi8(b, zero) : _mm_unpackhi_epi8(b, zero);
+        __m128i sum = _mm_add_epi16(r16, b16);
+
+        y[h] = _mm_add_epi16(_mm_srli_epi16(g16, 1), _mm_srli_epi16(sum, 2));
+        cg[h] = _mm_and_si128(_mm_sub_epi16(g16, _mm_srli_epi16(sum, 1)), low_byte);
+        co[h] = _mm_and_si128(_mm_sub_epi16(r16, b16), low_byte);
+    }
+
+    r = _mm_packus_epi16(co[0], co[1]);
+    g = _mm_packus_epi16(cg[0], cg[1]);
+    b = zero;
+    return _mm_packus_epi16(y[0], y[1]);
+}
+
+inline void EncodeBlockDXT1(__m128i r, __m128i g, __m128i b, byte* outData)
+{
+    byte minColor[3] = {HorizontalMin(r), HorizontalMin(g), HorizontalMin(b)};
+    byte maxColor[3] = {HorizontalMax(r), HorizontalMax(g), HorizontalMax(b)};
+
+    for(int c = 0; c < 3; c++)
+    {
+        InsetChannel(minColor[c], maxColor[c]);
+    }
+
+    StoreColorBlock(minColor, maxColor, ColorIndices(r, g, b, minColor, maxColor), outData);
+}
+
+inline void EncodeBlockDXT5(__m128i r, __m128i g, __m128i b, byte* outData)
+{
+    __m128i y = ConvertToCoCgY(r, g, b);
+
+    byte minColor[4] = {HorizontalMin(r), HorizontalMin(g), 0, HorizontalMin(y)};
+    byte maxColor[4] = {HorizontalMax(r), HorizontalMax(g), 0, HorizontalMax(y)};
+
+    for(int c = 0; c < 4; c++)
+    {
+        InsetChannel(minColor[c], maxColor[c]);
+    }
+
+    StoreAlphaBlock(minColor[3], maxColor[3], AlphaIndices(y, minColor[3], maxColor[3]), outData);
+    StoreColorBlock(minColor, maxColor, ColorIndices(r, g, b, minColor, maxColor), outData + 8);
+}
+
+} // namespace
+
+void CompressBlockRowDXT1_SSE41(const byte* inPtr, int width, int numBlocks, byte* outData)
+{
+    for(int i = 0; i < numBlocks; i++, inPtr += 4 * 4, outData += 8)
+    {
+        __m128i r, g, b;
+        LoadBlock(inPtr, width, r, g, b);
+        EncodeBlockDXT1(r, g, b, outData);
+    }
+}
+
+void CompressBlockRowDXT5_SSE41(const byte* inPtr, int width, int numBlocks, byte* outData)
+{
+    for(int i = 0; i < numBlocks; i++, inPtr += 4 * 4, outData += 16)
+    {
+        __m128i r, g, b;
+        LoadBlock(inPtr, width, r, g, b);
+        EncodeBlockDXT5(r, g, b, outData);
+    }
+}
+
+void CompressBlockRowDXT5YCoCg_SSE41(const byte* inPtr, int width, int numBlocks, byte* outData)
+{
+    for(int i = 0; i < numBlocks; i++, inPtr += 4 * 4, outData += 16)
+    {
+        __m128i r, g, b;
+        LoadBlock(inPtr, width, r, g, b);
+        ConvertToYCoCg(r, g, b);
+        EncodeBlockDXT5(r, g, b, outData);
+    }
+}
+
+#endif // DXT_HAVE_X86_SIMD
@@ -101,6 +101,7 @@ class GUA_VOLUME_DLL VolumeNode : public SerializableNode
     void update_bounding_box() const override;
 
   private:
+    bool has_untracked_properties() const override { return true; }
     std::shared_ptr<Node> copy() const override;
 };
 
@@ -24,7 +24,9 @@ void main() {
   gua_view_position  = (gua_model_view_matrix * vec4(gua_in_position, 1.0)).xyz;
   gua_normal         = (gua_normal_matrix * vec4(gua_in_normal, 0.0)).xyz;
   gua_tangent        = (gua_normal_matrix * vec4(gua_in_tangent, 0.0)).xyz;
-  gua_bitangent      = (gua_normal_matrix * vec4(gua_in_bitangent, 0.0)).xyz;
+  // meshes may be loaded without bitangents, see TriMeshLoader::NO_BITANGENTS
+  vec3 bitangent     = dot(gua_in_bitangent, gua_in_bitangent) > 0.0 ? gua_in_bitangent : cross(gua_in_normal, gua_in_tangent);
+  gua_bitangent      = (gua_normal_matrix * vec4(bitangent, 0.0)).xyz;
   gua_texcoords      = gua_in_texcoords;
   gua_metalness      = 0.01;
   gua_roughness      = 0.1;
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+// class header
+#include <gua/concurrent/ThreadPool.hpp>
+
+// external headers
+#include <algorithm>
+#include <atomic>
+
+namespace gua
+{
+namespace concurrent
+{
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::ThreadPool(unsigned thread_count)
+{
+    if(thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for(unsigned i(0); i < thread_count; ++i)
+    {
+        workers_.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+
+    condition_.notify_all();
+
+    for(auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool* ThreadPool::instance()
+{
+    static ThreadPool pool;
+    return &pool;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::parallel_for(std::size_t begin, std::size_t end, std::function<void(std::size_t, std::size_t)> const& func, std::size_t grain_size)
+{
+    if(begin >= end)
+    {
+        return;
+    }
+
+    std::size_t count(end - begin);
+    std::size_t chunk_size(std::max(std::max<std::size_t>(1, grain_size), count / (4 * (workers_.size() + 1))));
+    std::size_t chunk_count((count + chunk_size - 1) / chunk_size);
+
+    if(chunk_count == 1)
+    {
+        func(begin, end);
+        return;
+    }
+
+    // shared with helper tasks which may start after this call returned
+    struct State
+    {
+        std::atomic<std::size_t> next_chunk;
+        std::atomic<std::size_t> finished_chunks;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    auto state(std::make_shared<State>());
+    state->next_chunk = 0;
+    state->finished_chunks = 0;
+
+    auto process = [=]() {
+        std::size_t chunk;
+        while((chunk = state->next_chunk++) < chunk_count)
+        {
+            std::size_t chunk_begin(begin + chunk * chunk_size);
+            func(chunk_begin, std::min(end, chunk_begin + chunk_size));
+
+            if(++state->finished_chunks == chunk_count)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    std::size_t helper_count(std::min<std::size_t>(workers_.size(), chunk_count - 1));
+    for(std::size_t i(0); i < helper_count; ++i)
+    {
+        enqueue(process);
+    }
+
+    process();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->finished_chunks == chunk_count; });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::enqueue(std::function<void()> const& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(task);
+    }
+
+    condition_.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::work()
+{
+    while(true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return shutdown_ || !tasks_.empty(); });
+
+            if(shutdown_ && tasks_.empty())
+            {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+
+        task();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace concurrent
+} // namespace gua
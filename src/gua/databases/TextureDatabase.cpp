@@ -26,10 +26,10 @@
 
 // guacamole headers
 #include <gua/utils/Directory.hpp>
+#include <gua/utils/Logger.hpp>
 
 // external headers
 #include <sstream>
-#include <future>
 #include <iostream>
 #include <cstdint>
 #include <boost/filesystem.hpp>
@@ -44,6 +44,22 @@
 
 namespace gua
 {
+namespace
+{
+std::size_t image_size(scm::gl::texture_image_data_ptr const& image)
+{
+    std::size_t bits(0);
+
+    for(unsigned i(0); i < image->mip_level_count(); ++i)
+    {
+        auto const& size(image->mip_level(i).size());
+        bits += std::size_t(size.x) * size.y * scm::gl::bit_per_pixel(image->format());
+    }
+
+    return bits / 8;
+}
+} // namespace
+
 TextureDatabase::TextureDatabase()
 {
     texture_path_to_global_id_mapping_["gua_loading_texture"] = 0;
@@ -52,37 +68,32 @@ TextureDatabase::TextureDatabase()
     num_loaded_textured_ = 3;
 }
 
-void TextureDatabase::load(std::string const& filename)
+TextureDatabase::~TextureDatabase()
 {
-    boost::filesystem::path fp(filename);
-    std::string extension(fp.extension().string());
-    boost::algorithm::to_lower(extension);
-
-    if(extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" || extension == ".dds" || extension == ".tif" || extension == ".tga")
     {
-        {
-            std::lock_guard<std::mutex> lock(texture_request_mutex_);
-            auto needs_to_be_loaded_it = texture_loading_.find(filename);
+        std::lock_guard<std::mutex> lock(texture_request_mutex_);
+        shutdown_ = true;
+    }
 
-            if(texture_loading_.end() != needs_to_be_loaded_it)
-                return;
+    texture_request_condition_.notify_all();
 
-            texture_loading_.insert(filename);
-        }
+    for(auto& thread : streaming_threads_)
+    {
+        thread.join();
+    }
+}
 
-        // else
-        textures_loading_.push_back(std::async(std::launch::async, [filename]() -> std::string {
-            auto default_tex = TextureDatabase::instance()->lookup("gua_default_texture");
-            if(default_tex)
-            {
-                gua::TextureDatabase::instance()->add(filename, default_tex);
-            }
+void TextureDatabase::load(std::string const& filename) { load(filename, 0.f); }
 
-            auto image = gua::load_image_2d(filename, true);
+void TextureDatabase::load(std::string const& filename, float priority)
+{
+    boost::filesystem::path fp(filename);
+    std::string extension(fp.extension().string());
+    boost::algorithm::to_lower(extension);
 
-            instance()->add(filename, std::make_shared<Texture2D>(image, 1, scm::gl::sampler_state_desc(scm::gl::FILTER_ANISOTROPIC, scm::gl::WRAP_REPEAT, scm::gl::WRAP_REPEAT)));
-            return filename;
-        }));
+    if(extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" || extension == ".dds" || extension == ".tif" || extension == ".tga")
+    {
+        enqueue(filename, priority);
     }
     else if(extension == ".vol")
     {
@@ -128,6 +139,299 @@ void TextureDatabase::load(std::string const& filename)
     }
 }
 
+void TextureDatabase::enqueue(std::string const& filename, float priority)
+{
+    std::lock_guard<std::mutex> lock(texture_request_mutex_);
+
+    if(texture_loading_.count(filename))
+    {
+        auto request(texture_requests_.find(filename));
+        if(request != texture_requests_.end() && request->second.priority < priority)
+        {
+            texture_queue_.erase(request->second);
+            request->second.priority = priority;
+            texture_queue_.emplace(request->second, filename);
+        }
+        return;
+    }
+
+    texture_loading_.insert(filename);
+
+    auto default_tex = lookup("gua_default_texture");
+    if(default_tex)
+    {
+        add(filename, default_tex);
+    }
+
+    ++stats_.requested;
+
+    // a cancelled request which is still being decoded is simply resumed
+    auto decoding(textures_decoding_.find(filename));
+    if(decoding != textures_decoding_.end())
+    {
+        decoding->second = false;
+        --stats_.cancelled;
+        return;
+    }
+
+    Request request;
+    request.priority = priority;
+    request.sequence = next_request_++;
+    request.start = std::chrono::steady_clock::now();
+
+    texture_requests_[filename] = request;
+    texture_queue_.emplace(request, filename);
+    ++stats_.queued;
+
+    if(streaming_threads_.empty())
+    {
+        for(unsigned i(0); i < streaming_thread_count_; ++i)
+        {
+            streaming_threads_.emplace_back(&TextureDatabase::stream, this);
+        }
+    }
+
+    texture_request_condition_.notify_one();
+}
+
+bool TextureDatabase::fits_memory_budget(Request const& request) const
+{
+    std::size_t used(stats_.resident_bytes + stats_.reserved_bytes);
+
+    // a single texture is streamed even if it exceeds the budget
+    if(used == 0)
+    {
+        return true;
+    }
+
+    if(!request.estimated)
+    {
+        return used < memory_budget_;
+    }
+
+    return used <= memory_budget_ && request.estimated_bytes <= memory_budget_ - used;
+}
+
+void TextureDatabase::stream()
+{
+    while(true)
+    {
+        std::string filename;
+        Request request;
+
+        {
+            std::unique_lock<std::mutex> lock(texture_request_mutex_);
+            texture_request_condition_.wait(lock, [this]() { return shutdown_ || (!texture_queue_.empty() && fits_memory_budget(texture_queue_.begin()->first)); });
+
+            if(shutdown_)
+            {
+                return;
+            }
+
+            auto next(texture_queue_.begin());
+            request = next->first;
+            filename = next->second;
+
+            texture_queue_.erase(next);
+            texture_requests_.erase(filename);
+            textures_decoding_[filename] = false;
+
+            --stats_.queued;
+            ++stats_.loading;
+
+            if(request.estimated)
+            {
+                stats_.reserved_bytes += request.estimated_bytes;
+            }
+        }
+
+        // the size is reserved before decoding, so that the streaming threads
+        // together cannot exceed the budget
+        if(!request.estimated)
+        {
+            request.estimated = true;
+            request.estimated_bytes = estimate_image_2d_size(filename, true);
+
+            std::lock_guard<std::mutex> lock(texture_request_mutex_);
+
+            auto decoding(textures_decoding_.find(filename));
+            bool cancelled(decoding->second);
+
+            if(cancelled || !fits_memory_budget(request))
+            {
+                textures_decoding_.erase(decoding);
+                --stats_.loading;
+
+                // queued again until enough memory is freed
+                if(!cancelled)
+                {
+                    texture_requests_[filename] = request;
+                    texture_queue_.emplace(request, filename);
+                    ++stats_.queued;
+                }
+                continue;
+            }
+
+            stats_.reserved_bytes += request.estimated_bytes;
+        }
+
+        auto image(load_image_2d(filename, true));
+        std::shared_ptr<Texture2D> texture;
+        std::size_t bytes(0);
+
+        if(image)
+        {
+            texture = std::make_shared<Texture2D>(image, 1, scm::gl::sampler_state_desc(scm::gl::FILTER_ANISOTROPIC, scm::gl::WRAP_REPEAT, scm::gl::WRAP_REPEAT));
+            bytes = image_size(image);
+        }
+
+        std::lock_guard<std::mutex> lock(texture_request_mutex_);
+
+        // the reservation is released in any case, it may have been larger
+        // than the image
+        stats_.reserved_bytes -= request.estimated_bytes;
+        texture_request_condition_.notify_all();
+
+        --stats_.loading;
+
+        auto decoding(textures_decoding_.find(filename));
+        bool cancelled(decoding->second);
+        textures_decoding_.erase(decoding);
+
+        if(cancelled)
+        {
+            continue;
+        }
+
+        if(!texture)
+        {
+            // the placeholder stays in place
+            ++stats_.failed;
+            Logger::LOG_WARNING << "TextureDatabase: Failed to load texture \"" << filename << "\"." << std::endl;
+            continue;
+        }
+
+        add(filename, texture);
+        texture_sizes_[filename] = bytes;
+        stats_.resident_bytes += bytes;
+
+        double latency(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - request.start).count());
+        total_latency_ += latency;
+        ++stats_.loaded;
+        stats_.average_latency = total_latency_ / stats_.loaded;
+        stats_.max_latency = std::max(stats_.max_latency, latency);
+    }
+}
+
+bool TextureDatabase::request_visible(std::string const& filename, float screen_size)
+{
+    std::lock_guard<std::mutex> lock(texture_request_mutex_);
+
+    auto request(texture_requests_.find(filename));
+    if(request == texture_requests_.end())
+    {
+        return false;
+    }
+
+    if(request->second.screen_size < screen_size)
+    {
+        texture_queue_.erase(request->second);
+        request->second.screen_size = screen_size;
+        texture_queue_.emplace(request->second, filename);
+    }
+
+    return true;
+}
+
+bool TextureDatabase::is_loading(std::string const& filename) const
+{
+    std::lock_guard<std::mutex> lock(texture_request_mutex_);
+
+    if(texture_requests_.count(filename))
+    {
+        return true;
+    }
+
+    auto decoding(textures_decoding_.find(filename));
+    return decoding != textures_decoding_.end() && !decoding->second;
+}
+
+bool TextureDatabase::cancel(std::string const& filename)
+{
+    std::lock_guard<std::mutex> lock(texture_request_mutex_);
+
+    auto request(texture_requests_.find(filename));
+    auto decoding(textures_decoding_.find(filename));
+
+    if(request != texture_requests_.end())
+    {
+        texture_queue_.erase(request->second);
+        texture_requests_.erase(request);
+        --stats_.queued;
+    }
+    else if(decoding != textures_decoding_.end() && !decoding->second)
+    {
+        // the decoded image is discarded by the streaming thread
+        decoding->second = true;
+    }
+    else
+    {
+        return false;
+    }
+
+    ++stats_.cancelled;
+    texture_loading_.erase(filename);
+    remove(filename);
+
+    return true;
+}
+
+void TextureDatabase::unload(std::string const& filename)
+{
+    if(cancel(filename))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(texture_request_mutex_);
+
+        auto size(texture_sizes_.find(filename));
+        if(size != texture_sizes_.end())
+        {
+            stats_.resident_bytes -= size->second;
+            texture_sizes_.erase(size);
+        }
+
+        texture_loading_.erase(filename);
+    }
+
+    remove(filename);
+    texture_request_condition_.notify_all();
+}
+
+void TextureDatabase::set_streaming_threads(unsigned count)
+{
+    std::lock_guard<std::mutex> lock(texture_request_mutex_);
+    streaming_thread_count_ = std::max(1u, count);
+}
+
+void TextureDatabase::set_memory_budget(std::size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(texture_request_mutex_);
+        memory_budget_ = bytes;
+    }
+
+    texture_request_condition_.notify_all();
+}
+
+TextureDatabase::StreamingStats TextureDatabase::get_streaming_stats() const
+{
+    std::lock_guard<std::mutex> lock(texture_request_mutex_);
+    return stats_;
+}
+
 int32_t TextureDatabase::get_global_texture_id_by_path(std::string const& tex_path) const
 {
     auto texture_it = texture_path_to_global_id_mapping_.find(tex_path);
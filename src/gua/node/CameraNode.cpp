@@ -45,11 +45,11 @@ CameraNode::CameraNode(std::string const& name, std::shared_ptr<PipelineDescript
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Frustum CameraNode::get_rendering_frustum(SceneGraph const& graph, CameraMode mode) const { return make_frustum(graph, get_world_transform(), config, mode, false); }
+Frustum CameraNode::get_rendering_frustum(SceneGraph const& graph, CameraMode mode) const { return make_frustum(graph, get_current_world_transform(), config, mode, false); }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Frustum CameraNode::get_culling_frustum(SceneGraph const& graph, CameraMode mode) const { return make_frustum(graph, get_world_transform(), config, mode, true); }
+Frustum CameraNode::get_culling_frustum(SceneGraph const& graph, CameraMode mode) const { return make_frustum(graph, get_current_world_transform(), config, mode, true); }
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -61,7 +61,8 @@ std::map<size_t, CameraNode*> SerializedCameraNode::camera_nodes = std::map<size
 
 SerializedCameraNode CameraNode::serialize() const
 {
-    SerializedCameraNode s = {config, get_world_transform(), uuid()};
+    // the transforms have been cached by SceneGraph::update_cache() already
+    SerializedCameraNode s = {config, get_current_world_transform(), uuid()};
 
     for(auto const& cam : pre_render_cameras_)
     {
@@ -70,7 +71,7 @@ SerializedCameraNode CameraNode::serialize() const
 
     s.pipeline_description = pipeline_description_;
 
-	s.parents_transform = get_parent()->get_world_transform();
+	s.parents_transform = get_parent()->get_current_world_transform();
     s.camera_node_name = get_name();
   
 	if (SerializedCameraNode::camera_nodes[s.uuid] == nullptr) {
@@ -91,8 +92,7 @@ Frustum CameraNode::make_frustum(SceneGraph const& graph, math::mat4 const& came
         screen_name = mode != CameraMode::RIGHT ? config.left_screen_path() : config.right_screen_path();
     }
 
-    auto screen_it(graph[screen_name]);
-    auto screen(std::dynamic_pointer_cast<node::ScreenNode>(screen_it));
+    auto screen(graph.get_screen_node(screen_name));
     if(!screen)
     {
         Logger::LOG_WARNING << "Cannot make Frustum: No valid screen specified" << std::endl;
@@ -182,6 +182,7 @@ void CameraNode::set_pre_render_cameras(std::vector<std::shared_ptr<CameraNode>>
         }
     }
     pre_render_cameras_ = cams;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
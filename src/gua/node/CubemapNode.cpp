@@ -94,17 +94,27 @@ math::vec3 CubemapNode::get_min_distance_position()
 
 float CubemapNode::get_distance_by_local_direction(math::vec3 const& dir) const
 {
-    math::mat4 screen_transform(scm::math::make_translation(0., 0., -0.5));
-    std::vector<math::mat4> screen_transforms({screen_transform,
-                                               scm::math::make_rotation(180., 0., 1., 0.) * screen_transform,
-                                               scm::math::make_rotation(90., 1., 0., 0.) * screen_transform,
-                                               scm::math::make_rotation(-90., 1., 0., 0.) * screen_transform,
-                                               scm::math::make_rotation(90., 0., 1., 0.) * screen_transform,
-                                               scm::math::make_rotation(-90., 0., 1., 0.) * screen_transform});
+    if(m_FaceFrustumsNear != config.near_clip() || m_FaceFrustumsFar != config.far_clip())
+    {
+        math::mat4 screen_transform(scm::math::make_translation(0., 0., -0.5));
+        std::vector<math::mat4> screen_transforms({screen_transform,
+                                                   scm::math::make_rotation(180., 0., 1., 0.) * screen_transform,
+                                                   scm::math::make_rotation(90., 1., 0., 0.) * screen_transform,
+                                                   scm::math::make_rotation(-90., 1., 0., 0.) * screen_transform,
+                                                   scm::math::make_rotation(90., 0., 1., 0.) * screen_transform,
+                                                   scm::math::make_rotation(-90., 0., 1., 0.) * screen_transform});
+
+        for(int i = 0; i < 6; ++i)
+        {
+            m_FaceFrustums[i] = Frustum::perspective(math::mat4::identity(), screen_transforms[i], config.near_clip(), config.far_clip());
+        }
+        m_FaceFrustumsNear = config.near_clip();
+        m_FaceFrustumsFar = config.far_clip();
+    }
 
     for(int i = 0; i < 6; ++i)
     {
-        auto frustum(Frustum::perspective(math::mat4::identity(), screen_transforms[i], config.near_clip(), config.far_clip()));
+        auto const& frustum(m_FaceFrustums[i]);
         if(frustum.contains(dir))
         {
             math::vec4 view_point(frustum.get_view() * math::vec4(dir.x, dir.y, dir.z, 1.0));
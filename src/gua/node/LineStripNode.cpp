@@ -50,6 +50,7 @@ void LineStripNode::set_geometry_description(std::string const& v)
 {
     geometry_description_ = v;
     geometry_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -60,6 +61,7 @@ void LineStripNode::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
     // material_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -194,6 +196,19 @@ void LineStripNode::ray_test_impl(Ray const& ray, int options, Mask const& mask,
 ////////////////////////////////////////////////////////////////////////////////
 
 void LineStripNode::update_cache()
+{
+    update_geometry();
+
+    GeometryNode::update_cache();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LineStripNode::prepare_flat_update() { update_geometry(); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LineStripNode::update_geometry()
 {
     // The code below auto-loads a geometry if it's not already supported by
     // the GeometryDatabase. Name is generated by GeometryDescription
@@ -234,8 +249,6 @@ void LineStripNode::update_cache()
 
         geometry_changed_ = false;
     }
-
-    GeometryNode::update_cache();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -349,6 +362,7 @@ void LineStripNode::forward_queued_vertices()
     {
         geometry_->forward_queued_vertices(queued_positions_, queued_colors_, queued_thicknesses_, queued_normals_);
         update_bounding_box();
+        invalidate_snapshot();
     }
 }
 
@@ -370,5 +384,40 @@ void LineStripNode::uncompile_buffer_string(std::string const& buffer_string)
     }
 };
 
+////////////////////////////////////////////////////////////////////////////////
+std::size_t LineStripNode::max_sync_size() const
+{
+    if(nullptr != geometry_)
+    {
+        return geometry_->max_sync_size();
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+std::size_t LineStripNode::write_sync(char* buffer, std::size_t capacity, bool delta, float precision)
+{
+    if(nullptr != geometry_)
+    {
+        return geometry_->write_sync(buffer, capacity, delta, precision);
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+bool LineStripNode::read_sync(char const* buffer, std::size_t size)
+{
+    if(nullptr != geometry_)
+    {
+        if(geometry_->read_sync(buffer, size))
+        {
+            update_bounding_box();
+            invalidate_snapshot();
+            return true;
+        }
+    }
+    return false;
+}
+
 } // namespace node
 } // namespace gua
@@ -30,11 +30,20 @@
 #include <gua/utils/string_utils.hpp>
 #include <gua/node/RayNode.hpp>
 #include <gua/scenegraph/NodeVisitor.hpp>
+#include <gua/scenegraph/SceneGraph.hpp>
+
+// external headers
+#include <atomic>
 
 namespace gua
 {
 namespace node
 {
+namespace
+{
+std::atomic<std::size_t> structure_version(0);
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 
 Node::Node(std::string const& name, math::mat4 const& transform) : children_(), name_(name), transform_(transform), bounding_box_(), user_data_() {}
@@ -101,6 +110,7 @@ void Node::clear_children()
         }
 
         set_dirty();
+        notify_structure_change();
 
         children_.clear();
     }
@@ -117,6 +127,7 @@ void Node::remove_child(std::shared_ptr<Node> const& child)
             children_.erase(c);
             child->parent_ = nullptr;
             set_dirty();
+            notify_structure_change();
             child->set_scenegraph(nullptr);
 
             break;
@@ -182,6 +193,10 @@ math::mat4 const& Node::get_cached_world_transform() const { return world_transf
 
 ////////////////////////////////////////////////////////////////////////////////
 
+math::mat4 Node::get_current_world_transform() const { return self_dirty_ ? get_world_transform() : world_transform_; }
+
+////////////////////////////////////////////////////////////////////////////////
+
 math::mat4 Node::get_latest_cached_world_transform(const WindowBase* w) const {
   math::mat4 world_transform = world_transform_;
   world_transform_ = get_latest_world_transform(w);
@@ -318,7 +333,11 @@ void Node::update_bounding_box() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Node::set_draw_bounding_box(bool draw) { draw_bounding_box_ = draw; }
+void Node::set_draw_bounding_box(bool draw)
+{
+    draw_bounding_box_ = draw;
+    invalidate_snapshot();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -381,6 +400,8 @@ std::shared_ptr<Node> Node::deep_copy() const
     copied_node->user_data_ = user_data_;
     copied_node->world_transform_ = world_transform_;
     copied_node->uuid_ = uuid_;
+    copied_node->snapshot_ = nullptr;
+    copied_node->snapshot_anchor_ = nullptr;
 
     for(int i(0); i < children_.size(); ++i)
     {
@@ -393,6 +414,70 @@ std::shared_ptr<Node> Node::deep_copy() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<Node> Node::snapshot() const { return snapshot_subtree(nullptr, false); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<Node> Node::snapshot_subtree(Node* parent_anchor, bool parent_changed) const
+{
+    if(!parent_changed && !snapshot_dirty_ && snapshot_)
+    {
+        return snapshot_;
+    }
+
+    std::shared_ptr<Node> copied_node = copy();
+    copied_node->tags_ = tags_;
+    copied_node->draw_bounding_box_ = draw_bounding_box_;
+    copied_node->scenegraph_ = nullptr;
+    copied_node->bounding_box_ = bounding_box_;
+    copied_node->user_data_ = user_data_;
+    copied_node->world_transform_ = world_transform_;
+    copied_node->uuid_ = uuid_;
+    copied_node->parent_ = parent_anchor;
+    copied_node->snapshot_ = nullptr;
+    copied_node->snapshot_anchor_ = nullptr;
+
+    // if neither this node nor its ancestors changed, the copy only differs
+    // from the anchor in its children and the children keep pointing to the
+    // anchor. Otherwise, the copy becomes the new anchor and all descendants
+    // have to be copied, since their parent changed.
+    const bool changed(parent_changed || snapshot_self_dirty_ || !snapshot_anchor_);
+    if(changed)
+    {
+        snapshot_anchor_ = copied_node;
+    }
+    else
+    {
+        copied_node->snapshot_anchor_ = snapshot_anchor_;
+    }
+
+    for(int i(0); i < children_.size(); ++i)
+    {
+        copied_node->children_[i] = children_[i]->snapshot_subtree(snapshot_anchor_.get(), changed);
+    }
+
+    snapshot_ = copied_node;
+    snapshot_dirty_ = false;
+    snapshot_self_dirty_ = false;
+
+    return copied_node;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Node::invalidate_snapshot() const
+{
+    snapshot_dirty_ = true;
+    snapshot_self_dirty_ = true;
+
+    for(auto parent(parent_); parent && !parent->snapshot_dirty_; parent = parent->parent_)
+    {
+        parent->snapshot_dirty_ = true;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void* Node::get_user_data(unsigned handle) const
 {
     if(user_data_.size() > handle)
@@ -406,6 +491,7 @@ void* Node::get_user_data(unsigned handle) const
 unsigned Node::add_user_data(void* data)
 {
     user_data_.push_back(data);
+    invalidate_snapshot();
     return unsigned(user_data_.size() - 1);
 }
 
@@ -421,9 +507,10 @@ void Node::set_dirty() const
 
 void Node::set_parent_dirty() const
 {
-    if(!is_root() && !parent_->child_dirty_)
+    if(!is_root() && (!parent_->child_dirty_ || !parent_->snapshot_dirty_))
     {
         parent_->child_dirty_ = true;
+        parent_->snapshot_dirty_ = true;
         parent_->set_parent_dirty();
     }
 }
@@ -434,6 +521,8 @@ void Node::set_children_dirty() const
 {
     self_dirty_ = true;
     child_dirty_ = true;
+    snapshot_dirty_ = true;
+    snapshot_self_dirty_ = true;
     for(auto const& child : children_)
     {
         child->set_children_dirty();
@@ -442,8 +531,28 @@ void Node::set_children_dirty() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::size_t Node::get_structure_version() { return structure_version; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Node::notify_structure_change() { ++structure_version; }
+
+////////////////////////////////////////////////////////////////////////////////
+
 void Node::set_scenegraph(SceneGraph* scenegraph)
 {
+    if(scenegraph_ != scenegraph && has_untracked_properties())
+    {
+        if(scenegraph_)
+        {
+            scenegraph_->untracked_nodes_.erase(this);
+        }
+        if(scenegraph)
+        {
+            scenegraph->untracked_nodes_.insert(this);
+        }
+    }
+
     scenegraph_ = scenegraph;
 
     for(auto const& child : children_)
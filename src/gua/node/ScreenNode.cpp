@@ -43,7 +43,7 @@ math::mat4 ScreenNode::get_scaled_transform() const
 math::mat4 ScreenNode::get_scaled_world_transform() const
 {
     math::mat4 scale(scm::math::make_scale(data.get_size().x, data.get_size().y, gua::math::float_t(1.0)));
-    return get_world_transform() * scale;
+    return get_current_world_transform() * scale;
 }
 
 std::shared_ptr<Node> ScreenNode::copy() const { return std::make_shared<ScreenNode>(*this); }
@@ -94,56 +94,63 @@ void TexturedQuadNode::ray_test_impl(Ray const& ray, int options, Mask const& ma
     // bbox is intersected, but check geometry only if mask tells us to check
     if(mask.check(get_tags()))
     {
-        math::mat4 world_transform(get_world_transform());
-        math::mat4 ori_transform(scm::math::inverse(world_transform));
+        ray_test_geometry(ray, options, hits);
+    }
 
-        math::vec4 ori(ray.origin_[0], ray.origin_[1], ray.origin_[2], 1.0);
-        math::vec4 dir(ray.direction_[0], ray.direction_[1], ray.direction_[2], 0.0);
+    for(auto child : get_children())
+    {
+        // test for intersection with each child
+        child->ray_test_impl(ray, options, mask, hits);
+    }
+}
 
-        ori = ori_transform * ori;
-        dir = ori_transform * dir;
+////////////////////////////////////////////////////////////////////////////////
 
-        Ray object_ray(ori, dir, ray.t_max_);
-        auto result(intersect(object_ray, math::BoundingBox<math::vec3>(math::vec3(-0.5, -0.5, 0), math::vec3(0.5, 0.5, 0))));
+void TexturedQuadNode::ray_test_geometry(Ray const& ray, int options, std::set<PickResult>& hits)
+{
+    math::mat4 world_transform(get_world_transform());
+    math::mat4 ori_transform(scm::math::inverse(world_transform));
 
-        float const inf(std::numeric_limits<float>::max());
+    math::vec4 ori(ray.origin_[0], ray.origin_[1], ray.origin_[2], 1.0);
+    math::vec4 dir(ray.direction_[0], ray.direction_[1], ray.direction_[2], 0.0);
 
-        if(result.first != Ray::END)
-        {
-            hits.insert(PickResult(result.first, this, ori + result.first * dir, math::vec3(inf, inf, inf), math::vec3(0.f, 0.f, 1.f), math::vec3(inf, inf, inf), ori + result.first * dir + 0.5f));
-        }
+    ori = ori_transform * ori;
+    dir = ori_transform * dir;
+
+    Ray object_ray(ori, dir, ray.t_max_);
+    auto result(intersect(object_ray, math::BoundingBox<math::vec3>(math::vec3(-0.5, -0.5, 0), math::vec3(0.5, 0.5, 0))));
+
+    float const inf(std::numeric_limits<float>::max());
 
-        if(options & PickResult::GET_WORLD_POSITIONS)
+    if(result.first != Ray::END)
+    {
+        hits.insert(PickResult(result.first, this, ori + result.first * dir, math::vec3(inf, inf, inf), math::vec3(0.f, 0.f, 1.f), math::vec3(inf, inf, inf), ori + result.first * dir + 0.5f));
+    }
+
+    if(options & PickResult::GET_WORLD_POSITIONS)
+    {
+        for(auto& hit : hits)
         {
-            for(auto& hit : hits)
+            if(hit.world_position == math::vec3(inf, inf, inf))
             {
-                if(hit.world_position == math::vec3(inf, inf, inf))
-                {
-                    auto transformed(world_transform * math::vec4(hit.position.x, hit.position.y, hit.position.z, 0.0));
-                    hit.world_position = scm::math::vec3(transformed.x, transformed.y, transformed.z);
-                }
+                auto transformed(world_transform * math::vec4(hit.position.x, hit.position.y, hit.position.z, 0.0));
+                hit.world_position = scm::math::vec3(transformed.x, transformed.y, transformed.z);
             }
         }
+    }
 
-        if(options & PickResult::GET_WORLD_NORMALS)
+    if(options & PickResult::GET_WORLD_NORMALS)
+    {
+        math::mat4 normal_matrix(scm::math::inverse(scm::math::transpose(world_transform)));
+        for(auto& hit : hits)
         {
-            math::mat4 normal_matrix(scm::math::inverse(scm::math::transpose(world_transform)));
-            for(auto& hit : hits)
+            if(hit.world_normal == math::vec3(inf, inf, inf))
             {
-                if(hit.world_normal == math::vec3(inf, inf, inf))
-                {
-                    auto transformed(normal_matrix * math::vec4(hit.normal.x, hit.normal.y, hit.normal.z, 0.0));
-                    hit.world_normal = scm::math::normalize(scm::math::vec3(transformed.x, transformed.y, transformed.z));
-                }
+                auto transformed(normal_matrix * math::vec4(hit.normal.x, hit.normal.y, hit.normal.z, 0.0));
+                hit.world_normal = scm::math::normalize(scm::math::vec3(transformed.x, transformed.y, transformed.z));
             }
         }
     }
-
-    for(auto child : get_children())
-    {
-        // test for intersection with each child
-        child->ray_test_impl(ray, options, mask, hits);
-    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +49,7 @@ void TriMeshNode::set_geometry_description(std::string const& v)
 {
     geometry_description_ = v;
     geometry_changed_ = self_dirty_ = true;
+    invalidate_snapshot();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -58,6 +59,7 @@ std::shared_ptr<Material> const& TriMeshNode::get_material() const { return mate
 void TriMeshNode::set_material(std::shared_ptr<Material> const& material)
 {
     material_ = material;
+    invalidate_snapshot();
     // material_changed_ = self_dirty_ = true;
 }
 
@@ -82,97 +84,122 @@ void TriMeshNode::ray_test_impl(Ray const& ray, int options, Mask const& mask, s
     }
 
     // bbox is intersected, but check geometry only if mask tells us to check
-    if(get_geometry_description() != "" && mask.check(get_tags()))
+    if(mask.check(get_tags()))
     {
-        auto geometry(GeometryDatabase::instance()->lookup(get_geometry_description()));
+        ray_test_geometry(ray, options, hits);
+    }
 
-        if(geometry)
-        {
-            bool check_kd_tree(true);
+    for(auto child : get_children())
+    {
+        // test for intersection with each child
+        child->ray_test_impl(ray, options, mask, hits);
+    }
+}
 
-            math::mat4 world_transform(get_world_transform());
+////////////////////////////////////////////////////////////////////////////////
 
-            // check for bounding box intersection of contained geometry if node
-            // has children (in this case, the bbox might be larger
-            // than the actual geometry)
-            if(has_children())
-            {
-                auto geometry_bbox(geometry->get_bounding_box());
+void TriMeshNode::ray_test_geometry(Ray const& ray, int options, std::set<PickResult>& hits)
+{
+    if(get_geometry_description() == "")
+    {
+        return;
+    }
+
+    auto geometry(GeometryDatabase::instance()->lookup(get_geometry_description()));
+
+    if(geometry)
+    {
+        bool check_kd_tree(true);
+
+        math::mat4 world_transform(get_world_transform());
+
+        // check for bounding box intersection of contained geometry if node
+        // has children (in this case, the bbox might be larger
+        // than the actual geometry)
+        if(has_children())
+        {
+            auto geometry_bbox(geometry->get_bounding_box());
 
 #if 0
-          auto inner_bbox = gua::math::transform(geometry_bbox, world_transform);
+      auto inner_bbox = gua::math::transform(geometry_bbox, world_transform);
 #else
-                math::BoundingBox<math::vec3> inner_bbox;
-                inner_bbox.expandBy(world_transform * geometry_bbox.min);
-                inner_bbox.expandBy(world_transform * geometry_bbox.max);
-                inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.min.x, geometry_bbox.min.y, geometry_bbox.max.z));
-                inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.min.x, geometry_bbox.max.y, geometry_bbox.min.z));
-                inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.min.x, geometry_bbox.max.y, geometry_bbox.max.z));
-                inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.max.x, geometry_bbox.min.y, geometry_bbox.max.z));
-                inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.max.x, geometry_bbox.max.y, geometry_bbox.min.z));
-                inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.max.x, geometry_bbox.min.y, geometry_bbox.min.z));
+            math::BoundingBox<math::vec3> inner_bbox;
+            inner_bbox.expandBy(world_transform * geometry_bbox.min);
+            inner_bbox.expandBy(world_transform * geometry_bbox.max);
+            inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.min.x, geometry_bbox.min.y, geometry_bbox.max.z));
+            inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.min.x, geometry_bbox.max.y, geometry_bbox.min.z));
+            inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.min.x, geometry_bbox.max.y, geometry_bbox.max.z));
+            inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.max.x, geometry_bbox.min.y, geometry_bbox.max.z));
+            inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.max.x, geometry_bbox.max.y, geometry_bbox.min.z));
+            inner_bbox.expandBy(world_transform * math::vec3(geometry_bbox.max.x, geometry_bbox.min.y, geometry_bbox.min.z));
 #endif
 
-                auto inner_hits(::gua::intersect(ray, inner_bbox));
-                if(inner_hits.first == RayNode::END && inner_hits.second == RayNode::END)
-                    check_kd_tree = false;
-            }
+            auto inner_hits(::gua::intersect(ray, inner_bbox));
+            if(inner_hits.first == RayNode::END && inner_hits.second == RayNode::END)
+                check_kd_tree = false;
+        }
 
-            if(check_kd_tree)
-            {
-                Ray world_ray(ray);
+        if(check_kd_tree)
+        {
+            Ray world_ray(ray);
 
-                math::mat4 ori_transform(scm::math::inverse(world_transform));
+            math::mat4 ori_transform(scm::math::inverse(world_transform));
 
-                math::vec4 ori(world_ray.origin_[0], world_ray.origin_[1], world_ray.origin_[2], 1.0);
-                math::vec4 dir(world_ray.direction_[0], world_ray.direction_[1], world_ray.direction_[2], 0.0);
+            math::vec4 ori(world_ray.origin_[0], world_ray.origin_[1], world_ray.origin_[2], 1.0);
+            math::vec4 dir(world_ray.direction_[0], world_ray.direction_[1], world_ray.direction_[2], 0.0);
 
-                ori = ori_transform * ori;
-                dir = ori_transform * dir;
+            ori = ori_transform * ori;
+            dir = ori_transform * dir;
 
-                Ray object_ray(ori, dir, world_ray.t_max_);
-                geometry->ray_test(object_ray, options, this, hits);
+            Ray object_ray(ori, dir, world_ray.t_max_);
+            geometry->ray_test(object_ray, options, this, hits);
 
-                float const inf(std::numeric_limits<float>::max());
+            float const inf(std::numeric_limits<float>::max());
 
-                if(options & PickResult::GET_WORLD_POSITIONS)
+            if(options & PickResult::GET_WORLD_POSITIONS)
+            {
+                for(auto& hit : hits)
                 {
-                    for(auto& hit : hits)
+                    if(hit.world_position == math::vec3(inf, inf, inf))
                     {
-                        if(hit.world_position == math::vec3(inf, inf, inf))
-                        {
-                            auto transformed(world_transform * math::vec4(hit.position.x, hit.position.y, hit.position.z, 1.0));
-                            hit.world_position = scm::math::vec3(transformed.x, transformed.y, transformed.z);
-                        }
+                        auto transformed(world_transform * math::vec4(hit.position.x, hit.position.y, hit.position.z, 1.0));
+                        hit.world_position = scm::math::vec3(transformed.x, transformed.y, transformed.z);
                     }
                 }
+            }
 
-                if(options & PickResult::GET_WORLD_NORMALS)
+            if(options & PickResult::GET_WORLD_NORMALS)
+            {
+                math::mat4 normal_matrix(scm::math::inverse(scm::math::transpose(world_transform)));
+                for(auto& hit : hits)
                 {
-                    math::mat4 normal_matrix(scm::math::inverse(scm::math::transpose(world_transform)));
-                    for(auto& hit : hits)
+                    if(hit.world_normal == math::vec3(inf, inf, inf))
                     {
-                        if(hit.world_normal == math::vec3(inf, inf, inf))
-                        {
-                            auto transformed(normal_matrix * math::vec4(hit.normal.x, hit.normal.y, hit.normal.z, 0.0));
-                            hit.world_normal = scm::math::normalize(scm::math::vec3(transformed.x, transformed.y, transformed.z));
-                        }
+                        auto transformed(normal_matrix * math::vec4(hit.normal.x, hit.normal.y, hit.normal.z, 0.0));
+                        hit.world_normal = scm::math::normalize(scm::math::vec3(transformed.x, transformed.y, transformed.z));
                     }
                 }
             }
         }
     }
-
-    for(auto child : get_children())
-    {
-        // test for intersection with each child
-        child->ray_test_impl(ray, options, mask, hits);
-    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void TriMeshNode::update_cache()
+{
+    update_geometry();
+
+    GeometryNode::update_cache();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TriMeshNode::prepare_flat_update() { update_geometry(); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TriMeshNode::update_geometry()
 {
     // The code below auto-loads a geometry if it's not already supported by
     // the GeometryDatabase. Name is generated by GeometryDescription
@@ -223,8 +250,6 @@ void TriMeshNode::update_cache()
 
     // material_changed_ = false;
     // }
-
-    GeometryNode::update_cache();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -31,11 +31,20 @@
 #include <gua/physics/Constraint.hpp>
 #include <gua/physics/PhysicsUtils.hpp>
 #include <gua/renderer/DisplayData.hpp>
+#include <gua/concurrent/ThreadPool.hpp>
+#include <gua/utils/Logger.hpp>
 
 // external headers
 #include <iostream>
 #include <stack>
 
+#if BT_BULLET_VERSION >= 288
+#include <LinearMath/btThreads.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#endif
+
 using std::lock_guard;
 using std::mutex;
 using std::thread;
@@ -46,28 +55,87 @@ namespace gua
 {
 namespace physics
 {
-Physics::Physics()
-    : simulation_mutex_(), start_stop_mutex_(), motion_state_update_mutex_(), pause_mutex_(), thread_(nullptr), is_stopped_(true), fixed_timestep_(physics_default_fixed_timestep),
-      reduce_sim_rate_(physics_default_reduce_sim_rate), max_sim_time_(chrono::microseconds(physics_default_max_sim_time)), shape_visitor_(), call_once_queue_(), call_once_queue_mutex_(),
-      broadphase_(new btDbvtBroadphase()), collision_configuration_(new btDefaultCollisionConfiguration()), dispatcher_(new btCollisionDispatcher(collision_configuration_)),
-      solver_(new btSequentialImpulseConstraintSolver()), dw_(new btDiscreteDynamicsWorld(dispatcher_, broadphase_, solver_, collision_configuration_)), rigid_bodies_(), constraints_(),
-      physics_fps_(0.0f)
+#if BT_BULLET_VERSION >= 288
+namespace
 {
-    if(dw_)
-        dw_->setGravity(btVector3(0, physics_default_gravity, 0));
-}
+// runs Bullet's parallel loops on guacamole's thread pool instead of
+// spawning a second set of worker threads
+class ThreadPoolTaskScheduler : public btITaskScheduler
+{
+  public:
+    ThreadPoolTaskScheduler() : btITaskScheduler("gua::concurrent::ThreadPool") {}
+
+    int getMaxNumThreads() const override { return BT_MAX_THREAD_COUNT; }
+
+    // Bullet indexes its per-thread storage with a process wide counter of
+    // all threads that ever entered a parallel section, not with pool slots
+    int getNumThreads() const override { return BT_MAX_THREAD_COUNT; }
+
+    void setNumThreads(int) override {}
+
+    void parallelFor(int begin, int end, int grain_size, const btIParallelForBody& body) override
+    {
+        concurrent::ThreadPool::instance()->parallel_for(
+            begin, end, [&body](std::size_t b, std::size_t e) { body.forLoop(int(b), int(e)); }, std::max(grain_size, 1));
+    }
+
+    btScalar parallelSum(int begin, int end, int grain_size, const btIParallelSumBody& body) override
+    {
+        std::mutex sum_mutex;
+        btScalar sum(0);
+
+        concurrent::ThreadPool::instance()->parallel_for(
+            begin,
+            end,
+            [&](std::size_t b, std::size_t e) {
+                const btScalar partial_sum(body.sumLoop(int(b), int(e)));
+                lock_guard<mutex> lk(sum_mutex);
+                sum += partial_sum;
+            },
+            std::max(grain_size, 1));
+
+        return sum;
+    }
+};
+} // namespace
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+Physics::Physics() : Physics(physics_default_gravity, physics_default_fixed_timestep) {}
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Physics::Physics(float gravity, float fixed_timestep)
-    : simulation_mutex_(), start_stop_mutex_(), motion_state_update_mutex_(), pause_mutex_(), thread_(nullptr), is_stopped_(true), fixed_timestep_(fixed_timestep),
-      reduce_sim_rate_(physics_default_reduce_sim_rate), max_sim_time_(chrono::microseconds(physics_default_max_sim_time)), shape_visitor_(), call_once_queue_(), call_once_queue_mutex_(),
-      broadphase_(new btDbvtBroadphase()), collision_configuration_(new btDefaultCollisionConfiguration()), dispatcher_(new btCollisionDispatcher(collision_configuration_)),
-      solver_(new btSequentialImpulseConstraintSolver()), dw_(new btDiscreteDynamicsWorld(dispatcher_, broadphase_, solver_, collision_configuration_)), rigid_bodies_(), constraints_(),
-      physics_fps_(0.0f)
+Physics::Physics(float gravity, float fixed_timestep, bool parallel_islands)
+    : simulation_mutex_(), start_stop_mutex_(), pause_mutex_(), thread_(nullptr), is_stopped_(true), fixed_timestep_(fixed_timestep), reduce_sim_rate_(physics_default_reduce_sim_rate),
+      max_sim_time_(chrono::microseconds(physics_default_max_sim_time)), shape_visitor_(), call_once_queue_(), broadphase_(new btDbvtBroadphase()),
+      collision_configuration_(new btDefaultCollisionConfiguration()), rigid_bodies_(), constraints_(), physics_fps_(0.0f)
 {
-    if(dw_)
-        dw_->setGravity(btVector3(0, gravity, 0));
+    if(parallel_islands)
+    {
+#if BT_BULLET_VERSION >= 288
+        static ThreadPoolTaskScheduler scheduler;
+        if(btGetTaskScheduler() != &scheduler)
+            btSetTaskScheduler(&scheduler);
+
+        // each island is solved by one of the pooled solvers
+        dispatcher_ = new btCollisionDispatcherMt(collision_configuration_);
+        solver_pool_ = new btConstraintSolverPoolMt(BT_MAX_THREAD_COUNT);
+        solver_ = new btSequentialImpulseConstraintSolverMt();
+        dw_ = new btDiscreteDynamicsWorldMt(dispatcher_, broadphase_, solver_pool_, solver_, collision_configuration_);
+#else
+        Logger::LOG_WARNING << "Parallel simulation islands require Bullet 2.88 or newer. Falling back to serial simulation." << std::endl;
+#endif
+    }
+
+    if(!dw_)
+    {
+        dispatcher_ = new btCollisionDispatcher(collision_configuration_);
+        solver_ = new btSequentialImpulseConstraintSolver();
+        dw_ = new btDiscreteDynamicsWorld(dispatcher_, broadphase_, solver_, collision_configuration_);
+    }
+
+    dw_->setGravity(btVector3(0, gravity, 0));
 
     // Collision calback example
     /*
@@ -116,6 +184,9 @@ Physics::~Physics()
         remove_rigid_body(rigid_bodies_[0]);
     delete dw_;
     delete solver_;
+#if BT_BULLET_VERSION >= 288
+    delete solver_pool_;
+#endif
     delete collision_configuration_;
     delete dispatcher_;
     delete broadphase_;
@@ -187,14 +258,10 @@ void Physics::simulation_rate_reduction(bool enabled, int max_sim_time)
 
 void Physics::synchronize(bool auto_start)
 {
-    // swap motion state transforms^
+    // pick up the latest published motion state transforms
+    for(auto const& rb : rigid_bodies_)
     {
-        lock_guard<SpinLock> lk(motion_state_update_mutex_);
-
-        for(auto rb : rigid_bodies_)
-        {
-            rb->motion_state_->flip_reader();
-        }
+        rb->motion_state_->flip_reader();
     }
 
     // traverse rigid body subgraphs in order to apply collision shapes
@@ -286,8 +353,7 @@ float Physics::get_physics_fps() const
 
 void Physics::call_once(std::function<void()> fun)
 {
-    lock_guard<mutex> lk(call_once_queue_mutex_);
-    call_once_queue_.push(fun);
+    call_once_queue_.push(std::move(fun));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -303,7 +369,7 @@ void Physics::simulate()
 
         // Process call-once queue
         std::function<void()> fun;
-        while(pop_call_once(fun))
+        while(call_once_queue_.pop(fun))
             fun();
 
         {
@@ -315,13 +381,10 @@ void Physics::simulate()
             const btScalar current_timestep = chrono::duration_cast<chrono::microseconds>(current_time - last_time).count() * 1.e-6f;
 
             dw_->stepSimulation(current_timestep, physics_default_max_sub_steps, fixed_timestep_);
-            // Swap motion state transforms
+            // Publish motion state transforms
+            for(auto const& rb : rigid_bodies_)
             {
-                lock_guard<SpinLock> lk(motion_state_update_mutex_);
-                for(auto rb : rigid_bodies_)
-                {
-                    rb->motion_state_->flip_writer();
-                }
+                rb->motion_state_->flip_writer();
             }
         }
         if(reduce_sim_rate_)
@@ -349,17 +412,5 @@ void Physics::simulate()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool Physics::pop_call_once(std::function<void()>& value)
-{
-    lock_guard<mutex> lk(call_once_queue_mutex_);
-    if(call_once_queue_.empty())
-        return false;
-    value = call_once_queue_.front();
-    call_once_queue_.pop();
-    return true;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
 } // namespace physics
 } // namespace gua
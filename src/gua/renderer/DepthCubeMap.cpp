@@ -92,6 +92,7 @@ void DepthCubeMap::remove_buffers(RenderContext const& ctx)
 
     if(texture_distance_)
     {
+        texture_distance_->remove_readback_buffers(ctx);
         texture_distance_->make_non_resident(ctx);
     }
 }
@@ -102,4 +103,8 @@ void DepthCubeMap::retrieve_data(RenderContext const& ctx, float near_clip, floa
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool DepthCubeMap::fetch_data(RenderContext const& ctx) { return texture_distance_->fetch_data(ctx); }
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // namespace gua
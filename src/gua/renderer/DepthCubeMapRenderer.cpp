@@ -69,6 +69,10 @@ void DepthCubeMapRenderer::render(Pipeline& pipe, PipelinePassDescription const&
             if(cube_map_node->config.get_active() && needs_rendering)
             {
                 needs_rendering_.second.push_back(cube_map_node->uuid());
+
+                // downloads of previous frames which the GPU has finished meanwhile
+                fetch_depth_cubemap(*cube_map_node, pipe);
+
                 if(cube_map_node->config.get_render_mode() == node::CubemapNode::RenderMode::COMPLETE)
                 {
                     prepare_depth_cubemap(*cube_map_node, pipe);
@@ -218,6 +222,20 @@ void DepthCubeMapRenderer::download_depth_cubemap(node::CubemapNode& cube_map_no
     {
         current_depth_cube_map = depth_cube_map_it->second;
         current_depth_cube_map->retrieve_data(pipe.get_context(), cube_map_node.config.near_clip(), cube_map_node.config.far_clip());
+    }
+}
+
+void DepthCubeMapRenderer::fetch_depth_cubemap(node::CubemapNode& cube_map_node, Pipeline const& pipe) const
+{
+    if(!depth_cube_map_res_)
+    {
+        return;
+    }
+
+    auto depth_cube_map_it = depth_cube_map_res_->cube_maps_.find(cube_map_node.config.get_texture_name());
+
+    if(depth_cube_map_it != depth_cube_map_res_->cube_maps_.end() && depth_cube_map_it->second->fetch_data(pipe.get_context()))
+    {
         *(cube_map_node.m_NewTextureData) = true;
     }
 }
@@ -23,12 +23,168 @@
 #include <gua/renderer/Frustum.hpp>
 #include <gua/node/RayNode.hpp>
 
+#include <algorithm>
 #include <iostream>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GUA_FRUSTUM_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+using BoundingBox = gua::math::BoundingBox<gua::math::vec3>;
+
+// number of bounding boxes which are tested at once
+const std::size_t PACK_SIZE = 4;
+const int PACK_MASK = (1 << PACK_SIZE) - 1;
+
+#if defined(__AVX__)
+
+struct BoxPack
+{
+    __m256d min[3];
+    __m256d max[3];
+};
+
+BoxPack load_pack(BoundingBox const* const* boxes)
+{
+    BoxPack pack;
+
+    for(int c(0); c < 3; ++c)
+    {
+        pack.min[c] = _mm256_set_pd(boxes[3]->min[c], boxes[2]->min[c], boxes[1]->min[c], boxes[0]->min[c]);
+        pack.max[c] = _mm256_set_pd(boxes[3]->max[c], boxes[2]->max[c], boxes[1]->max[c], boxes[0]->max[c]);
+    }
+
+    return pack;
+}
+
+// returns one bit for each box whose positive vertex is outside of a plane
+int test_planes(BoxPack const& pack, gua::math::vec4 const* planes, std::size_t plane_count, int outside)
+{
+    __m256d result(_mm256_setzero_pd());
+    __m256d zero(_mm256_setzero_pd());
+
+    for(std::size_t i(0); i < plane_count && outside != PACK_MASK; ++i)
+    {
+        auto const& plane(planes[i]);
+
+        // the positive vertex is the same for all boxes of a pack
+        __m256d x(_mm256_mul_pd(_mm256_set1_pd(plane[0]), plane[0] >= 0 ? pack.max[0] : pack.min[0]));
+        __m256d y(_mm256_mul_pd(_mm256_set1_pd(plane[1]), plane[1] >= 0 ? pack.max[1] : pack.min[1]));
+        __m256d z(_mm256_mul_pd(_mm256_set1_pd(plane[2]), plane[2] >= 0 ? pack.max[2] : pack.min[2]));
+        __m256d distance(_mm256_add_pd(_mm256_add_pd(_mm256_add_pd(x, y), z), _mm256_set1_pd(plane[3])));
+
+        result = _mm256_or_pd(result, _mm256_cmp_pd(distance, zero, _CMP_LT_OQ));
+        outside |= _mm256_movemask_pd(result);
+    }
+
+    return outside;
+}
+
+#elif defined(GUA_FRUSTUM_SSE2)
+
+// two boxes per register, two registers per component
+struct BoxPack
+{
+    __m128d min[3][2];
+    __m128d max[3][2];
+};
+
+BoxPack load_pack(BoundingBox const* const* boxes)
+{
+    BoxPack pack;
+
+    for(int c(0); c < 3; ++c)
+    {
+        pack.min[c][0] = _mm_set_pd(boxes[1]->min[c], boxes[0]->min[c]);
+        pack.min[c][1] = _mm_set_pd(boxes[3]->min[c], boxes[2]->min[c]);
+        pack.max[c][0] = _mm_set_pd(boxes[1]->max[c], boxes[0]->max[c]);
+        pack.max[c][1] = _mm_set_pd(boxes[3]->max[c], boxes[2]->max[c]);
+    }
+
+    return pack;
+}
+
+// returns one bit for each box whose positive vertex is outside of a plane
+int test_planes(BoxPack const& pack, gua::math::vec4 const* planes, std::size_t plane_count, int outside)
+{
+    __m128d result[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d zero(_mm_setzero_pd());
+
+    for(std::size_t i(0); i < plane_count && outside != PACK_MASK; ++i)
+    {
+        auto const& plane(planes[i]);
+
+        __m128d a(_mm_set1_pd(plane[0]));
+        __m128d b(_mm_set1_pd(plane[1]));
+        __m128d c(_mm_set1_pd(plane[2]));
+        __m128d d(_mm_set1_pd(plane[3]));
+
+        for(int h(0); h < 2; ++h)
+        {
+            // the positive vertex is the same for all boxes of a pack
+            __m128d x(_mm_mul_pd(a, plane[0] >= 0 ? pack.max[0][h] : pack.min[0][h]));
+            __m128d y(_mm_mul_pd(b, plane[1] >= 0 ? pack.max[1][h] : pack.min[1][h]));
+            __m128d z(_mm_mul_pd(c, plane[2] >= 0 ? pack.max[2][h] : pack.min[2][h]));
+            __m128d distance(_mm_add_pd(_mm_add_pd(_mm_add_pd(x, y), z), d));
+
+            result[h] = _mm_or_pd(result[h], _mm_cmplt_pd(distance, zero));
+        }
+
+        outside |= _mm_movemask_pd(result[0]) | (_mm_movemask_pd(result[1]) << 2);
+    }
+
+    return outside;
+}
+
+#else
+
+struct BoxPack
+{
+    BoundingBox const* boxes[PACK_SIZE];
+};
+
+BoxPack load_pack(BoundingBox const* const* boxes)
+{
+    BoxPack pack;
+    std::copy(boxes, boxes + PACK_SIZE, pack.boxes);
+    return pack;
+}
+
+// returns one bit for each box whose positive vertex is outside of a plane
+int test_planes(BoxPack const& pack, gua::math::vec4 const* planes, std::size_t plane_count, int outside)
+{
+    for(std::size_t i(0); i < plane_count && outside != PACK_MASK; ++i)
+    {
+        auto const& plane(planes[i]);
+
+        for(std::size_t b(0); b < PACK_SIZE; ++b)
+        {
+            auto const& box(*pack.boxes[b]);
+            gua::math::vec3 p(plane[0] >= 0 ? box.max[0] : box.min[0], plane[1] >= 0 ? box.max[1] : box.min[1], plane[2] >= 0 ? box.max[2] : box.min[2]);
+
+            if(plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2] + plane[3] < 0)
+            {
+                outside |= 1 << b;
+            }
+        }
+    }
+
+    return outside;
+}
+
+#endif
+
+} // namespace
+
 namespace gua
 {
 Frustum::Frustum()
-    : camera_transform_(math::mat4::identity()), screen_transform_(math::mat4::identity()), projection_(math::mat4::identity()), view_(math::mat4::identity()), planes_(6), clip_near_(0), clip_far_(0)
+    : camera_transform_(math::mat4::identity()), screen_transform_(math::mat4::identity()), projection_(math::mat4::identity()), view_(math::mat4::identity()), planes_(), clip_near_(0), clip_far_(0)
 {
 }
 
@@ -137,6 +293,33 @@ bool Frustum::intersects(math::BoundingBox<math::vec3> const& bbox, std::vector<
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Frustum::intersects(math::BoundingBox<math::vec3> const* boxes, std::size_t count, std::vector<math::vec4> const& global_planes, std::uint8_t* results) const
+{
+    for(std::size_t first(0); first < count; first += PACK_SIZE)
+    {
+        std::size_t pack_count(std::min(PACK_SIZE, count - first));
+
+        // incomplete packs are padded with the last box
+        BoundingBox const* pack_boxes[PACK_SIZE];
+        for(std::size_t i(0); i < PACK_SIZE; ++i)
+        {
+            pack_boxes[i] = &boxes[first + std::min(i, pack_count - 1)];
+        }
+
+        auto pack(load_pack(pack_boxes));
+
+        int outside(test_planes(pack, planes_.data(), planes_.size(), 0));
+        outside = test_planes(pack, global_planes.data(), global_planes.size(), outside);
+
+        for(std::size_t i(0); i < pack_count; ++i)
+        {
+            results[first + i] = (outside & (1 << i)) ? 0 : 1;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool Frustum::contains(math::vec3 const& point) const
 {
     auto outside = [](math::vec4 const& plane, math::vec3 const& point) { return plane[0] * point[0] + plane[1] * point[1] + plane[2] * point[2] + plane[3] < 0; };
@@ -0,0 +1,403 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+// class header
+#include <gua/renderer/LightClusterer.hpp>
+
+#include <gua/concurrent/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GUA_LIGHT_CLUSTERER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+// minimum number of tile rows filled by one task
+const std::size_t ROWS_PER_TASK = 4;
+
+// squared distance of a coordinate to the interval [min, max]
+inline float distance2(float value, float min, float max)
+{
+    const float d(std::max(std::max(min - value, value - max), 0.f));
+    return d * d;
+}
+
+} // namespace
+
+namespace gua
+{
+////////////////////////////////////////////////////////////////////////////////
+
+LightClusterer::LightClusterer(unsigned depth_slices) : depth_slices_(std::max(depth_slices, 1u)) {}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LightClusterer::set_depth_slices(unsigned depth_slices) { depth_slices_ = std::max(depth_slices, 1u); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+math::vec2ui LightClusterer::assign(math::mat4 const& view, math::mat4 const& projection, math::vec2ui const& resolution, int tile_power, LightTable::array_type const& lights, unsigned sun_lights_num)
+{
+    // same tiling as LightTable::invalidate()
+    tile_power = std::max(tile_power, 0);
+    tiles_ = math::vec2ui(unsigned(std::ceil(float(resolution.x) / std::pow(2, tile_power))), unsigned(std::ceil(float(resolution.y) / std::pow(2, tile_power))));
+    words_ = lights.empty() ? 0 : unsigned((lights.size() - 1) / 32 + 1);
+
+    // rows are cleared while they are filled
+    light_bitset_.resize(std::size_t(words_) * tiles_.x * tiles_.y);
+
+    if(light_bitset_.empty())
+    {
+        return tiles_;
+    }
+
+    compute_bounds(projection, resolution, 1u << tile_power);
+    transform_lights(view, lights, unsigned(lights.size()) - std::min(sun_lights_num, unsigned(lights.size())));
+
+    rects_.resize(depth_slices_);
+
+    auto pool(concurrent::ThreadPool::instance());
+
+    pool->parallel_for(0, depth_slices_, [this](std::size_t begin, std::size_t end) {
+        for(std::size_t slice(begin); slice < end; ++slice)
+        {
+            collect_rects(unsigned(slice));
+        }
+    });
+
+    // each task owns whole rows, so no bits are shared between tasks
+    pool->parallel_for(0, tiles_.y, [this](std::size_t begin, std::size_t end) { fill_rows(unsigned(begin), unsigned(end)); }, ROWS_PER_TASK);
+
+    return tiles_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LightClusterer::compute_bounds(math::mat4 const& projection, math::vec2ui const& resolution, unsigned tile_size)
+{
+    const math::mat4 inverse_projection(scm::math::inverse(projection));
+
+    auto unproject = [&](double x, double y, double z) {
+        const math::vec4 p(inverse_projection * math::vec4(x, y, z, 1.0));
+        return math::vec3(p.x / p.w, p.y / p.w, p.z / p.w);
+    };
+
+    const double near_clip(-unproject(0.0, 0.0, -1.0).z);
+    const double far_clip(-unproject(0.0, 0.0, 1.0).z);
+    const bool perspective(projection[11] != 0.0 && near_clip > 0.0);
+
+    // exponential slices keep the froxels roughly cubic in perspective views
+    slice_depths_.resize(depth_slices_ + 1);
+    for(unsigned i(0); i < depth_slices_; ++i)
+    {
+        const double t(double(i) / depth_slices_);
+        slice_depths_[i] = float(perspective ? near_clip * std::pow(far_clip / near_clip, t) : near_clip + (far_clip - near_clip) * t);
+    }
+    slice_depths_[depth_slices_] = float(far_clip);
+
+    // the tile boundaries are lines through the frustum, the bounds of a
+    // froxel are their intersections with its near and far plane
+    auto compute_axis = [&](int axis, unsigned tiles, unsigned pixels, std::vector<float>& min, std::vector<float>& max) {
+        std::vector<double> near_bounds(tiles + 1), far_bounds(tiles + 1);
+
+        for(unsigned b(0); b <= tiles; ++b)
+        {
+            const double ndc(std::min(-1.0 + 2.0 * b * tile_size / pixels, 1.0));
+            near_bounds[b] = unproject(axis == 0 ? ndc : 0.0, axis == 1 ? ndc : 0.0, -1.0)[axis];
+            far_bounds[b] = unproject(axis == 0 ? ndc : 0.0, axis == 1 ? ndc : 0.0, 1.0)[axis];
+        }
+
+        auto bound_at = [&](unsigned b, double depth) { return near_bounds[b] + (far_bounds[b] - near_bounds[b]) * (depth - near_clip) / (far_clip - near_clip); };
+
+        min.resize(depth_slices_ * tiles);
+        max.resize(depth_slices_ * tiles);
+
+        for(unsigned slice(0); slice < depth_slices_; ++slice)
+        {
+            const double front(slice_depths_[slice]), back(slice_depths_[slice + 1]);
+
+            for(unsigned t(0); t < tiles; ++t)
+            {
+                min[slice * tiles + t] = float(std::min(bound_at(t, front), bound_at(t, back)));
+                max[slice * tiles + t] = float(std::max(bound_at(t + 1, front), bound_at(t + 1, back)));
+            }
+        }
+    };
+
+    compute_axis(0, tiles_.x, resolution.x, column_min_, column_max_);
+    compute_axis(1, tiles_.y, resolution.y, row_min_, row_max_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LightClusterer::transform_lights(math::mat4 const& view, LightTable::array_type const& lights, unsigned count)
+{
+    const double scale(std::max(std::max(scm::math::length(math::vec3(view.column(0))), scm::math::length(math::vec3(view.column(1)))), scm::math::length(math::vec3(view.column(2)))));
+    const float near_clip(slice_depths_.front()), far_clip(slice_depths_.back());
+
+    lights_.clear();
+
+    for(unsigned i(0); i < count; ++i)
+    {
+        auto const& block(lights[i]);
+
+        Light light{};
+        light.index = i;
+
+        const math::vec3 position(view * math::vec4(block.position_and_radius.x, block.position_and_radius.y, block.position_and_radius.z, 1.0));
+        math::vec3 center(position);
+        double radius(block.position_and_radius.w * scale);
+
+        if(block.type == 1)
+        {
+            const math::vec3 beam(view * math::vec4(block.beam_direction_and_half_angle.x, block.beam_direction_and_half_angle.y, block.beam_direction_and_half_angle.z, 0.0));
+            const double range(scm::math::length(beam));
+
+            if(range <= 0.0)
+            {
+                continue;
+            }
+
+            const math::vec3 direction(beam / range);
+            const double cos_angle(std::min(std::max(double(block.beam_direction_and_half_angle.w), 0.0), 1.0));
+            const double sin_angle(std::sqrt(1.0 - cos_angle * cos_angle));
+
+            // smallest sphere around the cone: through apex and base circle
+            // for narrow cones, around the base circle for wide ones
+            if(2.0 * cos_angle * cos_angle >= 1.0)
+            {
+                radius = range / (2.0 * cos_angle * cos_angle);
+                center = position + direction * radius;
+            }
+            else
+            {
+                radius = range * sin_angle / cos_angle;
+                center = position + direction * range;
+            }
+
+            light.spot = true;
+            light.range = float(range);
+            light.cos_angle = float(cos_angle);
+            light.sin_angle = float(sin_angle);
+
+            for(int c(0); c < 3; ++c)
+            {
+                light.origin[c] = float(position[c]);
+                light.direction[c] = float(direction[c]);
+            }
+        }
+
+        // completely in front of the near or behind the far plane
+        if(-center.z + radius < near_clip || -center.z - radius > far_clip)
+        {
+            continue;
+        }
+
+        for(int c(0); c < 3; ++c)
+        {
+            light.center[c] = float(center[c]);
+        }
+        light.radius = float(radius);
+
+        lights_.push_back(light);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LightClusterer::collect_rects(unsigned slice)
+{
+    auto& rects(rects_[slice]);
+    rects.clear();
+
+    const float min_z(-slice_depths_[slice + 1]), max_z(-slice_depths_[slice]);
+
+    const float* column_min(&column_min_[slice * tiles_.x]);
+    const float* column_max(&column_max_[slice * tiles_.x]);
+    const float* row_min(&row_min_[slice * tiles_.y]);
+    const float* row_max(&row_max_[slice * tiles_.y]);
+
+    for(unsigned i(0); i < lights_.size(); ++i)
+    {
+        auto const& light(lights_[i]);
+
+        const float radius2(light.radius * light.radius - distance2(light.center[2], min_z, max_z));
+        if(radius2 < 0.f)
+        {
+            continue;
+        }
+
+        // the bounds are sorted, so the touched tiles are found by bisection
+        const float extent(std::sqrt(radius2));
+
+        const unsigned min_x(unsigned(std::lower_bound(column_max, column_max + tiles_.x, light.center[0] - extent) - column_max));
+        const unsigned end_x(unsigned(std::upper_bound(column_min, column_min + tiles_.x, light.center[0] + extent) - column_min));
+        const unsigned min_y(unsigned(std::lower_bound(row_max, row_max + tiles_.y, light.center[1] - extent) - row_max));
+        const unsigned end_y(unsigned(std::upper_bound(row_min, row_min + tiles_.y, light.center[1] + extent) - row_min));
+
+        if(min_x < end_x && min_y < end_y)
+        {
+            rects.push_back(Rect{i, min_x, end_x - 1, min_y, end_y - 1, radius2});
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LightClusterer::fill_rows(unsigned begin, unsigned end)
+{
+    const unsigned width(tiles_.x), height(tiles_.y);
+
+    for(unsigned word(0); word < words_; ++word)
+    {
+        auto row(light_bitset_.begin() + (std::size_t(word) * height + begin) * width);
+        std::fill(row, row + std::size_t(end - begin) * width, 0u);
+    }
+
+    for(unsigned slice(0); slice < depth_slices_; ++slice)
+    {
+        const float* column_min(&column_min_[slice * width]);
+        const float* column_max(&column_max_[slice * width]);
+
+        for(auto const& rect : rects_[slice])
+        {
+            if(rect.max_y < begin || rect.min_y >= end)
+            {
+                continue;
+            }
+
+            auto const& light(lights_[rect.light]);
+            const std::uint32_t bit(1u << (light.index % 32));
+            std::uint32_t* plane(&light_bitset_[std::size_t(light.index / 32) * height * width]);
+
+            for(unsigned y(std::max(rect.min_y, begin)); y <= std::min(rect.max_y, end - 1); ++y)
+            {
+                const float radius2(rect.radius2 - distance2(light.center[1], row_min_[slice * height + y], row_max_[slice * height + y]));
+                if(radius2 < 0.f)
+                {
+                    continue;
+                }
+
+                std::uint32_t* row(plane + std::size_t(y) * width);
+
+                ConeRow cone{};
+                if(light.spot)
+                {
+                    cone = make_cone_row(light, slice, y);
+                }
+
+                // the tile may already be marked by another slice
+                auto mark = [&](unsigned x) {
+                    if(!(row[x] & bit) && (!light.spot || cone_intersects(light, cone, 0.5f * (column_min[x] + column_max[x]), 0.5f * (column_max[x] - column_min[x]))))
+                    {
+                        row[x] |= bit;
+                    }
+                };
+
+                unsigned x(rect.min_x);
+
+#if defined(GUA_LIGHT_CLUSTERER_SSE2)
+                const __m128 center(_mm_set1_ps(light.center[0]));
+                const __m128 limit(_mm_set1_ps(radius2));
+                const __m128 zero(_mm_setzero_ps());
+                const __m128 half(_mm_set1_ps(0.5f));
+
+                for(; x + 3 <= rect.max_x; x += 4)
+                {
+                    const __m128 min(_mm_loadu_ps(column_min + x)), max(_mm_loadu_ps(column_max + x));
+                    const __m128 d(_mm_max_ps(_mm_max_ps(_mm_sub_ps(min, center), _mm_sub_ps(center, max)), zero));
+                    __m128 inside(_mm_cmple_ps(_mm_mul_ps(d, d), limit));
+
+                    if(light.spot && _mm_movemask_ps(inside))
+                    {
+                        // the same test as cone_intersects(), for four froxels
+                        const __m128 v(_mm_sub_ps(_mm_mul_ps(half, _mm_add_ps(min, max)), _mm_set1_ps(light.origin[0])));
+                        const __m128 extent(_mm_mul_ps(half, _mm_sub_ps(max, min)));
+                        const __m128 radius(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(extent, extent), _mm_set1_ps(cone.extent2))));
+                        const __m128 length2(_mm_add_ps(_mm_mul_ps(v, v), _mm_set1_ps(cone.length2)));
+                        const __m128 axial(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(light.direction[0])), _mm_set1_ps(cone.axial)));
+                        const __m128 distance(_mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(length2, _mm_mul_ps(axial, axial)), zero)));
+                        const __m128 closest(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(light.cos_angle), distance), _mm_mul_ps(axial, _mm_set1_ps(light.sin_angle))));
+
+                        inside = _mm_and_ps(inside, _mm_cmple_ps(closest, radius));
+                        inside = _mm_and_ps(inside, _mm_cmple_ps(axial, _mm_add_ps(radius, _mm_set1_ps(light.range))));
+                        inside = _mm_and_ps(inside, _mm_cmpge_ps(axial, _mm_sub_ps(zero, radius)));
+                    }
+
+                    const int mask(_mm_movemask_ps(inside));
+                    for(unsigned lane(0); mask && lane < 4; ++lane)
+                    {
+                        if(mask & (1 << lane))
+                        {
+                            row[x + lane] |= bit;
+                        }
+                    }
+                }
+#endif
+
+                for(; x <= rect.max_x; ++x)
+                {
+                    if(distance2(light.center[0], column_min[x], column_max[x]) <= radius2)
+                    {
+                        mark(x);
+                    }
+                }
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LightClusterer::ConeRow LightClusterer::make_cone_row(Light const& light, unsigned slice, unsigned y) const
+{
+    const float min_y(row_min_[slice * tiles_.y + y]), max_y(row_max_[slice * tiles_.y + y]);
+    const float min_z(-slice_depths_[slice + 1]), max_z(-slice_depths_[slice]);
+
+    const float extent_y(0.5f * (max_y - min_y)), extent_z(0.5f * (max_z - min_z));
+    const float v_y(0.5f * (min_y + max_y) - light.origin[1]), v_z(0.5f * (min_z + max_z) - light.origin[2]);
+
+    return ConeRow{extent_y * extent_y + extent_z * extent_z, v_y * v_y + v_z * v_z, v_y * light.direction[1] + v_z * light.direction[2]};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LightClusterer::cone_intersects(Light const& light, ConeRow const& row, float center_x, float extent_x)
+{
+    // bounding sphere of the froxel against the cone, see "Cull that cone!"
+    // by Bart Wronski
+    const float v_x(center_x - light.origin[0]);
+    const float radius(std::sqrt(extent_x * extent_x + row.extent2));
+    const float length2(v_x * v_x + row.length2);
+    const float axial(v_x * light.direction[0] + row.axial);
+    const float closest(light.cos_angle * std::sqrt(std::max(length2 - axial * axial, 0.f)) - axial * light.sin_angle);
+
+    return closest <= radius && axial <= radius + light.range && axial >= -radius;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace gua
@@ -90,4 +90,22 @@ math::vec2ui LightTable::invalidate(RenderContext const& ctx, math::vec2ui const
     return math::vec2ui(width, height);
 }
 
+void LightTable::upload_light_bitset(RenderContext const& ctx, math::vec2ui const& tiles, std::vector<std::uint32_t> const& bitset)
+{
+    if(!lights_num_ || !light_bitset_)
+    {
+        return;
+    }
+
+    unsigned light_bitset_words = ((lights_num_ - 1) / 32) + 1;
+
+    if(bitset.size() < std::size_t(tiles.x) * tiles.y * light_bitset_words)
+    {
+        Logger::LOG_WARNING << "LightTable::upload_light_bitset(): Bitset does not cover all tiles and lights." << std::endl;
+        return;
+    }
+
+    light_bitset_->update_sub_data(ctx, scm::gl::texture_region(math::vec3ui(0, 0, 0), math::vec3ui(tiles.x, tiles.y, light_bitset_words)), 0, scm::gl::FORMAT_R_32UI, bitset.data());
+}
+
 } // namespace gua
@@ -95,11 +95,19 @@ PipelinePass LightVisibilityPassDescription::make_pass(RenderContext const& ctx,
 
     auto renderer = std::make_shared<LightVisibilityRenderer>();
 
-    private_.process_ = [renderer, tp, ms_sample_count, enable_conservative, enable_fullscreen_fallback](PipelinePass& pass, PipelinePassDescription const& desc, Pipeline& pipe) {
-        pipe.get_context().render_context->set_depth_stencil_state(pass.depth_stencil_state());
-        pipe.get_context().render_context->set_rasterizer_state(pass.rasterizer_state());
-        renderer->render(pass, pipe, tp, ms_sample_count, enable_conservative, enable_fullscreen_fallback);
-    };
+    if(cpu_clustering_)
+    {
+        unsigned slices = depth_slices_;
+        private_.process_ = [renderer, tp, slices](PipelinePass& pass, PipelinePassDescription const& desc, Pipeline& pipe) { renderer->render_clustered(pipe, tp, slices); };
+    }
+    else
+    {
+        private_.process_ = [renderer, tp, ms_sample_count, enable_conservative, enable_fullscreen_fallback](PipelinePass& pass, PipelinePassDescription const& desc, Pipeline& pipe) {
+            pipe.get_context().render_context->set_depth_stencil_state(pass.depth_stencil_state());
+            pipe.get_context().render_context->set_rasterizer_state(pass.rasterizer_state());
+            renderer->render(pass, pipe, tp, ms_sample_count, enable_conservative, enable_fullscreen_fallback);
+        };
+    }
 
     PipelinePass pass{*this, ctx, substitution_map};
     return pass;
@@ -86,6 +86,32 @@ void LightVisibilityRenderer::render(PipelinePass& pass, Pipeline& pipe, int til
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void LightVisibilityRenderer::render_clustered(Pipeline& pipe, int tile_power, unsigned depth_slices)
+{
+    auto const& ctx(pipe.get_context());
+    auto const& camera = pipe.current_viewstate().camera;
+    auto const& frustum = pipe.current_viewstate().scene->rendering_frustum;
+
+    std::vector<math::mat4> transforms;
+    LightTable::array_type lights;
+
+    unsigned sun_lights_num = 0u;
+    prepare_light_table(pipe, transforms, lights, sun_lights_num);
+    math::vec2ui effective_resolution = pipe.get_light_table().invalidate(ctx, camera.config.get_resolution(), lights, tile_power, sun_lights_num);
+
+    // sun lights are not stored in the bitset
+    if(lights.size() == sun_lights_num)
+    {
+        return;
+    }
+
+    clusterer_.set_depth_slices(depth_slices);
+    clusterer_.assign(frustum.get_view(), frustum.get_projection(), camera.config.get_resolution(), tile_power, lights, sun_lights_num);
+    pipe.get_light_table().upload_light_bitset(ctx, effective_resolution, clusterer_.get_light_bitset());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void LightVisibilityRenderer::prepare_light_table(Pipeline& pipe, std::vector<math::mat4>& transforms, LightTable::array_type& lights, unsigned& sun_lights_num) const
 {
     sun_lights_num = 0u;
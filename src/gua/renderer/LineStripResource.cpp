@@ -248,6 +248,37 @@ void LineStripResource::uncompile_buffer_string(std::string const& buffer_string
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::size_t LineStripResource::max_sync_size() const
+{
+    std::lock_guard<std::mutex> lock(line_strip_update_mutex_);
+    return line_strip_.max_sync_size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LineStripResource::write_sync(char* buffer, std::size_t capacity, bool delta, float precision)
+{
+    std::lock_guard<std::mutex> lock(line_strip_update_mutex_);
+    return line_strip_.write_sync(buffer, capacity, delta, precision);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LineStripResource::read_sync(char const* buffer, std::size_t size)
+{
+    std::lock_guard<std::mutex> lock(line_strip_update_mutex_);
+    if(!line_strip_.read_sync(buffer, size))
+    {
+        return false;
+    }
+
+    compute_bounding_box();
+    make_clean_flags_dirty();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void LineStripResource::push_vertex(LineStrip::Vertex const& in_vertex)
 {
     std::lock_guard<std::mutex> lock(line_strip_update_mutex_);
@@ -22,10 +22,23 @@
 #include <gua/renderer/Material.hpp>
 
 #include <gua/databases/MaterialShaderDatabase.hpp>
+#include <gua/databases/TextureDatabase.hpp>
 #include <gua/renderer/ShaderProgram.hpp>
 
+#include <boost/functional/hash.hpp>
+
 namespace gua
 {
+namespace
+{
+std::size_t next_material_id()
+{
+    static std::atomic<std::size_t> next_id(0);
+    return next_id++;
+}
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 
 Material::Material(std::string const& shader_name)
@@ -34,6 +47,8 @@ Material::Material(std::string const& shader_name)
       ,
       enable_virtual_texturing_(false)
 #endif
+      ,
+      id_(next_material_id()), version_(1)
 {
     set_shader_name(shader_name_);
 }
@@ -41,7 +56,8 @@ Material::Material(std::string const& shader_name)
 ////////////////////////////////////////////////////////////////////////////////
 
 Material::Material(Material const& copy)
-    : shader_name_(copy.shader_name_), shader_cache_(copy.shader_cache_), uniforms_(copy.uniforms_), show_back_faces_(copy.show_back_faces_), render_wireframe_(copy.render_wireframe_)
+    : shader_name_(copy.shader_name_), shader_cache_(copy.shader_cache_), uniforms_(copy.uniforms_), show_back_faces_(copy.show_back_faces_), render_wireframe_(copy.render_wireframe_),
+      id_(next_material_id()), version_(1)
 {
 }
 
@@ -74,6 +90,8 @@ void Material::set_shader_name(std::string const& name)
 
         uniforms_ = new_uniforms;
     }
+
+    ++version_;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -122,6 +140,113 @@ void Material::apply_uniforms(RenderContext const& ctx, ShaderProgram* shader, i
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Material::bind_uniform_block(RenderContext const& ctx, int view) const
+{
+    auto shader(get_shader());
+
+    if(!shader || shader->get_uniform_block_size() == 0)
+    {
+        return;
+    }
+
+    std::size_t key(id_);
+    boost::hash_combine(key, view);
+
+    auto& block(ctx.material_uniform_blocks[key]);
+    unsigned const version(version_);
+
+    if(!block.buffer || block.version != version || (shader->get_uniform_block_has_textures() && block.framecount != ctx.framecount))
+    {
+        std::vector<char> data(shader->get_uniform_block_size(), 0);
+        block.loading_textures.clear();
+#ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
+        block.virtual_texture_index = 0;
+#endif
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            for(auto const& member : shader->get_uniform_block_members())
+            {
+                auto uniform(uniforms_.find(member.name));
+
+                // values of a different type than declared in the shader are ignored
+                if(uniform != uniforms_.end() && uniform->second.get(view).get_std140_size() == member.size)
+                {
+                    auto const& value(uniform->second.get(view));
+                    value.write_std140(ctx, data.data() + member.offset);
+
+                    auto texture(boost::get<std::string>(&value.data));
+                    if(texture && TextureDatabase::instance()->is_loading(*texture))
+                    {
+                        block.loading_textures.push_back(*texture);
+                    }
+#ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
+                    // like the per-uniform path, the last texture selects the virtual texture
+                    if(texture && !texture->empty())
+                    {
+                        auto global_tex_id(TextureDatabase::instance()->get_global_texture_id_by_path(*texture));
+                        block.virtual_texture_index = global_tex_id >= 0 ? global_tex_id : block.virtual_texture_index;
+                    }
+#endif
+                }
+            }
+        }
+
+        if(!block.buffer)
+        {
+            block.buffer = ctx.render_device->create_buffer(scm::gl::BIND_UNIFORM_BUFFER, scm::gl::USAGE_DYNAMIC_DRAW, data.size(), data.data());
+        }
+        else if(data != block.data)
+        {
+            auto mapped(ctx.render_context->map_buffer(block.buffer, scm::gl::ACCESS_WRITE_INVALIDATE_BUFFER));
+            memcpy(mapped, data.data(), data.size());
+            ctx.render_context->unmap_buffer(block.buffer);
+        }
+
+        block.data.swap(data);
+        block.version = version;
+        block.framecount = ctx.framecount;
+    }
+
+    block.last_used = ctx.framecount;
+    ctx.render_context->bind_uniform_buffer(block.buffer, MaterialShader::UNIFORM_BLOCK_BINDING);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Material::request_textures(RenderContext const& ctx, int view, float screen_size) const
+{
+    std::size_t key(id_);
+    boost::hash_combine(key, view);
+
+    auto block(ctx.material_uniform_blocks.find(key));
+    if(block == ctx.material_uniform_blocks.end())
+    {
+        return;
+    }
+
+    for(auto const& texture : block->second.loading_textures)
+    {
+        TextureDatabase::instance()->request_visible(texture, screen_size);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
+int Material::get_virtual_texture_index(RenderContext const& ctx, int view) const
+{
+    std::size_t key(id_);
+    boost::hash_combine(key, view);
+
+    auto block(ctx.material_uniform_blocks.find(key));
+    return block == ctx.material_uniform_blocks.end() ? 0 : block->second.virtual_texture_index;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
 std::ostream& Material::serialize_uniforms_to_stream(std::ostream& os) const
 {
     for(auto& uniform : uniforms_)
@@ -171,6 +296,7 @@ Material& Material::set_uniform<std::string>(std::string const& name, std::strin
         tmp.set(view_id, UniformValue(tex_name));
         uniforms_[name] = tmp;
     }
+    ++version_;
     return *this;
 }
 
@@ -32,6 +32,7 @@
 // external headers
 #include <assimp/scene.h>
 #include <fstream>
+#include <sstream>
 #include <jsoncpp/json/json.h>
 
 // Windows includes
@@ -61,6 +62,13 @@ bool replace(std::string& str, const std::string& from, const std::string& to)
 }
 
 std::shared_ptr<Material> MaterialLoader::load_material(aiMaterial const* ai_material, std::string const& assets_directory, bool optimize_material, bool nrp) const
+{
+    return create_material(describe_material(ai_material, assets_directory, optimize_material, nrp));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+MaterialLoader::Description MaterialLoader::describe_material(aiMaterial const* ai_material, std::string const& assets_directory, bool optimize_material, bool nrp) const
 {
     // helper lambdas ------------------------------------------------------------
     auto get_color = [&](const char* pKey, unsigned int type, unsigned int idx) -> std::string {
@@ -224,12 +232,13 @@ std::shared_ptr<Material> MaterialLoader::load_material(aiMaterial const* ai_mat
         }
     }
 
-    auto new_mat(PBSMaterialFactory::create_material(static_cast<PBSMaterialFactory::Capabilities>(capabilities)));
+    Description description;
+    description.capabilities = capabilities;
+    description.name = material_name;
 
     if(!uniform_color_map.empty())
     {
-        new_mat->set_uniform("ColorMap", assets + uniform_color_map);
-        TextureDatabase::instance()->load(assets + uniform_color_map);
+        description.uniforms.emplace_back("ColorMap", assets + uniform_color_map);
     }
 
     if(!uniform_color.empty())
@@ -242,52 +251,101 @@ std::shared_ptr<Material> MaterialLoader::load_material(aiMaterial const* ai_mat
             opacity_to_set = std::max(0.0f, std::min(1.0f, string_utils::from_string<float>(uniform_opacity)));
         }
 
-        new_mat->set_uniform("Color", scm::math::vec4f(gua::math::float_t(c.x), gua::math::float_t(c.y), gua::math::float_t(c.z), opacity_to_set));
+        description.uniforms.emplace_back("Color", scm::math::vec4f(gua::math::float_t(c.x), gua::math::float_t(c.y), gua::math::float_t(c.z), opacity_to_set));
     }
 
 #if 1
     if(!uniform_roughness_map.empty())
     {
-        new_mat->set_uniform("RoughnessMap", assets + uniform_roughness_map);
+        description.uniforms.emplace_back("RoughnessMap", assets + uniform_roughness_map);
     }
     else if(!uniform_roughness.empty() && uniform_roughness != "0")
     {
         // specular exponent is taken to the power of 0.02 in order to move it to the desired range
-        new_mat->set_uniform("Roughness", float(std::min(1.f, std::pow(string_utils::from_string<float>(uniform_roughness), 0.02f) - 1.f)));
+        description.uniforms.emplace_back("Roughness", float(std::min(1.f, std::pow(string_utils::from_string<float>(uniform_roughness), 0.02f) - 1.f)));
     }
 #endif
 
 #if 1
     if(!uniform_metalness_map.empty())
     {
-        new_mat->set_uniform("MetalnessMap", assets + uniform_metalness_map);
+        description.uniforms.emplace_back("MetalnessMap", assets + uniform_metalness_map);
     }
     else if(!uniform_metalness.empty())
     {
         // multiplying with 0.5, since metalness of 1.0 is seldomly wanted but specularity of 1.0 often given
-        new_mat->set_uniform("Metalness", scm::math::vec3f(string_utils::from_string<math::vec3>(uniform_metalness)[0] * 0.5f));
+        description.uniforms.emplace_back("Metalness", scm::math::vec3f(string_utils::from_string<math::vec3>(uniform_metalness)[0] * 0.5f));
     }
 #endif
 
     if(!uniform_emit_map.empty())
     {
-        new_mat->set_uniform("EmissivityMap", assets + uniform_emit_map);
+        description.uniforms.emplace_back("EmissivityMap", assets + uniform_emit_map);
     }
     else if(!uniform_emit.empty())
     {
-        new_mat->set_uniform("Emissivity", string_utils::from_string<scm::math::vec3f>(uniform_emit)[0]);
+        description.uniforms.emplace_back("Emissivity", string_utils::from_string<scm::math::vec3f>(uniform_emit)[0]);
     }
 
     if(!uniform_normal_map.empty())
     {
-        new_mat->set_uniform("NormalMap", assets + uniform_normal_map);
+        description.uniforms.emplace_back("NormalMap", assets + uniform_normal_map);
     }
 
-    new_mat->rename_existing_shader(material_name);
+    return description;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<Material> MaterialLoader::create_material(Description const& description) const
+{
+    auto new_mat(PBSMaterialFactory::create_material(static_cast<PBSMaterialFactory::Capabilities>(description.capabilities)));
+
+    for(auto const& uniform : description.uniforms)
+    {
+        // samplers are set by name, which loads their textures
+        if(auto texture = boost::get<std::string>(&uniform.second.data))
+        {
+            new_mat->set_uniform(uniform.first, *texture);
+        }
+        else
+        {
+            new_mat->set_uniform(uniform.first, uniform.second);
+        }
+    }
+
+    if(!description.name.empty())
+    {
+        new_mat->rename_existing_shader(description.name);
+    }
 
     return new_mat;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+bool MaterialLoader::Description::serialize(std::string& shader_name, std::string& serialized_uniforms) const
+{
+    // renamed shaders are not known when the material is restored
+    if(!name.empty())
+    {
+        return false;
+    }
+
+    std::stringstream stream;
+
+    for(auto const& uniform : uniforms)
+    {
+        stream << uniform.first << "#";
+        ViewDependentUniform(uniform.second).serialize_to_stream(stream);
+        stream << ";";
+    }
+
+    shader_name = PBSMaterialFactory::material_name_from_capabilites(static_cast<PBSMaterialFactory::Capabilities>(capabilities));
+    serialized_uniforms = stream.str();
+    return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 #ifdef GUACAMOLE_FBX
 std::shared_ptr<Material> MaterialLoader::load_material(FbxSurfaceMaterial const& fbx_material, std::string const& assets_directory, bool optimize_material, bool nrp) const
@@ -48,6 +48,24 @@ MaterialShader::MaterialShader(std::string const& name, std::shared_ptr<Material
             default_uniforms_[uniform.first] = ViewDependentUniform(uniform.second);
         }
     }
+
+    // std140 layout, in the order of the declarations in the shader
+    for(auto const& uniform : default_uniforms_)
+    {
+        auto const& value(uniform.second.get());
+        auto alignment(value.get_std140_alignment());
+
+        uniform_block_size_ = (uniform_block_size_ + alignment - 1) / alignment * alignment;
+        uniform_block_members_.push_back(UniformBlockMember{uniform.first, uniform_block_size_, value.get_std140_size()});
+        uniform_block_size_ += value.get_std140_size();
+
+        if(boost::get<std::string>(&value.data))
+        {
+            uniform_block_has_textures_ = true;
+        }
+    }
+
+    uniform_block_size_ = (uniform_block_size_ + 15) / 16 * 16;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -68,7 +86,7 @@ std::list<std::shared_ptr<MaterialShaderMethod>> const& MaterialShader::get_vert
 ////////////////////////////////////////////////////////////////////////////////
 std::list<std::shared_ptr<MaterialShaderMethod>> const& MaterialShader::get_fragment_methods() const { return desc_->get_fragment_methods(); }
 
-SubstitutionMap MaterialShader::generate_substitution_map() const
+SubstitutionMap MaterialShader::generate_substitution_map(bool uniform_block) const
 {
     SubstitutionMap smap;
     std::stringstream sstr;
@@ -77,9 +95,21 @@ SubstitutionMap MaterialShader::generate_substitution_map() const
     const auto& f_methods = get_fragment_methods();
 
     // uniform substitutions
-    for(auto const& uniform : default_uniforms_)
+    if(uniform_block && !default_uniforms_.empty())
+    {
+        sstr << "layout(std140, binding=" << UNIFORM_BLOCK_BINDING << ") uniform gua_material_block {" << std::endl;
+        for(auto const& uniform : default_uniforms_)
+        {
+            sstr << "  " << uniform.second.get().get_glsl_type() << " " << uniform.first << ";" << std::endl;
+        }
+        sstr << "};" << std::endl;
+    }
+    else
     {
-        sstr << "uniform " << uniform.second.get().get_glsl_type() << " " << uniform.first << ";" << std::endl;
+        for(auto const& uniform : default_uniforms_)
+        {
+            sstr << "uniform " << uniform.second.get().get_glsl_type() << " " << uniform.first << ";" << std::endl;
+        }
     }
     sstr << std::endl;
     smap["material_uniforms"] = sstr.str();
@@ -225,4 +225,64 @@ std::string const PBSMaterialFactory::material_name_from_capabilites(Capabilitie
 
 ////////////////////////////////////////////////////////////////////////////////
 
+PBSMaterialFactory::Capabilities PBSMaterialFactory::capabilities_from_material_name(std::string const& material_name)
+{
+    if(material_name == "gua_default_material")
+    {
+        return Capabilities::ALL;
+    }
+
+    auto contains = [&](std::string const& part) { return material_name.find(part) != std::string::npos; };
+    unsigned capabilities(0);
+
+    if(contains("_color_value_and_map"))
+    {
+        capabilities |= Capabilities::COLOR_VALUE_AND_MAP;
+    }
+    else if(contains("_color_value"))
+    {
+        capabilities |= Capabilities::COLOR_VALUE;
+    }
+    else if(contains("_color_map"))
+    {
+        capabilities |= Capabilities::COLOR_MAP;
+    }
+
+    if(contains("_roughness_value"))
+    {
+        capabilities |= Capabilities::ROUGHNESS_VALUE;
+    }
+    else if(contains("_roughness_map"))
+    {
+        capabilities |= Capabilities::ROUGHNESS_MAP;
+    }
+
+    if(contains("_metalness_value"))
+    {
+        capabilities |= Capabilities::METALNESS_VALUE;
+    }
+    else if(contains("_metalness_map"))
+    {
+        capabilities |= Capabilities::METALNESS_MAP;
+    }
+
+    if(contains("_emissivity_value"))
+    {
+        capabilities |= Capabilities::EMISSIVITY_VALUE;
+    }
+    else if(contains("_emissivity_map"))
+    {
+        capabilities |= Capabilities::EMISSIVITY_MAP;
+    }
+
+    if(contains("_normal_map"))
+    {
+        capabilities |= Capabilities::NORMAL_MAP;
+    }
+
+    return static_cast<Capabilities>(capabilities);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // namespace gua
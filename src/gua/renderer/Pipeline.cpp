@@ -40,6 +40,7 @@
 
 // external headers
 #include <iostream>
+#include <map>
 
 namespace
 {
@@ -132,6 +133,9 @@ scm::gl::texture_2d_ptr Pipeline::render_scene(CameraMode mode, node::Serialized
     bool reload_gbuffer(false);
     bool reload_abuffer(false);
 
+    // cull the views of this camera and its prerender cameras in one go
+    serialize_views(mode, camera, scene_graphs);
+
     // execute all prerender cameras
     for(auto const& cam : camera.pre_render_cameras)
     {
@@ -171,10 +175,14 @@ scm::gl::texture_2d_ptr Pipeline::render_scene(CameraMode mode, node::Serialized
     }
     else
     {
-        // if pipeline configuration is unchanged, update only uniforms of passes
+        // if pipeline configuration is unchanged, update only modified uniforms of passes
         for(unsigned i(0); i < last_description_.get_passes().size(); ++i)
         {
-            last_description_.get_passes()[i]->uniforms = camera.pipeline_description->get_passes()[i]->uniforms;
+            auto const& uniforms(camera.pipeline_description->get_passes()[i]->uniforms);
+            if(last_description_.get_passes()[i]->uniforms.version() != uniforms.version())
+            {
+                last_description_.get_passes()[i]->uniforms = uniforms;
+            }
         }
     }
 
@@ -441,20 +449,72 @@ void Pipeline::generate_shadow_map(node::LightNode& light, LightTable::LightBloc
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Pipeline::render_shadow_map(LightTable::LightBlock& light_block, Frustum const& frustum, unsigned cascade_id, unsigned viewport_size, bool redraw)
+void Pipeline::serialize_views(CameraMode mode, node::SerializedCameraNode const& camera, std::vector<std::unique_ptr<const SceneGraph>> const& scene_graphs) const
+{
+    // views which will be rendered during this call, grouped by scene graph
+    std::map<SceneGraph const*, std::vector<std::pair<node::SerializedCameraNode const*, CameraMode>>> views;
+
+    auto add_views = [&](node::SerializedCameraNode const& cam) {
+        for(auto& graph : scene_graphs)
+        {
+            if(graph->get_name() == cam.config.get_scene_graph_name())
+            {
+                // without cache, the results could not be picked up later
+                if(graph->get_enable_serialization_cache())
+                {
+                    views[graph.get()].push_back(std::make_pair(&cam, mode));
+
+                    // the right eye is rendered right after the left one
+                    if(mode == CameraMode::LEFT && camera.config.get_enable_stereo())
+                    {
+                        views[graph.get()].push_back(std::make_pair(&cam, CameraMode::RIGHT));
+                    }
+                }
+                break;
+            }
+        }
+    };
+
+    add_views(camera);
+
+    for(auto const& cam : camera.pre_render_cameras)
+    {
+        add_views(cam);
+    }
+
+    for(auto const& graph_views : views)
+    {
+        graph_views.first->serialize(graph_views.second);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::shared_ptr<SerializedScene>> Pipeline::serialize_shadow_views(std::vector<Frustum> const& frustums, bool redraw) const
+{
+    // shadow maps which are not redrawn need no serialized scene
+    if(!redraw)
+    {
+        return std::vector<std::shared_ptr<SerializedScene>>(frustums.size());
+    }
+
+    return current_viewstate_.graph->serialize(frustums,
+                                               math::get_translation(current_viewstate_.camera.transform),
+                                               current_viewstate_.camera.config.enable_frustum_culling(),
+                                               current_viewstate_.camera.config.mask(),
+                                               current_viewstate_.camera.config.view_id());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Pipeline::render_shadow_map(LightTable::LightBlock& light_block, Frustum const& frustum, std::shared_ptr<SerializedScene> const& scene, unsigned cascade_id, unsigned viewport_size, bool redraw)
 {
     light_block.projection_view_mats[cascade_id] = math::mat4f(frustum.get_projection() * frustum.get_view());
 
     // only render shadow map if it hasn't been rendered before this frame
     if(redraw)
     {
-        current_viewstate_.scene = current_viewstate_.graph->serialize(frustum,
-                                                                       frustum,
-                                                                       math::get_translation(current_viewstate_.camera.transform),
-                                                                       current_viewstate_.camera.config.enable_frustum_culling(),
-                                                                       current_viewstate_.camera.config.mask(),
-                                                                       current_viewstate_.camera.config.view_id());
-
+        current_viewstate_.scene = scene;
         current_viewstate_.frustum = frustum;
 
         camera_block_.update(context_, frustum, frustum.get_camera_position(), current_viewstate_.scene->clipping_planes, current_viewstate_.camera.config.get_view_id(), math::vec2ui(viewport_size));
@@ -495,10 +555,10 @@ void Pipeline::generate_shadow_map_sunlight(
                   current_viewstate_.camera.config.far_clip()};
     }
 
+    std::vector<Frustum> shadow_frustums;
+
     for(uint32_t cascade = 0; cascade < splits.size() - 1; ++cascade)
     {
-        shadow_map->set_viewport_offset(math::vec2f(cascade, 0.f));
-
         // set clipping of camera frustum according to current cascade
         // use cyclops for consistent cascades for left and right eye in stereo
         Frustum cropped_frustum(Frustum::perspective(
@@ -565,9 +625,16 @@ void Pipeline::generate_shadow_map_sunlight(
         auto sun_eye_transform(scm::math::make_translation(sun_screen_transform.column(3)[0], sun_screen_transform.column(3)[1], sun_screen_transform.column(3)[2]));
         auto sun_eye_depth(transform * math::vec4(0, 0, extends_in_sun_space.max[2] - extends_in_sun_space.min[2] + light.data.get_shadow_near_clipping_in_sun_direction(), 0.0f));
 
-        auto shadow_frustum(Frustum::orthographic(sun_eye_transform, sun_screen_transform, 0, scm::math::length(sun_eye_depth) + light.data.get_shadow_far_clipping_in_sun_direction()));
+        shadow_frustums.push_back(Frustum::orthographic(sun_eye_transform, sun_screen_transform, 0, scm::math::length(sun_eye_depth) + light.data.get_shadow_far_clipping_in_sun_direction()));
+    }
+
+    // cull all cascades in a single traversal
+    auto scenes(serialize_shadow_views(shadow_frustums, redraw));
 
-        render_shadow_map(light_block, shadow_frustum, cascade, viewport_size, redraw);
+    for(uint32_t cascade = 0; cascade < shadow_frustums.size(); ++cascade)
+    {
+        shadow_map->set_viewport_offset(math::vec2f(cascade, 0.f));
+        render_shadow_map(light_block, shadow_frustums[cascade], scenes[cascade], cascade, viewport_size, redraw);
     }
 }
 
@@ -588,6 +655,8 @@ void Pipeline::generate_shadow_map_pointlight(std::shared_ptr<ShadowMap> const&
     std::vector<PipelineViewState::ViewDirection> view_directions = {
         PipelineViewState::front, PipelineViewState::back, PipelineViewState::top, PipelineViewState::bottom, PipelineViewState::left, PipelineViewState::right};
 
+    std::vector<Frustum> frustums;
+
     for(unsigned cascade(0); cascade < screen_transforms.size(); ++cascade)
     {
         auto transform(light.get_cached_world_transform() * screen_transforms[cascade]);
@@ -596,12 +665,19 @@ void Pipeline::generate_shadow_map_pointlight(std::shared_ptr<ShadowMap> const&
         auto light_near_clip = light.data.get_shadow_near_clipping_in_sun_direction();
         auto light_far_clip = light.data.get_shadow_far_clipping_in_sun_direction();
 
-        auto frustum(Frustum::perspective(light.get_cached_world_transform(), transform, light_near_clip, light_far_clip));
+        frustums.push_back(Frustum::perspective(light.get_cached_world_transform(), transform, light_near_clip, light_far_clip));
+    }
+
+    // cull all six faces in a single traversal
+    auto scenes(serialize_shadow_views(frustums, redraw));
+
+    for(unsigned cascade(0); cascade < frustums.size(); ++cascade)
+    {
         shadow_map->set_viewport_offset(math::vec2f(cascade, 0.0));
 
         current_viewstate_.view_direction = view_directions[cascade];
 
-        render_shadow_map(light_block, frustum, cascade, viewport_size, redraw);
+        render_shadow_map(light_block, frustums[cascade], scenes[cascade], cascade, viewport_size, redraw);
     }
 }
 
@@ -617,7 +693,7 @@ void Pipeline::generate_shadow_map_spotlight(node::LightNode& light, LightTable:
 
     auto frustum(Frustum::perspective(light.get_cached_world_transform(), screen_transform, light_near_clip, light_far_clip));
 
-    render_shadow_map(light_block, frustum, 0, viewport_size, redraw);
+    render_shadow_map(light_block, frustum, serialize_shadow_views({frustum}, redraw).front(), 0, viewport_size, redraw);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
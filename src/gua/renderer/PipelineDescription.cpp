@@ -68,6 +68,7 @@ PipelineDescription::PipelineDescription(PipelineDescription const& other)
     abuffer_size_ = other.abuffer_size_;
     blending_termination_threshold_ = other.blending_termination_threshold_;
     max_lights_count_ = other.max_lights_count_;
+    version_ = other.version_;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -75,7 +76,11 @@ PipelineDescription::PipelineDescription(PipelineDescription const& other)
 PipelineDescription::~PipelineDescription() {}
 
 ////////////////////////////////////////////////////////////////////////////////
-void PipelineDescription::add_pass(std::shared_ptr<PipelinePassDescription> const& pass_desc) { passes_.push_back(pass_desc); }
+void PipelineDescription::add_pass(std::shared_ptr<PipelinePassDescription> const& pass_desc)
+{
+    passes_.push_back(pass_desc);
+    touch();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -129,18 +134,14 @@ std::shared_ptr<SSAAPassDescription> const PipelineDescription::get_ssaa_pass()
 
 bool PipelineDescription::operator==(PipelineDescription const& other) const
 {
-    if(enable_abuffer_ != other.enable_abuffer_ || abuffer_size_ != other.abuffer_size_ || blending_termination_threshold_ != other.blending_termination_threshold_ ||
-       max_lights_count_ != other.max_lights_count_ || passes_.size() != other.passes_.size())
+    // versions are unique, so equal versions mean one is a copy of the other
+    if(version_ != other.version_ || passes_.size() != other.passes_.size())
     {
         return false;
     }
 
     for(unsigned int i = 0; i < passes_.size(); ++i)
     {
-        if(typeid(*passes_[i]) != typeid(*other.passes_[i]))
-        {
-            return false;
-        }
         if((*passes_[i]) != (*other.passes_[i]))
         {
             return false;
@@ -169,6 +170,7 @@ PipelineDescription& PipelineDescription::operator=(PipelineDescription const& o
     abuffer_size_ = other.abuffer_size_;
     blending_termination_threshold_ = other.blending_termination_threshold_;
     max_lights_count_ = other.max_lights_count_;
+    version_ = other.version_;
 
     return *this;
 }
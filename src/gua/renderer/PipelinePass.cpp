@@ -30,16 +30,26 @@
 #include <gua/databases/Resources.hpp>
 #include <gua/utils/Logger.hpp>
 
+// external headers
+#include <atomic>
+
 namespace gua
 {
 ////////////////////////////////////////////////////////////////////////////////
-void PipelinePassDescription::touch() { ++mod_count_; }
+std::size_t make_pipeline_description_version()
+{
+    static std::atomic<std::size_t> last_version(0);
+    return ++last_version;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void PipelinePassDescription::touch() { mod_count_ = make_pipeline_description_version(); }
 
 ////////////////////////////////////////////////////////////////////////////////
 std::string const& PipelinePassDescription::name() const { return private_.name_; }
 
 ////////////////////////////////////////////////////////////////////////////////
-unsigned PipelinePassDescription::mod_count() const { return mod_count_; }
+std::size_t PipelinePassDescription::mod_count() const { return mod_count_; }
 
 const std::vector<std::shared_ptr<PipelineResponsibilityDescription>>& PipelinePassDescription::get_responsibilities() const { return pipeline_responsibilities_; }
 
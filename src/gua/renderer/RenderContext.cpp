@@ -29,4 +29,27 @@ namespace gua
 ////////////////////////////////////////////////////////////////////////////////
 
 RenderContext::RenderContext() : context(), display(), render_context(), render_device(), render_window(nullptr), id(0), framecount(0) {}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RenderContext::evict_material_uniform_blocks() const
+{
+    if(framecount % MATERIAL_UNIFORM_BLOCK_LIFETIME != 0)
+    {
+        return;
+    }
+
+    for(auto block(material_uniform_blocks.begin()); block != material_uniform_blocks.end();)
+    {
+        if(framecount - block->second.last_used >= MATERIAL_UNIFORM_BLOCK_LIFETIME)
+        {
+            block = material_uniform_blocks.erase(block);
+        }
+        else
+        {
+            ++block;
+        }
+    }
+}
+
 } // namespace gua
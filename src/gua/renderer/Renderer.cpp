@@ -29,6 +29,7 @@
 #include <gua/platform.hpp>
 #include <gua/scenegraph.hpp>
 #include <gua/renderer/Pipeline.hpp>
+#include <gua/renderer/TriMeshLoader.hpp>
 #include <gua/databases/WindowDatabase.hpp>
 #include <gua/node/CameraNode.hpp>
 #include <gua/utils.hpp>
@@ -86,11 +87,37 @@ std::shared_ptr<const Renderer::SceneGraphs> garbage_collected_copy(std::vector<
     auto sgs = std::make_shared<Renderer::SceneGraphs>();
     for(auto graph : scene_graphs)
     {
-        sgs->push_back(gua::make_unique<SceneGraph>(*graph));
+        auto copy(gua::make_unique<SceneGraph>(*graph));
+        copy->set_enable_serialization_cache(true);
+        sgs->push_back(std::move(copy));
     }
     return sgs;
 }
 
+std::shared_ptr<const Renderer::SceneGraphs> Renderer::make_snapshot(std::vector<SceneGraph const*> const& scene_graphs)
+{
+    if(!enable_snapshot_sharing_)
+    {
+        return garbage_collected_copy(scene_graphs);
+    }
+
+    // snapshot nodes keep the parents they point to alive themselves
+    auto sgs = std::make_shared<Renderer::SceneGraphs>();
+
+    for(auto graph : scene_graphs)
+    {
+        auto snapshot(graph->snapshot());
+        snapshot->set_enable_serialization_cache(true);
+        sgs->push_back(std::move(snapshot));
+    }
+
+    return sgs;
+}
+
+void Renderer::set_enable_snapshot_sharing(bool enable) { enable_snapshot_sharing_ = enable; }
+
+bool Renderer::get_enable_snapshot_sharing() const { return enable_snapshot_sharing_; }
+
 Renderer::~Renderer() { stop(); }
 
 void Renderer::renderclient(Mailbox in, std::string window_name)
@@ -199,6 +226,7 @@ void Renderer::renderclient(Mailbox in, std::string window_name)
                 window->finish_frame();
 
                 ++(window->get_context()->framecount);
+                window->get_context()->evict_material_uniform_blocks();
 
                 fpsc.step();
             }
@@ -228,12 +256,14 @@ void Renderer::send_renderclient(std::string const& window_name, std::shared_ptr
 
 void Renderer::queue_draw(std::vector<SceneGraph const*> const& scene_graphs, bool alternate_frame_rendering)
 {
+    TriMeshLoader::apply_async_loads();
+
     for(auto graph : scene_graphs)
     {
         graph->update_cache();
     }
 
-    auto sgs = garbage_collected_copy(scene_graphs);
+    auto sgs = make_snapshot(scene_graphs);
 
     for(auto graph : scene_graphs)
     {
@@ -256,12 +286,14 @@ void Renderer::queue_draw(std::vector<SceneGraph const*> const& scene_graphs, bo
 
 void Renderer::draw_single_threaded(std::vector<SceneGraph const*> const& scene_graphs)
 {
+    TriMeshLoader::apply_async_loads();
+
     for(auto graph : scene_graphs)
     {
         graph->update_cache();
     }
 
-    auto sgs = garbage_collected_copy(scene_graphs);
+    auto sgs = make_snapshot(scene_graphs);
 
     for(auto graph : scene_graphs)
     {
@@ -351,6 +383,7 @@ void Renderer::draw_single_threaded(std::vector<SceneGraph const*> const& scene_
                     // swap buffers
                     window->finish_frame();
                     ++(window->get_context()->framecount);
+                    window->get_context()->evict_material_uniform_blocks();
                 }
             }
         }
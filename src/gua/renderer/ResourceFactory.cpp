@@ -21,6 +21,7 @@
 
 #include <gua/renderer/ResourceFactory.hpp>
 
+#include <cctype>
 #include <fstream>
 #include <sstream>
 #include <locale>
@@ -107,27 +108,50 @@ std::string ResourceFactory::prepare_shader(std::string const& shader_source, st
 std::string ResourceFactory::resolve_substitutions(std::string const& shader_source, SubstitutionMap const& smap) const
 {
     // TODO: add support for the #line macro if multi-line substitutions are supplied.
-    boost::regex regex("\\@(\\w+)\\@");
-    boost::smatch match;
-    std::string out, s = shader_source;
+    auto is_word = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
 
-    while(boost::regex_search(s, match, regex))
+    std::string out;
+    out.reserve(shader_source.size());
+
+    std::size_t copied(0);
+    std::size_t begin(shader_source.find('@'));
+
+    // replaces each @name@ in a single pass; an @ which does not open a
+    // substitution is kept and may close one
+    while(begin != std::string::npos)
     {
-        std::string subs;
-        auto search = smap.find(match[1]);
+        std::size_t end(begin + 1);
+        while(end < shader_source.size() && is_word(shader_source[end]))
+        {
+            ++end;
+        }
+
+        if(end == begin + 1 || end == shader_source.size() || shader_source[end] != '@')
+        {
+            begin = end < shader_source.size() && shader_source[end] == '@' ? end : shader_source.find('@', end);
+            continue;
+        }
+
+        out.append(shader_source, copied, begin - copied);
+
+        std::string name(shader_source, begin + 1, end - begin - 1);
+        auto search = smap.find(name);
         if(search != smap.end())
         {
-            subs = search->second;
+            out += search->second;
         }
         else
         {
-            Logger::LOG_WARNING << "Option \"" << match[1] << "\" is unknown!" << std::endl;
-            subs = match.str();
+            Logger::LOG_WARNING << "Option \"" << name << "\" is unknown!" << std::endl;
+            out.append(shader_source, begin, end - begin + 1);
         }
-        out += match.prefix().str() + subs;
-        s = match.suffix().str();
+
+        copied = end + 1;
+        begin = shader_source.find('@', copied);
     }
-    return out + s;
+
+    out.append(shader_source, copied, std::string::npos);
+    return out;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -27,6 +27,7 @@
 
 #include <gua/databases/GeometryDatabase.hpp>
 
+#include <gua/concurrent/ThreadPool.hpp>
 #include <gua/node/Node.hpp>
 #include <gua/node/TransformNode.hpp>
 #include <gua/node/LODNode.hpp>
@@ -34,48 +35,55 @@
 #include <gua/scenegraph/SceneGraph.hpp>
 
 // external headers
+#include <algorithm>
+#include <limits>
 #include <stack>
 #include <utility>
+
+namespace
+{
+// subtrees are not deferred below this depth
+const unsigned MAX_SPLIT_DEPTH = 8;
+
+// number of deferred subtrees per thread, for load balancing
+const unsigned SUBTREES_PER_THREAD = 4;
+
+} // namespace
+
 namespace gua
 {
 ////////////////////////////////////////////////////////////////////////////////
 
-Serializer::Serializer() : data_(nullptr), rendering_frustum_(), enable_frustum_culling_(false), enable_alternative_frustum_culling_(false) {}
+Serializer::Serializer() : views_(), active_views_(0), depth_(0), split_depth_(std::numeric_limits<unsigned>::max()), deferred_subtrees_(nullptr) {}
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void Serializer::check(SerializedScene& output, SceneGraph const& scene_graph, Mask const& mask, bool enable_frustum_culling, int view_id)
 {
-    data_ = &output;
-    data_->nodes.clear();
-    data_->bounding_boxes.clear();
-    data_->clipping_planes.clear();
-
-    enable_frustum_culling_ = enable_frustum_culling;
-    enable_alternative_frustum_culling_ = (output.rendering_frustum != output.culling_frustum) && enable_frustum_culling;
+    check(std::vector<View>{{&output, mask, enable_frustum_culling, view_id}}, scene_graph);
+}
 
-    render_mask_ = mask;
-    rendering_frustum_ = output.rendering_frustum;
-    culling_frustum_ = output.culling_frustum;
+////////////////////////////////////////////////////////////////////////////////
 
-    for(auto plane : scene_graph.get_clipping_plane_nodes())
+void Serializer::check(std::vector<View> const& views, SceneGraph const& scene_graph)
+{
+    for(auto begin(views.begin()); begin != views.end();)
     {
-        if(plane->is_visible(view_id) && render_mask_.check(plane->get_tags()))
-        {
-            data_->clipping_planes.push_back(plane->get_component_vector());
-        }
+        auto end(begin + std::min<std::ptrdiff_t>(MAX_VIEWS, views.end() - begin));
+        check_batch(begin, end, scene_graph);
+        begin = end;
     }
-
-    scene_graph.accept(*this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 /* virtual */ void Serializer::visit(node::Node* node)
 {
-    if(is_visible(node))
+    auto visible_views(get_visible_views(node));
+
+    if(visible_views)
     {
-        visit_children(node);
+        visit_children(node, visible_views);
     }
 }
 
@@ -83,19 +91,37 @@ void Serializer::check(SerializedScene& output, SceneGraph const& scene_graph, M
 
 /* virtual */ void Serializer::visit(node::LODNode* node)
 {
-    if(is_visible(node))
+    auto visible_views(get_visible_views(node));
+
+    if(!visible_views)
+    {
+        return;
+    }
+
+    auto const& children(node->get_children());
+    auto const& lod_distances(node->data.get_lod_distances());
+
+    // the selected child depends on the distance to each view's camera
+    unsigned child_indices[MAX_VIEWS];
+
+    for(unsigned v(0); v < views_.size(); ++v)
     {
-        float distance_to_camera(scm::math::length(node->get_world_position() - data_->reference_camera_position));
+        if(!(visible_views & (std::uint64_t(1) << v)))
+        {
+            continue;
+        }
 
         unsigned child_index(0);
 
-        if(!node->data.get_lod_distances().empty())
+        if(!lod_distances.empty())
         {
-            child_index = node->get_children().size();
+            float distance_to_camera(scm::math::length(node->get_world_position() - views_[v].scene->reference_camera_position));
 
-            for(unsigned i(0); i < node->data.get_lod_distances().size(); ++i)
+            child_index = children.size();
+
+            for(unsigned i(0); i < lod_distances.size(); ++i)
             {
-                if(node->data.get_lod_distances()[i] > distance_to_camera)
+                if(lod_distances[i] > distance_to_camera)
                 {
                     child_index = i;
                     break;
@@ -103,9 +129,44 @@ void Serializer::check(SerializedScene& output, SceneGraph const& scene_graph, M
             }
         }
 
-        if(child_index < node->get_children().size())
+        child_indices[v] = child_index;
+    }
+
+    // traverse each selected child once for all views which selected it
+    while(visible_views)
+    {
+        unsigned child_index(children.size());
+        std::uint64_t child_views(0);
+
+        for(unsigned v(0); v < views_.size(); ++v)
+        {
+            std::uint64_t bit(std::uint64_t(1) << v);
+
+            if(visible_views & bit)
+            {
+                if(!child_views)
+                {
+                    child_index = child_indices[v];
+                }
+
+                if(child_indices[v] == child_index)
+                {
+                    child_views |= bit;
+                }
+            }
+        }
+
+        visible_views &= ~child_views;
+
+        if(child_index < children.size())
         {
-            node->get_children()[child_index]->accept(*this);
+            std::uint64_t visible_child_views(0);
+            cull(&children[child_index], 1, child_views, &visible_child_views);
+
+            if(visible_child_views)
+            {
+                traverse(children[child_index].get(), visible_child_views);
+            }
         }
     }
 }
@@ -114,56 +175,296 @@ void Serializer::check(SerializedScene& output, SceneGraph const& scene_graph, M
 
 /* virtual */ void Serializer::visit(node::SerializableNode* node)
 {
-    if(is_visible(node))
+    auto visible_views(get_visible_views(node));
+
+    if(visible_views)
+    {
+        std::type_index type(typeid(*node));
+
+        for(unsigned v(0); v < views_.size(); ++v)
+        {
+            if(visible_views & (std::uint64_t(1) << v))
+            {
+                views_[v].output->nodes[type].push_back(node);
+            }
+        }
+
+        visit_children(node, visible_views);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Serializer::check_batch(std::vector<View>::const_iterator begin, std::vector<View>::const_iterator end, SceneGraph const& scene_graph)
+{
+    views_.clear();
+
+    for(auto view(begin); view != end; ++view)
+    {
+        auto& output(*view->output);
+        output.nodes.clear();
+        output.bounding_boxes.clear();
+        output.clipping_planes.clear();
+
+        for(auto plane : scene_graph.get_clipping_plane_nodes())
+        {
+            if(plane->is_visible(view->view_id) && view->mask.check(plane->get_tags()))
+            {
+                output.clipping_planes.push_back(plane->get_component_vector());
+            }
+        }
+
+        bool enable_alternative_frustum_culling((output.rendering_frustum != output.culling_frustum) && view->enable_frustum_culling);
+        views_.push_back({&output, &output, &view->mask, view->enable_frustum_culling, enable_alternative_frustum_culling});
+    }
+
+    auto const& root(scene_graph.get_root());
+
+    if(!root || views_.empty())
+    {
+        return;
+    }
+
+    std::uint64_t all_views(views_.size() == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << views_.size()) - 1);
+    std::uint64_t root_views(0);
+    cull(&root, 1, all_views, &root_views);
+
+    if(!root_views)
+    {
+        return;
+    }
+
+    // serialize the upper levels of the graph on this thread and collect the
+    // subtrees below
+    std::vector<Subtree> subtrees;
+    deferred_subtrees_ = &subtrees;
+    split_depth_ = get_split_depth(root.get());
+    depth_ = 0;
+
+    traverse(root.get(), root_views);
+
+    deferred_subtrees_ = nullptr;
+
+    if(subtrees.empty())
+    {
+        return;
+    }
+
+    // each subtree is serialized into separate outputs which are appended to
+    // the views' outputs afterwards, in order of traversal
+    std::vector<std::vector<SerializedScene>> subtree_outputs(subtrees.size(), std::vector<SerializedScene>(views_.size()));
+
+    concurrent::ThreadPool::instance()->parallel_for(0, subtrees.size(), [&](std::size_t first, std::size_t last) {
+        Serializer worker;
+        worker.views_ = views_;
+
+        for(std::size_t i(first); i < last; ++i)
+        {
+            for(unsigned v(0); v < views_.size(); ++v)
+            {
+                worker.views_[v].output = &subtree_outputs[i][v];
+            }
+
+            worker.traverse(subtrees[i].node, subtrees[i].views);
+        }
+    });
+
+    for(auto const& outputs : subtree_outputs)
+    {
+        for(unsigned v(0); v < views_.size(); ++v)
+        {
+            auto& output(*views_[v].output);
+
+            for(auto const& nodes : outputs[v].nodes)
+            {
+                auto& target(output.nodes[nodes.first]);
+                target.insert(target.end(), nodes.second.begin(), nodes.second.end());
+            }
+
+            output.bounding_boxes.insert(output.bounding_boxes.end(), outputs[v].bounding_boxes.begin(), outputs[v].bounding_boxes.end());
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned Serializer::get_split_depth(node::Node* root) const
+{
+    // defer subtrees on the first level which is wide enough to keep all
+    // threads busy
+    std::size_t target_width(SUBTREES_PER_THREAD * (concurrent::ThreadPool::instance()->size() + 1));
+
+    std::vector<node::Node*> level{root};
+    std::vector<node::Node*> next_level;
+
+    for(unsigned depth(0); depth <= MAX_SPLIT_DEPTH; ++depth)
     {
-        data_->nodes[std::type_index(typeid(*node))].push_back(node);
+        if(level.size() >= target_width)
+        {
+            return depth;
+        }
+
+        next_level.clear();
+
+        for(auto node : level)
+        {
+            for(auto const& child : node->children_)
+            {
+                next_level.push_back(child.get());
+            }
+        }
+
+        // the graph is too small to be worth distributing
+        if(next_level.empty())
+        {
+            return std::numeric_limits<unsigned>::max();
+        }
 
-        visit_children(node);
+        std::swap(level, next_level);
     }
+
+    return MAX_SPLIT_DEPTH;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool Serializer::is_visible(node::Node* node) const
+void Serializer::cull(std::shared_ptr<node::Node> const* nodes, std::size_t count, std::uint64_t views, std::uint64_t* visible_views)
 {
-    bool is_visible(true);
+    boxes_.clear();
+    has_boxes_.clear();
+
+    for(std::size_t i(0); i < count; ++i)
+    {
+        boxes_.push_back(nodes[i]->get_bounding_box());
+        has_boxes_.push_back(boxes_.back() != math::BoundingBox<math::vec3>());
+        visible_views[i] = 0;
+    }
+
+    rendering_results_.resize(count);
+    culling_results_.resize(count);
 
-    // check whether bounding box is (partially) within frustum
-    if(enable_frustum_culling_)
+    for(unsigned v(0); v < views_.size(); ++v)
     {
-        auto bbox(node->get_bounding_box());
-        if(bbox != math::BoundingBox<math::vec3>())
+        std::uint64_t bit(std::uint64_t(1) << v);
+
+        if(!(views & bit))
+        {
+            continue;
+        }
+
+        auto const& view(views_[v]);
+
+        if(!view.enable_frustum_culling)
         {
-            is_visible = rendering_frustum_.intersects(bbox, data_->clipping_planes);
+            for(std::size_t i(0); i < count; ++i)
+            {
+                visible_views[i] |= bit;
+            }
+
+            continue;
+        }
+
+        // check whether bounding boxes are (partially) within frustum
+        view.scene->rendering_frustum.intersects(boxes_.data(), count, view.scene->clipping_planes, rendering_results_.data());
 
-            if(is_visible && enable_alternative_frustum_culling_)
+        if(view.enable_alternative_frustum_culling)
+        {
+            view.scene->culling_frustum.intersects(boxes_.data(), count, {}, culling_results_.data());
+        }
+
+        for(std::size_t i(0); i < count; ++i)
+        {
+            bool is_visible(rendering_results_[i] && (!view.enable_alternative_frustum_culling || culling_results_[i]));
+
+            // nodes without bounding box are never culled
+            if(is_visible || !has_boxes_[i])
             {
-                is_visible = culling_frustum_.intersects(bbox);
+                visible_views[i] |= bit;
             }
         }
     }
+}
 
-    // check whether mask allows rendering
-    if(is_visible)
+////////////////////////////////////////////////////////////////////////////////
+
+std::uint64_t Serializer::get_visible_views(node::Node* node) const
+{
+    std::uint64_t visible_views(0);
+
+    for(unsigned v(0); v < views_.size(); ++v)
     {
-        is_visible = render_mask_.check(node->get_tags());
+        std::uint64_t bit(std::uint64_t(1) << v);
+
+        // frustum culling has been done by cull() already, check whether mask
+        // allows rendering
+        if(!(active_views_ & bit) || !views_[v].mask->check(node->get_tags()))
+        {
+            continue;
+        }
+
+        visible_views |= bit;
+
+        if(node->get_draw_bounding_box())
+        {
+            views_[v].output->bounding_boxes.push_back(node->get_bounding_box());
+        }
     }
 
-    if(is_visible && node->get_draw_bounding_box())
+    return visible_views;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Serializer::traverse(node::Node* node, std::uint64_t views)
+{
+    if(deferred_subtrees_ && depth_ >= split_depth_)
     {
-        data_->bounding_boxes.push_back(node->get_bounding_box());
+        deferred_subtrees_->push_back({node, views});
+        return;
     }
 
-    return is_visible;
+    auto parent_views(active_views_);
+    active_views_ = views;
+    ++depth_;
+
+    node->accept(*this);
+
+    --depth_;
+    active_views_ = parent_views;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Serializer::visit_children(node::Node* node)
+void Serializer::visit_children(node::Node* node, std::uint64_t views)
 {
-    for(auto& c : node->children_)
+    auto const& children(node->children_);
+
+    if(children.empty())
+    {
+        return;
+    }
+
+    // cull all children at once; the results are kept per depth, as they are
+    // needed while traversing the children. child_views_ may grow during the
+    // traversal, hence it is indexed anew for each child
+    auto depth(depth_);
+
+    if(child_views_.size() <= depth)
+    {
+        child_views_.resize(depth + 1);
+    }
+
+    child_views_[depth].resize(children.size());
+    cull(children.data(), children.size(), views, child_views_[depth].data());
+
+    for(std::size_t i(0); i < children.size(); ++i)
     {
-        c->accept(*this);
+        auto visible_views(child_views_[depth][i]);
+
+        if(visible_views)
+        {
+            traverse(children[i].get(), visible_views);
+        }
     }
 }
 
@@ -28,6 +28,9 @@
 #include <gua/renderer/Uniform.hpp>
 #include <gua/utils/Logger.hpp>
 
+// external headers
+#include <boost/functional/hash.hpp>
+
 namespace gua
 {
 ////////////////////////////////////////////////////////////////////////////////
@@ -131,13 +134,43 @@ bool ShaderProgram::upload_to(RenderContext const& context) const
 {
     if(!program_ || dirty_)
     {
-        std::list<scm::gl::shader_ptr> shaders;
         ResourceFactory factory;
+        RenderContext::CachedShaderProgram entry;
+        std::size_t key(in_rasterization_discard_);
 
         for(auto const& s : stages_)
         {
-            auto source = factory.resolve_substitutions(s.source, substitutions_);
-            shaders.push_back(context.render_device->create_shader(s.type, source));
+            entry.sources.emplace_back(s.type, factory.resolve_substitutions(s.source, substitutions_));
+            boost::hash_combine(key, int(s.type));
+            boost::hash_combine(key, entry.sources.back().second);
+        }
+
+        for(auto const& k : interleaved_stream_capture_)
+        {
+            boost::hash_combine(key, k);
+        }
+
+        entry.interleaved_stream_capture = interleaved_stream_capture_;
+        entry.in_rasterization_discard = in_rasterization_discard_;
+
+        dirty_ = false;
+
+        // programs with identical sources are linked once per context. The
+        // sources are compared as well, a colliding hash must not select a
+        // different program
+        auto cached(context.shader_programs.find(key));
+        if(cached != context.shader_programs.end() && cached->second.sources == entry.sources &&
+           cached->second.interleaved_stream_capture == entry.interleaved_stream_capture && cached->second.in_rasterization_discard == entry.in_rasterization_discard)
+        {
+            program_ = cached->second.program;
+            return true;
+        }
+
+        std::list<scm::gl::shader_ptr> shaders;
+
+        for(auto const& source : entry.sources)
+        {
+            shaders.push_back(context.render_device->create_shader(source.first, source.second));
         }
 
         if(interleaved_stream_capture_.empty())
@@ -153,13 +186,14 @@ bool ShaderProgram::upload_to(RenderContext const& context) const
             program_ = context.render_device->create_program(shaders, capture_array, in_rasterization_discard_);
         }
 
-        dirty_ = false;
-
         if(!program_)
         {
             Logger::LOG_WARNING << "Failed to create shaders!" << std::endl;
             return false;
         }
+
+        entry.program = program_;
+        context.shader_programs[key] = std::move(entry);
     }
 
     return true;
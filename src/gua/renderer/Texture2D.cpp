@@ -24,6 +24,7 @@
 
 // guacamole headers
 #include <gua/platform.hpp>
+#include <gua/renderer/TextureCache.hpp>
 #include <gua/utils/Logger.hpp>
 #include <gua/math/math.hpp>
 
@@ -84,7 +85,9 @@ void Texture2D::upload_to(RenderContext const& context) const
     }
 }
 
-scm::gl::texture_image_data_ptr load_image_2d(std::string const& filename, bool create_mips)
+namespace
+{
+scm::gl::texture_image_data_ptr decode_image_2d(std::string const& filename, bool create_mips)
 {
     scm::scoped_ptr<fipImage> in_image(new fipImage);
 
@@ -226,4 +229,48 @@ scm::gl::texture_image_data_ptr load_image_2d(std::string const& filename, bool
 
     return boost::make_shared<scm::gl::texture_image_data>(scm::gl::texture_image_data::ORIGIN_LOWER_LEFT, format, mip_vec);
 }
+} // namespace
+
+scm::gl::texture_image_data_ptr load_image_2d(std::string const& filename, bool create_mips)
+{
+    if(!TextureCache::get_enabled())
+    {
+        return decode_image_2d(filename, create_mips);
+    }
+
+    auto image(TextureCache::read(filename, create_mips));
+
+    if(!image)
+    {
+        image = decode_image_2d(filename, create_mips);
+
+        if(image)
+        {
+            image = TextureCache::compress(image);
+            TextureCache::write(filename, create_mips, image);
+        }
+    }
+
+    return image;
+}
+
+std::size_t estimate_image_2d_size(std::string const& filename, bool create_mips)
+{
+#ifdef FIF_LOAD_NOPIXELS
+    // only the header is read
+    fipImage image;
+
+    if(!image.load(filename.c_str(), FIF_LOAD_NOPIXELS))
+    {
+        return 0;
+    }
+
+    std::size_t level_size(std::size_t(image.getWidth()) * image.getHeight() * image.getBitsPerPixel() / 8);
+
+    // the mip levels add up to a third of the first level
+    return create_mips ? level_size + level_size / 3 + 1 : level_size;
+#else
+    return 0;
+#endif
+}
 } // namespace gua
@@ -0,0 +1,632 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+// class header
+#include <gua/renderer/TextureCache.hpp>
+
+// guacamole headers
+#include <gua/concurrent/ThreadPool.hpp>
+#include <gua/math/math.hpp>
+#include <gua/utils/Logger.hpp>
+#include <gua/utils/string_utils.hpp>
+
+// external headers
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/make_shared.hpp>
+#include <scm/gl_core/data_formats.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace gua
+{
+namespace
+{
+// increase whenever the layout of cache files or the encoder changes
+const std::uint32_t VERSION = 1;
+const char MAGIC[8] = {'G', 'U', 'A', 'T', 'E', 'X', '\0', '\0'};
+
+// block rows per task of the encoder
+const std::size_t GRAIN_SIZE = 4;
+
+struct FileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t format; // scm::gl::data_format
+    std::uint32_t level_count;
+    std::uint32_t padding;
+    std::uint64_t source_size;
+    std::int64_t source_time;
+};
+
+// followed by the level's data, padded to a multiple of four bytes
+struct LevelHeader
+{
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint64_t size;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool get_source_stats(std::string const& file_name, std::uint64_t& size, std::int64_t& time)
+{
+    boost::system::error_code error;
+
+    size = boost::filesystem::file_size(file_name, error);
+    if(error)
+    {
+        return false;
+    }
+
+    time = boost::filesystem::last_write_time(file_name, error);
+    return !error;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t level_size(scm::gl::data_format format, unsigned width, unsigned height)
+{
+    if(scm::gl::is_compressed_format(format))
+    {
+        return std::size_t((width + 3) / 4) * ((height + 3) / 4) * scm::gl::bit_per_pixel(format) * 16 / 8;
+    }
+
+    return std::size_t(width) * height * scm::gl::size_of_format(format);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// 4x4 pixels with four 8 bit channels (red, green, blue, alpha)
+struct Block
+{
+    std::uint8_t pixels[16][4];
+};
+
+// reads a block from an image with the given channel order; pixels outside
+// of the image repeat the last row and column
+void extract_block(std::uint8_t const* data, unsigned width, unsigned height, unsigned x, unsigned y, unsigned channels, int const* order, Block& block)
+{
+    for(unsigned i(0); i < 16; ++i)
+    {
+        unsigned px(std::min(x + i % 4, width - 1));
+        unsigned py(std::min(y + i / 4, height - 1));
+        auto pixel(data + (std::size_t(py) * width + px) * channels);
+
+        for(int c(0); c < 4; ++c)
+        {
+            block.pixels[i][c] = order[c] < 0 ? 255 : pixel[order[c]];
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::uint16_t to_565(float const* color)
+{
+    auto quantize = [](float value, int max) { return std::min(max, std::max(0, int(value * max / 255.f + 0.5f))); };
+    return std::uint16_t((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void from_565(std::uint16_t color, int* rgb)
+{
+    rgb[0] = ((color >> 11) & 31) * 255 / 31;
+    rgb[1] = ((color >> 5) & 63) * 255 / 63;
+    rgb[2] = (color & 31) * 255 / 31;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// endpoints are the extremes of the colors along their principal axis
+void encode_color_block(Block const& block, std::uint8_t* target)
+{
+    float mean[3] = {0.f, 0.f, 0.f};
+
+    for(auto const& pixel : block.pixels)
+    {
+        for(int c(0); c < 3; ++c)
+        {
+            mean[c] += pixel[c] / 16.f;
+        }
+    }
+
+    float covariance[6] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+
+    for(auto const& pixel : block.pixels)
+    {
+        float d[3] = {pixel[0] - mean[0], pixel[1] - mean[1], pixel[2] - mean[2]};
+        covariance[0] += d[0] * d[0];
+        covariance[1] += d[0] * d[1];
+        covariance[2] += d[0] * d[2];
+        covariance[3] += d[1] * d[1];
+        covariance[4] += d[1] * d[2];
+        covariance[5] += d[2] * d[2];
+    }
+
+    // power iteration
+    float axis[3] = {1.f, 1.f, 1.f};
+
+    for(int i(0); i < 4; ++i)
+    {
+        float next[3] = {covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                         covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                         covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]};
+
+        float length(std::max(std::abs(next[0]), std::max(std::abs(next[1]), std::abs(next[2]))));
+
+        if(length == 0.f)
+        {
+            break;
+        }
+
+        for(int c(0); c < 3; ++c)
+        {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float min_projection(0.f), max_projection(0.f);
+    int min_pixel(0), max_pixel(0);
+
+    for(int i(0); i < 16; ++i)
+    {
+        float projection((block.pixels[i][0] - mean[0]) * axis[0] + (block.pixels[i][1] - mean[1]) * axis[1] + (block.pixels[i][2] - mean[2]) * axis[2]);
+
+        if(i == 0 || projection < min_projection)
+        {
+            min_projection = projection;
+            min_pixel = i;
+        }
+        if(i == 0 || projection > max_projection)
+        {
+            max_projection = projection;
+            max_pixel = i;
+        }
+    }
+
+    float endpoints[2][3];
+    for(int c(0); c < 3; ++c)
+    {
+        endpoints[0][c] = block.pixels[max_pixel][c];
+        endpoints[1][c] = block.pixels[min_pixel][c];
+    }
+
+    std::uint16_t color0(to_565(endpoints[0]));
+    std::uint16_t color1(to_565(endpoints[1]));
+
+    // four color mode requires color0 > color1
+    if(color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    std::uint32_t indices(0);
+
+    if(color0 != color1)
+    {
+        int palette[4][3];
+        from_565(color0, palette[0]);
+        from_565(color1, palette[1]);
+
+        for(int c(0); c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for(int i(0); i < 16; ++i)
+        {
+            int best(0), best_distance(0);
+
+            for(int p(0); p < 4; ++p)
+            {
+                int distance(0);
+                for(int c(0); c < 3; ++c)
+                {
+                    int d(block.pixels[i][c] - palette[p][c]);
+                    distance += d * d;
+                }
+
+                if(p == 0 || distance < best_distance)
+                {
+                    best = p;
+                    best_distance = distance;
+                }
+            }
+
+            indices |= std::uint32_t(best) << (2 * i);
+        }
+    }
+
+    std::memcpy(target, &color0, 2);
+    std::memcpy(target + 2, &color1, 2);
+    std::memcpy(target + 4, &indices, 4);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// encodes one channel in eight value mode
+void encode_single_channel_block(Block const& block, int channel, std::uint8_t* target)
+{
+    int min_value(255), max_value(0);
+
+    for(auto const& pixel : block.pixels)
+    {
+        min_value = std::min(min_value, int(pixel[channel]));
+        max_value = std::max(max_value, int(pixel[channel]));
+    }
+
+    std::uint64_t indices(0);
+
+    if(max_value != min_value)
+    {
+        int palette[8] = {max_value, min_value};
+        for(int p(1); p < 7; ++p)
+        {
+            palette[p + 1] = ((7 - p) * max_value + p * min_value) / 7;
+        }
+
+        for(int i(0); i < 16; ++i)
+        {
+            int best(0), best_distance(256);
+
+            for(int p(0); p < 8; ++p)
+            {
+                int distance(std::abs(block.pixels[i][channel] - palette[p]));
+                if(distance < best_distance)
+                {
+                    best = p;
+                    best_distance = distance;
+                }
+            }
+
+            indices |= std::uint64_t(best) << (3 * i);
+        }
+    }
+
+    target[0] = std::uint8_t(max_value);
+    target[1] = std::uint8_t(min_value);
+
+    for(int i(0); i < 6; ++i)
+    {
+        target[2 + i] = std::uint8_t(indices >> (8 * i));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool has_alpha(scm::gl::texture_image_data_ptr const& image)
+{
+    auto const& level(image->mip_level(0));
+    auto data(level.data().get());
+    std::size_t count(std::size_t(level.size().x) * level.size().y);
+
+    for(std::size_t i(0); i < count; ++i)
+    {
+        if(data[i * 4 + 3] != 255)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TextureCache::enabled_ = false;
+std::string TextureCache::directory_ = "";
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::set_enabled(bool enabled) { enabled_ = enabled; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TextureCache::get_enabled() { return enabled_; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TextureCache::set_directory(std::string const& directory) { directory_ = directory; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string const& TextureCache::get_directory() { return directory_; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string TextureCache::get_cache_file(std::string const& file_name, bool create_mips)
+{
+    std::string suffix(create_mips ? ".mip.gtc" : ".gtc");
+
+    if(directory_.empty())
+    {
+        return file_name + suffix;
+    }
+
+    // files of the same name in different directories must not collide
+    boost::filesystem::path path(file_name);
+    auto path_hash(std::hash<std::string>()(boost::filesystem::absolute(path).string()));
+
+    return (boost::filesystem::path(directory_) / (path.filename().string() + "." + string_utils::to_string(path_hash) + suffix)).string();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+scm::gl::texture_image_data_ptr TextureCache::read(std::string const& file_name, bool create_mips)
+{
+    auto cache_file(get_cache_file(file_name, create_mips));
+
+    std::uint64_t source_size;
+    std::int64_t source_time;
+
+    if(!get_source_stats(file_name, source_size, source_time) || !boost::filesystem::exists(cache_file))
+    {
+        return nullptr;
+    }
+
+    // the mapping stays alive as long as one of the levels refers to it
+    std::shared_ptr<boost::interprocess::mapped_region> region;
+
+    try
+    {
+        boost::interprocess::file_mapping mapping(cache_file.c_str(), boost::interprocess::read_only);
+        region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    }
+    catch(boost::interprocess::interprocess_exception const& e)
+    {
+        Logger::LOG_WARNING << "TextureCache::read(): Unable to map " << cache_file << ": " << e.what() << std::endl;
+        return nullptr;
+    }
+
+    auto position(static_cast<char const*>(region->get_address()));
+    auto end(position + region->get_size());
+
+    FileHeader header;
+
+    if(std::size_t(end - position) < sizeof(FileHeader))
+    {
+        return nullptr;
+    }
+
+    std::memcpy(&header, position, sizeof(FileHeader));
+    position += sizeof(FileHeader);
+
+    if(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.source_size != source_size || header.source_time != source_time || header.level_count == 0)
+    {
+        return nullptr;
+    }
+
+    auto format(scm::gl::data_format(header.format));
+    scm::gl::texture_image_data::level_vector levels;
+
+    for(std::uint32_t i(0); i < header.level_count; ++i)
+    {
+        LevelHeader level;
+
+        if(std::size_t(end - position) < sizeof(LevelHeader))
+        {
+            return nullptr;
+        }
+
+        std::memcpy(&level, position, sizeof(LevelHeader));
+        position += sizeof(LevelHeader);
+
+        std::size_t padded_size(level.size + (4 - level.size % 4) % 4);
+
+        if(level.size != level_size(format, level.width, level.height) || std::size_t(end - position) < padded_size)
+        {
+            return nullptr;
+        }
+
+        // the data is only read when it is uploaded
+        auto data(reinterpret_cast<unsigned char*>(const_cast<char*>(position)));
+        levels.push_back({math::vec2ui(level.width, level.height), scm::shared_array<unsigned char>(data, [region](unsigned char*) {})});
+
+        position += padded_size;
+    }
+
+    return boost::make_shared<scm::gl::texture_image_data>(scm::gl::texture_image_data::ORIGIN_LOWER_LEFT, format, levels);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TextureCache::write(std::string const& file_name, bool create_mips, scm::gl::texture_image_data_ptr const& image)
+{
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.format = std::uint32_t(image->format());
+    header.padding = 0;
+    header.level_count = std::uint32_t(image->mip_level_count());
+
+    if(!get_source_stats(file_name, header.source_size, header.source_time))
+    {
+        return false;
+    }
+
+    auto cache_file(get_cache_file(file_name, create_mips));
+
+    // concurrent readers never see an incomplete file, and the random name
+    // keeps concurrent writers of the same image, also in other processes,
+    // from writing into the same temporary file
+    auto temporary_file(boost::filesystem::unique_path(cache_file + ".%%%%-%%%%-%%%%-%%%%.tmp").string());
+
+    {
+        std::ofstream file(temporary_file, std::ios::binary);
+
+        if(!file)
+        {
+            Logger::LOG_WARNING << "TextureCache::write(): Unable to write " << cache_file << std::endl;
+            return false;
+        }
+
+        file.write(reinterpret_cast<char const*>(&header), sizeof(FileHeader));
+
+        for(std::uint32_t i(0); i < header.level_count; ++i)
+        {
+            auto const& level(image->mip_level(i));
+
+            LevelHeader level_header;
+            level_header.width = level.size().x;
+            level_header.height = level.size().y;
+            level_header.size = level_size(image->format(), level_header.width, level_header.height);
+
+            char const padding[4] = {0, 0, 0, 0};
+
+            file.write(reinterpret_cast<char const*>(&level_header), sizeof(LevelHeader));
+            file.write(reinterpret_cast<char const*>(level.data().get()), level_header.size);
+            file.write(padding, (4 - level_header.size % 4) % 4);
+        }
+
+        if(!file)
+        {
+            Logger::LOG_WARNING << "TextureCache::write(): Unable to write " << cache_file << std::endl;
+            file.close();
+            boost::system::error_code error;
+            boost::filesystem::remove(temporary_file, error);
+            return false;
+        }
+    }
+
+    boost::system::error_code error;
+    boost::filesystem::rename(temporary_file, cache_file, error);
+
+    if(error)
+    {
+        boost::filesystem::remove(temporary_file, error);
+        return false;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+scm::gl::texture_image_data_ptr TextureCache::compress(scm::gl::texture_image_data_ptr const& image)
+{
+    // source channels of red, green, blue and alpha, -1 for opaque
+    int order[4] = {-1, -1, -1, -1};
+    unsigned channels(0);
+    scm::gl::data_format format(scm::gl::FORMAT_NULL);
+
+    switch(image->format())
+    {
+    case scm::gl::FORMAT_R_8:
+        channels = 1;
+        order[0] = 0;
+        format = scm::gl::FORMAT_BC4_R;
+        break;
+    case scm::gl::FORMAT_RG_8:
+        channels = 2;
+        order[0] = 0;
+        order[1] = 1;
+        format = scm::gl::FORMAT_BC5_RG;
+        break;
+    case scm::gl::FORMAT_BGR_8:
+        channels = 3;
+        order[0] = 2;
+        order[1] = 1;
+        order[2] = 0;
+        format = scm::gl::FORMAT_BC1_RGBA;
+        break;
+    case scm::gl::FORMAT_BGRA_8:
+        channels = 4;
+        order[0] = 2;
+        order[1] = 1;
+        order[2] = 0;
+        order[3] = 3;
+        format = has_alpha(image) ? scm::gl::FORMAT_BC3_RGBA : scm::gl::FORMAT_BC1_RGBA;
+        break;
+    default:
+        return image;
+    }
+
+    std::size_t const block_size(scm::gl::bit_per_pixel(format) * 16 / 8);
+    auto pool(concurrent::ThreadPool::instance());
+    scm::gl::texture_image_data::level_vector levels;
+
+    for(unsigned i(0); i < image->mip_level_count(); ++i)
+    {
+        auto const& level(image->mip_level(i));
+        unsigned const width(level.size().x);
+        unsigned const height(level.size().y);
+        unsigned const blocks_x((width + 3) / 4);
+        unsigned const blocks_y((height + 3) / 4);
+
+        auto source(level.data().get());
+        scm::shared_array<unsigned char> data(new unsigned char[level_size(format, width, height)]);
+        auto target(data.get());
+
+        pool->parallel_for(0,
+                           blocks_y,
+                           [&](std::size_t begin, std::size_t end) {
+                               Block block;
+
+                               for(std::size_t y(begin); y < end; ++y)
+                               {
+                                   for(unsigned x(0); x < blocks_x; ++x)
+                                   {
+                                       extract_block(source, width, height, x * 4, unsigned(y) * 4, channels, order, block);
+                                       auto block_target(target + (y * blocks_x + x) * block_size);
+
+                                       switch(format)
+                                       {
+                                       case scm::gl::FORMAT_BC1_RGBA:
+                                           encode_color_block(block, block_target);
+                                           break;
+                                       case scm::gl::FORMAT_BC3_RGBA:
+                                           encode_single_channel_block(block, 3, block_target);
+                                           encode_color_block(block, block_target + 8);
+                                           break;
+                                       case scm::gl::FORMAT_BC4_R:
+                                           encode_single_channel_block(block, 0, block_target);
+                                           break;
+                                       default:
+                                           encode_single_channel_block(block, 0, block_target);
+                                           encode_single_channel_block(block, 1, block_target + 8);
+                                           break;
+                                       }
+                                   }
+                               }
+                           },
+                           GRAIN_SIZE);
+
+        levels.push_back({math::vec2ui(width, height), data});
+    }
+
+    return boost::make_shared<scm::gl::texture_image_data>(scm::gl::texture_image_data::ORIGIN_LOWER_LEFT, format, levels);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace gua
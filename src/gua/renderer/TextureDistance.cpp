@@ -26,46 +26,204 @@
 #include <gua/platform.hpp>
 #include <gua/utils/Logger.hpp>
 #include <gua/math/math.hpp>
+#include <gua/concurrent/ThreadPool.hpp>
 
 // external headers
 #include <scm/gl_util/data/imaging/texture_loader.h>
+#include <scm/gl_core/render_device/opengl/gl_core.h>
+#include <algorithm>
 #include <iostream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GUA_TEXTURE_DISTANCE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+// minimum number of texels converted by one task
+const std::size_t TEXELS_PER_TASK = 16384;
+
+// upper bound for waiting on a download, in nanoseconds
+const GLuint64 READBACK_TIMEOUT = 1000000000;
+
+} // namespace
+
 namespace gua
 {
-TextureDistance::TextureDistance(unsigned width, unsigned height, scm::gl::data_format color_format, unsigned mipmap_layers, scm::gl::sampler_state_desc const& state_descripton)
-    : Texture2D(width, height, color_format, mipmap_layers, state_descripton)
+TextureDistance::TextureDistance(
+    unsigned width, unsigned height, scm::gl::data_format color_format, unsigned mipmap_layers, scm::gl::sampler_state_desc const& state_descripton, unsigned readback_buffers)
+    : Texture2D(width, height, color_format, mipmap_layers, state_descripton), readbacks_(std::max(readback_buffers, 1u))
 {
     int pixel_size = height_ * width_ * 6;
-    int byte_size = pixel_size * sizeof(uint32_t);
-    texture_data_ = (uint32_t*)malloc(byte_size);
     world_depth_data_ = std::vector<float>(pixel_size, -1.0f);
+    converted_data_ = world_depth_data_;
+
+    // the faces are square (height = width/6) with the screen at a distance
+    // of 0.5, so the distance is the linear depth times the ray length
+    ray_lengths_.resize(height_ * height_);
+    for(unsigned y = 0; y < height_; ++y)
+    {
+        for(unsigned x = 0; x < height_; ++x)
+        {
+            float x_s = (float(x) / height_) - 0.5;
+            float y_s = (float(y) / height_) - 0.5;
+            ray_lengths_[y * height_ + x] = std::sqrt(x_s * x_s + y_s * y_s + 0.25f);
+        }
+    }
 }
 
 void TextureDistance::download_data(RenderContext const& ctx, float near_clip, float far_clip)
 {
-    ctx.render_context->retrieve_texture_data(get_buffer(ctx), 0, texture_data_);
-    unsigned size = height_ * width_;
-    for(int texel = 0; texel < size; ++texel)
+    auto const& glapi = ctx.render_context->opengl_api();
+    auto& readback(readbacks_[next_readback_]);
+
+    // all buffers are in flight, the oldest one has to be finished first
+    if(readback.fence)
+    {
+        glapi.glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, READBACK_TIMEOUT);
+        convert(ctx, readback);
+        waited_for_readback_ = true;
+    }
+
+    if(!readback.buffer)
+    {
+        readback.buffer = ctx.render_device->create_buffer(scm::gl::BIND_STORAGE_BUFFER, scm::gl::USAGE_STREAM_READ, width_ * height_ * sizeof(uint32_t));
+    }
+
+    glapi.glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer->object_id());
+    glapi.glGetTextureImageEXT(get_buffer(ctx)->object_id(), GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    glapi.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.fence = glapi.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.near_clip = near_clip;
+    readback.far_clip = far_clip;
+
+    next_readback_ = (next_readback_ + 1) % readbacks_.size();
+}
+
+bool TextureDistance::fetch_data(RenderContext const& ctx)
+{
+    auto const& glapi = ctx.render_context->opengl_api();
+
+    bool updated(waited_for_readback_);
+    waited_for_readback_ = false;
+
+    // from the oldest to the newest download, only the newest finished one is converted
+    Readback* newest(nullptr);
+    for(unsigned i = 0; i < readbacks_.size(); ++i)
     {
-        if(texture_data_[texel] == 0xFFFFFFFF)
+        auto& readback(readbacks_[(next_readback_ + i) % readbacks_.size()]);
+
+        if(!readback.fence)
         {
-            world_depth_data_[texel] = -1.0;
+            continue;
         }
-        else
+
+        GLenum status(glapi.glClientWaitSync(readback.fence, 0, 0));
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
         {
-            float x = (float(texel % height_) / height_) - 0.5; // height = width/6
-            float y = (float(texel / width_) / height_) - 0.5;
-            float z = (float)texture_data_[texel] / 4294967295.0;
+            break;
+        }
 
-            float z_n = 2.0 * near_clip * far_clip / (far_clip + near_clip - z * (far_clip - near_clip));
-            float x_n = x * z_n / 0.5;
-            float y_n = y * z_n / 0.5;
+        if(newest)
+        {
+            glapi.glDeleteSync(newest->fence);
+            newest->fence = nullptr;
+        }
+        newest = &readback;
+    }
 
-            float distance = std::sqrt((x_n * x_n) + (y_n * y_n) + (z_n * z_n)) * 0.5;
-            world_depth_data_[texel] = distance;
+    if(newest)
+    {
+        convert(ctx, *newest);
+        updated = true;
+    }
+
+    return updated;
+}
+
+void TextureDistance::remove_readback_buffers(RenderContext const& ctx)
+{
+    auto const& glapi = ctx.render_context->opengl_api();
+
+    for(auto& readback : readbacks_)
+    {
+        if(readback.fence)
+        {
+            glapi.glDeleteSync(readback.fence);
         }
+        readback = Readback();
     }
+
+    next_readback_ = 0;
+    waited_for_readback_ = false;
+}
+
+void TextureDistance::convert(RenderContext const& ctx, Readback& readback)
+{
+    ctx.render_context->opengl_api().glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    auto texture_data = static_cast<const uint32_t*>(ctx.render_context->map_buffer(readback.buffer, scm::gl::ACCESS_READ_ONLY));
+    if(!texture_data)
+    {
+        Logger::LOG_WARNING << "TextureDistance::convert(): Unable to map readback buffer." << std::endl;
+        return;
+    }
+
+    // linear depth is a / (b - texel * c)
+    const float near_clip(readback.near_clip), far_clip(readback.far_clip);
+    const float a(2.0 * near_clip * far_clip);
+    const float b(far_clip + near_clip);
+    const float c((far_clip - near_clip) / 4294967295.0);
+
+    float* distances(converted_data_.data());
+    const float* ray_lengths(ray_lengths_.data());
+    const unsigned width(width_), height(height_);
+
+    auto convert_rows = [=](std::size_t begin, std::size_t end) {
+        for(std::size_t y = begin; y < end; ++y)
+        {
+            for(unsigned face = 0; face < 6; ++face)
+            {
+                const uint32_t* src(texture_data + y * width + face * height);
+                float* dst(distances + y * width + face * height);
+                const float* lengths(ray_lengths + y * height);
+                unsigned x = 0;
+
+#if defined(GUA_TEXTURE_DISTANCE_SSE2)
+                const __m128i far_plane(_mm_set1_epi32(-1));
+                const __m128i low_mask(_mm_set1_epi32(0xFFFF));
+                const __m128 a4(_mm_set1_ps(a)), b4(_mm_set1_ps(b)), c4(_mm_set1_ps(c));
+                const __m128 no_hit(_mm_set1_ps(-1.f)), high_scale(_mm_set1_ps(65536.f));
+
+                for(; x + 4 <= height; x += 4)
+                {
+                    const __m128i texels(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)));
+
+                    // unsigned to float, the halves convert exactly
+                    const __m128 depth(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(texels, 16)), high_scale), _mm_cvtepi32_ps(_mm_and_si128(texels, low_mask))));
+                    const __m128 distance(_mm_mul_ps(_mm_div_ps(a4, _mm_sub_ps(b4, _mm_mul_ps(depth, c4))), _mm_loadu_ps(lengths + x)));
+                    const __m128 cleared(_mm_castsi128_ps(_mm_cmpeq_epi32(texels, far_plane)));
+
+                    _mm_storeu_ps(dst + x, _mm_or_ps(_mm_and_ps(cleared, no_hit), _mm_andnot_ps(cleared, distance)));
+                }
+#endif
+
+                for(; x < height; ++x)
+                {
+                    dst[x] = src[x] == 0xFFFFFFFF ? -1.0f : a / (b - float(src[x]) * c) * lengths[x];
+                }
+            }
+        }
+    };
+
+    concurrent::ThreadPool::instance()->parallel_for(0, height, convert_rows, std::max<std::size_t>(1, TEXELS_PER_TASK / width));
+
+    ctx.render_context->unmap_buffer(readback.buffer);
+
+    world_depth_data_.swap(converted_data_);
 }
 
 std::vector<float> const& TextureDistance::get_data()
@@ -0,0 +1,635 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+// class header
+#include <gua/renderer/TriMeshCache.hpp>
+
+// guacamole headers
+#include <gua/concurrent/ThreadPool.hpp>
+#include <gua/databases/GeometryDatabase.hpp>
+#include <gua/databases/GeometryDescription.hpp>
+#include <gua/databases/MaterialShaderDatabase.hpp>
+#include <gua/databases/TextureDatabase.hpp>
+#include <gua/node/TransformNode.hpp>
+#include <gua/node/TriMeshNode.hpp>
+#include <gua/renderer/Material.hpp>
+#include <gua/renderer/PBSMaterialFactory.hpp>
+#include <gua/renderer/TriMeshLoader.hpp>
+#include <gua/renderer/TriMeshRessource.hpp>
+#include <gua/utils/Logger.hpp>
+#include <gua/utils/string_utils.hpp>
+
+// external headers
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace gua
+{
+namespace
+{
+// increase whenever the layout of cache files changes
+const std::uint32_t VERSION = 2;
+const char MAGIC[8] = {'G', 'U', 'A', 'M', 'E', 'S', 'H', '\0'};
+
+// flags which influence the cached data
+const unsigned CACHED_FLAGS = TriMeshLoader::LOAD_MATERIALS | TriMeshLoader::OPTIMIZE_GEOMETRY | TriMeshLoader::MAKE_PICKABLE | TriMeshLoader::OPTIMIZE_MATERIALS | TriMeshLoader::PARSE_HIERARCHY |
+                              TriMeshLoader::NO_BITANGENTS | TriMeshLoader::NO_TANGENTS;
+
+// All records have a size divisible by four, so that the vertex and index
+// data can be used in place.
+struct FileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t source_size;
+    std::int64_t source_time;
+    std::uint32_t mesh_count;
+    std::uint32_t material_count;
+    std::uint32_t node_count;
+};
+
+// followed by the interleaved vertices, the indices and the kd-tree
+struct MeshHeader
+{
+    std::uint32_t num_vertices;
+    std::uint32_t num_triangles;
+    std::uint32_t attributes;  // see InterleavedMesh::Attributes
+    std::uint32_t vertex_size; // in bytes
+    double bbox_min[3];
+    double bbox_max[3];
+};
+
+// nodes are stored in depth-first order
+struct NodeRecord
+{
+    double transform[16];
+    std::int32_t mesh;     // -1 for TransformNodes
+    std::int32_t material; // -1 if there is none
+    std::uint32_t child_count;
+    std::uint32_t padding;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool get_source_stats(std::string const& file_name, std::uint64_t& size, std::int64_t& time)
+{
+    boost::system::error_code error;
+
+    size = boost::filesystem::file_size(file_name, error);
+    if(error)
+    {
+        return false;
+    }
+
+    time = boost::filesystem::last_write_time(file_name, error);
+    return !error;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<Material> restore_material(std::string const& shader_name, std::string const& uniforms)
+{
+    auto shader(MaterialShaderDatabase::instance()->lookup(shader_name));
+    auto material(shader ? shader->make_new_material() : PBSMaterialFactory::create_material(PBSMaterialFactory::capabilities_from_material_name(shader_name)));
+
+    material->set_uniforms_from_serialized_string(uniforms);
+
+    // textures are usually requested when samplers are set with set_uniform()
+    for(auto const& uniform : material->get_uniforms())
+    {
+        auto texture(boost::get<std::string>(&uniform.second.get().data));
+
+        if(texture && !texture->empty() && !TextureDatabase::instance()->contains(*texture))
+        {
+            TextureDatabase::instance()->load(*texture);
+        }
+    }
+
+    return material;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void write_value(std::ostream& os, T const& value)
+{
+    os.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void write_string(std::ostream& os, std::string const& value)
+{
+    write_value(os, std::uint32_t(value.size()));
+    os.write(value.data(), value.size());
+
+    // keep the following records aligned
+    char const padding[4] = {0, 0, 0, 0};
+    os.write(padding, (4 - value.size() % 4) % 4);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// reads consecutive records from a memory mapped cache file
+class Reader
+{
+  public:
+    Reader(char const* begin, char const* end) : position_(begin), end_(end) {}
+
+    template <typename T>
+    bool read(T& value)
+    {
+        if(std::size_t(end_ - position_) < sizeof(T))
+        {
+            return false;
+        }
+
+        std::memcpy(&value, position_, sizeof(T));
+        position_ += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& value)
+    {
+        std::uint32_t size;
+
+        if(!read(size) || std::size_t(end_ - position_) < size + (4 - size % 4) % 4)
+        {
+            return false;
+        }
+
+        value.assign(position_, size);
+        position_ += size + (4 - size % 4) % 4;
+        return true;
+    }
+
+    bool read(KDTree& kd_tree)
+    {
+        position_ = kd_tree.read(position_, end_);
+        return position_ != nullptr;
+    }
+
+    // returns a pointer to count elements in the mapped file
+    template <typename T>
+    T const* view(std::size_t count)
+    {
+        if(std::size_t(end_ - position_) / sizeof(T) < count)
+        {
+            return nullptr;
+        }
+
+        auto result(reinterpret_cast<T const*>(position_));
+        position_ += count * sizeof(T);
+        return result;
+    }
+
+  private:
+    char const* position_;
+    char const* end_;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<node::Node> read_node(Reader& reader,
+                                      std::vector<std::string> const& mesh_keys,
+                                      std::vector<std::shared_ptr<Material>> const& materials,
+                                      std::vector<TriMeshLoader::DeferredMaterial>* deferred_materials,
+                                      std::uint32_t& remaining_nodes)
+{
+    NodeRecord record;
+
+    if(remaining_nodes == 0 || !reader.read(record))
+    {
+        return nullptr;
+    }
+
+    --remaining_nodes;
+
+    math::mat4 transform;
+    for(int i(0); i < 16; ++i)
+    {
+        transform.data_array[i] = math::float_t(record.transform[i]);
+    }
+
+    std::shared_ptr<node::Node> result;
+
+    if(record.mesh < 0)
+    {
+        result = std::make_shared<node::TransformNode>("", transform);
+    }
+    else if(std::size_t(record.mesh) < mesh_keys.size() && record.material < int(materials.size()))
+    {
+        auto material(record.material < 0 ? nullptr : materials[record.material]);
+        auto tri_mesh_node(std::make_shared<node::TriMeshNode>("", mesh_keys[record.mesh], material, transform));
+
+        if(deferred_materials && record.material >= 0)
+        {
+            (*deferred_materials)[record.material].nodes.push_back(tri_mesh_node);
+        }
+
+        result = tri_mesh_node;
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    for(std::uint32_t i(0); i < record.child_count; ++i)
+    {
+        auto child(read_node(reader, mesh_keys, materials, deferred_materials, remaining_nodes));
+
+        if(!child)
+        {
+            return nullptr;
+        }
+
+        result->add_child(child);
+    }
+
+    return result;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string TriMeshCache::directory_ = "";
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TriMeshCache::set_directory(std::string const& directory) { directory_ = directory; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string const& TriMeshCache::get_directory() { return directory_; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string TriMeshCache::get_cache_file(std::string const& file_name, unsigned flags)
+{
+    std::string suffix("." + string_utils::to_string(flags & CACHED_FLAGS) + ".gmc");
+
+    if(directory_.empty())
+    {
+        return file_name + suffix;
+    }
+
+    // files of the same name in different directories must not collide
+    boost::filesystem::path path(file_name);
+    auto path_hash(std::hash<std::string>()(boost::filesystem::absolute(path).string()));
+
+    return (boost::filesystem::path(directory_) / (path.filename().string() + "." + string_utils::to_string(path_hash) + suffix)).string();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<node::Node> TriMeshCache::read(std::string const& file_name, unsigned flags, std::vector<TriMeshLoader::DeferredMaterial>* materials)
+{
+    auto cache_file(get_cache_file(file_name, flags));
+
+    std::uint64_t source_size;
+    std::int64_t source_time;
+
+    if(!get_source_stats(file_name, source_size, source_time) || !boost::filesystem::exists(cache_file))
+    {
+        return nullptr;
+    }
+
+    // the mapping stays alive as long as a TriMeshRessource refers to it
+    std::shared_ptr<boost::interprocess::mapped_region> region;
+
+    try
+    {
+        boost::interprocess::file_mapping mapping(cache_file.c_str(), boost::interprocess::read_only);
+        region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    }
+    catch(boost::interprocess::interprocess_exception const& e)
+    {
+        Logger::LOG_WARNING << "TriMeshCache::read(): Unable to map " << cache_file << ": " << e.what() << std::endl;
+        return nullptr;
+    }
+
+    auto begin(static_cast<char const*>(region->get_address()));
+    Reader reader(begin, begin + region->get_size());
+
+    FileHeader header;
+
+    if(!reader.read(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.flags != (flags & CACHED_FLAGS) ||
+       header.source_size != source_size || header.source_time != source_time)
+    {
+        return nullptr;
+    }
+
+    std::vector<std::shared_ptr<TriMeshRessource>> meshes;
+    meshes.reserve(header.mesh_count);
+
+    for(std::uint32_t i(0); i < header.mesh_count; ++i)
+    {
+        MeshHeader mesh_header;
+
+        if(!reader.read(mesh_header))
+        {
+            return nullptr;
+        }
+
+        // the vertex layout is derived from the attributes
+        InterleavedMesh layout(mesh_header.attributes, 0, nullptr, 0, nullptr);
+
+        if(layout.get_attributes() != mesh_header.attributes || layout.get_vertex_size() != mesh_header.vertex_size)
+        {
+            return nullptr;
+        }
+
+        auto vertices(reader.view<float>(std::size_t(mesh_header.num_vertices) * mesh_header.vertex_size / sizeof(float)));
+        auto indices(reader.view<unsigned>(std::size_t(mesh_header.num_triangles) * 3));
+
+        KDTree kd_tree;
+
+        if(!vertices || !indices || !reader.read(kd_tree))
+        {
+            return nullptr;
+        }
+
+        // vertices and indices are used in place
+        InterleavedMesh mesh(mesh_header.attributes,
+                             mesh_header.num_vertices,
+                             std::shared_ptr<float const>(region, vertices),
+                             mesh_header.num_triangles,
+                             std::shared_ptr<unsigned const>(region, indices));
+
+        math::BoundingBox<math::vec3> bounding_box;
+        for(int c(0); c < 3; ++c)
+        {
+            bounding_box.min[c] = math::float_t(mesh_header.bbox_min[c]);
+            bounding_box.max[c] = math::float_t(mesh_header.bbox_max[c]);
+        }
+
+        meshes.push_back(std::make_shared<TriMeshRessource>(mesh, kd_tree, bounding_box));
+    }
+
+    // deferred materials are assigned to their nodes by the caller
+    std::vector<std::shared_ptr<Material>> restored_materials(header.material_count);
+    std::vector<TriMeshLoader::DeferredMaterial> deferred_materials;
+
+    for(std::uint32_t i(0); i < header.material_count; ++i)
+    {
+        std::string shader_name;
+        std::string uniforms;
+
+        if(!reader.read(shader_name) || !reader.read(uniforms))
+        {
+            return nullptr;
+        }
+
+        if(materials)
+        {
+            deferred_materials.push_back({[shader_name, uniforms]() { return restore_material(shader_name, uniforms); }, {}, shader_name, uniforms});
+        }
+        else
+        {
+            restored_materials[i] = restore_material(shader_name, uniforms);
+        }
+    }
+
+    std::vector<std::string> mesh_keys;
+    for(std::uint32_t i(0); i < header.mesh_count; ++i)
+    {
+        mesh_keys.push_back(GeometryDescription("TriMesh", file_name, i, flags).unique_key());
+    }
+
+    std::uint32_t remaining_nodes(header.node_count);
+    auto root(read_node(reader, mesh_keys, restored_materials, materials ? &deferred_materials : nullptr, remaining_nodes));
+
+    if(!root || remaining_nodes != 0)
+    {
+        return nullptr;
+    }
+
+    for(std::uint32_t i(0); i < header.mesh_count; ++i)
+    {
+        GeometryDatabase::instance()->add(mesh_keys[i], meshes[i]);
+    }
+
+    if(materials)
+    {
+        materials->insert(materials->end(), deferred_materials.begin(), deferred_materials.end());
+    }
+
+    return root;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TriMeshCache::write(std::string const& file_name, unsigned flags, std::shared_ptr<node::Node> const& root, std::vector<TriMeshLoader::DeferredMaterial> const& materials)
+{
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.flags = flags & CACHED_FLAGS;
+
+    if(!root || !get_source_stats(file_name, header.source_size, header.source_time))
+    {
+        return false;
+    }
+
+    std::vector<NodeRecord> nodes;
+    std::vector<TriMeshRessource*> meshes;
+    std::unordered_map<TriMeshRessource*, int> mesh_indices;
+    std::unordered_map<node::TriMeshNode*, int> material_indices;
+
+    for(std::size_t i(0); i < materials.size(); ++i)
+    {
+        if(materials[i].shader_name.empty())
+        {
+            return false;
+        }
+
+        for(auto const& node : materials[i].nodes)
+        {
+            material_indices[node.get()] = int(i);
+        }
+    }
+
+    // collect the nodes in depth-first order
+    std::vector<node::Node*> stack(1, root.get());
+
+    while(!stack.empty())
+    {
+        auto current(stack.back());
+        stack.pop_back();
+
+        NodeRecord record;
+        auto transform(current->get_transform());
+
+        for(int i(0); i < 16; ++i)
+        {
+            record.transform[i] = transform.data_array[i];
+        }
+
+        record.mesh = -1;
+        record.material = -1;
+        record.child_count = std::uint32_t(current->get_children().size());
+        record.padding = 0;
+
+        if(auto tri_mesh_node = dynamic_cast<node::TriMeshNode*>(current))
+        {
+            auto resource(std::dynamic_pointer_cast<TriMeshRessource>(GeometryDatabase::instance()->lookup(tri_mesh_node->get_geometry_description())));
+
+            if(!resource)
+            {
+                return false;
+            }
+
+            auto mesh(mesh_indices.insert(std::make_pair(resource.get(), int(meshes.size()))));
+            if(mesh.second)
+            {
+                meshes.push_back(resource.get());
+            }
+            record.mesh = mesh.first->second;
+
+            auto material(material_indices.find(tri_mesh_node));
+
+            if(material != material_indices.end())
+            {
+                record.material = material->second;
+            }
+            else if(tri_mesh_node->get_material())
+            {
+                // created materials are not stored
+                return false;
+            }
+        }
+        else if(!dynamic_cast<node::TransformNode*>(current))
+        {
+            return false;
+        }
+
+        nodes.push_back(record);
+
+        auto const& children(current->get_children());
+        for(auto child(children.rbegin()); child != children.rend(); ++child)
+        {
+            stack.push_back(child->get());
+        }
+    }
+
+    header.mesh_count = std::uint32_t(meshes.size());
+    header.material_count = std::uint32_t(materials.size());
+    header.node_count = std::uint32_t(nodes.size());
+
+    // kd-trees are built lazily otherwise
+    concurrent::ThreadPool::instance()->parallel_for(0, meshes.size(), [&](std::size_t begin, std::size_t end) {
+        for(std::size_t i(begin); i < end; ++i)
+        {
+            if(meshes[i]->build_kd_tree_)
+            {
+                meshes[i]->generate_kd_tree();
+            }
+        }
+    });
+
+    // concurrent loads of the same file must not write to the same file
+    auto cache_file(get_cache_file(file_name, flags));
+    std::stringstream temporary_file;
+    temporary_file << cache_file << "." << std::this_thread::get_id() << ".tmp";
+
+    {
+        std::ofstream os(temporary_file.str(), std::ios::binary);
+
+        if(!os)
+        {
+            Logger::LOG_WARNING << "TriMeshCache::write(): Unable to write " << temporary_file.str() << std::endl;
+            return false;
+        }
+
+        write_value(os, header);
+
+        for(auto mesh : meshes)
+        {
+            auto const& bounding_box(mesh->get_bounding_box());
+
+            MeshHeader mesh_header;
+            mesh_header.num_vertices = mesh->mesh_.get_num_vertices();
+            mesh_header.num_triangles = mesh->mesh_.get_num_triangles();
+            mesh_header.attributes = mesh->mesh_.get_attributes();
+            mesh_header.vertex_size = std::uint32_t(mesh->mesh_.get_vertex_size());
+
+            for(int c(0); c < 3; ++c)
+            {
+                mesh_header.bbox_min[c] = bounding_box.min[c];
+                mesh_header.bbox_max[c] = bounding_box.max[c];
+            }
+
+            write_value(os, mesh_header);
+
+            os.write(reinterpret_cast<char const*>(mesh->mesh_.get_vertices()), std::size_t(mesh_header.num_vertices) * mesh_header.vertex_size);
+            os.write(reinterpret_cast<char const*>(mesh->mesh_.get_indices()), std::size_t(mesh_header.num_triangles) * 3 * sizeof(unsigned));
+
+            mesh->kd_tree_.write(os);
+        }
+
+        for(auto const& material : materials)
+        {
+            write_string(os, material.shader_name);
+            write_string(os, material.uniforms);
+        }
+
+        for(auto const& record : nodes)
+        {
+            write_value(os, record);
+        }
+
+        if(!os)
+        {
+            Logger::LOG_WARNING << "TriMeshCache::write(): Unable to write " << temporary_file.str() << std::endl;
+            os.close();
+            boost::system::error_code error;
+            boost::filesystem::remove(temporary_file.str(), error);
+            return false;
+        }
+    }
+
+    boost::system::error_code error;
+    boost::filesystem::rename(temporary_file.str(), cache_file, error);
+
+    if(error)
+    {
+        Logger::LOG_WARNING << "TriMeshCache::write(): Unable to write " << cache_file << ": " << error.message() << std::endl;
+        boost::filesystem::remove(temporary_file.str(), error);
+        return false;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace gua
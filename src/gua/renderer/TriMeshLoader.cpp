@@ -23,14 +23,15 @@
 #include <gua/renderer/TriMeshLoader.hpp>
 
 // guacamole headers
+#include <gua/concurrent/ThreadPool.hpp>
 #include <gua/databases/GeometryDatabase.hpp>
 #include <gua/databases/MaterialShaderDatabase.hpp>
 #include <gua/node/TransformNode.hpp>
 #include <gua/node/TriMeshNode.hpp>
 #include <gua/renderer/MaterialLoader.hpp>
+#include <gua/renderer/TriMeshCache.hpp>
 #include <gua/renderer/TriMeshRessource.hpp>
 #include <gua/utils/Logger.hpp>
-#include <gua/utils/TextFile.hpp>
 #include <gua/utils/ToGua.hpp>
 #include <gua/utils/string_utils.hpp>
 
@@ -39,16 +40,43 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <assimp/version.h>
+#include <fstream>
 #ifdef GUACAMOLE_FBX
 #include <fbxsdk.h>
 #endif // GUACAMOLE_FBX
 
 namespace gua
 {
+namespace
+{
+// strips the vertex attributes excluded by flags and optimizes the vertex
+// order for geometry loaded with OPTIMIZE_GEOMETRY
+InterleavedMesh interleave(Mesh const& mesh, unsigned flags)
+{
+    unsigned attributes(InterleavedMesh::ALL_ATTRIBUTES);
+
+    if(flags & TriMeshLoader::NO_TANGENTS)
+    {
+        attributes &= ~(InterleavedMesh::TANGENTS | InterleavedMesh::BITANGENTS);
+    }
+    else if(flags & TriMeshLoader::NO_BITANGENTS)
+    {
+        attributes &= ~InterleavedMesh::BITANGENTS;
+    }
+
+    return InterleavedMesh(mesh, attributes, (flags & TriMeshLoader::OPTIMIZE_GEOMETRY) != 0);
+}
+
+} // namespace
+
 /////////////////////////////////////////////////////////////////////////////
 // static variables
 /////////////////////////////////////////////////////////////////////////////
 std::unordered_map<std::string, std::shared_ptr<::gua::node::Node>> TriMeshLoader::loaded_files_ = std::unordered_map<std::string, std::shared_ptr<::gua::node::Node>>();
+std::mutex TriMeshLoader::loaded_files_mutex_;
+
+std::list<TriMeshLoader::AsyncLoad> TriMeshLoader::async_loads_;
+std::mutex TriMeshLoader::async_loads_mutex_;
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -58,67 +86,126 @@ TriMeshLoader::TriMeshLoader() {}
 
 std::shared_ptr<node::Node> TriMeshLoader::load_geometry(std::string const& file_name, unsigned flags)
 {
-    std::shared_ptr<node::Node> cached_node;
-    std::string key(file_name + "_" + string_utils::to_string(flags));
-    auto searched(loaded_files_.find(key));
+    auto file(import_file(file_name, flags));
+    return finish_file(file);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TriMeshLoader::ImportedFile TriMeshLoader::import_file(std::string const& file_name, unsigned flags)
+{
+    ImportedFile file;
+    file.key = file_name + "_" + string_utils::to_string(flags);
+    file.flags = flags;
 
-    if(searched != loaded_files_.end())
     {
-        cached_node = searched->second;
+        std::lock_guard<std::mutex> lock(loaded_files_mutex_);
+        auto searched(loaded_files_.find(file.key));
+
+        if(searched != loaded_files_.end())
+        {
+            file.root = searched->second;
+            file.from_loaded_files = true;
+            return file;
+        }
     }
-    else
+
+    if(!is_supported(file_name))
     {
-        bool fileload_succeed = false;
+        Logger::LOG_WARNING << "Unable to load " << file_name << ": Type is not supported!" << std::endl;
+        return file;
+    }
+
+    // the file is loaded without holding the lock, so that different files
+    // may be loaded concurrently
+    if(flags & TriMeshLoader::CACHE_GEOMETRY)
+    {
+        file.root = TriMeshCache::read(file_name, flags, &file.materials);
+    }
 
-        if(is_supported(file_name))
+    if(!file.root)
+    {
+        file.root = load(file_name, flags, file.materials);
+
+        if(file.root && (flags & TriMeshLoader::CACHE_GEOMETRY))
         {
-            cached_node = load(file_name, flags);
-            cached_node->update_cache();
+            TriMeshCache::write(file_name, flags, file.root, file.materials);
+        }
+    }
 
-            loaded_files_.insert(std::make_pair(key, cached_node));
+    return file;
+}
 
-            // normalize mesh position and rotation
-            if(flags & TriMeshLoader::NORMALIZE_POSITION || flags & TriMeshLoader::NORMALIZE_SCALE)
-            {
-                auto bbox = cached_node->get_bounding_box();
+////////////////////////////////////////////////////////////////////////////////
 
-                if(flags & TriMeshLoader::NORMALIZE_POSITION)
-                {
-                    auto center((bbox.min + bbox.max) * 0.5f);
-                    cached_node->translate(-center);
-                }
+std::shared_ptr<node::Node> TriMeshLoader::finish_file(ImportedFile& file)
+{
+    if(!file.root || file.from_loaded_files)
+    {
+        return file.root;
+    }
 
-                if(flags & TriMeshLoader::NORMALIZE_SCALE)
-                {
-                    auto size(bbox.max - bbox.min);
-                    auto max_size(std::max(std::max(size.x, size.y), size.z));
-                    cached_node->scale(1.f / max_size);
-                }
-            }
+    create_materials(file.materials);
 
-            fileload_succeed = true;
+    auto const& cached_node(file.root);
+    cached_node->update_cache();
+
+    // normalize mesh position and rotation
+    if(file.flags & TriMeshLoader::NORMALIZE_POSITION || file.flags & TriMeshLoader::NORMALIZE_SCALE)
+    {
+        auto bbox = cached_node->get_bounding_box();
+
+        if(file.flags & TriMeshLoader::NORMALIZE_POSITION)
+        {
+            auto center((bbox.min + bbox.max) * 0.5f);
+            cached_node->translate(-center);
         }
 
-        if(!fileload_succeed)
+        if(file.flags & TriMeshLoader::NORMALIZE_SCALE)
         {
-            Logger::LOG_WARNING << "Unable to load " << file_name << ": Type is not supported!" << std::endl;
+            auto size(bbox.max - bbox.min);
+            auto max_size(std::max(std::max(size.x, size.y), size.z));
+            cached_node->scale(1.f / max_size);
         }
     }
 
-    return cached_node;
+    std::lock_guard<std::mutex> lock(loaded_files_mutex_);
+    return loaded_files_.insert(std::make_pair(file.key, cached_node)).first->second;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-std::shared_ptr<node::Node> TriMeshLoader::create_geometry_from_file(std::string const& node_name, std::string const& file_name, std::shared_ptr<Material> const& fallback_material, unsigned flags)
+void TriMeshLoader::create_materials(std::vector<DeferredMaterial> const& materials)
 {
-    auto cached_node(load_geometry(file_name, flags));
+    for(auto const& deferred : materials)
+    {
+        auto material(deferred.create());
 
+        for(auto const& node : deferred.nodes)
+        {
+            node->set_material(material);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<node::Node>
+TriMeshLoader::instantiate(std::shared_ptr<node::Node> const& cached_node, std::string const& node_name, std::shared_ptr<Material> const& fallback_material, unsigned flags)
+{
     if(cached_node)
     {
         auto copy(cached_node->deep_copy());
 
-        apply_fallback_material(copy, fallback_material, flags & NO_SHARED_MATERIALS);
+        if(fallback_material)
+        {
+            apply_fallback_material(copy, fallback_material, flags & NO_SHARED_MATERIALS);
+        }
+        else
+        {
+            auto shader(gua::MaterialShaderDatabase::instance()->lookup("gua_default_material"));
+            apply_fallback_material(copy, shader->make_new_material(), flags & NO_SHARED_MATERIALS);
+        }
 
         copy->set_name(node_name);
         return copy;
@@ -129,33 +216,122 @@ std::shared_ptr<node::Node> TriMeshLoader::create_geometry_from_file(std::string
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<node::Node> TriMeshLoader::create_geometry_from_file(std::string const& node_name, std::string const& file_name, std::shared_ptr<Material> const& fallback_material, unsigned flags)
+{
+    return instantiate(load_geometry(file_name, flags), node_name, fallback_material, flags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 std::shared_ptr<node::Node> TriMeshLoader::create_geometry_from_file(std::string const& node_name, std::string const& file_name, unsigned flags)
 {
-    auto cached_node(load_geometry(file_name, flags));
+    return instantiate(load_geometry(file_name, flags), node_name, nullptr, flags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<node::Node>
+TriMeshLoader::create_geometry_from_file_async(std::string const& node_name, std::string const& file_name, std::shared_ptr<Material> const& fallback_material, unsigned flags)
+{
+    return create_async(node_name, file_name, fallback_material, flags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<node::Node> TriMeshLoader::create_geometry_from_file_async(std::string const& node_name, std::string const& file_name, unsigned flags)
+{
+    return create_async(node_name, file_name, nullptr, flags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<node::Node> TriMeshLoader::create_async(std::string const& node_name, std::string const& file_name, std::shared_ptr<Material> const& fallback_material, unsigned flags)
+{
+    auto placeholder(std::make_shared<node::TransformNode>(node_name));
+
+    // the task only imports the file, its materials are created by
+    // apply_async_loads() on the application thread
+    auto result(concurrent::ThreadPool::instance()->submit([file_name, flags]() {
+        TriMeshLoader loader;
+        return loader.import_file(file_name, flags);
+    }));
+
+    std::lock_guard<std::mutex> lock(async_loads_mutex_);
+    async_loads_.push_back(AsyncLoad{placeholder, fallback_material, flags, std::move(result)});
+
+    return placeholder;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TriMeshLoader::apply_async_loads()
+{
+    std::list<AsyncLoad> finished;
 
-    if(cached_node)
     {
-        auto copy(cached_node->deep_copy());
+        std::lock_guard<std::mutex> lock(async_loads_mutex_);
 
-        auto shader(gua::MaterialShaderDatabase::instance()->lookup("gua_default_material"));
-        apply_fallback_material(copy, shader->make_new_material(), flags & NO_SHARED_MATERIALS);
+        for(auto load(async_loads_.begin()); load != async_loads_.end();)
+        {
+            auto next(std::next(load));
 
-        copy->set_name(node_name);
-        return copy;
+            if(load->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                finished.splice(finished.end(), async_loads_, load);
+            }
+
+            load = next;
+        }
     }
 
-    return std::make_shared<node::TransformNode>(node_name);
+    for(auto& load : finished)
+    {
+        std::shared_ptr<node::Node> cached_node;
+
+        try
+        {
+            auto file(load.result.get());
+            cached_node = finish_file(file);
+        }
+        catch(std::exception const& e)
+        {
+            Logger::LOG_WARNING << "TriMeshLoader::apply_async_loads(): Loading failed, " << e.what() << std::endl;
+        }
+
+        auto placeholder(load.placeholder.lock());
+
+        if(cached_node && placeholder)
+        {
+            placeholder->add_child(instantiate(cached_node, placeholder->get_name(), load.fallback_material, load.flags));
+        }
+    }
+}
+
+////////
+
+std::size_t TriMeshLoader::pending_async_loads()
+{
+    std::lock_guard<std::mutex> lock(async_loads_mutex_);
+    return async_loads_.size();
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
 std::shared_ptr<node::Node> TriMeshLoader::load(std::string const& file_name, unsigned flags)
 {
-    TextFile file(file_name);
+    std::vector<DeferredMaterial> materials;
+    auto root(load(file_name, flags, materials));
+    create_materials(materials);
+    return root;
+}
+
+/////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<node::Node> TriMeshLoader::load(std::string const& file_name, unsigned flags, std::vector<DeferredMaterial>& materials)
+{
     // MESSAGE("Loading mesh file %s", file_name.c_str());
 
-    if(file.is_valid())
+    if(std::ifstream(file_name).good())
     {
 #ifdef GUACAMOLE_FBX
         auto point_pos(file_name.find_last_of("."));
@@ -163,7 +339,13 @@ std::shared_ptr<node::Node> TriMeshLoader::load(std::string const& file_name, un
         {
             // The first thing to do is to create the FBX Manager which is the object
             // allocator for almost all the classes in the SDK
-            FbxManager* sdk_manager = FbxManager::Create();
+            // the manager owns the materials, which are created later
+            std::shared_ptr<FbxManager> sdk_manager(FbxManager::Create(), [](FbxManager* manager) {
+                if(manager)
+                {
+                    manager->Destroy();
+                }
+            });
             if(!sdk_manager)
             {
                 Logger::LOG_ERROR << "Error: Unable to create FBX Manager!\n";
@@ -172,7 +354,7 @@ std::shared_ptr<node::Node> TriMeshLoader::load(std::string const& file_name, un
 
             // Create an IOSettings object. This object holds all import/export
             // settings.
-            FbxIOSettings* ios = FbxIOSettings::Create(sdk_manager, IOSROOT);
+            FbxIOSettings* ios = FbxIOSettings::Create(sdk_manager.get(), IOSROOT);
             if(flags & TriMeshLoader::LOAD_MATERIALS)
             {
                 ios->SetBoolProp(IMP_FBX_MATERIAL, true);
@@ -192,11 +374,10 @@ std::shared_ptr<node::Node> TriMeshLoader::load(std::string const& file_name, un
             ios->SetBoolProp(IMP_FBX_ANIMATION, false);
             ios->SetBoolProp(IMP_FBX_GLOBAL_SETTINGS, false);
             sdk_manager->SetIOSettings(ios);
-            FbxScene* scene = load_fbx_file(sdk_manager, file_name);
+            FbxScene* scene = load_fbx_file(sdk_manager.get(), file_name);
 
             unsigned count(0);
-            std::shared_ptr<node::Node> tree{get_tree(*scene->GetRootNode(), file_name, flags, count)};
-            sdk_manager->Destroy();
+            std::shared_ptr<node::Node> tree{get_tree(*scene->GetRootNode(), sdk_manager, file_name, flags, count, materials)};
 
             return tree;
         }
@@ -234,11 +415,21 @@ std::shared_ptr<node::Node> TriMeshLoader::load(std::string const& file_name, un
                 Logger::LOG_WARNING << "TriMeshLoader::load(): Importing failed, " << error << std::endl;
             }
 
-            if(scene->mRootNode)
+            if(scene && scene->mRootNode)
             {
+                // convert and interleave the meshes in parallel, one task per aiMesh
+                std::vector<std::shared_ptr<TriMeshRessource>> meshes(scene->mNumMeshes);
+
+                concurrent::ThreadPool::instance()->parallel_for(0, scene->mNumMeshes, [&](std::size_t begin, std::size_t end) {
+                    for(std::size_t i(begin); i < end; ++i)
+                    {
+                        meshes[i] = std::make_shared<TriMeshRessource>(interleave(Mesh{*scene->mMeshes[i]}, flags), flags & TriMeshLoader::MAKE_PICKABLE);
+                    }
+                });
+
                 unsigned count = 0;
                 bool enforce_hierarchy = flags & TriMeshLoader::PARSE_HIERARCHY;
-                new_node = get_tree(importer, scene, scene->mRootNode, file_name, flags, count, enforce_hierarchy);
+                new_node = get_tree(importer, scene, meshes, scene->mRootNode, file_name, flags, count, enforce_hierarchy, materials);
             }
             else
             {
@@ -294,31 +485,33 @@ bool TriMeshLoader::is_supported(std::string const& file_name) const
 
 ////////////////////////////////////////////////////////////////////////////////
 #ifdef GUACAMOLE_FBX
-std::shared_ptr<node::Node> TriMeshLoader::get_tree(FbxNode& fbx_node, std::string const& file_name, unsigned flags, unsigned& mesh_count)
+std::shared_ptr<node::Node> TriMeshLoader::get_tree(
+    FbxNode& fbx_node, std::shared_ptr<FbxManager> const& manager, std::string const& file_name, unsigned flags, unsigned& mesh_count, std::vector<DeferredMaterial>& materials)
 {
     // creates a geometry node and returns it
     auto load_geometry = [&](FbxNode& fbx_node) {
         FbxMesh* fbx_mesh = fbx_node.GetMesh();
 
         GeometryDescription desc("TriMesh", file_name, mesh_count++, flags);
-        GeometryDatabase::instance()->add(desc.unique_key(), std::make_shared<TriMeshRessource>(Mesh{*fbx_mesh}, flags & TriMeshLoader::MAKE_PICKABLE));
+        GeometryDatabase::instance()->add(desc.unique_key(), std::make_shared<TriMeshRessource>(interleave(Mesh{*fbx_mesh}, flags), flags & TriMeshLoader::MAKE_PICKABLE));
 
-        // load material
-        std::shared_ptr<Material> material;
+        auto node = std::shared_ptr<node::TriMeshNode>(new node::TriMeshNode("", desc.unique_key(), nullptr));
 
+        // load material
         if(fbx_node.GetMaterialCount() > 0 && flags & TriMeshLoader::LOAD_MATERIALS)
         {
-            MaterialLoader material_loader;
             if(fbx_node.GetMaterialCount() > 1)
             {
                 Logger::LOG_WARNING << "Trimesh has more than one material, using only first one" << std::endl;
             }
             FbxSurfaceMaterial* mat = fbx_node.GetMaterial(0);
-            material = material_loader.load_material(*mat, file_name, flags & TriMeshLoader::OPTIMIZE_MATERIALS);
+            materials.push_back({[manager, mat, file_name, flags]() {
+                                     MaterialLoader material_loader;
+                                     return material_loader.load_material(*mat, file_name, flags & TriMeshLoader::OPTIMIZE_MATERIALS);
+                                 },
+                                 {node}});
         }
 
-        auto node = std::shared_ptr<node::TriMeshNode>(new node::TriMeshNode("", desc.unique_key(), material));
-
         node->set_transform(to_gua::mat4d(fbx_node.EvaluateGlobalTransform()));
         return node;
     };
@@ -344,44 +537,62 @@ std::shared_ptr<node::Node> TriMeshLoader::get_tree(FbxNode& fbx_node, std::stri
     {
         if(fbx_node.GetChild(0)->GetGeometry()->GetAttributeType() == FbxNodeAttribute::eMesh)
         {
-            return get_tree(*fbx_node.GetChild(0), file_name, flags, mesh_count);
+            return get_tree(*fbx_node.GetChild(0), manager, file_name, flags, mesh_count, materials);
         }
     }
 
     // else: there are multiple children and meshes
     for(int i = 0; i < fbx_node.GetChildCount(); ++i)
     {
-        group->add_child(get_tree(*fbx_node.GetChild(i), file_name, flags, mesh_count));
+        group->add_child(get_tree(*fbx_node.GetChild(i), manager, file_name, flags, mesh_count, materials));
     }
 
     return group;
 }
 #endif
 ////////////////////////////////////////////////////////////////////////////////
-std::shared_ptr<node::Node> TriMeshLoader::get_tree(
-    std::shared_ptr<Assimp::Importer> const& importer, aiScene const* ai_scene, aiNode* ai_root, std::string const& file_name, unsigned flags, unsigned& mesh_count, bool enforce_hierarchy)
+std::shared_ptr<node::Node> TriMeshLoader::get_tree(std::shared_ptr<Assimp::Importer> const& importer,
+                                                     aiScene const* ai_scene,
+                                                     std::vector<std::shared_ptr<TriMeshRessource>> const& meshes,
+                                                     aiNode* ai_root,
+                                                     std::string const& file_name,
+                                                     unsigned flags,
+                                                     unsigned& mesh_count,
+                                                     bool enforce_hierarchy,
+                                                     std::vector<DeferredMaterial>& materials)
 {
     // std::cout << "get_tree, " << file_name.c_str() << std::endl;
 
     // creates a geometry node and returns it
     auto load_geometry = [&](aiNode* ai_current, int i) {
         GeometryDescription desc("TriMesh", file_name, mesh_count++, flags);
-        GeometryDatabase::instance()->add(desc.unique_key(), std::make_shared<TriMeshRessource>(Mesh{*ai_scene->mMeshes[ai_current->mMeshes[i]]}, flags & TriMeshLoader::MAKE_PICKABLE));
+        GeometryDatabase::instance()->add(desc.unique_key(), meshes[ai_current->mMeshes[i]]);
+
+        // return std::make_shared<node::TriMeshNode>("", desc.unique_key(),
+        // material); // not allowed -> private c'tor
+        auto node(std::shared_ptr<node::TriMeshNode>(new node::TriMeshNode("", desc.unique_key(), nullptr)));
 
         // load material
-        std::shared_ptr<Material> material = nullptr;
         unsigned material_index(ai_scene->mMeshes[ai_current->mMeshes[i]]->mMaterialIndex);
 
         if(flags & TriMeshLoader::LOAD_MATERIALS)
         {
             MaterialLoader material_loader;
-            aiMaterial const* ai_material(ai_scene->mMaterials[material_index]);
-            material = material_loader.load_material(ai_material, file_name, flags & TriMeshLoader::OPTIMIZE_MATERIALS, flags & TriMeshLoader::PARSE_HIERARCHY);
+            auto description(std::make_shared<MaterialLoader::Description>(material_loader.describe_material(
+                ai_scene->mMaterials[material_index], file_name, flags & TriMeshLoader::OPTIMIZE_MATERIALS, flags & TriMeshLoader::PARSE_HIERARCHY)));
+
+            DeferredMaterial deferred{[description]() {
+                                          MaterialLoader material_loader;
+                                          return material_loader.create_material(*description);
+                                      },
+                                      {node}};
+
+            // the cache file is written before the material is created
+            description->serialize(deferred.shader_name, deferred.uniforms);
+            materials.push_back(deferred);
         }
 
-        // return std::make_shared<node::TriMeshNode>("", desc.unique_key(),
-        // material); // not allowed -> private c'tor
-        return std::shared_ptr<node::TriMeshNode>(new node::TriMeshNode("", desc.unique_key(), material));
+        return node;
     };
 
     if(!enforce_hierarchy)
@@ -391,7 +602,7 @@ std::shared_ptr<node::Node> TriMeshLoader::get_tree(
         {
             // std::cout << "one child: " << ai_root->mChildren[0]->mName.data << ", no meshes" << std::endl;
 
-            auto node = get_tree(importer, ai_scene, ai_root->mChildren[0], file_name, flags, mesh_count, enforce_hierarchy);
+            auto node = get_tree(importer, ai_scene, meshes, ai_root->mChildren[0], file_name, flags, mesh_count, enforce_hierarchy, materials);
             node->set_transform(convert_transformation(ai_root->mTransformation) * convert_transformation(ai_root->mChildren[0]->mTransformation));
             return node;
         }
@@ -422,7 +633,7 @@ std::shared_ptr<node::Node> TriMeshLoader::get_tree(
         {
             // std::cout << ai_root->mChildren[i]->mName.data << std::endl;
 
-            auto child = get_tree(importer, ai_scene, ai_root->mChildren[i], file_name, flags, mesh_count, enforce_hierarchy);
+            auto child = get_tree(importer, ai_scene, meshes, ai_root->mChildren[i], file_name, flags, mesh_count, enforce_hierarchy, materials);
             auto child_transform_ai = ai_root->mChildren[i]->mTransformation;
             apply_transformation(child, child_transform_ai);
 
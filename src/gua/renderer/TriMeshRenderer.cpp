@@ -85,8 +85,11 @@ void TriMeshRenderer::render(Pipeline& pipe, PipelinePassDescription const& desc
         auto& target = *pipe.current_viewstate().target;
         auto const& camera = pipe.current_viewstate().camera;
 
+        // sorted by shader and material, so that both are bound as rarely as possible
         std::sort(sorted_objects->second.begin(), sorted_objects->second.end(), [](node::Node* a, node::Node* b) {
-            return reinterpret_cast<node::TriMeshNode*>(a)->get_material()->get_shader() < reinterpret_cast<node::TriMeshNode*>(b)->get_material()->get_shader();
+            auto const& material_a(reinterpret_cast<node::TriMeshNode*>(a)->get_material());
+            auto const& material_b(reinterpret_cast<node::TriMeshNode*>(b)->get_material());
+            return std::make_pair(material_a->get_shader(), material_a.get()) < std::make_pair(material_b->get_shader(), material_b.get());
         });
 
 #ifdef GUACAMOLE_ENABLE_PIPELINE_PASS_TIME_QUERIES
@@ -104,6 +107,10 @@ void TriMeshRenderer::render(Pipeline& pipe, PipelinePassDescription const& desc
         int view_id(camera.config.get_view_id());
 
         MaterialShader* current_material(nullptr);
+        Material* current_uniforms(nullptr);
+#ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
+        int current_vt_idx(0);
+#endif
         std::shared_ptr<ShaderProgram> current_shader;
         auto current_rasterizer_state = rs_cull_back_;
         ctx.render_context->apply();
@@ -135,7 +142,7 @@ void TriMeshRenderer::render(Pipeline& pipe, PipelinePassDescription const& desc
                     else
                     {
                         auto smap = global_substitution_map_;
-                        for(const auto& i : current_material->generate_substitution_map())
+                        for(const auto& i : current_material->generate_substitution_map(true))
                             smap[i.first] = i.second;
 
                         current_shader = std::make_shared<ShaderProgram>();
@@ -192,9 +199,32 @@ void TriMeshRenderer::render(Pipeline& pipe, PipelinePassDescription const& desc
                 current_shader->apply_uniform(ctx, "gua_rendering_mode", rendering_mode);
 
                 // lowfi shadows dont need material input
-                if(rendering_mode != 1)
+                if(rendering_mode != 1 && current_uniforms != tri_mesh_node->get_material().get())
+                {
+                    current_uniforms = tri_mesh_node->get_material().get();
+                    current_uniforms->bind_uniform_block(ctx, view_id);
+                    ctx.render_context->apply();
+#ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
+                    current_vt_idx = current_uniforms->get_virtual_texture_index(ctx, view_id);
+#endif
+                }
+
+#ifdef GUACAMOLE_ENABLE_VIRTUAL_TEXTURING
+                // not part of the uniform block, hence set for every draw
+                if(rendering_mode == 0)
+                {
+                    current_shader->apply_uniform(ctx, "gua_current_vt_idx", current_vt_idx);
+                }
+#endif
+
+                // nearby and large objects get their textures streamed first
+                if(rendering_mode == 0)
                 {
-                    tri_mesh_node->get_material()->apply_uniforms(ctx, current_shader.get(), view_id);
+                    auto const& bbox(tri_mesh_node->get_bounding_box());
+                    float distance(scm::math::length(bbox.center() - scene.rendering_frustum.get_camera_position()));
+                    float radius(0.5f * scm::math::length(bbox.max - bbox.min));
+                    float screen_size(distance > radius ? (radius * radius) / (distance * distance) : 1.f);
+                    current_uniforms->request_textures(ctx, view_id, screen_size);
                 }
 
                 bool show_backfaces = tri_mesh_node->get_material()->get_show_back_faces();
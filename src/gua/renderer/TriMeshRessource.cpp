@@ -37,48 +37,51 @@ TriMeshRessource::TriMeshRessource() : kd_tree_(), mesh_() {}
 
 ////////////////////////////////////////////////////////////////////////////////
 
-TriMeshRessource::TriMeshRessource(Mesh const& mesh, bool build_kd_tree) : kd_tree_(), mesh_(mesh)
+TriMeshRessource::TriMeshRessource(Mesh const& mesh, bool build_kd_tree) : TriMeshRessource(InterleavedMesh(mesh), build_kd_tree) {}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TriMeshRessource::TriMeshRessource(InterleavedMesh const& mesh, bool build_kd_tree) : kd_tree_(), build_kd_tree_(build_kd_tree), mesh_(mesh)
 {
-    if(mesh_.num_vertices > 0)
+    if(mesh_.get_num_vertices() > 0)
     {
         bounding_box_ = math::BoundingBox<math::vec3>();
 
-        for(unsigned v(0); v < mesh_.num_vertices; ++v)
+        for(unsigned v(0); v < mesh_.get_num_vertices(); ++v)
         {
-            bounding_box_.expandBy(math::vec3{mesh_.positions[v]});
-        }
-
-        if(build_kd_tree)
-        {
-            kd_tree_.generate(mesh);
+            bounding_box_.expandBy(math::vec3{mesh_.get_position(v)});
         }
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+TriMeshRessource::TriMeshRessource(InterleavedMesh const& mesh, KDTree const& kd_tree, math::BoundingBox<math::vec3> const& bounding_box)
+    : kd_tree_(kd_tree), build_kd_tree_(!kd_tree.is_empty()), mesh_(mesh)
+{
+    bounding_box_ = bounding_box;
+
+    // the tree is complete already
+    std::call_once(kd_tree_flag_, []() {});
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void TriMeshRessource::upload_to(RenderContext& ctx) const
 {
     RenderContext::Mesh cmesh{};
     cmesh.indices_topology = scm::gl::PRIMITIVE_TRIANGLE_LIST;
     cmesh.indices_type = scm::gl::TYPE_UINT;
-    cmesh.indices_count = mesh_.num_triangles * 3;
+    cmesh.indices_count = mesh_.get_num_triangles() * 3;
 
-    if(!(mesh_.num_vertices > 0))
+    if(!(mesh_.get_num_vertices() > 0))
     {
         Logger::LOG_WARNING << "Unable to load Mesh! Has no vertex data." << std::endl;
         return;
     }
 
-    cmesh.vertices = ctx.render_device->create_buffer(scm::gl::BIND_VERTEX_BUFFER, scm::gl::USAGE_STATIC_DRAW, mesh_.num_vertices * sizeof(Mesh::Vertex), 0);
-
-    Mesh::Vertex* data(static_cast<Mesh::Vertex*>(ctx.render_context->map_buffer(cmesh.vertices, scm::gl::ACCESS_WRITE_INVALIDATE_BUFFER)));
-
-    mesh_.copy_to_buffer(data);
-
-    ctx.render_context->unmap_buffer(cmesh.vertices);
-
-    cmesh.indices = ctx.render_device->create_buffer(scm::gl::BIND_INDEX_BUFFER, scm::gl::USAGE_STATIC_DRAW, mesh_.num_triangles * 3 * sizeof(unsigned), mesh_.indices.data());
+    cmesh.vertices = ctx.render_device->create_buffer(scm::gl::BIND_VERTEX_BUFFER, scm::gl::USAGE_STATIC_DRAW, mesh_.get_num_vertices() * mesh_.get_vertex_size(), mesh_.get_vertices());
+    cmesh.indices = ctx.render_device->create_buffer(scm::gl::BIND_INDEX_BUFFER, scm::gl::USAGE_STATIC_DRAW, mesh_.get_num_triangles() * 3 * sizeof(unsigned), mesh_.get_indices());
 
     cmesh.vertex_array = ctx.render_device->create_vertex_array(mesh_.get_vertex_format(), {cmesh.vertices});
     ctx.meshes[uuid()] = cmesh;
@@ -105,20 +108,36 @@ void TriMeshRessource::draw(RenderContext& ctx) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void TriMeshRessource::ray_test(Ray const& ray, int options, node::Node* owner, std::set<PickResult>& hits) { kd_tree_.ray_test(ray, mesh_, options, owner, hits); }
+void TriMeshRessource::ray_test(Ray const& ray, int options, node::Node* owner, std::set<PickResult>& hits)
+{
+    if(!build_kd_tree_ || mesh_.get_num_vertices() == 0)
+    {
+        return;
+    }
+
+    generate_kd_tree();
+    kd_tree_.ray_test(ray, mesh_, options, owner, hits);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TriMeshRessource::generate_kd_tree()
+{
+    std::call_once(kd_tree_flag_, [this]() { kd_tree_.generate(mesh_); });
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
-math::vec3 TriMeshRessource::get_vertex(unsigned int i) const { return math::vec3(mesh_.positions[i].x, mesh_.positions[i].y, mesh_.positions[i].z); }
+math::vec3 TriMeshRessource::get_vertex(unsigned int i) const { return math::vec3(mesh_.get_position(i).x, mesh_.get_position(i).y, mesh_.get_position(i).z); }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 std::vector<unsigned int> TriMeshRessource::get_face(unsigned int i) const
 {
     std::vector<unsigned int> face;
-    face.push_back(mesh_.indices[3 * i]);
-    face.push_back(mesh_.indices[3 * i + 1]);
-    face.push_back(mesh_.indices[3 * i + 2]);
+    face.push_back(mesh_.get_indices()[3 * i]);
+    face.push_back(mesh_.get_indices()[3 * i + 1]);
+    face.push_back(mesh_.get_indices()[3 * i + 2]);
     return face;
 }
 
@@ -112,6 +112,78 @@ void UniformValue::write_bytes_impl<std::string>(UniformValue const* self, Rende
     }
 }
 
+struct GUA_DLL GetStd140Size : public boost::static_visitor<unsigned>
+{
+    unsigned operator()(int) const { return 4; }
+    unsigned operator()(bool) const { return 4; }
+    unsigned operator()(float) const { return 4; }
+    unsigned operator()(math::mat3f const&) const { return 48; }
+    unsigned operator()(math::mat4f const&) const { return 64; }
+    unsigned operator()(math::vec2f const&) const { return 8; }
+    unsigned operator()(math::vec3f const&) const { return 12; }
+    unsigned operator()(math::vec4f const&) const { return 16; }
+    unsigned operator()(math::vec2i const&) const { return 8; }
+    unsigned operator()(math::vec3i const&) const { return 12; }
+    unsigned operator()(math::vec4i const&) const { return 16; }
+    unsigned operator()(math::vec2ui const&) const { return 8; }
+    unsigned operator()(math::vec3ui const&) const { return 12; }
+    unsigned operator()(math::vec4ui const&) const { return 16; }
+    unsigned operator()(std::string const&) const { return 8; }
+};
+
+struct GUA_DLL GetStd140Alignment : public boost::static_visitor<unsigned>
+{
+    template <typename T>
+    unsigned operator()(T const& value) const
+    {
+        // three component vectors and matrix columns are aligned like vec4
+        auto size(GetStd140Size()(value));
+        return size > 8 ? 16 : size;
+    }
+};
+
+struct GUA_DLL CopyBytes : public boost::static_visitor<>
+{
+    CopyBytes(char* t) : target(t) {}
+
+    char* target;
+
+    template <typename T>
+    void operator()(T const& value) const
+    {
+        memcpy(target, &value, sizeof(T));
+    }
+};
+
+unsigned UniformValue::get_std140_size() const { return boost::apply_visitor(GetStd140Size(), data); }
+
+unsigned UniformValue::get_std140_alignment() const { return boost::apply_visitor(GetStd140Alignment(), data); }
+
+void UniformValue::write_std140(RenderContext const& ctx, char* target) const
+{
+    if(auto matrix = boost::get<math::mat3f>(&data))
+    {
+        // each column occupies a vec4
+        for(int column(0); column < 3; ++column)
+        {
+            memcpy(target + column * 16, matrix->data_array + column * 3, 3 * sizeof(float));
+        }
+    }
+    else if(auto value = boost::get<bool>(&data))
+    {
+        int converted(*value);
+        memcpy(target, &converted, sizeof(int));
+    }
+    else if(boost::get<std::string>(&data))
+    {
+        write_bytes_impl<std::string>(this, ctx, target);
+    }
+    else
+    {
+        boost::apply_visitor(CopyBytes(target), data);
+    }
+}
+
 UniformValue UniformValue::create_from_string_and_type(std::string const& value, UniformType const& ty)
 {
     switch(ty)
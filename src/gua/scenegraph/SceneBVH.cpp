@@ -0,0 +1,362 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+// class header
+#include <gua/scenegraph/SceneBVH.hpp>
+
+// guacamole headers
+#include <gua/node/Node.hpp>
+#include <gua/utils/KDTreeUtils.hpp>
+
+// external headers
+#include <algorithm>
+#include <functional>
+
+namespace gua
+{
+namespace
+{
+// maximum number of Nodes per leaf
+const std::uint32_t LEAF_SIZE = 4;
+
+bool is_hit(std::pair<float, float> const& box_hits) { return box_hits.first != Ray::END || box_hits.second != Ray::END; }
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SceneBVH::update(node::Node* root)
+{
+    if(root != root_ || structure_version_ != node::Node::get_structure_version())
+    {
+        rebuild(root);
+    }
+    else if(refit_required_)
+    {
+        refit();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SceneBVH::ray_test(std::vector<Ray> const& rays, int options, Mask const& mask, std::vector<PickResult>& hits, std::vector<std::size_t>& offsets) const
+{
+    hits.clear();
+    offsets.assign(rays.size() + 1, 0);
+
+    if(tree_.empty() || rays.empty())
+    {
+        return;
+    }
+
+    // hits are collected in sets first, as the geometry resources expect them
+    std::vector<std::set<PickResult>> ray_hits(rays.size());
+
+    // lazily evaluated results of mask checks; -1 means unknown
+    std::vector<std::int8_t> group_results(groups_.size(), -1);
+    std::vector<std::int8_t> primitive_results(primitives_.size(), -1);
+
+    // returns whether the ray may hit something inside the box
+    auto is_candidate = [&](std::uint32_t ray, math::BoundingBox<math::vec3> const& box) {
+        auto box_hits(::gua::intersect(rays[ray], box));
+
+        if(!is_hit(box_hits))
+        {
+            return false;
+        }
+
+        // skip the box if only the first object shall be returned and the
+        // current first hit is in front of the box's entry point
+        return !(options & PickResult::PICK_ONLY_FIRST_OBJECT && !ray_hits[ray].empty() && ray_hits[ray].begin()->distance < box_hits.first && box_hits.first != Ray::END);
+    };
+
+    // indices of the rays which are still active; each stack entry refers to
+    // a range of it. Ranges of entries further up the stack always start
+    // behind the ranges of the entries below.
+    std::vector<std::uint32_t> active_rays(rays.size());
+    for(std::uint32_t i(0); i < rays.size(); ++i)
+    {
+        active_rays[i] = i;
+    }
+
+    struct StackEntry
+    {
+        std::uint32_t tree_node;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    std::vector<StackEntry> stack{{0, 0, rays.size()}};
+
+    while(!stack.empty())
+    {
+        auto entry(stack.back());
+        stack.pop_back();
+
+        // ranges behind this one belong to finished subtrees
+        active_rays.resize(entry.end);
+
+        auto const& tree_node(tree_[entry.tree_node]);
+
+        std::size_t begin(active_rays.size());
+        for(std::size_t i(entry.begin); i < entry.end; ++i)
+        {
+            if(is_candidate(active_rays[i], tree_node.bounds))
+            {
+                active_rays.push_back(active_rays[i]);
+            }
+        }
+        std::size_t end(active_rays.size());
+
+        if(begin == end)
+        {
+            continue;
+        }
+
+        if(tree_node.count == 0)
+        {
+            std::uint32_t first(entry.tree_node + 1);
+            std::uint32_t second(tree_node.offset);
+
+            // visit the child closer to the first active ray first
+            auto const& origin(rays[active_rays[begin]].origin_);
+            auto distance = [&](std::uint32_t child) {
+                auto const& bounds(tree_[child].bounds);
+                return scm::math::length_sqr((bounds.min + bounds.max) * 0.5 - origin);
+            };
+
+            if(distance(first) > distance(second))
+            {
+                std::swap(first, second);
+            }
+
+            stack.push_back({second, begin, end});
+            stack.push_back({first, begin, end});
+            continue;
+        }
+
+        for(std::uint32_t p(tree_node.offset); p < tree_node.offset + tree_node.count; ++p)
+        {
+            auto const& primitive(primitives_[p]);
+
+            if(primitive_results[p] < 0)
+            {
+                bool rejected(is_rejected(primitive, mask, group_results) || (!primitive.test_subtree && !mask.check(primitive.node->get_tags())));
+                primitive_results[p] = rejected ? 0 : 1;
+            }
+
+            if(primitive_results[p] == 0)
+            {
+                continue;
+            }
+
+            auto const& bounds(primitive.node->get_bounding_box());
+
+            for(std::size_t i(begin); i < end; ++i)
+            {
+                auto ray(active_rays[i]);
+
+                if(primitive.test_subtree)
+                {
+                    primitive.node->ray_test_impl(rays[ray], options, mask, ray_hits[ray]);
+                }
+                else if(is_candidate(ray, bounds))
+                {
+                    primitive.node->ray_test_geometry(rays[ray], options, ray_hits[ray]);
+                }
+            }
+        }
+    }
+
+    for(std::size_t i(0); i < rays.size(); ++i)
+    {
+        offsets[i] = hits.size();
+        hits.insert(hits.end(), ray_hits[i].begin(), ray_hits[i].end());
+    }
+
+    offsets.back() = hits.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SceneBVH::rebuild(node::Node* root)
+{
+    root_ = root;
+    structure_version_ = node::Node::get_structure_version();
+
+    tree_.clear();
+    primitives_.clear();
+    groups_.clear();
+
+    if(!root)
+    {
+        return;
+    }
+
+    std::function<void(node::Node*, int)> collect = [&](node::Node* node, int group) {
+        switch(node->get_ray_test_mode())
+        {
+        case node::Node::RayTestMode::SUBTREE:
+            primitives_.push_back({node, group, true});
+            return;
+        case node::Node::RayTestMode::GEOMETRY:
+            primitives_.push_back({node, group, false});
+            break;
+        case node::Node::RayTestMode::GROUP:
+            groups_.push_back({node, group});
+            group = int(groups_.size() - 1);
+            break;
+        }
+
+        for(auto const& child : node->children_)
+        {
+            collect(child.get(), group);
+        }
+    };
+
+    collect(root, -1);
+
+    if(primitives_.empty())
+    {
+        return;
+    }
+
+    std::vector<math::vec3> centers;
+    std::vector<std::uint32_t> indices;
+
+    for(std::uint32_t i(0); i < primitives_.size(); ++i)
+    {
+        auto const& bounds(primitives_[i].node->get_bounding_box());
+        centers.push_back(bounds.isEmpty() ? math::vec3(0.0, 0.0, 0.0) : (bounds.min + bounds.max) * 0.5);
+        indices.push_back(i);
+    }
+
+    build(centers, indices, 0, std::uint32_t(primitives_.size()));
+
+    // store primitives in leaf order
+    std::vector<Primitive> ordered_primitives;
+    ordered_primitives.reserve(primitives_.size());
+
+    for(auto index : indices)
+    {
+        ordered_primitives.push_back(primitives_[index]);
+    }
+
+    primitives_.swap(ordered_primitives);
+
+    refit();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SceneBVH::refit()
+{
+    refit_required_ = false;
+
+    // children are stored behind their parents
+    for(std::size_t i(tree_.size()); i-- > 0;)
+    {
+        auto& tree_node(tree_[i]);
+        tree_node.bounds = math::BoundingBox<math::vec3>();
+
+        if(tree_node.count > 0)
+        {
+            for(std::uint32_t p(tree_node.offset); p < tree_node.offset + tree_node.count; ++p)
+            {
+                auto const& bounds(primitives_[p].node->get_bounding_box());
+
+                if(!bounds.isEmpty())
+                {
+                    tree_node.bounds.expandBy(bounds);
+                }
+            }
+        }
+        else
+        {
+            tree_node.bounds.expandBy(tree_[i + 1].bounds);
+            tree_node.bounds.expandBy(tree_[tree_node.offset].bounds);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::uint32_t SceneBVH::build(std::vector<math::vec3> const& centers, std::vector<std::uint32_t>& indices, std::uint32_t begin, std::uint32_t end)
+{
+    std::uint32_t index(std::uint32_t(tree_.size()));
+    tree_.push_back({math::BoundingBox<math::vec3>(), begin, end - begin});
+
+    if(end - begin <= LEAF_SIZE)
+    {
+        return index;
+    }
+
+    // split at the median along the largest extent of the centers
+    math::BoundingBox<math::vec3> center_bounds;
+    for(std::uint32_t i(begin); i < end; ++i)
+    {
+        center_bounds.expandBy(centers[indices[i]]);
+    }
+
+    unsigned axis(0);
+    for(unsigned i(1); i < 3; ++i)
+    {
+        if(center_bounds.size(i) > center_bounds.size(axis))
+        {
+            axis = i;
+        }
+    }
+
+    std::uint32_t middle(begin + (end - begin) / 2);
+    std::nth_element(indices.begin() + begin, indices.begin() + middle, indices.begin() + end, [&](std::uint32_t lhs, std::uint32_t rhs) { return centers[lhs][axis] < centers[rhs][axis]; });
+
+    build(centers, indices, begin, middle);
+    std::uint32_t second(build(centers, indices, middle, end));
+
+    tree_[index].offset = second;
+    tree_[index].count = 0;
+
+    return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SceneBVH::is_rejected(Primitive const& primitive, Mask const& mask, std::vector<std::int8_t>& group_results) const
+{
+    for(int group(primitive.group); group >= 0; group = groups_[group].parent)
+    {
+        if(group_results[group] < 0)
+        {
+            group_results[group] = mask.check(groups_[group].node->get_tags()) ? 1 : 0;
+        }
+
+        if(group_results[group] == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace gua
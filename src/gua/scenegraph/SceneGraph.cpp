@@ -29,12 +29,48 @@
 #include <gua/utils/DotGenerator.hpp>
 #include <gua/utils/Mask.hpp>
 #include <gua/utils/Logger.hpp>
+#include <gua/utils/KDTreeUtils.hpp>
 #include <gua/renderer/Serializer.hpp>
 #include <gua/node/CameraNode.hpp>
+#include <gua/node/ClippingPlaneNode.hpp>
+#include <gua/node/ScreenNode.hpp>
+#include <gua/memory.hpp>
 
 // external headers
+#include <algorithm>
 #include <iostream>
 
+namespace
+{
+// the node at the position of node in the deep copy of original_root
+std::shared_ptr<gua::node::Node> copied_node(gua::node::Node const* original_root, std::shared_ptr<gua::node::Node> const& copied_root, gua::node::Node const* node)
+{
+    std::vector<std::size_t> child_indices;
+
+    for(; node != original_root; node = node->get_parent())
+    {
+        if(!node->get_parent())
+        {
+            return nullptr;
+        }
+
+        auto const& siblings(node->get_parent()->get_children());
+        auto child(std::find_if(siblings.begin(), siblings.end(), [node](std::shared_ptr<gua::node::Node> const& sibling) { return sibling.get() == node; }));
+        child_indices.push_back(child - siblings.begin());
+    }
+
+    auto result(copied_root);
+    for(auto index(child_indices.rbegin()); result && index != child_indices.rend(); ++index)
+    {
+        auto const& children(result->get_children());
+        result = *index < children.size() ? children[*index] : nullptr;
+    }
+
+    return result;
+}
+
+} // namespace
+
 namespace gua
 {
 ////////////////////////////////////////////////////////////////////////////////
@@ -43,7 +79,107 @@ SceneGraph::SceneGraph(std::string const& name) : root_(new node::TransformNode(
 
 ////////////////////////////////////////////////////////////////////////////////
 
-SceneGraph::SceneGraph(SceneGraph const& graph) : root_(graph.root_ ? graph.root_->deep_copy() : nullptr), name_(graph.name_) { root_->set_scenegraph(this); }
+SceneGraph::SceneGraph(SceneGraph const& graph) : root_(graph.root_ ? graph.root_->deep_copy() : nullptr), name_(graph.name_)
+{
+    root_->set_scenegraph(this);
+    copy_resolved_screens(graph);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SceneGraph::copy_resolved_screens(SceneGraph const& graph)
+{
+    std::unordered_map<std::string, std::shared_ptr<node::ScreenNode>> screens;
+    std::size_t version;
+
+    {
+        std::lock_guard<std::mutex> lock(graph.resolved_screens_mutex_);
+        screens = graph.resolved_screens_;
+        version = graph.resolved_screens_version_;
+    }
+
+    // the deep copy has the same structure, hence the screens resolved in
+    // graph are found at the same positions in this graph
+    std::unordered_map<std::string, std::shared_ptr<node::ScreenNode>> copied_screens;
+
+    if(version == node::Node::get_structure_version())
+    {
+        for(auto const& screen : screens)
+        {
+            if(!screen.second)
+            {
+                copied_screens.emplace(screen.first, nullptr);
+            }
+            else if(auto copy = copied_node(graph.root_.get(), root_, screen.second.get()))
+            {
+                copied_screens.emplace(screen.first, std::static_pointer_cast<node::ScreenNode>(copy));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(resolved_screens_mutex_);
+    resolved_screens_.swap(copied_screens);
+    resolved_screens_version_ = version;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<SceneGraph> SceneGraph::snapshot() const
+{
+    // resolve the screens of the cameras in the original graph, where the
+    // results survive until the structure changes
+    for(auto camera : camera_nodes_)
+    {
+        get_screen_node(camera->config.left_screen_path());
+        get_screen_node(camera->config.right_screen_path());
+
+        if(camera->config.alternative_frustum_culling_screen_path() != "")
+        {
+            get_screen_node(camera->config.alternative_frustum_culling_screen_path());
+        }
+    }
+
+    // changes of public configurations are not noticed by the nodes
+    for(auto node : untracked_nodes_)
+    {
+        node->invalidate_snapshot();
+    }
+
+    auto graph(gua::make_unique<SceneGraph>(name_));
+    graph->root_ = root_ ? root_->snapshot() : nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(resolved_screens_mutex_);
+        if(resolved_screens_version_ == node::Node::get_structure_version())
+        {
+            for(auto const& screen : resolved_screens_)
+            {
+                graph->resolved_screens_[screen.first] = screen.second ? std::static_pointer_cast<node::ScreenNode>(screen.second->snapshot_) : nullptr;
+            }
+            graph->resolved_screens_version_ = resolved_screens_version_;
+        }
+    }
+
+    // snapshot nodes are not attached to a graph, hence the registered
+    // cameras and clipping planes are looked up from their originals
+    for(auto camera : camera_nodes_)
+    {
+        if(camera->snapshot_)
+        {
+            graph->camera_nodes_.push_back(static_cast<node::CameraNode*>(camera->snapshot_.get()));
+        }
+    }
+
+    for(auto plane : clipping_plane_nodes_)
+    {
+        if(plane->snapshot_)
+        {
+            graph->clipping_plane_nodes_.push_back(static_cast<node::ClippingPlaneNode*>(plane->snapshot_.get()));
+        }
+    }
+
+    return graph;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -77,7 +213,24 @@ std::string const& SceneGraph::get_name() const { return name_; }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void SceneGraph::set_root(std::shared_ptr<node::Node> const& root) { root_ = root; }
+void SceneGraph::set_root(std::shared_ptr<node::Node> const& root)
+{
+    // the registered nodes of the old root must not outlive it
+    if(root_)
+    {
+        root_->set_scenegraph(nullptr);
+    }
+
+    root_ = root;
+
+    if(root_)
+    {
+        root_->set_scenegraph(this);
+    }
+
+    std::lock_guard<std::mutex> lock(resolved_screens_mutex_);
+    resolved_screens_.clear();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -96,10 +249,50 @@ std::shared_ptr<node::Node> SceneGraph::operator[](std::string const& path_to_no
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<node::ScreenNode> SceneGraph::get_screen_node(std::string const& path_to_screen) const
+{
+    std::lock_guard<std::mutex> lock(resolved_screens_mutex_);
+
+    const std::size_t structure_version(node::Node::get_structure_version());
+    if(resolved_screens_version_ != structure_version)
+    {
+        resolved_screens_.clear();
+        resolved_screens_version_ = structure_version;
+    }
+
+    auto screen(resolved_screens_.find(path_to_screen));
+    if(screen != resolved_screens_.end())
+    {
+        return screen->second;
+    }
+
+    // paths without a screen are cached as well
+    auto result(std::dynamic_pointer_cast<node::ScreenNode>(find_node(path_to_screen, "/")));
+    resolved_screens_.emplace(path_to_screen, result);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 SceneGraph const& SceneGraph::operator=(SceneGraph const& rhs)
 {
+    if(root_)
+    {
+        root_->set_scenegraph(nullptr);
+    }
+
     root_ = rhs.root_ ? rhs.root_->deep_copy() : nullptr;
 
+    if(root_)
+    {
+        root_->set_scenegraph(this);
+    }
+
+    copy_resolved_screens(rhs);
+
+    std::lock_guard<std::mutex> lock(serialization_cache_mutex_);
+    serialization_cache_.clear();
+
     return *this;
 }
 
@@ -118,12 +311,43 @@ void SceneGraph::update_cache() const
 {
     if(root_)
     {
-        root_->update_cache();
+        if(transform_hierarchy_)
+        {
+            transform_hierarchy_->update(root_.get());
+        }
+        else
+        {
+            root_->update_cache();
+        }
+
+        // bounding boxes may have changed
+        if(bvh_)
+        {
+            bvh_->invalidate();
+        }
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void SceneGraph::set_enable_transform_hierarchy(bool enable)
+{
+    if(!enable)
+    {
+        transform_hierarchy_.reset();
+    }
+    else if(!transform_hierarchy_)
+    {
+        transform_hierarchy_ = gua::make_unique<TransformHierarchy>();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SceneGraph::get_enable_transform_hierarchy() const { return transform_hierarchy_ != nullptr; }
+
+////////////////////////////////////////////////////////////////////////////////
+
 std::shared_ptr<node::Node> SceneGraph::find_node(std::string const& path_to_node, std::string const& path_to_start) const
 {
     PathParser parser;
@@ -227,7 +451,62 @@ std::set<PickResult> const SceneGraph::ray_test(node::RayNode const& ray, int op
 
 ////////////////////////////////////////////////////////////////////////////////
 
-std::set<PickResult> const SceneGraph::ray_test(Ray const& ray, int options, Mask const& mask) { return root_->ray_test(ray, options, mask); }
+std::set<PickResult> const SceneGraph::ray_test(Ray const& ray, int options, Mask const& mask)
+{
+    if(!bvh_)
+    {
+        return root_->ray_test(ray, options, mask);
+    }
+
+    std::vector<PickResult> hits;
+    std::vector<std::size_t> offsets;
+    ray_test(std::vector<Ray>{ray}, hits, offsets, options, mask);
+
+    return std::set<PickResult>(hits.begin(), hits.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SceneGraph::ray_test(std::vector<Ray> const& rays, std::vector<PickResult>& hits, std::vector<std::size_t>& offsets, int options, Mask const& mask)
+{
+    if(bvh_)
+    {
+        bvh_->update(root_.get());
+        bvh_->ray_test(rays, options, mask, hits, offsets);
+        return;
+    }
+
+    hits.clear();
+    offsets.clear();
+
+    for(auto const& ray : rays)
+    {
+        offsets.push_back(hits.size());
+
+        auto ray_hits(root_->ray_test(ray, options, mask));
+        hits.insert(hits.end(), ray_hits.begin(), ray_hits.end());
+    }
+
+    offsets.push_back(hits.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SceneGraph::set_enable_bvh_ray_test(bool enable)
+{
+    if(!enable)
+    {
+        bvh_.reset();
+    }
+    else if(!bvh_)
+    {
+        bvh_ = gua::make_unique<SceneBVH>();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SceneGraph::get_enable_bvh_ray_test() const { return bvh_ != nullptr; }
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -249,14 +528,180 @@ SceneGraph::serialize(Frustum const& rendering_frustum, Frustum const& culling_f
 
 std::shared_ptr<SerializedScene> SceneGraph::serialize(node::SerializedCameraNode const& camera, CameraMode mode) const
 {
-    return serialize(camera.get_rendering_frustum(*this, mode),
-                     camera.get_culling_frustum(*this, mode),
-                     math::get_translation(camera.transform),
-                     camera.config.enable_frustum_culling(),
-                     camera.config.mask(),
-                     camera.config.view_id());
+    return serialize(std::vector<std::pair<node::SerializedCameraNode const*, CameraMode>>{std::make_pair(&camera, mode)}).front();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SceneGraph::SerializationCacheEntry SceneGraph::make_serialization_cache_key(node::SerializedCameraNode const& camera, CameraMode mode) const
+{
+    SerializationCacheEntry key{camera.uuid,
+                                mode,
+                                camera.config.mask(),
+                                camera.config.view_id(),
+                                camera.config.enable_frustum_culling(),
+                                camera.transform,
+                                camera.get_rendering_frustum(*this, mode),
+                                camera.get_culling_frustum(*this, mode),
+                                {},
+                                nullptr};
+
+    // the same planes as collected by the Serializer
+    for(auto plane : clipping_plane_nodes_)
+    {
+        if(plane->is_visible(key.view_id) && key.mask.check(plane->get_tags()))
+        {
+            key.clipping_planes.push_back(plane->get_component_vector());
+        }
+    }
+
+    return key;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::shared_ptr<SerializedScene>> SceneGraph::serialize(std::vector<std::pair<node::SerializedCameraNode const*, CameraMode>> const& views) const
+{
+    std::vector<std::shared_ptr<SerializedScene>> scenes(views.size());
+
+    // Frustum::operator== ignores the transformations
+    auto same_frustum = [](Frustum const& a, Frustum const& b) { return a == b && a.get_camera_transform() == b.get_camera_transform() && a.get_screen_transform() == b.get_screen_transform(); };
+
+    auto same_slot = [](SerializationCacheEntry const& entry, SerializationCacheEntry const& key) {
+        return entry.camera_uuid == key.camera_uuid && entry.mode == key.mode && entry.mask == key.mask && entry.view_id == key.view_id;
+    };
+
+    auto matches = [&](SerializationCacheEntry const& entry, SerializationCacheEntry const& key) {
+        return same_slot(entry, key) && entry.enable_frustum_culling == key.enable_frustum_culling && entry.camera_transform == key.camera_transform &&
+               same_frustum(entry.rendering_frustum, key.rendering_frustum) && same_frustum(entry.culling_frustum, key.culling_frustum) && entry.clipping_planes == key.clipping_planes;
+    };
+
+    std::vector<SerializationCacheEntry> keys;
+
+    if(enable_serialization_cache_)
+    {
+        for(auto const& view : views)
+        {
+            keys.push_back(make_serialization_cache_key(*view.first, view.second));
+        }
+
+        std::lock_guard<std::mutex> lock(serialization_cache_mutex_);
+
+        for(std::size_t i(0); i < views.size(); ++i)
+        {
+            for(auto const& entry : serialization_cache_)
+            {
+                if(matches(entry, keys[i]))
+                {
+                    scenes[i] = entry.scene;
+                    break;
+                }
+            }
+        }
+    }
+
+    // cull all views which are not cached yet in a single traversal
+    std::vector<Serializer::View> serializer_views;
+    std::vector<std::size_t> serialized_indices;
+
+    for(std::size_t i(0); i < views.size(); ++i)
+    {
+        if(scenes[i])
+        {
+            continue;
+        }
+
+        auto const& camera(*views[i].first);
+        auto mode(views[i].second);
+
+        scenes[i] = std::make_shared<SerializedScene>();
+        if(keys.empty())
+        {
+            scenes[i]->rendering_frustum = camera.get_rendering_frustum(*this, mode);
+            scenes[i]->culling_frustum = camera.get_culling_frustum(*this, mode);
+        }
+        else
+        {
+            scenes[i]->rendering_frustum = keys[i].rendering_frustum;
+            scenes[i]->culling_frustum = keys[i].culling_frustum;
+        }
+        scenes[i]->reference_camera_position = math::get_translation(camera.transform);
+
+        serializer_views.push_back({scenes[i].get(), camera.config.mask(), camera.config.enable_frustum_culling(), camera.config.view_id()});
+        serialized_indices.push_back(i);
+    }
+
+    if(serializer_views.empty())
+    {
+        return scenes;
+    }
+
+    Serializer s;
+    s.check(serializer_views, *this);
+
+    if(enable_serialization_cache_ && !keys.empty())
+    {
+        std::lock_guard<std::mutex> lock(serialization_cache_mutex_);
+
+        for(auto i : serialized_indices)
+        {
+            keys[i].scene = scenes[i];
+
+            auto entry(std::find_if(serialization_cache_.begin(), serialization_cache_.end(), [&](SerializationCacheEntry const& e) { return same_slot(e, keys[i]); }));
+
+            if(entry != serialization_cache_.end())
+            {
+                *entry = std::move(keys[i]);
+            }
+            else
+            {
+                serialization_cache_.push_back(std::move(keys[i]));
+            }
+        }
+    }
+
+    return scenes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::shared_ptr<SerializedScene>>
+SceneGraph::serialize(std::vector<Frustum> const& frustums, math::vec3 const& reference_camera_position, bool enable_frustum_culling, Mask const& mask, int view_id) const
+{
+    std::vector<std::shared_ptr<SerializedScene>> scenes;
+    std::vector<Serializer::View> views;
+
+    for(auto const& frustum : frustums)
+    {
+        auto scene(std::make_shared<SerializedScene>());
+        scene->rendering_frustum = frustum;
+        scene->culling_frustum = frustum;
+        scene->reference_camera_position = reference_camera_position;
+
+        views.push_back({scene.get(), mask, enable_frustum_culling, view_id});
+        scenes.push_back(scene);
+    }
+
+    Serializer s;
+    s.check(views, *this);
+
+    return scenes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SceneGraph::set_enable_serialization_cache(bool enable)
+{
+    std::lock_guard<std::mutex> lock(serialization_cache_mutex_);
+
+    enable_serialization_cache_ = enable;
+    serialization_cache_.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool SceneGraph::get_enable_serialization_cache() const { return enable_serialization_cache_; }
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // namespace gua
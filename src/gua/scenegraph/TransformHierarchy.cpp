@@ -0,0 +1,211 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+// class header
+#include <gua/scenegraph/TransformHierarchy.hpp>
+
+// guacamole headers
+#include <gua/node/Node.hpp>
+#include <gua/concurrent/ThreadPool.hpp>
+
+namespace gua
+{
+namespace
+{
+// levels smaller than this are processed on the calling thread
+const std::size_t GRAIN_SIZE = 256;
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TransformHierarchy::rebuild(node::Node* root)
+{
+    root_ = root;
+    structure_version_ = node::Node::get_structure_version();
+
+    nodes_.clear();
+    parents_.clear();
+    flags_.clear();
+    level_offsets_.clear();
+
+    nodes_.push_back(root);
+    parents_.push_back(-1);
+    level_offsets_.push_back(0);
+
+    std::size_t level_begin(0);
+
+    while(level_begin < nodes_.size())
+    {
+        std::size_t level_end(nodes_.size());
+
+        for(std::size_t i(level_begin); i < level_end; ++i)
+        {
+            auto node(nodes_[i]);
+
+            if(!node->supports_flat_update())
+            {
+                flags_.push_back(RECURSIVE);
+                continue;
+            }
+
+            flags_.push_back(0);
+
+            for(auto const& child : node->children_)
+            {
+                nodes_.push_back(child.get());
+                parents_.push_back(int(i));
+            }
+        }
+
+        level_offsets_.push_back(level_end);
+        level_begin = level_end;
+    }
+
+    local_transforms_.resize(nodes_.size());
+    world_transforms_.resize(nodes_.size());
+
+    for(std::size_t i(0); i < nodes_.size(); ++i)
+    {
+        local_transforms_[i] = nodes_[i]->get_transform();
+        world_transforms_[i] = nodes_[i]->world_transform_;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TransformHierarchy::update(node::Node* root)
+{
+    if(root != root_ || structure_version_ != node::Node::get_structure_version())
+    {
+        rebuild(root);
+    }
+
+    auto pool(concurrent::ThreadPool::instance());
+
+    // gather dirty flags and local transformations of dirty nodes
+    pool->parallel_for(0,
+                       nodes_.size(),
+                       [this](std::size_t begin, std::size_t end) {
+                           for(std::size_t i(begin); i < end; ++i)
+                           {
+                               auto node(nodes_[i]);
+                               std::uint8_t flags(flags_[i] & RECURSIVE);
+
+                               if(node->self_dirty_)
+                               {
+                                   flags |= SELF_DIRTY;
+
+                                   if(!(flags & RECURSIVE))
+                                   {
+                                       local_transforms_[i] = node->get_transform();
+                                   }
+                               }
+
+                               if(node->child_dirty_)
+                               {
+                                   flags |= CHILD_DIRTY;
+                               }
+
+                               flags_[i] = flags;
+                           }
+                       },
+                       GRAIN_SIZE);
+
+    // resolve resources (e.g. geometries) on the calling thread
+    for(std::size_t i(0); i < nodes_.size(); ++i)
+    {
+        if((flags_[i] & (SELF_DIRTY | RECURSIVE)) == SELF_DIRTY)
+        {
+            nodes_[i]->prepare_flat_update();
+        }
+    }
+
+    // top-down: world transformations
+    for(std::size_t level(0); level + 1 < level_offsets_.size(); ++level)
+    {
+        pool->parallel_for(level_offsets_[level],
+                           level_offsets_[level + 1],
+                           [this](std::size_t begin, std::size_t end) {
+                               for(std::size_t i(begin); i < end; ++i)
+                               {
+                                   if((flags_[i] & (SELF_DIRTY | RECURSIVE)) != SELF_DIRTY)
+                                   {
+                                       continue;
+                                   }
+
+                                   math::mat4 world(parents_[i] < 0 ? local_transforms_[i] : world_transforms_[parents_[i]] * local_transforms_[i]);
+
+                                   if(world != world_transforms_[i])
+                                   {
+                                       world_transforms_[i] = world;
+                                       flags_[i] |= CHANGED;
+                                   }
+
+                                   nodes_[i]->world_transform_ = world;
+                                   nodes_[i]->self_dirty_ = false;
+                               }
+                           },
+                           GRAIN_SIZE);
+
+        // nodes which compute their world transformation on their own may
+        // load resources in update_cache(), hence they are processed serially
+        for(std::size_t i(level_offsets_[level]); i < level_offsets_[level + 1]; ++i)
+        {
+            if((flags_[i] & RECURSIVE) && (flags_[i] & (SELF_DIRTY | CHILD_DIRTY)))
+            {
+                nodes_[i]->update_cache();
+            }
+        }
+    }
+
+    // signals are emitted on the calling thread only
+    for(std::size_t i(0); i < nodes_.size(); ++i)
+    {
+        if(flags_[i] & CHANGED)
+        {
+            nodes_[i]->on_world_transform_changed.emit(world_transforms_[i]);
+        }
+    }
+
+    // bottom-up: bounding boxes
+    for(std::size_t level(level_offsets_.size() - 1); level-- > 0;)
+    {
+        pool->parallel_for(level_offsets_[level],
+                           level_offsets_[level + 1],
+                           [this](std::size_t begin, std::size_t end) {
+                               for(std::size_t i(begin); i < end; ++i)
+                               {
+                                   if((flags_[i] & (CHILD_DIRTY | RECURSIVE)) != CHILD_DIRTY)
+                                   {
+                                       continue;
+                                   }
+
+                                   nodes_[i]->update_bounding_box();
+                                   nodes_[i]->child_dirty_ = false;
+                               }
+                           },
+                           GRAIN_SIZE);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace gua
@@ -0,0 +1,445 @@
+/******************************************************************************
+ * guacamole - delicious VR                                                   *
+ *                                                                            *
+ * Copyright: (c) 2011-2013 Bauhaus-Universität Weimar                        *
+ * Contact:   felix.lauer@uni-weimar.de / simon.schneegans@uni-weimar.de      *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify it    *
+ * under the terms of the GNU General Public License as published by the Free *
+ * Software Foundation, either version 3 of the License, or (at your option)  *
+ * any later version.                                                         *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful, but        *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License   *
+ * for more details.                                                          *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License along    *
+ * with this program. If not, see <http://www.gnu.org/licenses/>.             *
+ *                                                                            *
+ ******************************************************************************/
+
+
+// class header
+#include <gua/utils/InterleavedMesh.hpp>
+
+// external headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace gua
+{
+namespace
+{
+// size of the simulated post-transform vertex cache
+const unsigned CACHE_SIZE = 32;
+
+// vertices which are in the cache and belong to few remaining triangles are
+// preferred
+float vertex_score(int cache_position, unsigned remaining_triangles)
+{
+    if(remaining_triangles == 0)
+    {
+        return -1.f;
+    }
+
+    float score(0.f);
+
+    if(cache_position >= 0)
+    {
+        // the vertices of the last triangle get a fixed score, otherwise
+        // triangles would be chosen which share a vertex with it only
+        score = cache_position < 3 ? 0.75f : std::pow(1.f - float(cache_position - 3) / float(CACHE_SIZE - 3), 1.5f);
+    }
+
+    return score + 2.f * std::pow(float(remaining_triangles), -0.5f);
+}
+
+template <typename T>
+bool is_zero(std::vector<T> const& values, unsigned count, unsigned components)
+{
+    if(values.size() < count)
+    {
+        return true;
+    }
+
+    for(unsigned i(0); i < count; ++i)
+    {
+        for(unsigned c(0); c < components; ++c)
+        {
+            if(values[i][c] != 0.f)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+float* append(float* target, T const& value, unsigned components)
+{
+    for(unsigned c(0); c < components; ++c)
+    {
+        *target++ = value[c];
+    }
+
+    return target;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+InterleavedMesh::InterleavedMesh() : vertices_(std::make_shared<float>(0.f)), indices_(std::make_shared<unsigned>(0)) {}
+
+////////////////////////////////////////////////////////////////////////////////
+
+InterleavedMesh::InterleavedMesh(Mesh const& mesh, unsigned attributes, bool optimize) : num_vertices_(mesh.num_vertices), num_triangles_(unsigned(mesh.indices.size() / 3))
+{
+    // attributes which are zero for all vertices carry no information
+    if(is_zero(mesh.texCoords, num_vertices_, 2))
+    {
+        attributes &= ~TEXCOORDS;
+    }
+
+    if(is_zero(mesh.normals, num_vertices_, 3))
+    {
+        attributes &= ~NORMALS;
+    }
+
+    if(is_zero(mesh.tangents, num_vertices_, 3))
+    {
+        attributes &= ~TANGENTS;
+    }
+
+    if(is_zero(mesh.bitangents, num_vertices_, 3))
+    {
+        attributes &= ~BITANGENTS;
+    }
+
+    attributes_ = attributes & ALL_ATTRIBUTES;
+    compute_layout();
+
+    auto vertices(std::make_shared<std::vector<float>>(std::size_t(num_vertices_) * vertex_size_));
+    float* target(vertices->data());
+
+    for(unsigned v(0); v < num_vertices_; ++v)
+    {
+        target = append(target, mesh.positions[v], 3);
+
+        if(attributes_ & TEXCOORDS)
+        {
+            target = append(target, mesh.texCoords[v], 2);
+        }
+
+        if(attributes_ & NORMALS)
+        {
+            target = append(target, mesh.normals[v], 3);
+        }
+
+        if(attributes_ & TANGENTS)
+        {
+            target = append(target, mesh.tangents[v], 3);
+        }
+
+        if(attributes_ & BITANGENTS)
+        {
+            target = append(target, mesh.bitangents[v], 3);
+        }
+    }
+
+    auto indices(std::make_shared<std::vector<unsigned>>(mesh.indices.begin(), mesh.indices.begin() + std::size_t(num_triangles_) * 3));
+
+    if(optimize)
+    {
+        optimize_indices(num_vertices_, vertex_size_, vertices->data(), *indices);
+    }
+
+    vertices_ = std::shared_ptr<float const>(vertices, vertices->data());
+    indices_ = std::shared_ptr<unsigned const>(indices, indices->data());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+InterleavedMesh::InterleavedMesh(
+    unsigned attributes, unsigned num_vertices, std::shared_ptr<float const> const& vertices, unsigned num_triangles, std::shared_ptr<unsigned const> const& indices)
+    : attributes_(attributes & ALL_ATTRIBUTES), num_vertices_(num_vertices), num_triangles_(num_triangles), vertices_(vertices), indices_(indices)
+{
+    compute_layout();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void InterleavedMesh::compute_layout()
+{
+    // the order matches Mesh::Vertex
+    vertex_size_ = 3;
+    texcoords_offset_ = 0;
+    normal_offset_ = 0;
+    tangent_offset_ = 0;
+    bitangent_offset_ = 0;
+
+    if(attributes_ & TEXCOORDS)
+    {
+        texcoords_offset_ = vertex_size_;
+        vertex_size_ += 2;
+    }
+
+    if(attributes_ & NORMALS)
+    {
+        normal_offset_ = vertex_size_;
+        vertex_size_ += 3;
+    }
+
+    if(attributes_ & TANGENTS)
+    {
+        tangent_offset_ = vertex_size_;
+        vertex_size_ += 3;
+    }
+
+    if(attributes_ & BITANGENTS)
+    {
+        bitangent_offset_ = vertex_size_;
+        vertex_size_ += 3;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+scm::gl::vertex_format InterleavedMesh::get_vertex_format() const
+{
+    int const stride = int(get_vertex_size());
+    scm::gl::vertex_format format(0, 0, scm::gl::TYPE_VEC3F, stride);
+
+    if(attributes_ & TEXCOORDS)
+    {
+        format(0, 1, scm::gl::TYPE_VEC2F, stride);
+    }
+
+    if(attributes_ & NORMALS)
+    {
+        format(0, 2, scm::gl::TYPE_VEC3F, stride);
+    }
+
+    if(attributes_ & TANGENTS)
+    {
+        format(0, 3, scm::gl::TYPE_VEC3F, stride);
+    }
+
+    if(attributes_ & BITANGENTS)
+    {
+        format(0, 4, scm::gl::TYPE_VEC3F, stride);
+    }
+
+    return format;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void InterleavedMesh::optimize_indices(unsigned num_vertices, unsigned vertex_size, float* vertices, std::vector<unsigned>& indices)
+{
+    std::size_t const num_triangles(indices.size() / 3);
+
+    if(num_triangles == 0)
+    {
+        return;
+    }
+
+    // the triangles of each vertex; the first remaining[v] ones of a vertex
+    // have not been emitted yet
+    std::vector<unsigned> offsets(num_vertices + 1, 0);
+
+    for(auto index : indices)
+    {
+        ++offsets[index + 1];
+    }
+
+    for(unsigned v(0); v < num_vertices; ++v)
+    {
+        offsets[v + 1] += offsets[v];
+    }
+
+    std::vector<unsigned> adjacency(indices.size());
+    std::vector<unsigned> remaining(num_vertices, 0);
+
+    for(std::size_t i(0); i < indices.size(); ++i)
+    {
+        auto vertex(indices[i]);
+        adjacency[offsets[vertex] + remaining[vertex]++] = unsigned(i / 3);
+    }
+
+    std::vector<int> cache_position(num_vertices, -1);
+    std::vector<float> score(num_vertices);
+
+    for(unsigned v(0); v < num_vertices; ++v)
+    {
+        score[v] = vertex_score(-1, remaining[v]);
+    }
+
+    std::vector<float> triangle_score(num_triangles, 0.f);
+    std::vector<bool> emitted(num_triangles, false);
+
+    for(std::size_t i(0); i < indices.size(); ++i)
+    {
+        triangle_score[i / 3] += score[indices[i]];
+    }
+
+    std::vector<unsigned> result;
+    result.reserve(indices.size());
+
+    std::vector<unsigned> cache;
+    std::vector<unsigned> new_cache;
+    cache.reserve(CACHE_SIZE + 3);
+    new_cache.reserve(CACHE_SIZE + 3);
+
+    std::size_t best(std::max_element(triangle_score.begin(), triangle_score.end()) - triangle_score.begin());
+    std::size_t next_unemitted(0);
+
+    while(result.size() < indices.size())
+    {
+        emitted[best] = true;
+        new_cache.clear();
+
+        for(unsigned c(0); c < 3; ++c)
+        {
+            auto vertex(indices[best * 3 + c]);
+            result.push_back(vertex);
+
+            // degenerate triangles list a vertex twice and are adjacent to it
+            // twice as well, hence one entry is removed per occurrence
+            auto begin(adjacency.begin() + offsets[vertex]);
+            auto end(begin + remaining[vertex]);
+            std::iter_swap(std::find(begin, end, unsigned(best)), end - 1);
+            --remaining[vertex];
+
+            if(std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+            {
+                new_cache.push_back(vertex);
+            }
+        }
+
+        for(auto vertex : cache)
+        {
+            if(std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+            {
+                new_cache.push_back(vertex);
+            }
+        }
+
+        // update the scores of all cached vertices and of those which were
+        // pushed out of the cache
+        for(std::size_t i(0); i < new_cache.size(); ++i)
+        {
+            auto vertex(new_cache[i]);
+            cache_position[vertex] = i < CACHE_SIZE ? int(i) : -1;
+
+            float const new_score(vertex_score(cache_position[vertex], remaining[vertex]));
+            float const delta(new_score - score[vertex]);
+            score[vertex] = new_score;
+
+            for(unsigned t(offsets[vertex]); t < offsets[vertex] + remaining[vertex]; ++t)
+            {
+                triangle_score[adjacency[t]] += delta;
+            }
+        }
+
+        new_cache.resize(std::min<std::size_t>(new_cache.size(), CACHE_SIZE));
+        cache.swap(new_cache);
+
+        // continue with the best triangle using a cached vertex
+        float best_score(-1.f);
+
+        for(auto vertex : cache)
+        {
+            for(unsigned t(offsets[vertex]); t < offsets[vertex] + remaining[vertex]; ++t)
+            {
+                if(triangle_score[adjacency[t]] > best_score)
+                {
+                    best_score = triangle_score[adjacency[t]];
+                    best = adjacency[t];
+                }
+            }
+        }
+
+        // otherwise with any remaining triangle
+        if(best_score < 0.f && result.size() < indices.size())
+        {
+            while(emitted[next_unemitted])
+            {
+                ++next_unemitted;
+            }
+
+            best = next_unemitted;
+        }
+    }
+
+    // renumber the vertices in the order of their first use
+    unsigned const unused(std::numeric_limits<unsigned>::max());
+    std::vector<unsigned> remap(num_vertices, unused);
+    unsigned next_vertex(0);
+
+    for(auto& index : result)
+    {
+        if(remap[index] == unused)
+        {
+            remap[index] = next_vertex++;
+        }
+
+        index = remap[index];
+    }
+
+    for(auto& index : remap)
+    {
+        if(index == unused)
+        {
+            index = next_vertex++;
+        }
+    }
+
+    std::vector<float> reordered(std::size_t(num_vertices) * vertex_size);
+
+    for(unsigned v(0); v < num_vertices; ++v)
+    {
+        std::copy(vertices + std::size_t(v) * vertex_size, vertices + std::size_t(v + 1) * vertex_size, reordered.begin() + std::size_t(remap[v]) * vertex_size);
+    }
+
+    std::copy(reordered.begin(), reordered.end(), vertices);
+    indices.swap(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+float InterleavedMesh::average_cache_miss_ratio(std::vector<unsigned> const& indices, unsigned cache_size)
+{
+    if(indices.size() < 3)
+    {
+        return 0.f;
+    }
+
+    std::vector<unsigned> cache;
+    std::size_t misses(0);
+
+    for(auto index : indices)
+    {
+        if(std::find(cache.begin(), cache.end(), index) == cache.end())
+        {
+            ++misses;
+            cache.push_back(index);
+
+            if(cache.size() > cache_size)
+            {
+                cache.erase(cache.begin());
+            }
+        }
+    }
+
+    return float(misses) / float(indices.size() / 3);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace gua
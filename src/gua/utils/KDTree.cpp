@@ -21,448 +21,844 @@
 
 #include <gua/math/math.hpp>
 #include <gua/utils/KDTree.hpp>
+#include <gua/concurrent/ThreadPool.hpp>
 
 #include <gua/platform.hpp>
 
+#include <array>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GUA_KD_TREE_SSE
+#include <xmmintrin.h>
+#endif
 
 namespace gua
 {
-KDTree::KDTree() : root_(nullptr), current_visit_flag_(0) {}
+namespace
+{
+using BoundingBox = math::BoundingBox<math::vec3>;
+
+// number of candidate splitting planes per dimension is BIN_COUNT - 1
+const unsigned BIN_COUNT = 32;
+
+// nodes with up to this many triangles consider all triangle bounds
+const std::size_t EXACT_SAH_SIZE = 64;
+
+// relative costs of traversing an inner node and intersecting a triangle
+const double TRAVERSAL_COST = 1.0;
+const double INTERSECTION_COST = 1.0;
+
+// splits which cut off at least MIN_EMPTY_FRACTION of a node as empty space
+// are favoured by this factor
+const double EMPTY_BONUS = 0.5;
+const double MIN_EMPTY_FRACTION = 0.1;
+
+// leaves with this many triangles are not split any further
+const std::size_t MAX_LEAF_SIZE = 4;
+
+// splits which do not pay off are accepted up to this many times per path
+const unsigned MAX_BAD_REFINES = 3;
+
+// subtrees with more triangles are built in parallel
+const std::size_t PARALLEL_THRESHOLD = 16384;
 
-void KDTree::generate(Mesh const& mesh)
+// number of triangles which are intersected at once
+const unsigned PACK_SIZE = 4;
+
+// single precision copy of a ray used for triangle intersections
+struct TraversalRay
+{
+    float origin[3];
+    float direction[3];
+    float t_max;
+};
+
+// four triangles in structure-of-arrays layout, given as one vertex and two
+// edges each
+struct TrianglePack
 {
-    triangles_.resize(mesh.num_triangles);
+    float v0[3][PACK_SIZE];
+    float e1[3][PACK_SIZE];
+    float e2[3][PACK_SIZE];
+};
 
-    for(unsigned i(0); i < mesh.num_triangles; ++i)
-    {
-        triangles_[i] = Triangle(i);
-    }
+double half_area(double a, double b, double c) { return a * b + b * c + c * a; }
 
-    std::vector<std::vector<LeafData>> sorted_triangles(3);
+// position of the i-th vertex of a triangle
+inline scm::math::vec3f const& triangle_position(Mesh const& mesh, std::size_t face, unsigned i) { return mesh.positions[mesh.indices[face * 3 + i]]; }
 
-    for(unsigned i(0); i < 3; ++i)
-        sorted_triangles[i] = std::vector<LeafData>(triangles_.size());
+inline scm::math::vec3f const& triangle_position(InterleavedMesh const& mesh, std::size_t face, unsigned i) { return mesh.get_position(mesh.get_indices()[face * 3 + i]); }
 
-    math::BoundingBox<math::vec3> root_bounds;
+inline unsigned triangle_count(Mesh const& mesh) { return mesh.num_triangles; }
 
-    for(unsigned i(0); i < triangles_.size(); ++i)
+inline unsigned triangle_count(InterleavedMesh const& mesh) { return mesh.get_num_triangles(); }
+
+template <typename MeshType>
+void load_pack(MeshType const& mesh, unsigned const* faces, unsigned count, TrianglePack& pack)
+{
+    for(unsigned lane(0); lane < PACK_SIZE; ++lane)
     {
-        for(unsigned j(0); j < 3; ++j)
+        // unused lanes repeat the first triangle, their results are ignored
+        unsigned face(faces[lane < count ? lane : 0]);
+
+        auto const& p0(triangle_position(mesh, face, 0));
+        auto const& p1(triangle_position(mesh, face, 1));
+        auto const& p2(triangle_position(mesh, face, 2));
+
+        for(unsigned c(0); c < 3; ++c)
         {
-            sorted_triangles[j][i] = LeafData(mesh, triangles_[i], i);
-            root_bounds.expandBy(triangles_[i].get_vertex(mesh, j));
+            pack.v0[c][lane] = p0[c];
+            pack.e1[c][lane] = p1[c] - p0[c];
+            pack.e2[c][lane] = p2[c] - p0[c];
         }
     }
+}
 
-    //below allows axis-aligned tris to be picked.
-    //axis-aligned tris cause unreliable picking when the boundary of
-    //the kdtree coincides with the triangle. therefore, we expand
-    //the box before building the tree. 
-    auto dim = root_bounds.max - root_bounds.min;
-    root_bounds.min -= 0.01f * dim;
-    root_bounds.max += 0.01f * dim;
+#if defined(GUA_KD_TREE_SSE)
 
-    for(unsigned i(0); i < 3; ++i)
-    {
-        LeafData::Comparator comp(i);
-        std::sort(sorted_triangles[i].begin(), sorted_triangles[i].end(), comp);
-    }
+// Moeller-Trumbore test of four triangles. Writes the distances along the ray
+// to t and returns a bit mask of the triangles which are hit in (0, 1) and
+// not farther away than ray.t_max
+int intersect_pack(TrianglePack const& pack, TraversalRay const& ray, float* t)
+{
+    __m128 dx(_mm_set1_ps(ray.direction[0]));
+    __m128 dy(_mm_set1_ps(ray.direction[1]));
+    __m128 dz(_mm_set1_ps(ray.direction[2]));
+
+    __m128 e1x(_mm_loadu_ps(pack.e1[0])), e1y(_mm_loadu_ps(pack.e1[1])), e1z(_mm_loadu_ps(pack.e1[2]));
+    __m128 e2x(_mm_loadu_ps(pack.e2[0])), e2y(_mm_loadu_ps(pack.e2[1])), e2z(_mm_loadu_ps(pack.e2[2]));
+
+    // p = d x e2
+    __m128 px(_mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y)));
+    __m128 py(_mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z)));
+    __m128 pz(_mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x)));
+
+    __m128 det(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz)));
+    __m128 inv_det(_mm_div_ps(_mm_set1_ps(1.f), det));
+
+    // s = o - v0
+    __m128 sx(_mm_sub_ps(_mm_set1_ps(ray.origin[0]), _mm_loadu_ps(pack.v0[0])));
+    __m128 sy(_mm_sub_ps(_mm_set1_ps(ray.origin[1]), _mm_loadu_ps(pack.v0[1])));
+    __m128 sz(_mm_sub_ps(_mm_set1_ps(ray.origin[2]), _mm_loadu_ps(pack.v0[2])));
 
-    root_ = build(sorted_triangles, root_bounds);
+    __m128 u(_mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv_det));
+
+    // q = s x e1
+    __m128 qx(_mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y)));
+    __m128 qy(_mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z)));
+    __m128 qz(_mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x)));
+
+    __m128 v(_mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv_det));
+    __m128 distance(_mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv_det));
+
+    __m128 zero(_mm_setzero_ps());
+    __m128 one(_mm_set1_ps(1.f));
+
+    __m128 hit(_mm_cmpneq_ps(det, zero));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+    hit = _mm_and_ps(hit, _mm_cmpgt_ps(distance, zero));
+    hit = _mm_and_ps(hit, _mm_cmplt_ps(distance, one));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(distance, _mm_set1_ps(ray.t_max)));
+
+    _mm_storeu_ps(t, distance);
+
+    return _mm_movemask_ps(hit);
 }
 
-void KDTree::ray_test(Ray const& ray, Mesh const& mesh, int options, node::Node* owner, std::set<PickResult>& hits) const
+#else
+
+int intersect_pack(TrianglePack const& pack, TraversalRay const& ray, float* t)
 {
-    if(root_)
+    int result(0);
+
+    for(unsigned lane(0); lane < PACK_SIZE; ++lane)
     {
-        current_options_ = options;
-        current_owner_ = owner;
-        ++current_visit_flag_;
+        float const* d(ray.direction);
+        float e1[3] = {pack.e1[0][lane], pack.e1[1][lane], pack.e1[2][lane]};
+        float e2[3] = {pack.e2[0][lane], pack.e2[1][lane], pack.e2[2][lane]};
+        float s[3] = {ray.origin[0] - pack.v0[0][lane], ray.origin[1] - pack.v0[1][lane], ray.origin[2] - pack.v0[2][lane]};
 
-        if(options & PickResult::PICK_ONLY_FIRST_FACE && options & PickResult::PICK_ONLY_FIRST_OBJECT)
+        float p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+        float det(e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2]);
+
+        if(det == 0.f)
         {
-            // override any existing intersection if it's closer
-            intersect_one(root_, ray, mesh, options, triangles_, hits);
+            continue;
         }
-        else if(options & PickResult::PICK_ONLY_FIRST_FACE)
-        {
-            // add newly found intersection to intersections list
-            std::set<PickResult> new_hit;
-            intersect_one(root_, ray, mesh, options, triangles_, new_hit);
 
-            if(!new_hit.empty())
-                hits.insert(*new_hit.begin());
-        }
-        else if(options & PickResult::PICK_ONLY_FIRST_OBJECT)
+        float inv_det(1.f / det);
+        float u((s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv_det);
+
+        float q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+        float v((d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv_det);
+
+        t[lane] = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv_det;
+
+        if(u >= 0.f && v >= 0.f && u + v <= 1.f && t[lane] > 0.f && t[lane] < 1.f && t[lane] <= ray.t_max)
         {
-            // override all existing intersections and replace 'em
-            std::set<PickResult> new_hits;
-            intersect_all(root_, ray, mesh, options, triangles_, new_hits);
+            result |= 1 << lane;
+        }
+    }
 
-            if(!new_hits.empty())
-            {
-                if(hits.empty() || new_hits.begin()->distance < hits.begin()->distance)
-                {
-                    hits = new_hits;
-                }
-            }
+    return result;
+}
+
+#endif
+
+template <typename MeshType>
+PickResult make_pick_result(MeshType const& mesh, Ray const& ray, float distance, unsigned face, int options, node::Node* owner)
+{
+    Triangle const triangle(face);
+
+    float const inf(std::numeric_limits<float>::max());
+    math::vec3 position(inf, inf, inf), world_position(inf, inf, inf), normal(inf, inf, inf), world_normal(inf, inf, inf);
+    math::vec2 tex_coords;
+
+    if(options & PickResult::GET_POSITIONS || options & PickResult::GET_WORLD_POSITIONS || options & PickResult::INTERPOLATE_NORMALS || options & PickResult::GET_TEXTURE_COORDS)
+    {
+        position = ray.origin_ + distance * ray.direction_;
+    }
+
+    if(options & PickResult::GET_NORMALS || options & PickResult::GET_WORLD_NORMALS)
+    {
+        if(options & PickResult::INTERPOLATE_NORMALS)
+        {
+            normal = triangle.get_normal_interpolated(mesh, position);
         }
         else
         {
-            // add all intersections
-            intersect_all(root_, ray, mesh, options, triangles_, hits);
+            normal = triangle.get_normal(mesh);
         }
     }
+
+    if(options & PickResult::GET_TEXTURE_COORDS)
+    {
+        tex_coords = triangle.get_texture_coords_interpolated(mesh, position);
+    }
+
+    return PickResult(distance, owner, position, world_position, normal, world_normal, tex_coords);
 }
 
-KDTree::KDNode* KDTree::build(std::vector<std::vector<LeafData>> const& sorted_triangles, math::BoundingBox<math::vec3> const& bounds)
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+KDTree::KDTree() : nodes_(), triangle_indices_(), bounds_() {}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void KDTree::generate(Mesh const& mesh) { generate_impl(mesh); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void KDTree::generate(InterleavedMesh const& mesh) { generate_impl(mesh); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename MeshType>
+void KDTree::generate_impl(MeshType const& mesh)
 {
-    // determine splitting dimension
-    unsigned dim(0);
-    for(unsigned i(1); i < 3; ++i)
+    nodes_.clear();
+    triangle_indices_.clear();
+    bounds_ = BoundingBox();
+
+    unsigned const num_triangles(triangle_count(mesh));
+
+    if(num_triangles == 0)
     {
-        if(bounds.size(i) > bounds.size(dim))
-            dim = i;
+        return;
     }
 
-    // return empty leaf if there are no triangles left
-    if(sorted_triangles[dim].size() == 0)
+    std::vector<LeafData> data(num_triangles);
+
+    concurrent::ThreadPool::instance()->parallel_for(0,
+                                                     num_triangles,
+                                                     [&](std::size_t begin, std::size_t end) {
+                                                         for(std::size_t i(begin); i < end; ++i)
+                                                         {
+                                                             auto const& p0(triangle_position(mesh, i, 0));
+                                                             auto const& p1(triangle_position(mesh, i, 1));
+                                                             auto const& p2(triangle_position(mesh, i, 2));
+
+                                                             data[i].id_ = unsigned(i);
+
+                                                             for(unsigned dim(0); dim < 3; ++dim)
+                                                             {
+                                                                 data[i].min_[dim] = std::min(std::min(p0[dim], p1[dim]), p2[dim]);
+                                                                 data[i].max_[dim] = std::max(std::max(p0[dim], p1[dim]), p2[dim]);
+                                                             }
+                                                         }
+                                                     },
+                                                     4096);
+
+    for(auto const& triangle : data)
     {
-        return new KDNode;
+        bounds_.expandBy(math::vec3(triangle.min_[0], triangle.min_[1], triangle.min_[2]));
+        bounds_.expandBy(math::vec3(triangle.max_[0], triangle.max_[1], triangle.max_[2]));
     }
 
-    // return leaf with one triangle if there is only one left
-    if(sorted_triangles[dim].size() == 1)
+    // below allows axis-aligned tris to be picked.
+    // axis-aligned tris cause unreliable picking when the boundary of
+    // the kdtree coincides with the triangle. therefore, we expand
+    // the box before building the tree. flat meshes get a small
+    // thickness, otherwise the SAH could not compare any splits.
+    auto dim = bounds_.max - bounds_.min;
+    auto min_extent(1e-4 * std::max(std::max(dim[0], dim[1]), dim[2]));
+
+    for(unsigned i(0); i < 3; ++i)
     {
-        return new KDNode(std::vector<LeafData>({sorted_triangles[dim].front()}));
+        auto padding(0.01 * std::max(dim[i], min_extent));
+        bounds_.min[i] -= padding;
+        bounds_.max[i] += padding;
     }
 
-    // select splitting position as minimum point of median triangles bounding
-    // box
-    float split_position(sorted_triangles[dim][sorted_triangles[dim].size() / 2].bbox_.min[dim]);
+    unsigned max_depth(unsigned(8 + 1.3 * std::log2(double(data.size()))));
 
-    // list for children
-    std::vector<std::vector<LeafData>> left_list(3);
-    std::vector<std::vector<LeafData>> right_list(3);
+    nodes_.reserve(2 * data.size());
+    triangle_indices_.reserve(2 * data.size());
 
-    // bounding boxes for children
-    math::BoundingBox<math::vec3> left_bounds;
-    math::BoundingBox<math::vec3> right_bounds;
+    build(data, bounds_, max_depth, 0, nodes_, triangle_indices_);
 
-    // put all triangles into the appropriate lists
-    for(unsigned i(0); i < 3; ++i)
+    nodes_.shrink_to_fit();
+    triangle_indices_.shrink_to_fit();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void KDTree::ray_test(Ray const& ray, Mesh const& mesh, int options, node::Node* owner, std::set<PickResult>& hits) const { ray_test_impl(ray, mesh, options, owner, hits); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void KDTree::ray_test(Ray const& ray, InterleavedMesh const& mesh, int options, node::Node* owner, std::set<PickResult>& hits) const { ray_test_impl(ray, mesh, options, owner, hits); }
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename MeshType>
+void KDTree::ray_test_impl(Ray const& ray, MeshType const& mesh, int options, node::Node* owner, std::set<PickResult>& hits) const
+{
+    if(nodes_.empty())
     {
-        for(unsigned j(0); j < sorted_triangles[i].size(); ++j)
-        {
-            if(sorted_triangles[i][j].bbox_.max[dim] <= split_position)
-            {
-                // if triangle is entirely to the left
-                left_list[i].push_back(sorted_triangles[i][j]);
-                left_bounds.expandBy(sorted_triangles[i][j].bbox_);
-            }
-            else if(sorted_triangles[i][j].bbox_.min[dim] >= split_position)
-            {
-                // if triangle is entirely to the right
-                right_list[i].push_back(sorted_triangles[i][j]);
-                right_bounds.expandBy(sorted_triangles[i][j].bbox_);
-            }
-            else
-            {
-                // if triangle overlaps splitting point, split its bounding box
-                // into two halfs
-                math::vec3 left_max(sorted_triangles[i][j].bbox_.max);
-                left_max[dim] = split_position;
-                math::BoundingBox<math::vec3> left_box;
-                left_box.expandBy(sorted_triangles[i][j].bbox_.min);
-                left_box.expandBy(left_max);
-                LeafData left_half(left_box, sorted_triangles[i][j].id_);
-
-                math::vec3 right_min(sorted_triangles[i][j].bbox_.min);
-                right_min[dim] = split_position;
-                math::BoundingBox<math::vec3> right_box;
-                right_box.expandBy(sorted_triangles[i][j].bbox_.max);
-                right_box.expandBy(right_min);
-                LeafData right_half(right_box, sorted_triangles[i][j].id_);
-
-                left_list[i].push_back(left_half);
-                right_list[i].push_back(right_half);
-                left_bounds.expandBy(left_half.bbox_);
-                right_bounds.expandBy(right_half.bbox_);
-            }
-        }
+        return;
     }
 
-    KDNode* left_child(nullptr);
-    KDNode* right_child(nullptr);
+    bool const only_first_face((options & PickResult::PICK_ONLY_FIRST_FACE) != 0);
+    bool const only_first_object((options & PickResult::PICK_ONLY_FIRST_OBJECT) != 0);
 
-    // return children with mutlitple triangles if there were no separations
-    if(left_list[dim].empty())
+    std::vector<Hit> new_hits;
+    intersect(ray, mesh, only_first_face, new_hits);
+
+    if(new_hits.empty())
     {
-        right_child = new KDNode(right_list[dim]);
+        return;
     }
-    else if(right_list[dim].empty())
+
+    if(only_first_face && only_first_object)
     {
-        left_child = new KDNode(left_list[dim]);
+        // override any existing intersection if it's closer
+        if(hits.empty() || new_hits.front().first < hits.begin()->distance)
+        {
+            hits.clear();
+            hits.insert(make_pick_result(mesh, ray, new_hits.front().first, new_hits.front().second, options, owner));
+        }
     }
-    else if(right_list[dim].size() == sorted_triangles[dim].size() || left_list[dim].size() == sorted_triangles[dim].size())
+    else if(only_first_face)
     {
-        right_child = new KDNode(right_list[dim]);
-        left_child = new KDNode(left_list[dim]);
+        // add newly found intersection to intersections list
+        hits.insert(make_pick_result(mesh, ray, new_hits.front().first, new_hits.front().second, options, owner));
+    }
+    else if(only_first_object)
+    {
+        // override all existing intersections and replace 'em
+        std::set<PickResult> results;
+        for(auto const& hit : new_hits)
+        {
+            results.insert(make_pick_result(mesh, ray, hit.first, hit.second, options, owner));
+        }
+
+        if(hits.empty() || results.begin()->distance < hits.begin()->distance)
+        {
+            hits = results;
+        }
     }
     else
     {
-        // build children recursively
-        left_child = build(left_list, left_bounds);
-        right_child = build(right_list, right_bounds);
+        // add all intersections
+        for(auto const& hit : new_hits)
+        {
+            hits.insert(make_pick_result(mesh, ray, hit.first, hit.second, options, owner));
+        }
     }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t KDTree::get_memory_usage() const { return nodes_.capacity() * sizeof(KDNode) + triangle_indices_.capacity() * sizeof(unsigned); }
+
+////////////////////////////////////////////////////////////////////////////////
 
-    return new KDNode(left_child, right_child, dim, split_position, bounds);
+void KDTree::write(std::ostream& os) const
+{
+    std::uint32_t const sizes[2] = {std::uint32_t(nodes_.size()), std::uint32_t(triangle_indices_.size())};
+    double bounds[6];
+
+    for(int i(0); i < 3; ++i)
+    {
+        bounds[i] = bounds_.min[i];
+        bounds[i + 3] = bounds_.max[i];
+    }
+
+    os.write(reinterpret_cast<char const*>(sizes), sizeof(sizes));
+    os.write(reinterpret_cast<char const*>(bounds), sizeof(bounds));
+    os.write(reinterpret_cast<char const*>(nodes_.data()), nodes_.size() * sizeof(KDNode));
+    os.write(reinterpret_cast<char const*>(triangle_indices_.data()), triangle_indices_.size() * sizeof(unsigned));
 }
 
-bool KDTree::intersect_one(KDNode* node, Ray const& ray, Mesh const& mesh, int options, std::vector<Triangle> const& triangles, std::set<PickResult>& hits) const
+////////////////////////////////////////////////////////////////////////////////
+
+char const* KDTree::read(char const* data, char const* end)
 {
-    // intersect with all triangles if leaf node
-    if(node->is_leaf_)
+    std::uint32_t sizes[2];
+    double bounds[6];
+
+    if(std::size_t(end - data) < sizeof(sizes) + sizeof(bounds))
     {
-        bool intersected(false);
-        for(auto const& triangle : node->data_)
-        {
-            if(triangles[triangle.id_].visit_flag_ != current_visit_flag_)
-            {
-                auto intersection(triangles[triangle.id_].intersect(mesh, ray));
+        return nullptr;
+    }
 
-                if(intersection < Ray::END)
-                {
-                    if(hits.empty() || intersection < hits.begin()->distance)
-                    {
-                        hits.clear();
-                        float const inf(std::numeric_limits<float>::max());
-                        math::vec3 position(inf, inf, inf), world_position(inf, inf, inf), normal(inf, inf, inf), world_normal(inf, inf, inf);
-                        math::vec2 tex_coords;
-
-                        if(options & PickResult::GET_POSITIONS || options & PickResult::GET_WORLD_POSITIONS || options & PickResult::INTERPOLATE_NORMALS || options & PickResult::GET_TEXTURE_COORDS)
-                        {
-                            position = ray.origin_ + intersection * ray.direction_;
-                        }
-
-                        if(options & PickResult::GET_NORMALS || options & PickResult::GET_WORLD_NORMALS)
-                        {
-                            if(options & PickResult::INTERPOLATE_NORMALS)
-                            {
-                                normal = triangles[triangle.id_].get_normal_interpolated(mesh, position);
-                            }
-                            else
-                            {
-                                normal = triangles[triangle.id_].get_normal(mesh);
-                            }
-                        }
-
-                        if(options & PickResult::GET_TEXTURE_COORDS)
-                        {
-                            tex_coords = triangles[triangle.id_].get_texture_coords_interpolated(mesh, position);
-                        }
-
-                        hits.insert(PickResult(intersection, current_owner_, position, world_position, normal, world_normal, tex_coords));
-                        intersected = true;
-                    }
-                }
+    std::memcpy(sizes, data, sizeof(sizes));
+    data += sizeof(sizes);
+    std::memcpy(bounds, data, sizeof(bounds));
+    data += sizeof(bounds);
 
-                triangles[triangle.id_].visit_flag_ = current_visit_flag_;
-            }
-        }
+    std::size_t const nodes_size(sizes[0] * sizeof(KDNode));
+    std::size_t const indices_size(sizes[1] * sizeof(unsigned));
 
-        return intersected;
+    if(std::size_t(end - data) < nodes_size + indices_size)
+    {
+        return nullptr;
     }
 
-    Ray traversing_ray(ray.intersection(node->bounds_));
+    nodes_.resize(sizes[0]);
+    std::memcpy(nodes_.data(), data, nodes_size);
+    data += nodes_size;
 
-    if(traversing_ray.t_max_ >= 0.f)
+    triangle_indices_.resize(sizes[1]);
+    std::memcpy(triangle_indices_.data(), data, indices_size);
+    data += indices_size;
+
+    for(int i(0); i < 3; ++i)
     {
-        math::vec3 a(traversing_ray.origin_);
-        math::vec3 b(traversing_ray.origin_ + traversing_ray.t_max_ * traversing_ray.direction_);
+        bounds_.min[i] = bounds[i];
+        bounds_.max[i] = bounds[i + 3];
+    }
 
-        // if ray is only to the left
-        if(a[node->splitting_dimension_] <= node->splitting_position_ && b[node->splitting_dimension_] <= node->splitting_position_)
-        {
-            if(node->left_child_)
-            {
-                return intersect_one(node->left_child_, ray, mesh, options, triangles, hits);
-            }
+    return data;
+}
 
-            // if ray is only to the right
-        }
-        else if(a[node->splitting_dimension_] >= node->splitting_position_ && b[node->splitting_dimension_] >= node->splitting_position_)
+////////////////////////////////////////////////////////////////////////////////
+
+void KDTree::build(std::vector<LeafData>& data, BoundingBox const& bounds, unsigned depth, unsigned bad_refines, std::vector<KDNode>& nodes, std::vector<unsigned>& indices)
+{
+    std::size_t const node_index(nodes.size());
+    nodes.push_back(KDNode());
+
+    auto const extent(bounds.max - bounds.min);
+    double const total_area(half_area(extent[0], extent[1], extent[2]));
+
+    // find the cheapest splitting plane with the SAH
+    double best_cost(std::numeric_limits<double>::max());
+    unsigned best_dim(0);
+    float best_position(0.f);
+
+    if(data.size() > MAX_LEAF_SIZE && depth > 0 && total_area > 0.0)
+    {
+        // candidates are restricted to the tight bounds of the triangles, the
+        // empty space around them may be cut off in one step
+        float tight_min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        float tight_max[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+
+        for(auto const& triangle : data)
         {
-            if(node->right_child_)
+            for(unsigned dim(0); dim < 3; ++dim)
             {
-                return intersect_one(node->right_child_, ray, mesh, options, triangles, hits);
+                tight_min[dim] = std::min(tight_min[dim], triangle.min_[dim]);
+                tight_max[dim] = std::max(tight_max[dim], triangle.max_[dim]);
             }
-
-            // ray crosses splitting plane
         }
-        else
+
+        for(unsigned dim(0); dim < 3; ++dim)
         {
-            // check left child first
-            if(a[node->splitting_dimension_] < node->splitting_position_)
-            {
-                if(node->left_child_ && intersect_one(node->left_child_, ray, mesh, options, triangles, hits))
+            unsigned const other0((dim + 1) % 3);
+            unsigned const other1((dim + 2) % 3);
+
+            auto evaluate = [&](float position, std::size_t below, std::size_t above) {
+                double below_length(position - bounds.min[dim]);
+                double above_length(bounds.max[dim] - position);
+
+                if(below_length <= 0.0 || above_length <= 0.0)
                 {
-                    return true;
+                    return;
                 }
 
-                if(node->right_child_ && intersect_one(node->right_child_, ray, mesh, options, triangles, hits))
+                double below_probability(half_area(below_length, extent[other0], extent[other1]) / total_area);
+                double above_probability(half_area(above_length, extent[other0], extent[other1]) / total_area);
+                double empty_length(below == 0 ? below_length : (above == 0 ? above_length : 0.0));
+                double bonus(empty_length >= MIN_EMPTY_FRACTION * extent[dim] ? EMPTY_BONUS : 0.0);
+                double cost(TRAVERSAL_COST + INTERSECTION_COST * (1.0 - bonus) * (below_probability * below + above_probability * above));
+
+                if(cost < best_cost)
                 {
-                    return true;
+                    best_cost = cost;
+                    best_dim = dim;
+                    best_position = position;
                 }
-            }
-            else
+            };
+
+            // small nodes evaluate all triangle bounds as candidates
+            if(data.size() <= EXACT_SAH_SIZE)
             {
-                if(node->right_child_ && intersect_one(node->right_child_, ray, mesh, options, triangles, hits))
-                {
-                    return true;
-                }
+                std::array<float, EXACT_SAH_SIZE> mins, maxs;
+                std::size_t const count(data.size());
 
-                if(node->left_child_ && intersect_one(node->left_child_, ray, mesh, options, triangles, hits))
+                for(std::size_t i(0); i < count; ++i)
                 {
-                    return true;
+                    mins[i] = data[i].min_[dim];
+                    maxs[i] = data[i].max_[dim];
                 }
-            }
-        }
-    }
 
-    return false;
-}
+                std::sort(mins.begin(), mins.begin() + count);
+                std::sort(maxs.begin(), maxs.begin() + count);
 
-void KDTree::intersect_all(KDNode* node, Ray const& ray, Mesh const& mesh, int options, std::vector<Triangle> const& triangles, std::set<PickResult>& hits) const
-{
-    // intersect with all triangles if leaf node
-    if(node->is_leaf_)
-    {
-        for(auto const& triangle : node->data_)
-        {
-            if(triangles[triangle.id_].visit_flag_ != current_visit_flag_)
-            {
-                auto intersection(triangles[triangle.id_].intersect(mesh, ray));
+                // sweep over all distinct bounds in ascending order
+                std::size_t min_index(0);
+                std::size_t max_index(0);
 
-                if(intersection < Ray::END)
+                while(min_index < count || max_index < count)
                 {
-                    float const inf(std::numeric_limits<float>::max());
-                    math::vec3 position(inf, inf, inf), world_position(inf, inf, inf), normal(inf, inf, inf), world_normal(inf, inf, inf);
-                    math::vec2 tex_coords;
+                    float position(max_index == count || (min_index < count && mins[min_index] < maxs[max_index]) ? mins[min_index] : maxs[max_index]);
+                    std::size_t below(min_index);
 
-                    if(options & PickResult::GET_POSITIONS || options & PickResult::GET_WORLD_POSITIONS || options & PickResult::INTERPOLATE_NORMALS || options & PickResult::GET_TEXTURE_COORDS)
+                    while(min_index < count && mins[min_index] == position)
                     {
-                        position = ray.origin_ + intersection * ray.direction_;
+                        ++min_index;
                     }
 
-                    if(options & PickResult::GET_NORMALS || options & PickResult::GET_WORLD_NORMALS)
+                    while(max_index < count && maxs[max_index] == position)
                     {
-                        if(options & PickResult::INTERPOLATE_NORMALS)
-                        {
-                            normal = triangles[triangle.id_].get_normal_interpolated(mesh, position);
-                        }
-                        else
-                        {
-                            normal = triangles[triangle.id_].get_normal(mesh);
-                        }
+                        ++max_index;
                     }
 
-                    if(options & PickResult::GET_TEXTURE_COORDS)
-                    {
-                        tex_coords = triangles[triangle.id_].get_texture_coords_interpolated(mesh, position);
-                    }
-
-                    hits.insert(PickResult(intersection, current_owner_, position, world_position, normal, world_normal, tex_coords));
+                    evaluate(position, below, count - max_index);
                 }
 
-                triangles[triangle.id_].visit_flag_ = current_visit_flag_;
+                continue;
             }
-        }
-    }
 
-    Ray traversing_ray(ray.intersection(node->bounds_));
+            evaluate(tight_min[dim], 0, data.size());
+            evaluate(tight_max[dim], data.size(), 0);
 
-    if(traversing_ray.t_max_ >= 0.f)
-    {
-        math::vec3 a(traversing_ray.origin_);
-        math::vec3 b(traversing_ray.origin_ + traversing_ray.t_max_ * traversing_ray.direction_);
+            double const tight_extent(tight_max[dim] - tight_min[dim]);
 
-        // if ray is only to the left
-        if(a[node->splitting_dimension_] <= node->splitting_position_ && b[node->splitting_dimension_] <= node->splitting_position_)
-        {
-            if(node->left_child_)
+            if(tight_extent <= 0.0)
+            {
+                continue;
+            }
+
+            std::array<std::size_t, BIN_COUNT> min_counts, max_counts;
+            min_counts.fill(0);
+            max_counts.fill(0);
+
+            double const scale(BIN_COUNT / tight_extent);
+
+            for(auto const& triangle : data)
             {
-                intersect_all(node->left_child_, ray, mesh, options, triangles, hits);
+                ++min_counts[std::min(unsigned((triangle.min_[dim] - tight_min[dim]) * scale), BIN_COUNT - 1)];
+                ++max_counts[std::min(unsigned((triangle.max_[dim] - tight_min[dim]) * scale), BIN_COUNT - 1)];
             }
 
-            // if ray is only to the right
+            std::size_t below(0);
+            std::size_t above(data.size());
+
+            for(unsigned bin(1); bin < BIN_COUNT; ++bin)
+            {
+                below += min_counts[bin - 1];
+                above -= max_counts[bin - 1];
+
+                // splitting positions are stored in single precision
+                evaluate(float(tight_min[dim] + bin * tight_extent / BIN_COUNT), below, above);
+            }
         }
-        else if(a[node->splitting_dimension_] >= node->splitting_position_ && b[node->splitting_dimension_] >= node->splitting_position_)
+
+        double const leaf_cost(INTERSECTION_COST * data.size());
+
+        if(best_cost >= leaf_cost)
         {
-            if(node->right_child_)
+            ++bad_refines;
+
+            if((best_cost > 4.0 * leaf_cost && data.size() < 16) || bad_refines >= MAX_BAD_REFINES)
             {
-                intersect_all(node->right_child_, ray, mesh, options, triangles, hits);
+                best_cost = std::numeric_limits<double>::max();
             }
+        }
+    }
+
+    // create a leaf if no splitting plane pays off
+    if(best_cost == std::numeric_limits<double>::max())
+    {
+        nodes[node_index].first_triangle_ = std::uint32_t(indices.size());
+        nodes[node_index].flags_ = 3 | std::uint32_t(data.size() << 2);
 
-            // ray crosses splitting plane
+        for(auto const& triangle : data)
+        {
+            indices.push_back(triangle.id_);
+        }
+
+        return;
+    }
+
+    // put all triangles into the appropriate lists
+    std::size_t left_count(0);
+    std::size_t right_count(0);
+
+    for(auto const& triangle : data)
+    {
+        left_count += triangle.max_[best_dim] <= best_position || triangle.min_[best_dim] < best_position;
+        right_count += triangle.max_[best_dim] > best_position;
+    }
+
+    std::vector<LeafData> left_list;
+    std::vector<LeafData> right_list;
+    left_list.reserve(left_count);
+    right_list.reserve(right_count);
+
+    for(auto const& triangle : data)
+    {
+        if(triangle.max_[best_dim] <= best_position)
+        {
+            // if triangle is entirely to the left
+            left_list.push_back(triangle);
+        }
+        else if(triangle.min_[best_dim] >= best_position)
+        {
+            // if triangle is entirely to the right
+            right_list.push_back(triangle);
         }
         else
         {
-            if(node->left_child_)
-                intersect_all(node->left_child_, ray, mesh, options, triangles, hits);
+            // if triangle overlaps splitting plane, clip its bounding box
+            left_list.push_back(triangle);
+            left_list.back().max_[best_dim] = best_position;
 
-            if(node->right_child_)
-                intersect_all(node->right_child_, ray, mesh, options, triangles, hits);
+            right_list.push_back(triangle);
+            right_list.back().min_[best_dim] = best_position;
         }
     }
-}
 
-// LeafData --------------------------------------------------------------------
+    // the parent's list is not needed anymore
+    std::vector<LeafData>().swap(data);
 
-KDTree::LeafData::Comparator::Comparator(unsigned dim) : dim_(dim) {}
+    BoundingBox left_bounds(bounds);
+    BoundingBox right_bounds(bounds);
+    left_bounds.max[best_dim] = best_position;
+    right_bounds.min[best_dim] = best_position;
 
-bool KDTree::LeafData::Comparator::operator()(LeafData const& lhs, LeafData const& rhs) const { return lhs.bbox_.min[dim_] < rhs.bbox_.min[dim_]; }
+    nodes[node_index].splitting_position_ = best_position;
 
-KDTree::LeafData::LeafData() : id_(-1), bbox_() {}
+    if(left_list.size() + right_list.size() >= PARALLEL_THRESHOLD)
+    {
+        std::vector<KDNode> child_nodes[2];
+        std::vector<unsigned> child_indices[2];
 
-KDTree::LeafData::LeafData(Mesh const& mesh, Triangle const& triangle, unsigned id) : id_(id), bbox_()
-{
-    for(auto i(0); i < 3; ++i)
+        concurrent::ThreadPool::instance()->parallel_for(0, 2, [&](std::size_t begin, std::size_t end) {
+            for(std::size_t i(begin); i < end; ++i)
+            {
+                build(i == 0 ? left_list : right_list, i == 0 ? left_bounds : right_bounds, depth - 1, bad_refines, child_nodes[i], child_indices[i]);
+            }
+        });
+
+        append(child_nodes[0], child_indices[0], nodes, indices);
+        nodes[node_index].flags_ = best_dim | std::uint32_t(nodes.size() << 2);
+        append(child_nodes[1], child_indices[1], nodes, indices);
+    }
+    else
     {
-        bbox_.expandBy(triangle.get_vertex(mesh, i));
+        build(left_list, left_bounds, depth - 1, bad_refines, nodes, indices);
+        nodes[node_index].flags_ = best_dim | std::uint32_t(nodes.size() << 2);
+        build(right_list, right_bounds, depth - 1, bad_refines, nodes, indices);
     }
 }
 
-KDTree::LeafData::LeafData(math::BoundingBox<math::vec3> const& bbox, unsigned id) : id_(id), bbox_(bbox) {}
+////////////////////////////////////////////////////////////////////////////////
 
-// KDNode ----------------------------------------------------------------------
+void KDTree::append(std::vector<KDNode> const& subtree_nodes, std::vector<unsigned> const& subtree_indices, std::vector<KDNode>& nodes, std::vector<unsigned>& indices)
+{
+    std::uint32_t const node_offset(std::uint32_t(nodes.size()));
+    std::uint32_t const index_offset(std::uint32_t(indices.size()));
 
-KDTree::KDNode::KDNode(std::vector<LeafData> const& data) : data_(data), left_child_(nullptr), right_child_(nullptr), is_leaf_(true), splitting_dimension_(0), splitting_position_(0.f), bounds_() {}
+    for(auto node : subtree_nodes)
+    {
+        if(node.is_leaf())
+        {
+            node.first_triangle_ += index_offset;
+        }
+        else
+        {
+            node.flags_ += node_offset << 2;
+        }
 
-KDTree::KDNode::KDNode(KDNode* left_child, KDNode* right_child, unsigned splitting_dimension, float splitting_position, math::BoundingBox<math::vec3> const& bounds)
-    : data_(), left_child_(left_child), right_child_(right_child), is_leaf_(false), splitting_dimension_(splitting_dimension), splitting_position_(splitting_position), bounds_(bounds)
-{
+        nodes.push_back(node);
+    }
+
+    indices.insert(indices.end(), subtree_indices.begin(), subtree_indices.end());
 }
 
-void KDTree::KDNode::print(unsigned depth) const
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename MeshType>
+void KDTree::intersect(Ray const& ray, MeshType const& mesh, bool only_first, std::vector<Hit>& hits) const
 {
-    std::string msg;
-    for(unsigned i(0); i < depth; ++i)
-        msg += " ";
-    msg += is_leaf_ ? string_utils::to_string(data_.size()) + " leaf(s): " : "internal: ";
+    // traversal is done in double precision: thin cells, e.g. around flat
+    // meshes, may be narrower than the single precision resolution of t
+    math::vec3 const& origin(ray.origin_);
+    math::vec3 inv_direction;
 
-    if(is_leaf_)
-        msg += "";
-    else
-        msg += "Split @ " + string_utils::to_string(splitting_position_) + " " + string_utils::to_string(bounds_.min) + " " + string_utils::to_string(bounds_.max);
+    // triangles are only hit between origin and origin + direction
+    double t_min(0.0);
+    double t_max(std::min(double(ray.t_max_), 1.0));
+
+    TraversalRay r;
+    r.t_max = float(ray.t_max_);
+
+    // clip the ray against the bounds of the tree
+    for(unsigned i(0); i < 3; ++i)
+    {
+        r.origin[i] = float(ray.origin_[i]);
+        r.direction[i] = float(ray.direction_[i]);
+        inv_direction[i] = 1.0 / ray.direction_[i];
+
+        double t_near((bounds_.min[i] - origin[i]) * inv_direction[i]);
+        double t_far((bounds_.max[i] - origin[i]) * inv_direction[i]);
+
+        if(t_near > t_far)
+        {
+            std::swap(t_near, t_far);
+        }
 
-    Logger::LOG_MESSAGE << msg << std::endl;
+        t_min = std::max(t_min, t_near);
+        t_max = std::min(t_max, t_far);
 
-    if(left_child_)
-        left_child_->print(depth + 1);
-    if(right_child_)
-        right_child_->print(depth + 1);
+        if(t_min > t_max)
+        {
+            return;
+        }
+    }
+
+    Hit closest(std::numeric_limits<float>::max(), 0);
+
+    // the tree is traversed front to back without a stack: after a leaf has
+    // been processed, traversal restarts behind that leaf at the deepest node
+    // which contains the whole remaining ray segment
+    std::uint32_t restart_index(0);
+
+    while(t_min < t_max)
+    {
+        std::uint32_t index(restart_index);
+        double t_leaf_end(t_max);
+
+        while(!nodes_[index].is_leaf())
+        {
+            KDNode const& node(nodes_[index]);
+            unsigned const dim(node.splitting_dimension());
+
+            double const split(node.splitting_position_);
+            double const t_split((split - origin[dim]) * inv_direction[dim]);
+
+            bool const below_first(origin[dim] < split || (origin[dim] == split && ray.direction_[dim] <= 0.0));
+            std::uint32_t const first(below_first ? index + 1 : node.second_child());
+            std::uint32_t const second(below_first ? node.second_child() : index + 1);
+
+            if(!(t_split > 0.0) || t_split > t_leaf_end)
+            {
+                // the ray does not cross the splitting plane in this interval
+                index = first;
+            }
+            else if(t_split <= t_min)
+            {
+                // the ray already crossed the splitting plane
+                index = second;
+            }
+            else
+            {
+                index = first;
+                t_leaf_end = t_split;
+            }
+
+            if(t_leaf_end == t_max)
+            {
+                restart_index = index;
+            }
+        }
+
+        KDNode const& leaf(nodes_[index]);
+        unsigned const* faces(triangle_indices_.data() + leaf.first_triangle_);
+        unsigned const count(leaf.triangle_count());
+
+        for(unsigned i(0); i < count; i += PACK_SIZE)
+        {
+            unsigned const pack_count(std::min(PACK_SIZE, count - i));
+
+            TrianglePack pack;
+            load_pack(mesh, faces + i, pack_count, pack);
+
+            float t[PACK_SIZE];
+            int mask(intersect_pack(pack, r, t) & ((1 << pack_count) - 1));
+
+            for(unsigned lane(0); mask != 0; ++lane, mask >>= 1)
+            {
+                if(mask & 1)
+                {
+                    if(!only_first)
+                    {
+                        hits.push_back(Hit(t[lane], faces[i + lane]));
+                    }
+                    else if(t[lane] < closest.first)
+                    {
+                        closest = Hit(t[lane], faces[i + lane]);
+                    }
+                }
+            }
+        }
+
+        // triangles in the following leaves cannot be closer
+        if(only_first && closest.first <= t_leaf_end)
+        {
+            break;
+        }
+
+        t_min = t_leaf_end;
+    }
+
+    if(only_first)
+    {
+        if(closest.first < std::numeric_limits<float>::max())
+        {
+            hits.push_back(closest);
+        }
+
+        return;
+    }
+
+    // triangles which overlap several leaves are reported only once
+    std::sort(hits.begin(), hits.end(), [](Hit const& lhs, Hit const& rhs) { return lhs.second < rhs.second; });
+    hits.erase(std::unique(hits.begin(), hits.end(), [](Hit const& lhs, Hit const& rhs) { return lhs.second == rhs.second; }), hits.end());
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
 } // namespace gua
@@ -43,89 +43,40 @@ inline math::vec3 mesh_normal(Mesh const& mesh, unsigned face, unsigned i)
 
 inline math::vec2 mesh_texcoord(Mesh const& mesh, unsigned face, unsigned i) { return math::vec2(mesh.texCoords[mesh.indices[face * 3 + i]].x, mesh.texCoords[mesh.indices[face * 3 + i]].y); }
 
-} // namespace
-
-// Ray -------------------------------------------------------------------------
-
-const math::vec3::value_type Ray::END(std::numeric_limits<math::vec3::value_type>::max());
-
-Ray::Ray() : origin_(), direction_(), t_max_(-1.0) {}
-
-Ray::Ray(math::vec3 const& origin, math::vec3 const& direction, math::vec3::value_type t_max) : origin_(origin), direction_(direction), t_max_(t_max) {}
-
-std::pair<float, float> intersect(Ray const& ray, math::BoundingBox<math::vec3> const& box)
+inline math::vec3 mesh_vertex(InterleavedMesh const& mesh, unsigned face, unsigned i)
 {
-    math::vec3 t1((box.min - ray.origin_) / ray.direction_);
-    math::vec3 t2((box.max - ray.origin_) / ray.direction_);
-
-    math::vec3 tmin1(std::min(t1[0], t2[0]), std::min(t1[1], t2[1]), std::min(t1[2], t2[2]));
-    math::vec3 tmax1(std::max(t1[0], t2[0]), std::max(t1[1], t2[1]), std::max(t1[2], t2[2]));
-
-    auto tmin = std::max(std::max(tmin1[0], tmin1[1]), tmin1[2]);
-    auto tmax = std::min(std::min(tmax1[0], tmax1[1]), tmax1[2]);
-
-    if(tmax >= tmin)
-    {
-        if(tmin > 0.0 && tmax < ray.t_max_)
-        { // there are two intersections
-            return std::make_pair(tmin, tmax);
-        }
-        else if(tmin > 0.0)
-        {
-            // there is only one intersection, the ray ends inside the box
-            return std::make_pair(tmin, Ray::END);
-        }
-        else
-        { // there is only one intersection, the ray starts inside the box
-            // return std::make_pair(Ray::END, tmax);
-            return std::make_pair(0.0, tmax);
-        }
-    }
-
-    // there is no intersection
-
-    return std::make_pair(Ray::END, Ray::END);
+    auto const& position(mesh.get_position(mesh.get_indices()[face * 3 + i]));
+    return math::vec3(position.x, position.y, position.z);
 }
 
-Ray const Ray::intersection(math::BoundingBox<math::vec3> const& box) const
+// falls back to the face normal if normals were stripped
+inline math::vec3 mesh_normal(InterleavedMesh const& mesh, unsigned face, unsigned i)
 {
-    auto hits = intersect(*this, box);
-
-    // there are two hits -> clamp ray on both sides
-    if(hits.first != END && hits.second != END)
-    {
-        return Ray(origin_ + direction_ * hits.first, direction_, hits.second - hits.first);
-    }
-
-    // the ray ends inside the box -> clamp the origin
-    if(hits.first != END)
-    {
-        return Ray(origin_ + direction_ * hits.first, direction_, t_max_ - hits.first);
-    }
-
-    // the ray starts inside the box -> clamp the end
-    if(hits.second != END)
+    if(!(mesh.get_attributes() & InterleavedMesh::NORMALS))
     {
-        return Ray(origin_, direction_, hits.second);
+        auto const p0(mesh_vertex(mesh, face, 0));
+        return scm::math::normalize(scm::math::cross(mesh_vertex(mesh, face, 1) - p0, mesh_vertex(mesh, face, 2) - p0));
     }
 
-    // there is no intersection
-    return Ray();
+    auto const normal(mesh.get_normal(mesh.get_indices()[face * 3 + i]));
+    return math::vec3(normal.x, normal.y, normal.z);
 }
 
-// Triangle --------------------------------------------------------------------
-
-Triangle::Triangle() : face_id_(0) {}
-
-Triangle::Triangle(unsigned face_id) : face_id_(face_id) {}
+inline math::vec2 mesh_texcoord(InterleavedMesh const& mesh, unsigned face, unsigned i)
+{
+    auto const tex_coords(mesh.get_texcoords(mesh.get_indices()[face * 3 + i]));
+    return math::vec2(tex_coords.x, tex_coords.y);
+}
 
-float Triangle::intersect(Mesh const& mesh, Ray const& ray) const
+// the implementations of the Triangle methods for all mesh types
+template <typename MeshType>
+float intersect_triangle(MeshType const& mesh, unsigned face_id, Ray const& ray)
 {
     std::vector<math::vec3> points(3);
     // math::vec3 normal(0, 0, 0);
     for(unsigned i = 0; i < 3; ++i)
     {
-        points[i] = mesh_vertex(mesh, face_id_, i);
+        points[i] = mesh_vertex(mesh, face_id, i);
     }
 
     // Find Triangle Normal
@@ -179,24 +130,26 @@ float Triangle::intersect(Mesh const& mesh, Ray const& ray) const
     return t;
 }
 
-math::vec3 Triangle::get_vertex(Mesh const& mesh, unsigned vertex_id) const
+template <typename MeshType>
+math::vec3 triangle_vertex(MeshType const& mesh, unsigned face_id, unsigned vertex_id)
 {
     math::vec3 vertex;
     if(vertex_id < 3)
     {
-        vertex = mesh_vertex(mesh, face_id_, vertex_id);
+        vertex = mesh_vertex(mesh, face_id, vertex_id);
     }
 
     return vertex;
 }
 
-math::vec3 Triangle::get_normal(Mesh const& mesh) const
+template <typename MeshType>
+math::vec3 triangle_normal(MeshType const& mesh, unsigned face_id)
 {
     math::vec3 normal(0, 0, 0);
 
     for(unsigned i = 0; i < 3; ++i)
     {
-        normal += mesh_normal(mesh, face_id_, i);
+        normal += mesh_normal(mesh, face_id, i);
     }
 
     normal = scm::math::normalize(normal);
@@ -204,29 +157,127 @@ math::vec3 Triangle::get_normal(Mesh const& mesh) const
     return normal;
 }
 
-math::vec3 Triangle::get_normal_interpolated(Mesh const& mesh, math::vec3 const& position) const
+template <typename MeshType>
+math::vec3 triangle_normal_interpolated(MeshType const& mesh, unsigned face_id, math::vec3 const& position)
 {
     math::vec3 normal(0, 0, 0);
 
     normal = math::interpolate(position,
-                               std::make_pair(mesh_vertex(mesh, face_id_, 0), mesh_normal(mesh, face_id_, 0)),
-                               std::make_pair(mesh_vertex(mesh, face_id_, 1), mesh_normal(mesh, face_id_, 1)),
-                               std::make_pair(mesh_vertex(mesh, face_id_, 2), mesh_normal(mesh, face_id_, 2)));
+                               std::make_pair(mesh_vertex(mesh, face_id, 0), mesh_normal(mesh, face_id, 0)),
+                               std::make_pair(mesh_vertex(mesh, face_id, 1), mesh_normal(mesh, face_id, 1)),
+                               std::make_pair(mesh_vertex(mesh, face_id, 2), mesh_normal(mesh, face_id, 2)));
     normal = scm::math::normalize(normal);
 
     return normal;
 }
 
-math::vec2 Triangle::get_texture_coords_interpolated(Mesh const& mesh, math::vec3 const& position) const
+template <typename MeshType>
+math::vec2 triangle_texture_coords_interpolated(MeshType const& mesh, unsigned face_id, math::vec3 const& position)
 {
     math::vec2 tex_coords(0, 0);
 
     tex_coords = math::interpolate(position,
-                                   std::make_pair(mesh_vertex(mesh, face_id_, 0), mesh_texcoord(mesh, face_id_, 0)),
-                                   std::make_pair(mesh_vertex(mesh, face_id_, 1), mesh_texcoord(mesh, face_id_, 1)),
-                                   std::make_pair(mesh_vertex(mesh, face_id_, 2), mesh_texcoord(mesh, face_id_, 2)));
+                                   std::make_pair(mesh_vertex(mesh, face_id, 0), mesh_texcoord(mesh, face_id, 0)),
+                                   std::make_pair(mesh_vertex(mesh, face_id, 1), mesh_texcoord(mesh, face_id, 1)),
+                                   std::make_pair(mesh_vertex(mesh, face_id, 2), mesh_texcoord(mesh, face_id, 2)));
 
     return tex_coords;
 }
 
+} // namespace
+
+// Ray -------------------------------------------------------------------------
+
+const math::vec3::value_type Ray::END(std::numeric_limits<math::vec3::value_type>::max());
+
+Ray::Ray() : origin_(), direction_(), t_max_(-1.0) {}
+
+Ray::Ray(math::vec3 const& origin, math::vec3 const& direction, math::vec3::value_type t_max) : origin_(origin), direction_(direction), t_max_(t_max) {}
+
+std::pair<float, float> intersect(Ray const& ray, math::BoundingBox<math::vec3> const& box)
+{
+    math::vec3 t1((box.min - ray.origin_) / ray.direction_);
+    math::vec3 t2((box.max - ray.origin_) / ray.direction_);
+
+    math::vec3 tmin1(std::min(t1[0], t2[0]), std::min(t1[1], t2[1]), std::min(t1[2], t2[2]));
+    math::vec3 tmax1(std::max(t1[0], t2[0]), std::max(t1[1], t2[1]), std::max(t1[2], t2[2]));
+
+    auto tmin = std::max(std::max(tmin1[0], tmin1[1]), tmin1[2]);
+    auto tmax = std::min(std::min(tmax1[0], tmax1[1]), tmax1[2]);
+
+    if(tmax >= tmin)
+    {
+        if(tmin > 0.0 && tmax < ray.t_max_)
+        { // there are two intersections
+            return std::make_pair(tmin, tmax);
+        }
+        else if(tmin > 0.0)
+        {
+            // there is only one intersection, the ray ends inside the box
+            return std::make_pair(tmin, Ray::END);
+        }
+        else
+        { // there is only one intersection, the ray starts inside the box
+            // return std::make_pair(Ray::END, tmax);
+            return std::make_pair(0.0, tmax);
+        }
+    }
+
+    // there is no intersection
+
+    return std::make_pair(Ray::END, Ray::END);
+}
+
+Ray const Ray::intersection(math::BoundingBox<math::vec3> const& box) const
+{
+    auto hits = intersect(*this, box);
+
+    // there are two hits -> clamp ray on both sides
+    if(hits.first != END && hits.second != END)
+    {
+        return Ray(origin_ + direction_ * hits.first, direction_, hits.second - hits.first);
+    }
+
+    // the ray ends inside the box -> clamp the origin
+    if(hits.first != END)
+    {
+        return Ray(origin_ + direction_ * hits.first, direction_, t_max_ - hits.first);
+    }
+
+    // the ray starts inside the box -> clamp the end
+    if(hits.second != END)
+    {
+        return Ray(origin_, direction_, hits.second);
+    }
+
+    // there is no intersection
+    return Ray();
+}
+
+// Triangle --------------------------------------------------------------------
+
+Triangle::Triangle() : face_id_(0) {}
+
+Triangle::Triangle(unsigned face_id) : face_id_(face_id) {}
+
+float Triangle::intersect(Mesh const& mesh, Ray const& ray) const { return intersect_triangle(mesh, face_id_, ray); }
+
+math::vec3 Triangle::get_vertex(Mesh const& mesh, unsigned vertex_id) const { return triangle_vertex(mesh, face_id_, vertex_id); }
+
+math::vec3 Triangle::get_normal(Mesh const& mesh) const { return triangle_normal(mesh, face_id_); }
+
+math::vec3 Triangle::get_normal_interpolated(Mesh const& mesh, math::vec3 const& position) const { return triangle_normal_interpolated(mesh, face_id_, position); }
+
+math::vec2 Triangle::get_texture_coords_interpolated(Mesh const& mesh, math::vec3 const& position) const { return triangle_texture_coords_interpolated(mesh, face_id_, position); }
+
+float Triangle::intersect(InterleavedMesh const& mesh, Ray const& ray) const { return intersect_triangle(mesh, face_id_, ray); }
+
+math::vec3 Triangle::get_vertex(InterleavedMesh const& mesh, unsigned vertex_id) const { return triangle_vertex(mesh, face_id_, vertex_id); }
+
+math::vec3 Triangle::get_normal(InterleavedMesh const& mesh) const { return triangle_normal(mesh, face_id_); }
+
+math::vec3 Triangle::get_normal_interpolated(InterleavedMesh const& mesh, math::vec3 const& position) const { return triangle_normal_interpolated(mesh, face_id_, position); }
+
+math::vec2 Triangle::get_texture_coords_interpolated(InterleavedMesh const& mesh, math::vec3 const& position) const { return triangle_texture_coords_interpolated(mesh, face_id_, position); }
+
 } // namespace gua
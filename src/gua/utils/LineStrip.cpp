@@ -7,10 +7,134 @@
 // #include <gua/utils/Timer.hpp>
 
 // external headers
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
 #include <mutex>
 
+namespace
+{
+// "GLS" and the version of the sync format
+const char SYNC_MAGIC[4] = {'G', 'L', 'S', 1};
+
+enum SyncType : uint8_t
+{
+    SYNC_COMPLETE = 0,
+    SYNC_DELTA = 1
+};
+
+// magic, type, six varints for the header, origin and step of the position grid
+const std::size_t SYNC_HEADER_SIZE = 4 + 1 + 6 * 10 + 4 * sizeof(float);
+// three varints of at most 5 bytes for the position, one run per vertex at worst
+const std::size_t SYNC_VERTEX_SIZE = 3 * 5 + 5 + 4 + sizeof(float);
+
+// writes the sync format into a caller provided buffer, all writes beyond the
+// capacity are dropped and only counted
+struct SyncWriter
+{
+    SyncWriter(char* buffer, std::size_t buffer_capacity) : data(buffer), capacity(buffer_capacity) {}
+
+    void bytes(void const* source, std::size_t count)
+    {
+        if(size + count <= capacity)
+        {
+            std::memcpy(data + size, source, count);
+        }
+        size += count;
+    }
+
+    void varint(uint64_t value)
+    {
+        char encoded[10];
+        char* target(size + sizeof(encoded) <= capacity ? data + size : encoded);
+        std::size_t count(0);
+        for(; value >= 0x80; value >>= 7)
+        {
+            target[count++] = char(value | 0x80);
+        }
+        target[count++] = char(value);
+
+        if(target == encoded)
+        {
+            bytes(encoded, count);
+        }
+        else
+        {
+            size += count;
+        }
+    }
+
+    void zigzag(int32_t value) { varint((uint32_t(value) << 1) ^ uint32_t(value >> 31)); }
+
+    bool overflow() const { return size > capacity; }
+
+    char* data;
+    std::size_t capacity;
+    std::size_t size = 0;
+};
+
+struct SyncReader
+{
+    SyncReader(char const* buffer, std::size_t buffer_size) : data(buffer), size(buffer_size) {}
+
+    bool bytes(void* target, std::size_t count)
+    {
+        if(count > size - offset)
+        {
+            return false;
+        }
+        std::memcpy(target, data + offset, count);
+        offset += count;
+        return true;
+    }
+
+    bool varint(uint64_t& value)
+    {
+        value = 0;
+        for(unsigned shift(0); shift < 64 && offset < size; shift += 7)
+        {
+            const uint8_t byte(data[offset++]);
+            value |= uint64_t(byte & 0x7f) << shift;
+            if(!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool zigzag(int32_t& value)
+    {
+        uint64_t encoded(0);
+        if(!varint(encoded) || encoded > 0xffffffffu)
+        {
+            return false;
+        }
+        value = int32_t(uint32_t(encoded >> 1) ^ (0u - uint32_t(encoded & 1)));
+        return true;
+    }
+
+    std::size_t remaining() const { return size - offset; }
+
+    char const* data;
+    std::size_t size;
+    std::size_t offset = 0;
+};
+
+uint32_t quantize_color(scm::math::vec4f const& color)
+{
+    uint32_t packed(0);
+    for(unsigned c(0); c < 4; ++c)
+    {
+        packed |= uint32_t(std::min(std::max(color[c], 0.0f), 1.0f) * 255.0f + 0.5f) << (8 * c);
+    }
+    return packed;
+}
+
+} // namespace
+
 namespace gua
 {
 LineStrip::LineStrip(unsigned int intitial_line_buffer_size) : vertex_reservoir_size(intitial_line_buffer_size), num_occupied_vertex_slots()
@@ -67,6 +191,30 @@ void LineStrip::enlarge_reservoirs()
     normals.resize(padded_reservoir_size);
 }
 
+void LineStrip::reserve_vertex_slots(int num_vertices)
+{
+    while(vertex_reservoir_size < num_vertices)
+    {
+        enlarge_reservoirs();
+    }
+
+    // popping and clearing vertices shrinks the attribute arrays below the reservoir size
+    std::size_t padded_reservoir_size = vertex_reservoir_size + 2;
+    if(positions.size() < padded_reservoir_size)
+    {
+        positions.resize(padded_reservoir_size);
+        colors.resize(padded_reservoir_size);
+        thicknesses.resize(padded_reservoir_size);
+        normals.resize(padded_reservoir_size);
+    }
+}
+
+void LineStrip::restart_sync()
+{
+    ++sync_generation_;
+    sync_written_ = false;
+}
+
 void LineStrip::compute_consistent_normals() const
 {
     bool last_plane_normal_exists = false;
@@ -163,20 +311,23 @@ void LineStrip::compile_buffer_string(std::string& buffer_string)
 
     uint64_t num_string_bytes = size_of_byte_count + size_of_positions + size_of_colors + size_of_thicknesses + size_of_normals;
 
-    std::string tmp_string(num_string_bytes, '0');
+    // write directly to the given string, its storage is reused if it is large enough
+    buffer_string.resize(num_string_bytes);
 
     uint64_t write_offset = 0;
-    memcpy(&tmp_string[write_offset], &num_vertices_to_write, size_of_byte_count);
+    memcpy(&buffer_string[write_offset], &num_vertices_to_write, size_of_byte_count);
     write_offset += size_of_byte_count;
-    memcpy(&tmp_string[write_offset], &positions[0], size_of_positions);
-    write_offset += size_of_positions;
-    memcpy(&tmp_string[write_offset], &colors[0], size_of_colors);
-    write_offset += size_of_colors;
-    memcpy(&tmp_string[write_offset], &thicknesses[0], size_of_thicknesses);
-    write_offset += size_of_thicknesses;
-    memcpy(&tmp_string[write_offset], &normals[0], size_of_normals);
-
-    buffer_string = tmp_string;
+
+    if(num_vertices_to_write > 0)
+    {
+        memcpy(&buffer_string[write_offset], &positions[0], size_of_positions);
+        write_offset += size_of_positions;
+        memcpy(&buffer_string[write_offset], &colors[0], size_of_colors);
+        write_offset += size_of_colors;
+        memcpy(&buffer_string[write_offset], &thicknesses[0], size_of_thicknesses);
+        write_offset += size_of_thicknesses;
+        memcpy(&buffer_string[write_offset], &normals[0], size_of_normals);
+    }
 }
 
 void LineStrip::uncompile_buffer_string(std::string const& buffer_string)
@@ -214,19 +365,231 @@ void LineStrip::uncompile_buffer_string(std::string const& buffer_string)
     memcpy(&colors[currently_occupied_vertex_slots], &buffer_string[read_offset], num_vertices_written * sizeof(Vertex::col));
     read_offset += num_vertices_written * sizeof(Vertex::col);
     memcpy(&thicknesses[currently_occupied_vertex_slots], &buffer_string[read_offset], num_vertices_written * sizeof(Vertex::thick));
-    read_offset += num_vertices_written * sizeof(Vertex::nor);
+    read_offset += num_vertices_written * sizeof(Vertex::thick);
     memcpy(&normals[currently_occupied_vertex_slots], &buffer_string[read_offset], num_vertices_written * sizeof(Vertex::nor));
 
     num_occupied_vertex_slots = num_vertices_written;
+    restart_sync();
 }
 
-bool LineStrip::push_vertex(Vertex const& v_to_push)
+std::size_t LineStrip::max_sync_size() const { return SYNC_HEADER_SIZE + std::size_t(num_occupied_vertex_slots) * SYNC_VERTEX_SIZE; }
+
+std::size_t LineStrip::write_sync(char* buffer, std::size_t capacity, bool delta, float precision)
 {
-    if(num_occupied_vertex_slots >= vertex_reservoir_size)
+    const uint64_t num_vertices(num_occupied_vertex_slots);
+    delta = delta && sync_written_;
+
+    // in delta mode, the receiver keeps the first unchanged_vertices_ vertices after removing the popped ones
+    const uint64_t first_vertex(delta ? unchanged_vertices_ : 0);
+
+    SyncWriter writer(buffer, capacity);
+    writer.bytes(SYNC_MAGIC, sizeof(SYNC_MAGIC));
+    const uint8_t type(delta ? SYNC_DELTA : SYNC_COMPLETE);
+    writer.bytes(&type, sizeof(type));
+    writer.varint(sync_generation_);
+    writer.varint(sync_sequence_ + 1);
+
+    if(delta)
     {
-        enlarge_reservoirs();
+        writer.varint(synced_vertices_);
+        writer.varint(popped_front_vertices_);
+        writer.varint(synced_vertices_ - popped_front_vertices_ - unchanged_vertices_);
     }
 
+    writer.varint(num_vertices - first_vertex);
+
+    if(num_vertices > first_vertex)
+    {
+        scm::math::vec3f lower(positions[first_vertex]), upper(positions[first_vertex]);
+        for(uint64_t i(first_vertex + 1); i < num_vertices; ++i)
+        {
+            for(unsigned c(0); c < 3; ++c)
+            {
+                lower[c] = std::min(lower[c], positions[i][c]);
+                upper[c] = std::max(upper[c], positions[i][c]);
+            }
+        }
+
+        const float extent(std::max(std::max(upper[0] - lower[0], upper[1] - lower[1]), upper[2] - lower[2]));
+        float step(precision > 0.0f ? precision : extent / 65535.0f);
+        // keep the grid coordinates small enough for 32 bit differences
+        step = std::max(step, extent / float(1 << 30));
+        if(!(step > 0.0f) || !std::isfinite(step))
+        {
+            step = 1.0f;
+        }
+
+        writer.bytes(&lower[0], 3 * sizeof(float));
+        writer.bytes(&step, sizeof(step));
+
+        // positions are stored as differences between consecutive grid points
+        const float inv_step(1.0f / step);
+        int32_t last[3] = {0, 0, 0};
+        for(uint64_t i(first_vertex); i < num_vertices; ++i)
+        {
+            for(unsigned c(0); c < 3; ++c)
+            {
+                // all coordinates are positive relative to the lower corner
+                const int32_t grid(int32_t((positions[i][c] - lower[c]) * inv_step + 0.5f));
+                writer.zigzag(grid - last[c]);
+                last[c] = grid;
+            }
+        }
+
+        // colors and thicknesses are stored as runs
+        uint64_t run_start(first_vertex);
+        uint32_t run_color(quantize_color(colors[first_vertex]));
+        for(uint64_t i(first_vertex + 1); i <= num_vertices; ++i)
+        {
+            if(i < num_vertices && thicknesses[i] == thicknesses[i - 1] && (colors[i] == colors[i - 1] || quantize_color(colors[i]) == run_color))
+            {
+                continue;
+            }
+
+            writer.varint(i - run_start);
+            writer.bytes(&run_color, sizeof(run_color));
+            writer.bytes(&thicknesses[run_start], sizeof(float));
+
+            run_start = i;
+            run_color = i < num_vertices ? quantize_color(colors[i]) : 0;
+        }
+    }
+
+    if(writer.overflow())
+    {
+        return 0;
+    }
+
+    sync_written_ = true;
+    ++sync_sequence_;
+    synced_vertices_ = num_vertices;
+    unchanged_vertices_ = num_vertices;
+    popped_front_vertices_ = 0;
+
+    return writer.size;
+}
+
+bool LineStrip::read_sync(char const* buffer, std::size_t size)
+{
+    SyncReader reader(buffer, size);
+
+    char magic[sizeof(SYNC_MAGIC)];
+    uint8_t type(SYNC_COMPLETE);
+    uint64_t generation(0), sequence(0);
+
+    if(!reader.bytes(magic, sizeof(magic)) || std::memcmp(magic, SYNC_MAGIC, sizeof(magic)) != 0 || !reader.bytes(&type, sizeof(type)) || type > SYNC_DELTA || !reader.varint(generation) ||
+       !reader.varint(sequence))
+    {
+        Logger::LOG_WARNING << "Invalid line strip sync header! Ignoring line strip update." << std::endl;
+        return false;
+    }
+
+    uint64_t popped_front(0), popped_back(0), kept_vertices(0);
+
+    if(type == SYNC_DELTA)
+    {
+        uint64_t base_vertices(0);
+        if(!reader.varint(base_vertices) || !reader.varint(popped_front) || !reader.varint(popped_back))
+        {
+            Logger::LOG_WARNING << "Invalid line strip sync header! Ignoring line strip update." << std::endl;
+            return false;
+        }
+
+        // the delta has to follow the last update we applied
+        if(generation != received_generation_ || sequence != received_sequence_ + 1 || base_vertices != uint64_t(num_occupied_vertex_slots) || popped_front + popped_back > base_vertices)
+        {
+            return false;
+        }
+
+        kept_vertices = base_vertices - popped_front - popped_back;
+    }
+
+    uint64_t num_vertices(0);
+    // every vertex takes at least three bytes
+    if(!reader.varint(num_vertices) || num_vertices > reader.remaining() / 3)
+    {
+        Logger::LOG_WARNING << "Invalid line strip sync data! Ignoring line strip update." << std::endl;
+        return false;
+    }
+
+    // new vertices are decoded behind the occupied slots, the strip is only modified once everything has been read
+    const uint64_t first_vertex(num_occupied_vertex_slots);
+    reserve_vertex_slots(int(first_vertex + num_vertices));
+
+    bool valid(true);
+
+    if(num_vertices > 0)
+    {
+        scm::math::vec3f origin;
+        float step(0.0f);
+        valid = reader.bytes(&origin[0], 3 * sizeof(float)) && reader.bytes(&step, sizeof(step));
+
+        int64_t grid[3] = {0, 0, 0};
+        for(uint64_t i(first_vertex); valid && i < first_vertex + num_vertices; ++i)
+        {
+            for(unsigned c(0); valid && c < 3; ++c)
+            {
+                int32_t difference(0);
+                valid = reader.zigzag(difference);
+                grid[c] += difference;
+                positions[i][c] = origin[c] + float(grid[c]) * step;
+            }
+            normals[i] = scm::math::vec3f(0.0f, 1.0f, 0.0f);
+        }
+
+        for(uint64_t i(first_vertex); valid && i < first_vertex + num_vertices;)
+        {
+            uint64_t run_length(0);
+            uint8_t color[4];
+            float thickness(0.0f);
+            valid = reader.varint(run_length) && run_length > 0 && run_length <= first_vertex + num_vertices - i && reader.bytes(color, sizeof(color)) && reader.bytes(&thickness, sizeof(thickness));
+
+            const scm::math::vec4f decoded_color(color[0] / 255.0f, color[1] / 255.0f, color[2] / 255.0f, color[3] / 255.0f);
+            for(uint64_t end(valid ? i + run_length : i); i < end; ++i)
+            {
+                colors[i] = decoded_color;
+                thicknesses[i] = thickness;
+            }
+        }
+    }
+
+    if(!valid)
+    {
+        Logger::LOG_WARNING << "Invalid line strip sync data! Ignoring line strip update." << std::endl;
+        return false;
+    }
+
+    // move the kept vertices to the front and the decoded ones behind them
+    if(popped_front > 0)
+    {
+        const auto end(popped_front + kept_vertices);
+        std::copy(positions.begin() + popped_front, positions.begin() + end, positions.begin());
+        std::copy(colors.begin() + popped_front, colors.begin() + end, colors.begin());
+        std::copy(thicknesses.begin() + popped_front, thicknesses.begin() + end, thicknesses.begin());
+        std::copy(normals.begin() + popped_front, normals.begin() + end, normals.begin());
+    }
+
+    if(kept_vertices < first_vertex)
+    {
+        const auto end(first_vertex + num_vertices);
+        std::copy(positions.begin() + first_vertex, positions.begin() + end, positions.begin() + kept_vertices);
+        std::copy(colors.begin() + first_vertex, colors.begin() + end, colors.begin() + kept_vertices);
+        std::copy(thicknesses.begin() + first_vertex, thicknesses.begin() + end, thicknesses.begin() + kept_vertices);
+        std::copy(normals.begin() + first_vertex, normals.begin() + end, normals.begin() + kept_vertices);
+    }
+
+    num_occupied_vertex_slots = int(kept_vertices + num_vertices);
+    received_generation_ = generation;
+    received_sequence_ = sequence;
+    restart_sync();
+
+    return true;
+}
+
+bool LineStrip::push_vertex(Vertex const& v_to_push)
+{
+    reserve_vertex_slots(num_occupied_vertex_slots + 1);
+
     positions[num_occupied_vertex_slots] = v_to_push.pos;
     colors[num_occupied_vertex_slots] = v_to_push.col;
     thicknesses[num_occupied_vertex_slots] = v_to_push.thick;
@@ -248,6 +611,12 @@ bool LineStrip::pop_front_vertex()
     normals.erase(normals.begin());
 
     --num_occupied_vertex_slots;
+
+    if(unchanged_vertices_ > 0)
+    {
+        --unchanged_vertices_;
+        ++popped_front_vertices_;
+    }
     return true;
 }
 
@@ -265,6 +634,7 @@ bool LineStrip::pop_back_vertex()
     normals.pop_back();
 
     --num_occupied_vertex_slots;
+    unchanged_vertices_ = std::min(unchanged_vertices_, uint64_t(num_occupied_vertex_slots));
 
     return true;
 }
@@ -279,6 +649,7 @@ bool LineStrip::clear_vertices()
         normals.clear();
 
         num_occupied_vertex_slots = 0;
+        unchanged_vertices_ = 0;
 
         return true;
     }
@@ -301,6 +672,8 @@ void LineStrip::forward_queued_vertices(std::vector<scm::math::vec3f> const& que
     {
         vertex_reservoir_size = num_occupied_vertex_slots;
     }
+
+    restart_sync();
 }
 
 void LineStrip::copy_to_buffer(Vertex* vertex_buffer) const
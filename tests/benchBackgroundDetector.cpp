@@ -0,0 +1,165 @@
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <gua/utils/Timer.hpp>
+#include <gua/video3d/video3d_geometry/BackgroundDetector.h>
+
+// Measures the per frame cost of the background detection on a synthetic
+// sequence: a static, noisy scene with a square moving through it. The
+// former per pixel implementation (double precision conversion, square root
+// per pixel, single thread) serves as reference for cost and classification.
+
+namespace
+{
+const unsigned FRAMES = 30;
+const float THRESH = 0.64f;
+
+std::vector<unsigned char> make_frame(unsigned width, unsigned height, unsigned index)
+{
+    std::vector<unsigned char> rgb(width * height * 3);
+    unsigned seed(index * 7919 + 1);
+    const unsigned square(height / 4);
+    const unsigned square_x((index * 13) % (width - square));
+    const unsigned square_y(height / 3);
+
+    for(unsigned y(0); y < height; ++y)
+    {
+        for(unsigned x(0); x < width; ++x)
+        {
+            const bool inside(x >= square_x && x < square_x + square && y >= square_y && y < square_y + square);
+
+            for(unsigned c(0); c < 3; ++c)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                unsigned value(inside ? 40 + 80 * c : (x / 4 + y / 3 + 60 * c) % 200);
+                rgb[(y * width + x) * 3 + c] = static_cast<unsigned char>(value + (seed >> 29));
+            }
+        }
+    }
+
+    return rgb;
+}
+
+// the conversion and distance the detector used before
+struct Legacy
+{
+    Legacy(unsigned w, unsigned h) : width(w), height(h), background(w * h * 3), is_background(w * h) {}
+
+    static void to_lab(unsigned char r, unsigned char g, unsigned char b, double lab[3])
+    {
+        static const double rgb_xyz[3][3] = {{0.7976748465, 0.1351917082, 0.0313534088}, {0.2880402025, 0.7118741325, 0.0000856651}, {0.0000000000, 0.0000000000, 0.8252114389}};
+        static const float white[3] = {0.964220f, 1.0f, 0.825211f};
+        const double ep(216.0 / 24389.0), ka(24389.0 / 27.0);
+
+        double xyz[3];
+        for(unsigned c(0); c < 3; ++c)
+        {
+            double t((rgb_xyz[c][0] * r + rgb_xyz[c][1] * g + rgb_xyz[c][2] * b) / white[c] / 65535.0);
+            xyz[c] = t > ep ? std::pow(t, 1 / 3.0) : (ka * t + 16) / 116.0;
+        }
+
+        lab[0] = float(116.0 * xyz[1] - 16.0);
+        lab[1] = float(500.0 * (xyz[0] - xyz[1]));
+        lab[2] = float(200.0 * (xyz[1] - xyz[2]));
+    }
+
+    void reset(std::vector<unsigned char> const& frame)
+    {
+        for(unsigned j(0); j < width * height; ++j)
+        {
+            to_lab(frame[3 * j], frame[3 * j + 1], frame[3 * j + 2], &background[3 * j]);
+        }
+    }
+
+    void detect(std::vector<unsigned char> const& frame)
+    {
+        for(unsigned y(1); y < height - 1; ++y)
+        {
+            for(unsigned x(1); x < width - 1; ++x)
+            {
+                const unsigned j(y * width + x);
+                double lab[3];
+                to_lab(frame[3 * j], frame[3 * j + 1], frame[3 * j + 2], lab);
+
+                double* bg(&background[3 * j]);
+                const float d(std::sqrt(float((lab[0] - bg[0]) * (lab[0] - bg[0]) + (lab[1] - bg[1]) * (lab[1] - bg[1]) + (lab[2] - bg[2]) * (lab[2] - bg[2]))));
+                is_background[j] = 13 * d < THRESH + 12 * THRESH;
+
+                if(is_background[j])
+                {
+                    for(unsigned c(0); c < 3; ++c)
+                    {
+                        bg[c] = float(0.125f * lab[c] + 0.875f * bg[c]);
+                    }
+                }
+            }
+        }
+    }
+
+    unsigned width, height;
+    std::vector<double> background;
+    std::vector<char> is_background;
+};
+
+} // namespace
+
+int main()
+{
+    std::cout << std::setw(12) << "resolution" << std::setw(15) << "legacy [ms]" << std::setw(15) << "current [ms]" << std::setw(12) << "speedup" << std::setw(14) << "background"
+              << std::setw(14) << "agreement" << std::endl;
+
+    for(auto const& resolution : std::vector<std::pair<unsigned, unsigned>>{{640, 480}, {1280, 1024}, {1920, 1080}})
+    {
+        const unsigned width(resolution.first), height(resolution.second);
+
+        std::vector<std::vector<unsigned char>> frames;
+        for(unsigned i(0); i <= FRAMES; ++i)
+        {
+            frames.push_back(make_frame(width, height, i));
+        }
+
+        Legacy legacy(width, height);
+        BackgroundDetector detector(width, height);
+
+        legacy.reset(frames[0]);
+        detector.reset();
+        detector.detectBackground(frames[0].data(), THRESH);
+
+        double legacy_time(0.0), current_time(0.0);
+        std::size_t background_pixels(0), agreeing_pixels(0), pixels(0);
+
+        for(unsigned i(1); i <= FRAMES; ++i)
+        {
+            gua::Timer timer;
+            timer.start();
+            legacy.detect(frames[i]);
+            legacy_time += timer.get_elapsed();
+
+            timer.start();
+            detector.detectBackground(frames[i].data(), THRESH);
+            current_time += timer.get_elapsed();
+
+            const pixel* bg(reinterpret_cast<const pixel*>(detector.getBackground()));
+            for(unsigned y(1); y < height - 1; ++y)
+            {
+                for(unsigned x(1); x < width - 1; ++x)
+                {
+                    const unsigned j(y * width + x);
+                    const bool is_background(bg[j].r == 255);
+                    background_pixels += is_background;
+                    agreeing_pixels += is_background == bool(legacy.is_background[j]);
+                    ++pixels;
+                }
+            }
+        }
+
+        std::cout << std::setw(12) << std::to_string(width) + "x" + std::to_string(height) << std::fixed << std::setprecision(2) << std::setw(15) << legacy_time * 1000.0 / FRAMES
+                  << std::setw(15) << current_time * 1000.0 / FRAMES << std::setw(11) << legacy_time / current_time << "x" << std::setw(13) << 100.0 * background_pixels / pixels << "%"
+                  << std::setw(12) << std::setprecision(4) << 100.0 * agreeing_pixels / pixels << "%" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <gua/utils/Timer.hpp>
+#include <gua/video3d/video3d_geometry/DXTCompressor.h>
+
+// Measures the DXT compression of kinect color frames in megapixels per
+// second: the scalar block encoders against the SSE4.1 and AVX2 ones on the
+// calling thread and the tiled compression of mvt::DXTCompressor on the
+// thread pool. All encoders have to produce identical output.
+
+namespace
+{
+const unsigned FRAMES = 20;
+
+// smooth gradients with some sensor noise, like a camera image
+std::vector<unsigned char> make_frame(unsigned width, unsigned height)
+{
+    std::vector<unsigned char> rgb(width * height * 3);
+    unsigned seed(42);
+
+    for(unsigned y(0); y < height; ++y)
+    {
+        for(unsigned x(0); x < width; ++x)
+        {
+            for(unsigned c(0); c < 3; ++c)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                unsigned value((x * (c + 1) / 4 + y / (c + 2)) % 224 + (seed >> 27));
+                rgb[(y * width + x) * 3 + c] = static_cast<unsigned char>(value);
+            }
+        }
+    }
+
+    return rgb;
+}
+
+std::vector<unsigned char> to_rgba(std::vector<unsigned char> const& rgb)
+{
+    std::vector<unsigned char> rgba(rgb.size() / 3 * 4, 255);
+    for(std::size_t p(0); p < rgb.size() / 3; ++p)
+    {
+        std::memcpy(&rgba[p * 4], &rgb[p * 3], 3);
+    }
+    return rgba;
+}
+
+void compress(std::vector<unsigned char> const& rgba, std::vector<unsigned char>& out, unsigned width, unsigned height, unsigned format)
+{
+    int bytes(0);
+    switch(format)
+    {
+    case FORMAT_DXT1:
+        CompressImageDXT1(rgba.data(), out.data(), width, height, bytes);
+        break;
+    case FORMAT_DXT5:
+        CompressImageDXT5(rgba.data(), out.data(), width, height, bytes);
+        break;
+    default:
+        CompressImageDXT5YCoCg(rgba.data(), out.data(), width, height, bytes);
+        break;
+    }
+}
+
+double megapixels_per_second(unsigned width, unsigned height, double seconds) { return width * height * FRAMES / seconds / 1000000.0; }
+
+} // namespace
+
+int main()
+{
+    const int best_isa(GetSupportedDXTInstructionSet());
+
+    std::cout << std::setw(12) << "resolution" << std::setw(8) << "format" << std::setw(14) << "scalar [MP/s]" << std::setw(14) << "sse4.1 [MP/s]" << std::setw(14) << "avx2 [MP/s]"
+              << std::setw(16) << "threaded [MP/s]" << std::setw(11) << "identical" << std::endl;
+
+    for(auto const& resolution : std::vector<std::pair<unsigned, unsigned>>{{640, 480}, {1280, 1024}, {1920, 1080}})
+    {
+        const unsigned width(resolution.first), height(resolution.second);
+        auto rgb(make_frame(width, height));
+        auto rgba(to_rgba(rgb));
+
+        for(unsigned format : {FORMAT_DXT1, FORMAT_DXT5YCOCG})
+        {
+            std::vector<unsigned char> reference(width * height), out(width * height);
+            bool identical(true);
+
+            std::cout << std::setw(12) << std::to_string(width) + "x" + std::to_string(height) << std::setw(8) << (format == FORMAT_DXT1 ? "DXT1" : "YCoCg");
+
+            for(int isa(DXT_ISA_SCALAR); isa <= DXT_ISA_AVX2; ++isa)
+            {
+                if(isa > best_isa)
+                {
+                    std::cout << std::setw(14) << "-";
+                    continue;
+                }
+
+                SetDXTInstructionSet(isa);
+                auto& target(isa == DXT_ISA_SCALAR ? reference : out);
+
+                gua::Timer timer;
+                timer.start();
+                for(unsigned frame(0); frame < FRAMES; ++frame)
+                {
+                    compress(rgba, target, width, height, format);
+                }
+                std::cout << std::setw(14) << std::fixed << std::setprecision(1) << megapixels_per_second(width, height, timer.get_elapsed());
+
+                identical = identical && reference == target;
+            }
+
+            SetDXTInstructionSet(best_isa);
+
+            mvt::DXTCompressor compressor;
+            unsigned storage(compressor.init(width, height, format));
+            // warm up the thread pool
+            compressor.compress(rgb.data());
+
+            gua::Timer timer;
+            timer.start();
+            unsigned char* compressed(nullptr);
+            for(unsigned frame(0); frame < FRAMES; ++frame)
+            {
+                compressed = compressor.compress(rgb.data());
+            }
+            std::cout << std::setw(16) << megapixels_per_second(width, height, timer.get_elapsed());
+
+            identical = identical && std::memcmp(compressed, reference.data(), storage) == 0;
+            std::cout << std::setw(11) << (identical ? "yes" : "NO") << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include <gua/renderer/Frustum.hpp>
+#include <gua/utils/Timer.hpp>
+
+// Measures frustum culling of bounding boxes: one Frustum::intersects() call
+// per box against the batched Frustum::intersects() which tests packs of boxes
+// at once, with and without additional clipping planes.
+
+namespace
+{
+const unsigned ITERATIONS = 50;
+
+std::vector<gua::math::BoundingBox<gua::math::vec3>> make_boxes(std::size_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<double> position(-50.0, 50.0);
+    std::uniform_real_distribution<double> extent(0.1, 2.0);
+
+    std::vector<gua::math::BoundingBox<gua::math::vec3>> boxes;
+    boxes.reserve(count);
+
+    for(std::size_t i(0); i < count; ++i)
+    {
+        gua::math::vec3 min(position(rng), position(rng), position(rng));
+        boxes.emplace_back(min, min + gua::math::vec3(extent(rng), extent(rng), extent(rng)));
+    }
+
+    return boxes;
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 rng(42);
+
+    auto frustum(gua::Frustum::perspective(gua::math::mat4::identity(), scm::math::make_translation(0.0, 0.0, -1.0) * scm::math::make_scale(1.6, 0.9, 1.0), 0.1, 100.0));
+
+    std::cout << std::setw(10) << "boxes" << std::setw(10) << "planes" << std::setw(14) << "single [ms]" << std::setw(14) << "batched [ms]" << std::setw(10) << "speedup" << std::setw(10) << "visible"
+              << std::endl;
+
+    for(std::size_t count : {64u, 1024u, 16384u, 262144u})
+    {
+        auto boxes(make_boxes(count, rng));
+
+        for(unsigned plane_count : {0u, 2u})
+        {
+            std::vector<gua::math::vec4> clipping_planes;
+            for(unsigned i(0); i < plane_count; ++i)
+            {
+                clipping_planes.push_back(gua::math::vec4(i == 0 ? 1.0 : -1.0, 0.0, 0.0, 20.0));
+            }
+
+            std::vector<std::uint8_t> single_results(count);
+            std::vector<std::uint8_t> batched_results(count);
+
+            gua::Timer timer;
+            timer.start();
+
+            for(unsigned iteration(0); iteration < ITERATIONS; ++iteration)
+            {
+                for(std::size_t i(0); i < count; ++i)
+                {
+                    single_results[i] = frustum.intersects(boxes[i], clipping_planes);
+                }
+            }
+
+            double single_time(timer.get_elapsed() * 1000.0 / ITERATIONS);
+
+            timer.reset();
+
+            for(unsigned iteration(0); iteration < ITERATIONS; ++iteration)
+            {
+                frustum.intersects(boxes.data(), count, clipping_planes, batched_results.data());
+            }
+
+            double batched_time(timer.get_elapsed() * 1000.0 / ITERATIONS);
+
+            std::size_t visible(0);
+            for(std::size_t i(0); i < count; ++i)
+            {
+                if(single_results[i] != batched_results[i])
+                {
+                    std::cerr << "Results differ for box " << i << "!" << std::endl;
+                    return 1;
+                }
+
+                visible += batched_results[i];
+            }
+
+            std::cout << std::setw(10) << count << std::setw(10) << plane_count << std::setw(14) << single_time << std::setw(14) << batched_time << std::setw(9) << single_time / batched_time << "x"
+                      << std::setw(10) << visible << std::endl;
+        }
+    }
+
+    return 0;
+}
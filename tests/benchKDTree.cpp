@@ -0,0 +1,465 @@
+#include <iostream>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <gua/utils/KDTree.hpp>
+#include <gua/utils/Timer.hpp>
+
+// Compares the SAH kd-tree used by TriMeshRessource with the previous
+// median-split tree (reproduced below as LegacyKDTree): build time, memory
+// and rays per second for closest-hit and all-hits queries.
+
+namespace
+{
+const unsigned RAY_COUNT = 100000;
+
+////////////////////////////////////////////////////////////////////////////////
+// the median-split kd-tree guacamole used before, kept for comparison
+
+class LegacyKDTree
+{
+  public:
+    ~LegacyKDTree() { destroy(root_); }
+
+    void generate(gua::Mesh const& mesh)
+    {
+        triangles_.resize(mesh.num_triangles);
+        visit_flags_.assign(mesh.num_triangles, 0);
+
+        for(unsigned i(0); i < mesh.num_triangles; ++i)
+        {
+            triangles_[i] = gua::Triangle(i);
+        }
+
+        std::vector<std::vector<LeafData>> sorted_triangles(3, std::vector<LeafData>(triangles_.size()));
+        Box root_bounds;
+
+        for(unsigned i(0); i < triangles_.size(); ++i)
+        {
+            for(unsigned j(0); j < 3; ++j)
+            {
+                sorted_triangles[j][i].id = i;
+
+                for(unsigned v(0); v < 3; ++v)
+                {
+                    sorted_triangles[j][i].bbox.expandBy(triangles_[i].get_vertex(mesh, v));
+                }
+
+                root_bounds.expandBy(triangles_[i].get_vertex(mesh, j));
+            }
+        }
+
+        auto dim = root_bounds.max - root_bounds.min;
+        root_bounds.min -= 0.01f * dim;
+        root_bounds.max += 0.01f * dim;
+
+        for(unsigned i(0); i < 3; ++i)
+        {
+            std::sort(sorted_triangles[i].begin(), sorted_triangles[i].end(), [i](LeafData const& lhs, LeafData const& rhs) { return lhs.bbox.min[i] < rhs.bbox.min[i]; });
+        }
+
+        root_ = build(sorted_triangles, root_bounds);
+    }
+
+    void ray_test(gua::Ray const& ray, gua::Mesh const& mesh, bool only_first, std::set<float>& hits) const
+    {
+        ++visit_flag_;
+
+        if(only_first)
+        {
+            intersect_one(root_, ray, mesh, hits);
+        }
+        else
+        {
+            intersect_all(root_, ray, mesh, hits);
+        }
+    }
+
+    std::size_t get_memory_usage() const { return triangles_.capacity() * sizeof(gua::Triangle) + memory_usage(root_); }
+
+  private:
+    using Box = gua::math::BoundingBox<gua::math::vec3>;
+
+    struct LeafData
+    {
+        unsigned id = 0;
+        Box bbox;
+    };
+
+    struct KDNode
+    {
+        std::vector<LeafData> data;
+        KDNode* left_child = nullptr;
+        KDNode* right_child = nullptr;
+        bool is_leaf = true;
+        unsigned splitting_dimension = 0;
+        float splitting_position = 0.f;
+        Box bounds;
+    };
+
+    static void destroy(KDNode* node)
+    {
+        if(node)
+        {
+            destroy(node->left_child);
+            destroy(node->right_child);
+            delete node;
+        }
+    }
+
+    static std::size_t memory_usage(KDNode* node)
+    {
+        return node ? sizeof(KDNode) + node->data.capacity() * sizeof(LeafData) + memory_usage(node->left_child) + memory_usage(node->right_child) : 0;
+    }
+
+    static KDNode* make_leaf(std::vector<LeafData> const& data)
+    {
+        auto node(new KDNode);
+        node->data = data;
+        return node;
+    }
+
+    KDNode* build(std::vector<std::vector<LeafData>> const& sorted_triangles, Box const& bounds)
+    {
+        unsigned dim(0);
+        for(unsigned i(1); i < 3; ++i)
+        {
+            if(bounds.size(i) > bounds.size(dim))
+                dim = i;
+        }
+
+        if(sorted_triangles[dim].size() <= 1)
+        {
+            return make_leaf(sorted_triangles[dim]);
+        }
+
+        float split_position(sorted_triangles[dim][sorted_triangles[dim].size() / 2].bbox.min[dim]);
+
+        std::vector<std::vector<LeafData>> left_list(3);
+        std::vector<std::vector<LeafData>> right_list(3);
+        Box left_bounds;
+        Box right_bounds;
+
+        for(unsigned i(0); i < 3; ++i)
+        {
+            for(auto const& triangle : sorted_triangles[i])
+            {
+                if(triangle.bbox.max[dim] <= split_position)
+                {
+                    left_list[i].push_back(triangle);
+                    left_bounds.expandBy(triangle.bbox);
+                }
+                else if(triangle.bbox.min[dim] >= split_position)
+                {
+                    right_list[i].push_back(triangle);
+                    right_bounds.expandBy(triangle.bbox);
+                }
+                else
+                {
+                    LeafData left_half(triangle);
+                    left_half.bbox.max[dim] = split_position;
+                    LeafData right_half(triangle);
+                    right_half.bbox.min[dim] = split_position;
+
+                    left_list[i].push_back(left_half);
+                    right_list[i].push_back(right_half);
+                    left_bounds.expandBy(left_half.bbox);
+                    right_bounds.expandBy(right_half.bbox);
+                }
+            }
+        }
+
+        KDNode* left_child(nullptr);
+        KDNode* right_child(nullptr);
+
+        if(left_list[dim].empty())
+        {
+            right_child = make_leaf(right_list[dim]);
+        }
+        else if(right_list[dim].empty())
+        {
+            left_child = make_leaf(left_list[dim]);
+        }
+        else if(right_list[dim].size() == sorted_triangles[dim].size() || left_list[dim].size() == sorted_triangles[dim].size())
+        {
+            right_child = make_leaf(right_list[dim]);
+            left_child = make_leaf(left_list[dim]);
+        }
+        else
+        {
+            left_child = build(left_list, left_bounds);
+            right_child = build(right_list, right_bounds);
+        }
+
+        auto node(new KDNode);
+        node->left_child = left_child;
+        node->right_child = right_child;
+        node->is_leaf = false;
+        node->splitting_dimension = dim;
+        node->splitting_position = split_position;
+        node->bounds = bounds;
+        return node;
+    }
+
+    bool intersect_one(KDNode* node, gua::Ray const& ray, gua::Mesh const& mesh, std::set<float>& hits) const
+    {
+        if(node->is_leaf)
+        {
+            bool intersected(false);
+            for(auto const& triangle : node->data)
+            {
+                if(visit_flags_[triangle.id] != visit_flag_)
+                {
+                    auto intersection(triangles_[triangle.id].intersect(mesh, ray));
+
+                    if(intersection < gua::Ray::END && (hits.empty() || intersection < *hits.begin()))
+                    {
+                        hits.clear();
+                        hits.insert(intersection);
+                        intersected = true;
+                    }
+
+                    visit_flags_[triangle.id] = visit_flag_;
+                }
+            }
+
+            return intersected;
+        }
+
+        gua::Ray traversing_ray(ray.intersection(node->bounds));
+
+        if(traversing_ray.t_max_ >= 0.f)
+        {
+            unsigned dim(node->splitting_dimension);
+            gua::math::vec3 a(traversing_ray.origin_);
+            gua::math::vec3 b(traversing_ray.origin_ + traversing_ray.t_max_ * traversing_ray.direction_);
+
+            KDNode* first(a[dim] < node->splitting_position ? node->left_child : node->right_child);
+            KDNode* second(a[dim] < node->splitting_position ? node->right_child : node->left_child);
+
+            if(a[dim] <= node->splitting_position && b[dim] <= node->splitting_position)
+            {
+                return node->left_child && intersect_one(node->left_child, ray, mesh, hits);
+            }
+            else if(a[dim] >= node->splitting_position && b[dim] >= node->splitting_position)
+            {
+                return node->right_child && intersect_one(node->right_child, ray, mesh, hits);
+            }
+            else
+            {
+                return (first && intersect_one(first, ray, mesh, hits)) || (second && intersect_one(second, ray, mesh, hits));
+            }
+        }
+
+        return false;
+    }
+
+    void intersect_all(KDNode* node, gua::Ray const& ray, gua::Mesh const& mesh, std::set<float>& hits) const
+    {
+        if(node->is_leaf)
+        {
+            for(auto const& triangle : node->data)
+            {
+                if(visit_flags_[triangle.id] != visit_flag_)
+                {
+                    auto intersection(triangles_[triangle.id].intersect(mesh, ray));
+
+                    if(intersection < gua::Ray::END)
+                    {
+                        hits.insert(intersection);
+                    }
+
+                    visit_flags_[triangle.id] = visit_flag_;
+                }
+            }
+        }
+
+        gua::Ray traversing_ray(ray.intersection(node->bounds));
+
+        if(traversing_ray.t_max_ >= 0.f)
+        {
+            unsigned dim(node->splitting_dimension);
+            gua::math::vec3 a(traversing_ray.origin_);
+            gua::math::vec3 b(traversing_ray.origin_ + traversing_ray.t_max_ * traversing_ray.direction_);
+
+            bool const left_only(a[dim] <= node->splitting_position && b[dim] <= node->splitting_position);
+            bool const right_only(!left_only && a[dim] >= node->splitting_position && b[dim] >= node->splitting_position);
+
+            if(node->left_child && !right_only)
+            {
+                intersect_all(node->left_child, ray, mesh, hits);
+            }
+
+            if(node->right_child && !left_only)
+            {
+                intersect_all(node->right_child, ray, mesh, hits);
+            }
+        }
+    }
+
+    KDNode* root_ = nullptr;
+    std::vector<gua::Triangle> triangles_;
+    mutable std::vector<unsigned> visit_flags_;
+    mutable unsigned visit_flag_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a rolling height field, similar to scanned terrain or architecture
+gua::Mesh make_terrain(unsigned triangle_count)
+{
+    unsigned size(unsigned(std::sqrt(triangle_count / 2.0)));
+
+    gua::Mesh mesh;
+
+    for(unsigned y(0); y <= size; ++y)
+    {
+        for(unsigned x(0); x <= size; ++x)
+        {
+            float u(2.f * x / size - 1.f), v(2.f * y / size - 1.f);
+            mesh.positions.push_back(scm::math::vec3f(u, 0.2f * std::sin(5.f * u) * std::cos(4.f * v), v));
+        }
+    }
+
+    for(unsigned y(0); y < size; ++y)
+    {
+        for(unsigned x(0); x < size; ++x)
+        {
+            unsigned a(y * (size + 1) + x), b(a + 1), c(a + size + 1), d(c + 1);
+            mesh.indices.insert(mesh.indices.end(), {a, b, c, b, d, c});
+        }
+    }
+
+    mesh.num_vertices = unsigned(mesh.positions.size());
+    mesh.num_triangles = unsigned(mesh.indices.size() / 3);
+    return mesh;
+}
+
+// small triangles scattered in a cube, similar to foliage or point-like data
+gua::Mesh make_soup(unsigned triangle_count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> center(-1.f, 1.f);
+    std::uniform_real_distribution<float> offset(-0.01f, 0.01f);
+
+    gua::Mesh mesh;
+
+    for(unsigned i(0); i < triangle_count; ++i)
+    {
+        scm::math::vec3f c(center(rng), center(rng), center(rng));
+
+        for(unsigned v(0); v < 3; ++v)
+        {
+            mesh.indices.push_back(unsigned(mesh.positions.size()));
+            mesh.positions.push_back(c + scm::math::vec3f(offset(rng), offset(rng), offset(rng)));
+        }
+    }
+
+    mesh.num_vertices = unsigned(mesh.positions.size());
+    mesh.num_triangles = triangle_count;
+    return mesh;
+}
+
+std::vector<gua::Ray> make_rays(std::mt19937& rng)
+{
+    std::uniform_real_distribution<double> position(-1.5, 1.5);
+
+    std::vector<gua::Ray> rays;
+
+    for(unsigned i(0); i < RAY_COUNT; ++i)
+    {
+        gua::math::vec3 origin(position(rng), position(rng), position(rng));
+        gua::math::vec3 target(position(rng), position(rng), position(rng));
+        rays.push_back(gua::Ray(origin, target - origin, 1.0));
+    }
+
+    return rays;
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 rng(42);
+    auto rays(make_rays(rng));
+
+    std::cout << std::setw(8) << "mesh" << std::setw(10) << "triangles" << std::setw(8) << "tree" << std::setw(12) << "build [ms]" << std::setw(12) << "memory [MB]" << std::setw(18) << "closest [Mray/s]"
+              << std::setw(18) << "all [Mray/s]" << std::setw(8) << "hits" << std::endl;
+
+    for(unsigned triangle_count : {20000u, 200000u, 2000000u})
+    {
+        for(bool terrain : {true, false})
+        {
+            gua::Mesh mesh(terrain ? make_terrain(triangle_count) : make_soup(triangle_count, rng));
+            std::string name(terrain ? "terrain" : "soup");
+
+            auto print = [&](std::string const& tree, double build_time, std::size_t memory, double closest_time, double all_time, std::size_t hit_count) {
+                std::cout << std::setw(8) << name << std::setw(10) << mesh.num_triangles << std::setw(8) << tree << std::setw(12) << build_time * 1000.0 << std::setw(12) << memory / (1024.0 * 1024.0)
+                          << std::setw(18) << RAY_COUNT / closest_time * 1e-6 << std::setw(18) << RAY_COUNT / all_time * 1e-6 << std::setw(8) << hit_count << std::endl;
+            };
+
+            // previous tree
+            {
+                gua::Timer timer;
+                timer.start();
+                std::unique_ptr<LegacyKDTree> tree(new LegacyKDTree());
+                tree->generate(mesh);
+                double build_time(timer.get_elapsed());
+
+                std::size_t hit_count(0);
+                timer.reset();
+                for(auto const& ray : rays)
+                {
+                    std::set<float> hits;
+                    tree->ray_test(ray, mesh, true, hits);
+                    hit_count += hits.size();
+                }
+                double closest_time(timer.get_elapsed());
+
+                timer.reset();
+                for(auto const& ray : rays)
+                {
+                    std::set<float> hits;
+                    tree->ray_test(ray, mesh, false, hits);
+                }
+                double all_time(timer.get_elapsed());
+
+                print("legacy", build_time, tree->get_memory_usage(), closest_time, all_time, hit_count);
+            }
+
+            // SAH tree
+            {
+                gua::Timer timer;
+                timer.start();
+                gua::KDTree tree;
+                tree.generate(mesh);
+                double build_time(timer.get_elapsed());
+
+                std::size_t hit_count(0);
+                timer.reset();
+                for(auto const& ray : rays)
+                {
+                    std::set<gua::PickResult> hits;
+                    tree.ray_test(ray, mesh, gua::PickResult::PICK_ONLY_FIRST_FACE | gua::PickResult::PICK_ONLY_FIRST_OBJECT, nullptr, hits);
+                    hit_count += hits.size();
+                }
+                double closest_time(timer.get_elapsed());
+
+                timer.reset();
+                for(auto const& ray : rays)
+                {
+                    std::set<gua::PickResult> hits;
+                    tree.ray_test(ray, mesh, gua::PickResult::PICK_ALL, nullptr, hits);
+                }
+                double all_time(timer.get_elapsed());
+
+                print("SAH", build_time, tree.get_memory_usage(), closest_time, all_time, hit_count);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include <gua/renderer/Frustum.hpp>
+#include <gua/renderer/LightClusterer.hpp>
+#include <gua/utils/Timer.hpp>
+
+// Measures the CPU light assignment of LightClusterer for thousands of point
+// and spot lights at full HD, with a single depth slice (a test against the
+// whole tile frustum) and with more slices. Random points inside each light
+// volume are projected onto the screen to verify that no lit tile is missed;
+// the benchmark fails if one is.
+
+namespace
+{
+const unsigned ITERATIONS = 20;
+const unsigned SAMPLES = 64; // per light
+const double PI = 3.14159265358979323846;
+
+gua::LightTable::array_type make_lights(std::size_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-40.f, 40.f);
+    std::uniform_real_distribution<float> depth(-80.f, 0.f);
+    std::uniform_real_distribution<float> radius(0.5f, 4.f);
+    std::uniform_real_distribution<float> direction(-1.f, 1.f);
+    std::uniform_real_distribution<float> angle(0.1f, 1.f);
+
+    gua::LightTable::array_type lights(count);
+
+    for(std::size_t i(0); i < count; ++i)
+    {
+        auto& light(lights[i]);
+        light.position_and_radius = gua::math::vec4f(position(rng), 0.5f * position(rng), depth(rng), radius(rng));
+
+        // every second light is a spot light
+        if(i % 2)
+        {
+            gua::math::vec3f beam(scm::math::normalize(gua::math::vec3f(direction(rng), direction(rng), direction(rng))) * 2.f * radius(rng));
+            light.beam_direction_and_half_angle = gua::math::vec4f(beam.x, beam.y, beam.z, std::cos(angle(rng)));
+            light.type = 1;
+        }
+    }
+
+    return lights;
+}
+
+// a random point inside the volume of a light
+gua::math::vec3 sample(gua::LightTable::LightBlock const& light, std::mt19937& rng)
+{
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const gua::math::vec3 position(light.position_and_radius.x, light.position_and_radius.y, light.position_and_radius.z);
+
+    if(light.type == 0)
+    {
+        gua::math::vec3 offset(1.0, 1.0, 1.0);
+        while(scm::math::length(offset) > 1.0)
+        {
+            offset = gua::math::vec3(2.0 * unit(rng) - 1.0, 2.0 * unit(rng) - 1.0, 2.0 * unit(rng) - 1.0);
+        }
+        return position + offset * double(light.position_and_radius.w);
+    }
+
+    const gua::math::vec3 beam(light.beam_direction_and_half_angle.x, light.beam_direction_and_half_angle.y, light.beam_direction_and_half_angle.z);
+    const gua::math::vec3 axis(scm::math::normalize(beam));
+    const gua::math::vec3 side(scm::math::normalize(scm::math::cross(axis, std::abs(axis.x) < 0.9 ? gua::math::vec3(1.0, 0.0, 0.0) : gua::math::vec3(0.0, 1.0, 0.0))));
+    const gua::math::vec3 up(scm::math::cross(axis, side));
+
+    const double t(unit(rng) * scm::math::length(beam));
+    const double r(t * std::tan(std::acos(double(light.beam_direction_and_half_angle.w))) * std::sqrt(unit(rng)));
+    const double phi(2.0 * PI * unit(rng));
+
+    return position + axis * t + side * (r * std::cos(phi)) + up * (r * std::sin(phi));
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 rng(42);
+
+    const gua::math::vec2ui resolution(1920, 1080);
+    const int tile_power(4);
+    auto frustum(gua::Frustum::perspective(gua::math::mat4::identity(), scm::math::make_translation(0.0, 0.0, -1.0) * scm::math::make_scale(1.6, 0.9, 1.0), 0.1, 100.0));
+    const gua::math::mat4 view_projection(frustum.get_projection() * frustum.get_view());
+
+    std::size_t total_missed(0);
+
+    std::cout << std::setw(10) << "lights" << std::setw(10) << "slices" << std::setw(14) << "assign [ms]" << std::setw(16) << "lights / tile" << std::setw(10) << "missed" << std::endl;
+
+    for(std::size_t count : {256u, 1024u, 4096u})
+    {
+        auto lights(make_lights(count, rng));
+
+        for(unsigned slices : {1u, 4u, 16u, 32u})
+        {
+            gua::LightClusterer clusterer(slices);
+            // warm up the thread pool
+            auto tiles(clusterer.assign(frustum.get_view(), frustum.get_projection(), resolution, tile_power, lights, 0));
+
+            gua::Timer timer;
+            timer.start();
+            for(unsigned iteration(0); iteration < ITERATIONS; ++iteration)
+            {
+                clusterer.assign(frustum.get_view(), frustum.get_projection(), resolution, tile_power, lights, 0);
+            }
+            const double time(timer.get_elapsed() * 1000.0 / ITERATIONS);
+
+            auto const& bitset(clusterer.get_light_bitset());
+
+            std::size_t bits(0);
+            for(auto word : bitset)
+            {
+                for(; word; word &= word - 1)
+                {
+                    ++bits;
+                }
+            }
+
+            std::size_t missed(0);
+            for(std::size_t i(0); i < count; ++i)
+            {
+                for(unsigned s(0); s < SAMPLES; ++s)
+                {
+                    const gua::math::vec4 clip(view_projection * gua::math::vec4(sample(lights[i], rng), 1.0));
+                    const gua::math::vec3 ndc(clip.x / clip.w, clip.y / clip.w, clip.z / clip.w);
+
+                    if(clip.w <= 0.0 || std::abs(ndc.x) >= 1.0 || std::abs(ndc.y) >= 1.0 || std::abs(ndc.z) >= 1.0)
+                    {
+                        continue;
+                    }
+
+                    const unsigned x(unsigned((ndc.x * 0.5 + 0.5) * resolution.x) >> tile_power);
+                    const unsigned y(unsigned((ndc.y * 0.5 + 0.5) * resolution.y) >> tile_power);
+
+                    if(!(bitset[(i / 32 * tiles.y + y) * tiles.x + x] & (1u << (i % 32))))
+                    {
+                        ++missed;
+                    }
+                }
+            }
+
+            std::cout << std::setw(10) << count << std::setw(10) << slices << std::fixed << std::setprecision(3) << std::setw(14) << time << std::setprecision(1) << std::setw(16)
+                      << double(bits) / (tiles.x * tiles.y) << std::setw(10) << missed << std::endl;
+
+            total_missed += missed;
+        }
+    }
+
+    // a light missing from a tile it touches is a visible lighting error
+    if(total_missed > 0)
+    {
+        std::cerr << total_missed << " lit samples fell into tiles without their light" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
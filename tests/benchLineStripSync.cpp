@@ -0,0 +1,142 @@
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <gua/utils/LineStrip.hpp>
+#include <gua/utils/Timer.hpp>
+
+// Measures the cost of syncing a live annotation stroke between two line
+// strips: per frame, a few vertices are appended to a long stroke and its
+// tail is trimmed. The complete buffer string of compile_buffer_string()
+// serves as reference for the complete and the delta updates of write_sync().
+
+namespace
+{
+const unsigned FRAMES = 100;
+const unsigned APPENDED = 100; // per frame
+const unsigned TRIMMED = 10;   // per frame
+
+struct Stroke
+{
+    void push(gua::LineStrip& strip)
+    {
+        const float t(0.001f * vertices++);
+        strip.push_vertex(gua::LineStrip::Vertex(std::cos(7.f * t) * (1.f + 0.1f * t), std::sin(5.f * t), 0.2f * t, 1.f, 0.5f, 0.f, 1.f, 0.01f));
+    }
+
+    unsigned vertices = 0;
+};
+
+struct Result
+{
+    double write = 0.0;
+    double read = 0.0;
+    std::size_t bytes = 0;
+    double error = 0.0;
+};
+
+enum Mode
+{
+    LEGACY,
+    COMPLETE,
+    DELTA
+};
+
+Result run(unsigned size, Mode mode)
+{
+    gua::LineStrip sender, receiver;
+    Stroke stroke;
+    for(unsigned i(0); i < size; ++i)
+    {
+        stroke.push(sender);
+    }
+
+    std::string buffer_string;
+    std::vector<char> buffer;
+    Result result;
+
+    for(unsigned frame(0); frame <= FRAMES; ++frame)
+    {
+        for(unsigned i(0); i < APPENDED; ++i)
+        {
+            stroke.push(sender);
+        }
+        for(unsigned i(0); i < TRIMMED; ++i)
+        {
+            sender.pop_front_vertex();
+        }
+
+        // the buffer is grown ahead of time, like a network layer would
+        if(buffer.size() < sender.max_sync_size())
+        {
+            buffer.resize(2 * sender.max_sync_size());
+        }
+
+        gua::Timer timer;
+        timer.start();
+
+        std::size_t bytes(0);
+        if(mode == LEGACY)
+        {
+            sender.compile_buffer_string(buffer_string);
+            bytes = buffer_string.size();
+        }
+        else
+        {
+            bytes = sender.write_sync(buffer.data(), buffer.size(), mode == DELTA);
+        }
+        const double write(timer.get_elapsed());
+
+        timer.start();
+        if(mode == LEGACY)
+        {
+            receiver.uncompile_buffer_string(buffer_string);
+        }
+        else
+        {
+            receiver.read_sync(buffer.data(), bytes);
+        }
+        const double read(timer.get_elapsed());
+
+        // the first frame transfers the whole stroke in all modes
+        if(frame > 0)
+        {
+            result.write += write / FRAMES;
+            result.read += read / FRAMES;
+            result.bytes += bytes / FRAMES;
+        }
+    }
+
+    for(int i(0); i < sender.num_occupied_vertex_slots; ++i)
+    {
+        for(unsigned c(0); c < 3; ++c)
+        {
+            result.error = std::max(result.error, double(std::abs(sender.positions[i][c] - receiver.positions[i][c])));
+        }
+    }
+
+    return result;
+}
+
+} // namespace
+
+int main()
+{
+    std::cout << std::setw(10) << "vertices" << std::setw(10) << "mode" << std::setw(14) << "write [us]" << std::setw(14) << "read [us]" << std::setw(12) << "bytes" << std::setw(14) << "max error"
+              << std::endl;
+
+    for(unsigned size : {1000u, 10000u, 100000u})
+    {
+        for(Mode mode : {LEGACY, COMPLETE, DELTA})
+        {
+            Result result(run(size, mode));
+            std::cout << std::setw(10) << size << std::setw(10) << (mode == LEGACY ? "legacy" : mode == COMPLETE ? "complete" : "delta") << std::fixed << std::setprecision(1) << std::setw(14)
+                      << result.write * 1000000.0 << std::setw(14) << result.read * 1000000.0 << std::setw(12) << result.bytes << std::scientific << std::setprecision(2) << std::setw(14)
+                      << result.error << std::endl;
+        }
+    }
+
+    return 0;
+}
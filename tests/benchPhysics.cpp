@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gua/guacamole.hpp>
+#include <gua/physics.hpp>
+#include <gua/databases/CollisionShapeDatabase.hpp>
+#include <gua/node/TransformNode.hpp>
+#include <gua/scenegraph/SceneGraph.hpp>
+#include <gua/utils/Timer.hpp>
+
+// Drops 10k spheres onto a floor and measures the simulation rate together
+// with the time the application thread spends per frame in
+// Physics::synchronize() and in reading back all rigid body transforms. The
+// spheres are stacked in separate columns, so that the world decomposes into
+// many simulation islands, once stepped serially and once in parallel.
+
+namespace
+{
+const unsigned COLUMNS = 25;
+const unsigned LAYERS = 16;
+const float RADIUS = 0.25f;
+const double DURATION = 5.0;                             // seconds
+const auto FRAME_TIME = std::chrono::microseconds(8333); // a 120 Hz application loop
+
+struct Result
+{
+    double physics_fps = 0.0;
+    double mean_stall = 0.0;
+    double max_stall = 0.0;
+};
+
+Result run(bool parallel_islands)
+{
+    auto physics(std::make_shared<gua::physics::Physics>(gua::physics::physics_default_gravity, gua::physics::physics_default_fixed_timestep, parallel_islands));
+    physics->simulation_rate_reduction(false);
+
+    gua::SceneGraph graph("bench_scenegraph");
+    auto transform(graph.add_node<gua::node::TransformNode>("/", "transform"));
+
+    auto floor_body(std::make_shared<gua::physics::RigidBodyNode>("floor_body", 0, 0.5, 0.7));
+    auto floor_shape(std::make_shared<gua::physics::CollisionShapeNode>("floor_shape"));
+    floor_shape->data.set_shape("floor");
+    transform->add_child(floor_body);
+    floor_body->add_child(floor_shape);
+    physics->add_rigid_body(floor_body);
+
+    std::vector<std::shared_ptr<gua::physics::RigidBodyNode>> spheres;
+    for(unsigned x(0); x < COLUMNS; ++x)
+    {
+        for(unsigned z(0); z < COLUMNS; ++z)
+        {
+            for(unsigned y(0); y < LAYERS; ++y)
+            {
+                const float px(3.f * RADIUS * (x - COLUMNS * 0.5f)), pz(3.f * RADIUS * (z - COLUMNS * 0.5f));
+                auto body(std::make_shared<gua::physics::RigidBodyNode>("sphere_body", 1, 0.5, 0.7, scm::math::make_translation(px, 1.f + 2.5f * RADIUS * y, pz)));
+                auto shape(std::make_shared<gua::physics::CollisionShapeNode>("sphere_shape"));
+                shape->data.set_shape("sphere");
+                transform->add_child(body);
+                body->add_child(shape);
+                physics->add_rigid_body(body);
+                spheres.push_back(body);
+            }
+        }
+    }
+
+    physics->synchronize(true);
+
+    Result result;
+    unsigned frames(0), fps_samples(0);
+    gua::Timer total;
+    total.start();
+
+    while(total.get_elapsed() < DURATION)
+    {
+        gua::Timer stall;
+        stall.start();
+
+        physics->synchronize();
+        for(auto const& sphere : spheres)
+        {
+            sphere->get_transform();
+        }
+
+        const double elapsed(stall.get_elapsed());
+        result.mean_stall += elapsed;
+        result.max_stall = std::max(result.max_stall, elapsed);
+        ++frames;
+
+        // skip the first second, the simulation thread is still ramping up
+        if(total.get_elapsed() > 1.0)
+        {
+            result.physics_fps += physics->get_physics_fps();
+            ++fps_samples;
+        }
+
+        std::this_thread::sleep_for(FRAME_TIME);
+    }
+
+    physics->stop_simulation();
+
+    result.mean_stall /= frames;
+    result.physics_fps /= std::max(1u, fps_samples);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    gua::init(argc, argv);
+
+    gua::physics::CollisionShapeDatabase::add_shape("sphere", new gua::physics::SphereShape(RADIUS));
+    gua::physics::CollisionShapeDatabase::add_shape("floor", new gua::physics::BoxShape(gua::math::vec3(50, 1, 50)));
+
+    std::cout << COLUMNS * COLUMNS * LAYERS << " falling spheres" << std::endl;
+    std::cout << std::setw(12) << "islands" << std::setw(15) << "physics [fps]" << std::setw(18) << "mean stall [ms]" << std::setw(17) << "max stall [ms]" << std::endl;
+
+    for(bool parallel_islands : {false, true})
+    {
+        Result result(run(parallel_islands));
+        std::cout << std::setw(12) << (parallel_islands ? "parallel" : "serial") << std::fixed << std::setprecision(1) << std::setw(15) << result.physics_fps << std::setprecision(3)
+                  << std::setw(18) << result.mean_stall * 1000.0 << std::setw(17) << result.max_stall * 1000.0 << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gua/spoints/sgtp/SGTP.h>
+#include <gua/spoints/spoints_geometry/NetKinectArray.hpp>
+
+#include <zmq.hpp>
+
+// Replays recorded spoints messages through the decode path of NetKinectArray
+// and reports the SPointsDecodeStats of every decoded frame. Each file holds
+// one SGTP message as published by the reconstruction server:
+//
+//   benchSPointsReplay <message file> [<message file> ...]
+
+namespace
+{
+const std::string ENDPOINT = "127.0.0.1:7099";
+const unsigned ROUNDS = 10;
+const unsigned ATTEMPTS = 3;
+const auto DECODE_TIMEOUT = std::chrono::seconds(1);
+
+std::vector<char> read_message(std::string const& file)
+{
+    std::ifstream stream(file, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+bool is_calibration(std::vector<char> const& message)
+{
+    SGTP::header_data_t header;
+    std::memcpy(&header, message.data(), SGTP::HEADER_BYTE_SIZE);
+    return header.is_calibration_data;
+}
+
+// publishes the message until the unpack thread has decoded it; the first
+// messages are lost while the subscription is being established
+bool replay(zmq::socket_t& publisher, spoints::NetKinectArray& array, std::vector<char> const& message)
+{
+    for(unsigned attempt(0); attempt < ATTEMPTS; ++attempt)
+    {
+        zmq::message_t zmqm(message.size());
+        std::memcpy(zmqm.data(), message.data(), message.size());
+        publisher.send(zmqm);
+
+        auto const deadline(std::chrono::steady_clock::now() + DECODE_TIMEOUT);
+
+        while(std::chrono::steady_clock::now() < deadline)
+        {
+            if(array.swap_decoded_frame())
+            {
+                return true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    return false;
+}
+
+void print(std::string const& name, spoints::SPointsDecodeStats const& stats)
+{
+    std::cout << std::setw(30) << name << std::setw(12) << stats.m_queue_wait_ms << std::setw(12) << stats.m_unpack_ms << std::setw(12) << stats.m_geometry_decode_ms << std::setw(12)
+              << stats.m_image_decode_ms << std::setw(12) << stats.m_total_ms << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <message file> [<message file> ...]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    std::vector<std::vector<char>> messages;
+
+    for(int i(1); i < argc; ++i)
+    {
+        auto message(read_message(argv[i]));
+
+        if(message.size() < SGTP::HEADER_BYTE_SIZE || is_calibration(message))
+        {
+            std::cerr << "skipping " << argv[i] << ": no model message" << std::endl;
+            continue;
+        }
+
+        names.push_back(argv[i]);
+        messages.push_back(std::move(message));
+    }
+
+    zmq::context_t context(1);
+    zmq::socket_t publisher(context, ZMQ_PUB);
+    publisher.bind(("tcp://" + ENDPOINT).c_str());
+
+    spoints::NetKinectArray array(ENDPOINT);
+
+    std::cout << std::setw(30) << "message" << std::setw(12) << "wait [ms]" << std::setw(12) << "unpack [ms]" << std::setw(12) << "lz4 [ms]" << std::setw(12) << "jpeg [ms]" << std::setw(12)
+              << "total [ms]" << std::endl;
+
+    unsigned failed(0);
+    spoints::SPointsDecodeStats overall;
+    unsigned decoded(0);
+
+    for(std::size_t m(0); m < messages.size(); ++m)
+    {
+        spoints::SPointsDecodeStats mean;
+        unsigned rounds(0);
+
+        for(unsigned round(0); round < ROUNDS; ++round)
+        {
+            if(!replay(publisher, array, messages[m]))
+            {
+                ++failed;
+                continue;
+            }
+
+            auto stats(array.get_latest_decode_stats());
+            mean.m_queue_wait_ms += stats.m_queue_wait_ms;
+            mean.m_unpack_ms += stats.m_unpack_ms;
+            mean.m_geometry_decode_ms += stats.m_geometry_decode_ms;
+            mean.m_image_decode_ms += stats.m_image_decode_ms;
+            mean.m_total_ms += stats.m_total_ms;
+            overall.m_dropped_messages = stats.m_dropped_messages;
+            ++rounds;
+        }
+
+        if(rounds == 0)
+        {
+            std::cerr << names[m] << " was never decoded" << std::endl;
+            continue;
+        }
+
+        overall.m_queue_wait_ms += mean.m_queue_wait_ms;
+        overall.m_unpack_ms += mean.m_unpack_ms;
+        overall.m_geometry_decode_ms += mean.m_geometry_decode_ms;
+        overall.m_image_decode_ms += mean.m_image_decode_ms;
+        overall.m_total_ms += mean.m_total_ms;
+        decoded += rounds;
+
+        mean.m_queue_wait_ms /= rounds;
+        mean.m_unpack_ms /= rounds;
+        mean.m_geometry_decode_ms /= rounds;
+        mean.m_image_decode_ms /= rounds;
+        mean.m_total_ms /= rounds;
+        print(names[m], mean);
+    }
+
+    if(decoded > 0)
+    {
+        overall.m_queue_wait_ms /= decoded;
+        overall.m_unpack_ms /= decoded;
+        overall.m_geometry_decode_ms /= decoded;
+        overall.m_image_decode_ms /= decoded;
+        overall.m_total_ms /= decoded;
+        print("mean", overall);
+    }
+
+    std::cout << decoded << " frames decoded, " << failed << " lost, " << overall.m_dropped_messages << " replaced before unpacking" << std::endl;
+
+    return failed > 0 || decoded == 0 ? 1 : 0;
+}
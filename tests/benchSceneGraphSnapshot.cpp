@@ -0,0 +1,97 @@
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gua/scenegraph/SceneGraph.hpp>
+#include <gua/node/TransformNode.hpp>
+#include <gua/utils/Timer.hpp>
+
+// Measures the cost of handing a SceneGraph to the rendering threads: a full
+// deep copy (SceneGraph copy constructor) against a structurally shared
+// snapshot (SceneGraph::snapshot()) for various tree sizes and fractions of
+// modified nodes per frame.
+
+namespace
+{
+const unsigned BRANCHING = 8;
+const unsigned FRAMES = 20;
+
+std::vector<std::shared_ptr<gua::node::Node>> build_tree(gua::SceneGraph& graph, unsigned node_count)
+{
+    std::vector<std::shared_ptr<gua::node::Node>> nodes;
+    nodes.reserve(node_count);
+    nodes.push_back(graph.get_root());
+
+    for(unsigned i(1); i < node_count; ++i)
+    {
+        auto parent(nodes[(i - 1) / BRANCHING]);
+        nodes.push_back(parent->add_child(std::make_shared<gua::node::TransformNode>("n" + std::to_string(i))));
+    }
+
+    return nodes;
+}
+
+void modify(std::vector<std::shared_ptr<gua::node::Node>> const& nodes, float fraction, std::mt19937& rng)
+{
+    std::uniform_int_distribution<std::size_t> pick(1, nodes.size() - 1);
+    std::size_t count(static_cast<std::size_t>(fraction * nodes.size()));
+
+    for(std::size_t i(0); i < count; ++i)
+    {
+        nodes[pick(rng)]->translate(0.f, 0.001f, 0.f);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 rng(42);
+
+    std::cout << std::setw(10) << "nodes" << std::setw(12) << "modified" << std::setw(16) << "deep copy [ms]" << std::setw(16) << "snapshot [ms]" << std::setw(10) << "speedup" << std::endl;
+
+    for(unsigned node_count : {1000u, 10000u, 100000u, 200000u})
+    {
+        gua::SceneGraph graph;
+        auto nodes(build_tree(graph, node_count));
+        graph.update_cache();
+
+        for(float fraction : {0.f, 0.0001f, 0.001f, 0.01f, 0.1f})
+        {
+            // prime the snapshot cache, as the renderer would have done in the
+            // previous frame
+            std::unique_ptr<gua::SceneGraph> last(graph.snapshot());
+
+            double deep_copy_time(0.0);
+            double snapshot_time(0.0);
+
+            for(unsigned frame(0); frame < FRAMES; ++frame)
+            {
+                modify(nodes, fraction, rng);
+                graph.update_cache();
+
+                gua::Timer timer;
+                timer.start();
+                std::unique_ptr<gua::SceneGraph> copy(new gua::SceneGraph(graph));
+                deep_copy_time += timer.get_elapsed();
+                copy.reset();
+
+                timer.reset();
+                auto current(graph.snapshot());
+                snapshot_time += timer.get_elapsed();
+
+                last = std::move(current);
+            }
+
+            deep_copy_time *= 1000.0 / FRAMES;
+            snapshot_time *= 1000.0 / FRAMES;
+
+            std::cout << std::setw(10) << node_count << std::setw(11) << fraction * 100.f << "%" << std::setw(16) << deep_copy_time << std::setw(16) << snapshot_time << std::setw(9)
+                      << deep_copy_time / snapshot_time << "x" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include <boost/functional/hash.hpp>
+#include <boost/regex.hpp>
+
+#include <gua/renderer/ResourceFactory.hpp>
+#include <gua/utils/Timer.hpp>
+
+// Measures the CPU side expansion of shader sources before they are compiled:
+// the former boost::regex loop against ResourceFactory::resolve_substitutions()
+// and the hashing of the result which is used as key of the program cache.
+
+namespace
+{
+const unsigned ITERATIONS = 100;
+
+// the implementation ResourceFactory::resolve_substitutions() replaced
+std::string resolve_with_regex(std::string const& shader_source, gua::SubstitutionMap const& smap)
+{
+    boost::regex regex("\\@(\\w+)\\@");
+    boost::smatch match;
+    std::string out, s = shader_source;
+
+    while(boost::regex_search(s, match, regex))
+    {
+        auto search = smap.find(match[1]);
+        out += match.prefix().str() + (search != smap.end() ? search->second : match.str());
+        s = match.suffix().str();
+    }
+    return out + s;
+}
+
+// a shader of the given number of lines, every tenth one containing a substitution
+std::string make_source(unsigned lines, gua::SubstitutionMap& smap)
+{
+    std::string source;
+
+    for(unsigned i(0); i < lines; ++i)
+    {
+        if(i % 10 == 0)
+        {
+            std::string name("option_" + std::to_string(i % 200));
+            smap[name] = "vec3 " + name + "_value = vec3(0.0);";
+            source += "  @" + name + "@\n";
+        }
+        else
+        {
+            source += "  gua_color = mix(gua_color, texture(sampler2D(gua_texture), gua_texcoords).rgb, 0.5);\n";
+        }
+    }
+
+    return source;
+}
+
+} // namespace
+
+int main()
+{
+    gua::ResourceFactory factory;
+
+    std::cout << std::setw(10) << "lines" << std::setw(14) << "regex [ms]" << std::setw(18) << "single pass [ms]" << std::setw(10) << "speedup" << std::setw(12) << "hash [ms]" << std::endl;
+
+    for(unsigned lines : {100u, 1000u, 5000u, 20000u})
+    {
+        gua::SubstitutionMap smap;
+        auto source(make_source(lines, smap));
+
+        gua::Timer timer;
+        timer.start();
+        std::string regex_expanded;
+        for(unsigned i(0); i < ITERATIONS; ++i)
+        {
+            regex_expanded = resolve_with_regex(source, smap);
+        }
+        double regex_time(timer.get_elapsed() * 1000.0 / ITERATIONS);
+
+        timer.reset();
+        std::string expanded;
+        for(unsigned i(0); i < ITERATIONS; ++i)
+        {
+            expanded = factory.resolve_substitutions(source, smap);
+        }
+        double single_pass_time(timer.get_elapsed() * 1000.0 / ITERATIONS);
+
+        timer.reset();
+        std::size_t key(0);
+        for(unsigned i(0); i < ITERATIONS; ++i)
+        {
+            boost::hash_combine(key, expanded);
+        }
+        double hash_time(timer.get_elapsed() * 1000.0 / ITERATIONS);
+
+        if(regex_expanded != expanded)
+        {
+            std::cout << "results differ for " << lines << " lines!" << std::endl;
+            return 1;
+        }
+
+        std::cout << std::setw(10) << lines << std::setw(14) << regex_time << std::setw(18) << single_pass_time << std::setw(9) << regex_time / single_pass_time << "x" << std::setw(12) << hash_time << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gua/concurrent/ThreadPool.hpp>
+#include <gua/skelanim/node/SkeletalAnimationNode.hpp>
+#include <gua/skelanim/utils/Bone.hpp>
+#include <gua/skelanim/utils/SkeletalAnimation.hpp>
+#include <gua/skelanim/utils/Skeleton.hpp>
+#include <gua/utils/Timer.hpp>
+
+#include <assimp/anim.h>
+
+// Measures the bone update of crowds of SkeletalAnimationNodes blending two
+// animations: one node after the other on the calling thread against the
+// batched update distributed over thread pools of various sizes.
+
+namespace
+{
+const unsigned BONES = 60;
+const unsigned BRANCHING = 3;
+const unsigned KEYS = 30;
+const unsigned FRAMES = 20;
+
+gua::Skeleton make_skeleton()
+{
+    std::vector<gua::Bone> bones;
+    for(unsigned i(0); i < BONES; ++i)
+    {
+        std::vector<unsigned> children;
+        for(unsigned c(i * BRANCHING + 1); c <= i * BRANCHING + BRANCHING && c < BONES; ++c)
+        {
+            children.push_back(c);
+        }
+
+        bones.push_back(gua::Bone{"bone" + std::to_string(i), scm::math::make_translation(0.f, 0.1f, 0.f), scm::math::mat4f::identity(), children});
+    }
+
+    gua::Skeleton skeleton;
+    skeleton.set_bones(bones);
+    return skeleton;
+}
+
+gua::SkeletalAnimation make_animation(std::string const& name, float phase)
+{
+    // aiAnimation takes ownership of the channels and their keys
+    aiAnimation anim;
+    anim.mName = aiString(name);
+    anim.mDuration = KEYS - 1;
+    anim.mTicksPerSecond = 30;
+    anim.mNumChannels = BONES;
+    anim.mChannels = new aiNodeAnim*[BONES];
+
+    for(unsigned i(0); i < BONES; ++i)
+    {
+        auto channel(new aiNodeAnim());
+        channel->mNodeName = aiString("bone" + std::to_string(i));
+        channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = KEYS;
+        channel->mPositionKeys = new aiVectorKey[KEYS];
+        channel->mRotationKeys = new aiQuatKey[KEYS];
+        channel->mScalingKeys = new aiVectorKey[KEYS];
+
+        for(unsigned k(0); k < KEYS; ++k)
+        {
+            float angle(phase + 0.1f * k + 0.01f * i);
+            channel->mPositionKeys[k] = aiVectorKey(k, aiVector3D(0.f, 0.1f, 0.01f * std::sin(angle)));
+            channel->mRotationKeys[k] = aiQuatKey(k, aiQuaternion(aiVector3D(0.f, 0.f, 1.f), angle));
+            channel->mScalingKeys[k] = aiVectorKey(k, aiVector3D(1.f, 1.f, 1.f));
+        }
+
+        anim.mChannels[i] = channel;
+    }
+
+    return gua::SkeletalAnimation{anim};
+}
+
+double measure(std::vector<gua::node::SkeletalAnimationNode*> const& nodes, gua::concurrent::ThreadPool* pool)
+{
+    gua::Timer timer;
+    timer.start();
+
+    for(unsigned frame(0); frame < FRAMES; ++frame)
+    {
+        for(auto node : nodes)
+        {
+            node->set_time_1(float(frame) / FRAMES);
+            node->set_time_2(1.f - float(frame) / FRAMES);
+        }
+
+        gua::node::SkeletalAnimationNode::update_bone_transforms(nodes, pool);
+    }
+
+    return timer.get_elapsed() * 1000.0 / FRAMES;
+}
+
+} // namespace
+
+int main()
+{
+    auto skeleton(make_skeleton());
+    auto walk(make_animation("walk", 0.f));
+    auto run(make_animation("run", 1.f));
+
+    std::vector<unsigned> thread_counts{2u, 4u, std::max(2u, std::thread::hardware_concurrency())};
+    std::sort(thread_counts.begin(), thread_counts.end());
+    thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()), thread_counts.end());
+
+    std::cout << std::setw(10) << "avatars" << std::setw(14) << "serial [ms]";
+    for(unsigned threads : thread_counts)
+    {
+        std::cout << std::setw(10) << threads << " thr [ms]";
+    }
+    std::cout << std::endl;
+
+    for(unsigned avatar_count : {10u, 100u, 500u, 1000u, 5000u})
+    {
+        std::vector<std::shared_ptr<gua::node::SkeletalAnimationNode>> avatars;
+        std::vector<gua::node::SkeletalAnimationNode*> nodes;
+
+        for(unsigned i(0); i < avatar_count; ++i)
+        {
+            auto avatar(std::make_shared<gua::node::SkeletalAnimationNode>(
+                "avatar" + std::to_string(i), std::vector<std::string>{}, std::vector<std::shared_ptr<gua::Material>>{}, skeleton));
+            avatar->add_animation(walk);
+            avatar->add_animation(run);
+            avatar->set_animation_1("walk");
+            avatar->set_animation_2("run");
+            avatar->set_blend_factor(0.5f);
+
+            avatars.push_back(avatar);
+            nodes.push_back(avatar.get());
+        }
+
+        // warm up, the poses allocate their memory in the first update
+        gua::node::SkeletalAnimationNode::update_bone_transforms(nodes, nullptr);
+
+        std::cout << std::setw(10) << avatar_count << std::setw(14) << measure(nodes, nullptr);
+
+        for(unsigned threads : thread_counts)
+        {
+            // the calling thread takes part in the update
+            gua::concurrent::ThreadPool pool(threads - 1);
+            std::cout << std::setw(19) << measure(nodes, &pool);
+        }
+
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
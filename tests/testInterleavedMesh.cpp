@@ -0,0 +1,152 @@
+#include <unittest++/UnitTest++.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+#include <gua/utils/InterleavedMesh.hpp>
+#include <gua/utils/Mesh.hpp>
+
+namespace
+{
+typedef std::array<unsigned, 3> Triangle;
+
+// the triangles of the indices, with the original vertex ids read from the
+// one float per vertex
+std::vector<Triangle> sorted_triangles(std::vector<unsigned> const& indices, std::vector<float> const& vertex_ids)
+{
+    std::vector<Triangle> triangles;
+
+    for(std::size_t i(0); i + 2 < indices.size(); i += 3)
+    {
+        triangles.push_back(Triangle{{unsigned(vertex_ids[indices[i]]), unsigned(vertex_ids[indices[i + 1]]), unsigned(vertex_ids[indices[i + 2]])}});
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// a triangulated grid whose bitangents are the cross product of normal and
+// tangent, as the vertex shader reconstructs them
+gua::Mesh make_grid(unsigned size)
+{
+    gua::Mesh mesh;
+
+    for(unsigned y(0); y < size; ++y)
+    {
+        for(unsigned x(0); x < size; ++x)
+        {
+            float const angle(0.1f * float(x + y * size));
+            scm::math::vec3f const normal(std::sin(angle), std::cos(angle), 0.f);
+            scm::math::vec3f const tangent(0.f, 0.f, 1.f);
+
+            mesh.positions.push_back(scm::math::vec3f(float(x), float(y), 0.5f * float(x * y)));
+            mesh.texCoords.push_back(scm::math::vec2f(float(x) / size, float(y) / size));
+            mesh.normals.push_back(normal);
+            mesh.tangents.push_back(tangent);
+            mesh.bitangents.push_back(scm::math::cross(normal, tangent));
+        }
+    }
+
+    for(unsigned y(0); y + 1 < size; ++y)
+    {
+        for(unsigned x(0); x + 1 < size; ++x)
+        {
+            unsigned const v(x + y * size);
+            mesh.indices.insert(mesh.indices.end(), {v, v + 1, v + size, v + 1, v + size + 1, v + size});
+        }
+    }
+
+    // a degenerate triangle
+    mesh.indices.insert(mesh.indices.end(), {0, 0, 1});
+
+    mesh.num_vertices = size * size;
+    mesh.num_triangles = unsigned(mesh.indices.size() / 3);
+    return mesh;
+}
+
+bool near(scm::math::vec3f const& a, scm::math::vec3f const& b) { return scm::math::length(a - b) < 1e-5f; }
+
+// every interleaved vertex matches the source vertex at the same position,
+// every triangle references the same source vertices
+bool matches(gua::Mesh const& mesh, gua::InterleavedMesh const& interleaved)
+{
+    if(interleaved.get_num_vertices() != mesh.num_vertices || interleaved.get_num_triangles() != mesh.num_triangles)
+    {
+        return false;
+    }
+
+    std::vector<float> source_ids;
+
+    for(unsigned v(0); v < interleaved.get_num_vertices(); ++v)
+    {
+        auto source(std::find_if(mesh.positions.begin(), mesh.positions.end(), [&](scm::math::vec3f const& p) { return p == interleaved.get_position(v); }) - mesh.positions.begin());
+
+        if(std::size_t(source) == mesh.positions.size() || !near(mesh.normals[source], interleaved.get_normal(v)) || !near(mesh.bitangents[source], interleaved.get_bitangent(v)))
+        {
+            return false;
+        }
+
+        source_ids.push_back(float(source));
+    }
+
+    std::vector<float> identity(mesh.num_vertices);
+    for(unsigned v(0); v < mesh.num_vertices; ++v)
+    {
+        identity[v] = float(v);
+    }
+
+    std::vector<unsigned> indices(interleaved.get_indices(), interleaved.get_indices() + 3 * interleaved.get_num_triangles());
+    return sorted_triangles(mesh.indices, identity) == sorted_triangles(indices, source_ids);
+}
+
+} // namespace
+
+TEST(interleaved_mesh_keeps_all_attributes)
+{
+    auto const mesh(make_grid(8));
+    gua::InterleavedMesh interleaved(mesh);
+
+    CHECK_EQUAL(unsigned(gua::InterleavedMesh::ALL_ATTRIBUTES), interleaved.get_attributes());
+    CHECK_EQUAL(std::size_t(14 * sizeof(float)), interleaved.get_vertex_size());
+    CHECK(matches(mesh, interleaved));
+}
+
+TEST(interleaved_mesh_reconstructs_stripped_bitangents)
+{
+    auto const mesh(make_grid(8));
+    gua::InterleavedMesh interleaved(mesh, gua::InterleavedMesh::ALL_ATTRIBUTES & ~gua::InterleavedMesh::BITANGENTS);
+
+    CHECK_EQUAL(std::size_t(11 * sizeof(float)), interleaved.get_vertex_size());
+    CHECK(matches(mesh, interleaved));
+}
+
+TEST(optimized_interleaved_mesh_matches_the_source)
+{
+    auto const mesh(make_grid(16));
+    gua::InterleavedMesh interleaved(mesh, gua::InterleavedMesh::ALL_ATTRIBUTES & ~gua::InterleavedMesh::BITANGENTS, true);
+
+    CHECK(matches(mesh, interleaved));
+}
+
+TEST(optimized_indices_are_a_permutation_of_the_triangles)
+{
+    std::vector<float> vertex_ids{0.f, 1.f, 2.f, 3.f, 4.f, 5.f};
+    std::vector<unsigned> indices{0, 1, 2, 2, 1, 3, 3, 4, 5, 0, 2, 5, 1, 4, 3};
+
+    auto const expected(sorted_triangles(indices, vertex_ids));
+    gua::InterleavedMesh::optimize_indices(unsigned(vertex_ids.size()), 1, vertex_ids.data(), indices);
+
+    CHECK(expected == sorted_triangles(indices, vertex_ids));
+}
+
+TEST(optimized_indices_keep_degenerate_and_repeated_triangles)
+{
+    std::vector<float> vertex_ids{0.f, 1.f, 2.f, 3.f, 4.f};
+    std::vector<unsigned> indices{0, 0, 1, 1, 2, 3, 1, 2, 3, 3, 3, 3, 2, 4, 2, 0, 1, 0, 4, 4, 1, 1, 2, 3};
+
+    auto const expected(sorted_triangles(indices, vertex_ids));
+    gua::InterleavedMesh::optimize_indices(unsigned(vertex_ids.size()), 1, vertex_ids.data(), indices);
+
+    CHECK_EQUAL(std::size_t(24), indices.size());
+    CHECK(expected == sorted_triangles(indices, vertex_ids));
+}